@@ -102,23 +102,219 @@ void ADS1x15::setComparatorLatch(ADS1x15_COMP_LAT_t compCfg)
 
 /**
  * @brief Read an analog value
+ * @details This blocks until the conversion is complete. If a scan is running the conversion
+ * in progress is lost, the scan starts it again on the next call to pollScan().
  *
  * @param mux The configuration of the MUX
  * @return The converted value
  */
 int16_t ADS1x15::analogRead(ADS1x15_MUX_t mux)
 {
-	uint16_t result;
+	unsigned long start;
+	uint16_t mode = configRegister & ADS1x15_MODE_MASK;
+	configRegister |= (uint16_t)SINGLE_SHOT;
+	startConversion(mux);
+	start = micros();
+	while ((micros() - start) < conversionDelay); // delayMicroseconds() is only accurate up to 16383us
+	configRegister = (configRegister & ~ADS1x15_MODE_MASK) | mode;
+	if (scanning) { scanStarted = false; }
+	return readConversion();
+}
+
+/**
+ * @brief Write the MUX setting to the chip and start a conversion
+ *
+ * @param mux The configuration of the MUX
+ */
+void ADS1x15::startConversion(ADS1x15_MUX_t mux)
+{
 	configRegister &= ~(uint16_t)ADS1x15_MUX_MASK;
 	configRegister |= (uint16_t)mux;
 	configRegister |= ADS1x15_OS;
+	readyFlag = false;
 	writeRegister(CONFIG_REG, configRegister);
-	delayMicroseconds(conversionDelay);
+}
+
+/**
+ * @brief Read the result of the last conversion
+ *
+ * @return The converted value
+ */
+int16_t ADS1x15::readConversion()
+{
+	uint16_t result;
 	result = shiftConversion(readRegister(CONVERSION_REG));
 	if (result > getFullScaleBits()) { return (int16_t)(result | 0x8000); }
 	else { return (int16_t)result; }
 }
 
+/**
+ * @brief Get the channel used for the calibration factor of a MUX setting
+ * @details Single ended inputs use their own channel, differential inputs use the positive input.
+ *
+ * @param mux The configuration of the MUX
+ * @return Channel number
+ */
+uint8_t ADS1x15::muxChannel(ADS1x15_MUX_t mux)
+{
+	if (mux == DIF01 || mux == DIF03) { return 0; }
+	else if (mux == DIF13) { return 1; }
+	else if (mux == DIF23) { return 2; }
+	return ((uint16_t)mux >> 12) & 0x03;
+}
+
+/**
+ * @brief Start scanning a list of inputs in the background
+ * @details Each entry in the list is converted in turn and the result is stored in a ring buffer
+ * for that entry, the oldest sample is overwritten if the buffer is full. The scan is advanced by
+ * pollScan(). A list with a single entry runs the chip in continuous conversion mode.
+ *
+ * @param channels Array of MUX settings to convert
+ * @param count Number of entries in the array (up to ADS1x15_MAX_SCAN)
+ * @param depth Number of samples kept for each entry
+ * @return false if the parameters are invalid or there is not enough memory
+ */
+bool ADS1x15::beginScan(const ADS1x15_MUX_t *channels, uint8_t count, uint8_t depth)
+{
+	stopScan();
+	if (count == 0 || count > ADS1x15_MAX_SCAN || depth == 0) { return false; }
+	free(scanBuffer);
+	scanBuffer = (ADS1x15_sample_t *)calloc((size_t)count * depth, sizeof(ADS1x15_sample_t));
+	if (scanBuffer == NULL)
+	{
+		scanCount = 0;
+		return false;
+	}
+	for (uint8_t i = 0; i < count; i++)
+	{
+		scanList[i] = channels[i];
+		scanHead[i] = 0;
+		scanFill[i] = 0;
+	}
+	scanCount = count;
+	scanDepth = depth;
+	scanIndex = 0;
+	scanOverruns = 0;
+	configRegister &= ~(uint16_t)ADS1x15_MODE_MASK;
+	configRegister |= (uint16_t)((count == 1) ? CONTINUOUS_CONV : SINGLE_SHOT);
+	scanning = true;
+	scanStarted = false;
+	pollScan();
+	return true;
+}
+
+/**
+ * @brief Stop the scan engine
+ * @details Samples that have not been read are kept until the next beginScan().
+ */
+void ADS1x15::stopScan()
+{
+	if (!scanning) { return; }
+	scanning = false;
+	if ((configRegister & ADS1x15_MODE_MASK) == CONTINUOUS_CONV)
+	{
+		configRegister |= (uint16_t)SINGLE_SHOT; // single shot mode powers down after the current conversion
+		configRegister &= ~ADS1x15_OS;
+		writeRegister(CONFIG_REG, configRegister);
+	}
+}
+
+/**
+ * @brief Advance the scan engine, this should be called often from loop()
+ * @details A conversion is complete when conversionReady() has been called or when the
+ * conversion time for the current data rate has passed.
+ *
+ * @return true if a new sample was stored
+ */
+bool ADS1x15::pollScan()
+{
+	ADS1x15_sample_t *sample;
+	uint8_t slot;
+	unsigned long now;
+
+	if (!scanning) { return false; }
+	now = micros();
+	if (!scanStarted)
+	{
+		startConversion(scanList[scanIndex]);
+		scanStart = now;
+		scanStarted = true;
+		return false;
+	}
+	if (!readyFlag && (now - scanStart) < conversionDelay) { return false; }
+
+	slot = scanIndex;
+	if (scanFill[slot] == scanDepth)
+	{
+		scanHead[slot] = (scanHead[slot] + 1) % scanDepth; // full, drop the oldest sample
+		scanOverruns++;
+	}
+	else { scanFill[slot]++; }
+	sample = scanBuffer + (slot * scanDepth) + ((scanHead[slot] + scanFill[slot] - 1) % scanDepth);
+	sample->raw = readConversion();
+	sample->time = now;
+	sample->value = getFullScaleV(muxChannel(scanList[slot])) * ((float)sample->raw / (float)getFullScaleBits());
+
+	if (scanCount == 1)
+	{
+		readyFlag = false; // continuous mode, the next conversion has already started
+		scanStart = now;
+	}
+	else
+	{
+		if (++scanIndex >= scanCount) { scanIndex = 0; }
+		startConversion(scanList[scanIndex]);
+		scanStart = micros();
+	}
+	return true;
+}
+
+/**
+ * @brief Use the ALERT/RDY pin as a conversion ready signal
+ * @details The pin goes low when a conversion is complete. Attach an interrupt to the pin
+ * (FALLING) that calls conversionReady() to advance the scan without waiting for the full
+ * conversion time. This replaces the comparator settings.
+ *
+ * @return true on success, false if NACK
+ */
+bool ADS1x15::enableReadyPin()
+{
+	bool status;
+	status = writeRegister(HI_THRESH_REG, 0x8000);
+	status &= writeRegister(LOW_THRESH_REG, 0x0000);
+	configRegister &= ~(uint16_t)(ADS1x15_QUE_MASK | ADS1x15_COMP_POL_MASK | ADS1x15_COMP_LAT_MASK);
+	configRegister |= (uint16_t)(QUE_ONE | ACTIVE_LOW | NONLATCHING_COMP);
+	return status;
+}
+
+/**
+ * @brief Get the number of unread samples for an entry in the scan list
+ *
+ * @param slot Index in the scan list
+ * @return Number of samples that can be read with readScan()
+ */
+uint8_t ADS1x15::scanAvailable(uint8_t slot)
+{
+	if (slot >= scanCount) { return 0; }
+	return scanFill[slot];
+}
+
+/**
+ * @brief Read the oldest unread sample for an entry in the scan list
+ *
+ * @param slot Index in the scan list
+ * @param sample Pointer to the struct to copy the sample to
+ * @return false if there are no unread samples
+ */
+bool ADS1x15::readScan(uint8_t slot, ADS1x15_sample_t *sample)
+{
+	if (slot >= scanCount || scanFill[slot] == 0) { return false; }
+	*sample = *(scanBuffer + (slot * scanDepth) + scanHead[slot]);
+	scanHead[slot] = (scanHead[slot] + 1) % scanDepth;
+	scanFill[slot]--;
+	return true;
+}
+
 /**
  * @brief Read an analog value
  *
@@ -1,7 +1,7 @@
 /**
  * @file ADS1115.h
  * @author Keegan Morrow
- * @version 0.0.4
+ * @version 0.0.5
  * @brief Classes for the ADS1015 and ADS1115 analog to digital converters
  */
 
@@ -113,6 +113,18 @@ static const uint16_t ADS1x15_defaultConfig = 0x8583; // default startup state (
 
 static const uint8_t ADS1x15_defaultAddress = 0x48;
 
+static const uint8_t ADS1x15_MAX_SCAN = 8; // maximum number of entries in a scan list
+
+/**
+ * @brief One sample taken by the scan engine
+ */
+struct ADS1x15_sample_t
+{
+	int16_t raw; ///< Converted value as returned by analogRead()
+	float value; ///< Value in V, including the calibration factor
+	unsigned long time; ///< Time in us (from micros()) that the conversion was read
+};
+
 /**
  * @brief Foundation class for the ADS1015 and ADS1115 ADCs
  */
@@ -130,6 +142,10 @@ public:
 		calibration[3] = 1.0;
 		configRegister = ADS1x15_defaultConfig;
 		currentGain = GAIN_2; // this needs to match the defaultConfig configuration
+		scanBuffer = NULL;
+		scanCount = 0;
+		scanning = false;
+		readyFlag = false;
 	}
 	/**
 	 * @brief Initialize the chip at the default address
@@ -155,6 +171,30 @@ public:
 	float analogReadVoltage(uint8_t);
 	float analogReadCurrent(uint8_t, float = 100.0);
 	float analogRead420(uint8_t, float = 100.0);
+
+	bool beginScan(const ADS1x15_MUX_t *, uint8_t, uint8_t = 4);
+	void stopScan();
+	bool pollScan();
+	bool enableReadyPin();
+	/**
+	 * @brief Tell the scan engine that a conversion is complete
+	 * @details Call this from the interrupt attached to the ALERT/RDY pin (FALLING), see enableReadyPin()
+	 */
+	inline void conversionReady() {readyFlag = true;}
+	uint8_t scanAvailable(uint8_t);
+	bool readScan(uint8_t, ADS1x15_sample_t *);
+	/**
+	 * @brief Check if the scan engine is running
+	 *
+	 * @return true if a scan is running
+	 */
+	inline bool isScanning() {return scanning;}
+	/**
+	 * @brief Get the number of samples that were overwritten before they were read
+	 *
+	 * @return Number of lost samples since beginScan()
+	 */
+	inline uint16_t getScanOverruns() {return scanOverruns;}
 	/**
 	 * @brief Get the current calibration factor
 	 *
@@ -171,6 +211,23 @@ protected:
 	uint32_t conversionDelay;
 	float calibration[4];
 	virtual inline uint16_t shiftConversion(uint16_t c) {return c;}
+
+private:
+	ADS1x15_MUX_t scanList[ADS1x15_MAX_SCAN];
+	uint8_t scanCount; ///< Number of entries in the scan list
+	uint8_t scanDepth; ///< Number of samples kept for each entry
+	uint8_t scanIndex; ///< Entry currently being converted
+	uint8_t scanHead[ADS1x15_MAX_SCAN]; ///< Next sample to be read for each entry
+	uint8_t scanFill[ADS1x15_MAX_SCAN]; ///< Number of unread samples for each entry
+	ADS1x15_sample_t *scanBuffer;
+	uint16_t scanOverruns;
+	unsigned long scanStart; ///< Time the current conversion was started (us)
+	bool scanning;
+	bool scanStarted; ///< false if the current conversion still needs to be started
+	volatile bool readyFlag;
+	void startConversion(ADS1x15_MUX_t);
+	int16_t readConversion();
+	uint8_t muxChannel(ADS1x15_MUX_t);
 };
 
 /**
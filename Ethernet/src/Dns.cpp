@@ -47,11 +47,41 @@
 #define INVALID_SERVER   -2
 #define TRUNCATED        -3
 #define INVALID_RESPONSE -4
+#define NO_QUERY_SLOT    -11
+#define NO_SOCKET        -12
+
+// State of a query
+#define QUERY_FREE       0
+#define QUERY_WAITING    1
+#define QUERY_DONE       2
+
+#if DNS_CACHE_SIZE > 0
+DNSClient::CacheEntry DNSClient::iCache[DNS_CACHE_SIZE];
+#endif
+
+DNSClient::DNSClient()
+{
+    iUdpOpen = false;
+    for (uint8_t i = 0; i < DNS_MAX_QUERIES; i++)
+    {
+        iQuery[i].iState = QUERY_FREE;
+    }
+}
+
+DNSClient::~DNSClient()
+{
+    if (iUdpOpen)
+    {
+        iUdp.stop();
+    }
+}
 
 void DNSClient::begin(const IPAddress& aDNSServer)
 {
     iDNSServer = aDNSServer;
-    iRequestId = 0;
+    // Start somewhere different each time so a late answer to an earlier
+    // DNSClient isn't taken for an answer to this one
+    iRequestId = millis();
 }
 
 
@@ -97,13 +127,50 @@ int DNSClient::inet_aton(const char* address, IPAddress& result)
 
 int DNSClient::getHostByName(const char* aHostname, IPAddress& aResult)
 {
-    int ret =0;
+    int ret = startHostByName(aHostname);
+    if (ret < 0)
+    {
+        return ret;
+    }
 
-    // See if it's a numeric IP address
-    if (inet_aton(aHostname, aResult))
+    uint8_t query = ret;
+    while ((ret = queryResult(query, aResult)) == DNS_PENDING)
     {
-        // It is, our work here is done
-        return 1;
+        yield();
+    }
+    return ret;
+}
+
+int DNSClient::startHostByName(const char* aHostname, DNSCallback aCallback, void* aContext)
+{
+    // Find a free query
+    uint8_t q;
+    for (q = 0; q < DNS_MAX_QUERIES; q++)
+    {
+        if (iQuery[q].iState == QUERY_FREE)
+        {
+            break;
+        }
+    }
+    if (q == DNS_MAX_QUERIES)
+    {
+        return NO_QUERY_SLOT;
+    }
+
+    Query& query = iQuery[q];
+    query.iName = aHostname;
+    Hash(aHostname, query.iKey);
+    query.iTries = 0;
+    query.iCallback = aCallback;
+    query.iContext = aContext;
+
+    // See if it's a numeric IP address, or a name we already know
+    if (inet_aton(aHostname, query.iAddress) || CacheLookup(query.iKey, query.iAddress))
+    {
+        // It is, the result is handed over on the next poll()
+        query.iResult = SUCCESS;
+        query.iState = QUERY_DONE;
+        return q;
     }
 
     // Check we've got a valid DNS server to use
@@ -111,48 +178,227 @@ int DNSClient::getHostByName(const char* aHostname, IPAddress& aResult)
     {
         return INVALID_SERVER;
     }
-	
-    // Find a socket to use
-    if (iUdp.begin(1024+(millis() & 0xF)) == 1)
+
+    // All of the queries share one socket, answers are matched up by ID
+    if (!iUdpOpen)
     {
-        // Try up to three times
-        int retries = 0;
-//        while ((retries < 3) && (ret <= 0))
+        if (iUdp.begin(1024+(millis() & 0xF)) != 1)
         {
-            // Send DNS request
-            ret = iUdp.beginPacket(iDNSServer, DNS_PORT);
-            if (ret != 0)
+            return NO_SOCKET;
+        }
+        iUdpOpen = true;
+    }
+
+    query.iId = ++iRequestId;
+    query.iState = QUERY_WAITING;
+    SendRequest(q);
+    return q;
+}
+
+int DNSClient::poll()
+{
+    uint8_t q;
+    IPAddress address;
+    uint32_t ttl;
+    int ret;
+
+    // Deal with all of the answers that have arrived
+    while (iUdpOpen && (iUdp.parsePacket() > 0))
+    {
+        ret = ProcessResponse(q, address, ttl);
+        if (q < DNS_MAX_QUERIES)
+        {
+            if (ret == SUCCESS)
             {
-                // Now output the request data
-                ret = BuildRequest(aHostname);
-                if (ret != 0)
-                {
-                    // And finally send the request
-                    ret = iUdp.endPacket();
-                    if (ret != 0)
-                    {
-                        // Now wait for a response
-                        int wait_retries = 0;
-                        ret = TIMED_OUT;
-                        while ((wait_retries < 3) && (ret == TIMED_OUT))
-                        {
-                            ret = ProcessResponse(5000, aResult);
-                            wait_retries++;
-                        }
-                    }
-                }
+                CacheStore(iQuery[q].iKey, address, ttl);
+            }
+            Complete(q, ret, address);
+        }
+    }
+
+    int waiting = 0;
+    for (q = 0; q < DNS_MAX_QUERIES; q++)
+    {
+        Query& query = iQuery[q];
+        if ((query.iState == QUERY_DONE) && (query.iCallback != NULL))
+        {
+            // Completed by startHostByName()
+            Complete(q, query.iResult, query.iAddress);
+        }
+        else if ((query.iState == QUERY_WAITING) && (millis() - query.iSent >= DNS_TIMEOUT))
+        {
+            if (query.iTries < DNS_RETRIES)
+            {
+                SendRequest(q);
+            }
+            else
+            {
+                Complete(q, TIMED_OUT, INADDR_NONE);
             }
-            retries++;
         }
+        // A callback may have started another query
+        if (query.iState == QUERY_WAITING)
+        {
+            waiting++;
+        }
+    }
 
-        // We're done with the socket now
+    // We're done with the socket when nothing is outstanding
+    if ((waiting == 0) && iUdpOpen)
+    {
         iUdp.stop();
+        iUdpOpen = false;
     }
+    return waiting;
+}
 
-    return ret;
+int DNSClient::queryResult(int aQuery, IPAddress& aResult)
+{
+    if ((aQuery < 0) || (aQuery >= DNS_MAX_QUERIES) ||
+        (iQuery[aQuery].iState == QUERY_FREE) || (iQuery[aQuery].iCallback != NULL))
+    {
+        return INVALID_RESPONSE;
+    }
+
+    poll();
+    Query& query = iQuery[aQuery];
+    if (query.iState != QUERY_DONE)
+    {
+        return DNS_PENDING;
+    }
+    aResult = query.iAddress;
+    query.iState = QUERY_FREE;
+    return query.iResult;
 }
 
-uint16_t DNSClient::BuildRequest(const char* aName)
+void DNSClient::SendRequest(uint8_t aQuery)
+{
+    Query& query = iQuery[aQuery];
+    // If the request doesn't go out it is sent again after the timeout
+    if (iUdp.beginPacket(iDNSServer, DNS_PORT) && BuildRequest(query.iName, query.iId))
+    {
+        iUdp.endPacket();
+    }
+    query.iSent = millis();
+    query.iTries++;
+}
+
+void DNSClient::Complete(uint8_t aQuery, int aResult, const IPAddress& aAddress)
+{
+    Query& query = iQuery[aQuery];
+    query.iResult = aResult;
+    query.iAddress = aAddress;
+    query.iState = QUERY_DONE;
+    if (query.iCallback != NULL)
+    {
+        // Release the query first so that the callback can start a new one
+        DNSCallback callback = query.iCallback;
+        IPAddress address = aAddress;
+        query.iState = QUERY_FREE;
+        (*callback)(aResult, address, query.iContext);
+    }
+}
+
+void DNSClient::Hash(const char* aName, NameKey& aKey)
+{
+    // FNV-1a and a 16 bit djb2, names are not case sensitive and
+    // "host." is the same name as "host"
+    aKey.iHash = 2166136261UL;
+    aKey.iCheck = 5381;
+    aKey.iLength = 0;
+    while (*aName && !((*aName == '.') && (aName[1] == '\0')))
+    {
+        char c = *aName++;
+        if (c >= 'A' && c <= 'Z')
+        {
+            c += 'a' - 'A';
+        }
+        aKey.iHash ^= (uint8_t)c;
+        aKey.iHash *= 16777619UL;
+        aKey.iCheck = (aKey.iCheck << 5) + aKey.iCheck + (uint8_t)c;
+        aKey.iLength++;
+    }
+}
+
+bool DNSClient::SameName(const NameKey& aKey1, const NameKey& aKey2)
+{
+    return (aKey1.iHash == aKey2.iHash) && (aKey1.iCheck == aKey2.iCheck) && (aKey1.iLength == aKey2.iLength);
+}
+
+bool DNSClient::CacheLookup(const NameKey& aKey, IPAddress& aAddress)
+{
+#if DNS_CACHE_SIZE > 0
+    for (uint8_t i = 0; i < DNS_CACHE_SIZE; i++)
+    {
+        CacheEntry& entry = iCache[i];
+        if ((entry.iTTL == 0) || !SameName(entry.iKey, aKey))
+        {
+            continue;
+        }
+        if (millis() - entry.iStored >= entry.iTTL)
+        {
+            // Expired
+            entry.iTTL = 0;
+            return false;
+        }
+        aAddress = entry.iAddress;
+        return true;
+    }
+#endif
+    return false;
+}
+
+void DNSClient::CacheStore(const NameKey& aKey, const IPAddress& aAddress, uint32_t aTTL)
+{
+#if DNS_CACHE_SIZE > 0
+    if (aTTL == 0)
+    {
+        // Not to be cached
+        return;
+    }
+    if (aTTL > DNS_MAX_TTL)
+    {
+        aTTL = DNS_MAX_TTL;
+    }
+
+    // Use the entry for the same name, else the one with the least time left
+    uint32_t now = millis();
+    uint32_t least = 0xFFFFFFFF;
+    uint8_t slot = 0;
+    for (uint8_t i = 0; i < DNS_CACHE_SIZE; i++)
+    {
+        CacheEntry& entry = iCache[i];
+        if ((entry.iTTL != 0) && SameName(entry.iKey, aKey))
+        {
+            slot = i;
+            break;
+        }
+        uint32_t age = now - entry.iStored;
+        uint32_t left = (age < entry.iTTL) ? entry.iTTL - age : 0;
+        if (left < least)
+        {
+            least = left;
+            slot = i;
+        }
+    }
+    iCache[slot].iKey = aKey;
+    iCache[slot].iStored = now;
+    iCache[slot].iTTL = aTTL * 1000UL;
+    iCache[slot].iAddress = aAddress;
+#endif
+}
+
+void DNSClient::clearCache()
+{
+#if DNS_CACHE_SIZE > 0
+    for (uint8_t i = 0; i < DNS_CACHE_SIZE; i++)
+    {
+        iCache[i].iTTL = 0;
+    }
+#endif
+}
+
+uint16_t DNSClient::BuildRequest(const char* aName, uint16_t aId)
 {
     // Build header
     //                                    1  1  1  1  1  1
@@ -170,14 +416,13 @@ uint16_t DNSClient::BuildRequest(const char* aName)
     //    +--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+
     //    |                    ARCOUNT                    |
     //    +--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+
-    // As we only support one request at a time at present, we can simplify
-    // some of this header
-    iRequestId = millis(); // generate a random ID
+    // The ID is used to match the answer to the query, the rest of the
+    // header is the same for every request
     uint16_t twoByteBuffer;
 
     // FIXME We should also check that there's enough space available to write to, rather
     // FIXME than assume there's enough space (as the code does at present)
-    uint16_t _id = htons(iRequestId);
+    uint16_t _id = htons(aId);
     iUdp.write((uint8_t*)&_id, sizeof(_id));
 
     twoByteBuffer = htons(QUERY_FLAG | OPCODE_STANDARD_QUERY | RECURSION_DESIRED_FLAG);
@@ -233,17 +478,10 @@ uint16_t DNSClient::BuildRequest(const char* aName)
 }
 
 
-uint16_t DNSClient::ProcessResponse(uint16_t aTimeout, IPAddress& aAddress)
+int DNSClient::ProcessResponse(uint8_t& aQuery, IPAddress& aAddress, uint32_t& aTTL)
 {
-    uint32_t startTime = millis();
-
-    // Wait for a response packet
-    while(iUdp.parsePacket() <= 0)
-    {
-        if((millis() - startTime) > aTimeout)
-            return TIMED_OUT;
-        delay(50);
-    }
+    // Set to the query the packet answers, once we know
+    aQuery = DNS_MAX_QUERIES;
 
     // We've had a reply!
     // Read the UDP header
@@ -264,14 +502,27 @@ uint16_t DNSClient::ProcessResponse(uint16_t aTimeout, IPAddress& aAddress)
     iUdp.read(header, DNS_HEADER_SIZE);
 
     uint16_t header_flags = word(header[2], header[3]);
-    // Check that it's a response to this request
-    if ( (iRequestId != word(header[0], header[1])) ||
-        ((header_flags & QUERY_RESPONSE_MASK) != (uint16_t)RESPONSE_FLAG) )
+    // Check that it's a response to one of our requests
+    if ((header_flags & QUERY_RESPONSE_MASK) != (uint16_t)RESPONSE_FLAG)
     {
         // Mark the entire packet as read
         iUdp.flush();
         return INVALID_RESPONSE;
     }
+    for (aQuery = 0; aQuery < DNS_MAX_QUERIES; aQuery++)
+    {
+        if ( (iQuery[aQuery].iState == QUERY_WAITING) &&
+            (iQuery[aQuery].iId == word(header[0], header[1])) )
+        {
+            break;
+        }
+    }
+    if (aQuery == DNS_MAX_QUERIES)
+    {
+        // Not outstanding, e.g. a late answer to a request sent again
+        iUdp.flush();
+        return INVALID_RESPONSE;
+    }
     // Check for any errors in the response (or in our request)
     // although we don't do anything to get round these
     if ( (header_flags & TRUNCATION_FLAG) || (header_flags & RESP_MASK) )
@@ -363,11 +614,10 @@ uint16_t DNSClient::ProcessResponse(uint16_t aTimeout, IPAddress& aAddress)
         iUdp.read((uint8_t*)&answerType, sizeof(answerType));
         iUdp.read((uint8_t*)&answerClass, sizeof(answerClass));
 
-        // Ignore the Time-To-Live as we don't do any caching
-        for (int i =0; i < TTL_SIZE; i++)
-        {
-            iUdp.read(); // we don't care about the returned byte
-        }
+        // Read the Time-To-Live, for the cache
+        uint8_t ttl[TTL_SIZE];
+        iUdp.read(ttl, TTL_SIZE);
+        aTTL = ((uint32_t)word(ttl[0], ttl[1]) << 16) | word(ttl[2], ttl[3]);
 
         // And read out the length of this answer
         // Don't need header_flags anymore, so we can reuse it here
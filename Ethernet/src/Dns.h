@@ -7,9 +7,41 @@
 
 #include <EthernetUdp.h>
 
+// Number of queries that can be outstanding at once on one DNSClient
+#ifndef DNS_MAX_QUERIES
+#define DNS_MAX_QUERIES 2
+#endif
+// Number of answers kept in the cache shared by all DNSClient objects,
+// 0 disables the cache
+#ifndef DNS_CACHE_SIZE
+#define DNS_CACHE_SIZE 4
+#endif
+// Answers are cached for their TTL, but never longer than this (seconds)
+#ifndef DNS_MAX_TTL
+#define DNS_MAX_TTL 3600
+#endif
+// Time to wait for an answer before sending the request again (ms)
+#ifndef DNS_TIMEOUT
+#define DNS_TIMEOUT 5000
+#endif
+// Number of times a request is sent before giving up
+#ifndef DNS_RETRIES
+#define DNS_RETRIES 3
+#endif
+
+// Returned by queryResult() while the query is waiting for an answer
+#define DNS_PENDING 0
+
+// Called when a query started with a callback is complete.
+// aResult is 1 on success, else a (negative) error code
+typedef void (*DNSCallback)(int aResult, const IPAddress& aAddress, void* aContext);
+
 class DNSClient
 {
 public:
+    DNSClient();
+    ~DNSClient();
+
     // ctor
     void begin(const IPAddress& aDNSServer);
 
@@ -22,6 +54,8 @@ public:
     int inet_aton(const char *aIPAddrString, IPAddress& aResult);
 
     /** Resolve the given hostname to an IP address.
+        Blocks until there is an answer, see startHostByName() for the
+        non-blocking version.
         @param aHostname Name to be resolved
         @param aResult IPAddress structure to store the returned IP address
         @result 1 if aIPAddrString was successfully converted to an IP address,
@@ -29,13 +63,85 @@ public:
     */
     int getHostByName(const char* aHostname, IPAddress& aResult);
 
+    /** Start resolving the given hostname without waiting for the answer.
+        Numeric addresses and names in the cache complete on the next poll().
+        @param aHostname Name to be resolved, must stay in scope until the
+               query is complete
+        @param aCallback Called from poll() when the query is complete, the
+               query is then released. If NULL the result is collected with
+               queryResult()
+        @param aContext Passed to the callback
+        @result Query number (>= 0), else a (negative) error code
+    */
+    int startHostByName(const char* aHostname, DNSCallback aCallback = NULL, void* aContext = NULL);
+
+    /** Process any answers, send requests again and time out queries.
+        Call from loop() while queries are outstanding.
+        @result Number of queries still waiting for an answer
+    */
+    int poll();
+
+    /** Poll, then get the result of a query started without a callback.
+        The query is released once it is complete.
+        @param aQuery Query number returned by startHostByName()
+        @param aResult IPAddress structure to store the returned IP address
+        @result DNS_PENDING while waiting, 1 on success, else error code
+    */
+    int queryResult(int aQuery, IPAddress& aResult);
+
+    /** Forget all of the cached answers. */
+    static void clearCache();
+
 protected:
-    uint16_t BuildRequest(const char* aName);
-    uint16_t ProcessResponse(uint16_t aTimeout, IPAddress& aAddress);
+    uint16_t BuildRequest(const char* aName, uint16_t aId);
+    int ProcessResponse(uint8_t& aQuery, IPAddress& aAddress, uint32_t& aTTL);
+    void SendRequest(uint8_t aQuery);
+    void Complete(uint8_t aQuery, int aResult, const IPAddress& aAddress);
+
+    // Identifies a name without keeping it, two hashes and the length make
+    // it unlikely that two different names get mixed up
+    struct NameKey
+    {
+        uint32_t iHash;
+        uint16_t iCheck;
+        uint8_t iLength;
+    };
+
+    static void Hash(const char* aName, NameKey& aKey);
+    static bool SameName(const NameKey& aKey1, const NameKey& aKey2);
+    static bool CacheLookup(const NameKey& aKey, IPAddress& aAddress);
+    static void CacheStore(const NameKey& aKey, const IPAddress& aAddress, uint32_t aTTL);
+
+    struct Query
+    {
+        const char* iName;
+        NameKey iKey;
+        uint32_t iSent; // millis() when the request was last sent
+        uint16_t iId;
+        uint8_t iState;
+        uint8_t iTries;
+        int iResult;
+        IPAddress iAddress;
+        DNSCallback iCallback;
+        void* iContext;
+    };
+
+    struct CacheEntry
+    {
+        NameKey iKey; // the names themselves are not kept
+        uint32_t iStored; // millis() when the answer was stored
+        uint32_t iTTL; // ms, 0 for an empty entry
+        IPAddress iAddress;
+    };
 
     IPAddress iDNSServer;
     uint16_t iRequestId;
     EthernetUDP iUdp;
+    bool iUdpOpen;
+    Query iQuery[DNS_MAX_QUERIES];
+#if DNS_CACHE_SIZE > 0
+    static CacheEntry iCache[DNS_CACHE_SIZE];
+#endif
 };
 
 #endif
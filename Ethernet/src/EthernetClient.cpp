@@ -13,6 +13,17 @@ extern "C" {
 #include "Dns.h"
 
 uint16_t EthernetClient::_srcport = 49152;      //Use IANA recommended ephemeral port range 49152-65535
+uint16_t EthernetClient::_readAhead = 0;
+uint8_t *EthernetClient::_rxBuffer[MAX_SOCK_NUM] = { NULL, };
+uint16_t EthernetClient::_rxPos[MAX_SOCK_NUM] = { 0, };
+uint16_t EthernetClient::_rxLen[MAX_SOCK_NUM] = { 0, };
+uint16_t EthernetClient::_writeBuffer = 0;
+uint16_t EthernetClient::_writeDelay = 0;
+uint8_t *EthernetClient::_txBuffer[MAX_SOCK_NUM] = { NULL, };
+uint16_t EthernetClient::_txLen[MAX_SOCK_NUM] = { 0, };
+unsigned long EthernetClient::_txStart[MAX_SOCK_NUM] = { 0, };
+uint32_t EthernetClient::_bytesWritten = 0;
+uint32_t EthernetClient::_segmentsSent = 0;
 
 EthernetClient::EthernetClient() : _sock(MAX_SOCK_NUM) {
 }
@@ -50,6 +61,7 @@ int EthernetClient::connect(IPAddress ip, uint16_t port) {
   if (_sock == MAX_SOCK_NUM)
     return 0;
 
+  discardBuffers(_sock);
   _srcport++;
   if (_srcport == 0) _srcport = 49152;          //Use IANA recommended ephemeral port range 49152-65535
   socket(_sock, SnMR::TCP, _srcport, 0);
@@ -79,21 +91,58 @@ size_t EthernetClient::write(const uint8_t *buf, size_t size) {
     setWriteError();
     return 0;
   }
-  if (!send(_sock, buf, size)) {
+  if (_txBuffer[_sock] != NULL && size < _writeBuffer) {
+    const uint8_t *end = buf + size;
+    if (_txLen[_sock] == 0)
+      _txStart[_sock] = millis();
+    while (buf != end) {
+      uint16_t len = _writeBuffer - _txLen[_sock];
+      if (len > end - buf)
+        len = end - buf;
+      memcpy(_txBuffer[_sock] + _txLen[_sock], buf, len);
+      _txLen[_sock] += len;
+      buf += len;
+      if (_txLen[_sock] == _writeBuffer) {
+        if (!flushWriteBuffer()) {
+          setWriteError();
+          return 0;
+        }
+        _txStart[_sock] = millis();
+      }
+    }
+    _bytesWritten += size;
+    checkWriteDelay();
+    return size;
+  }
+  // anything already buffered goes first to keep the order
+  if (!flushWriteBuffer() || !sendSegment(buf, size)) {
     setWriteError();
     return 0;
   }
+  _bytesWritten += size;
   return size;
 }
 
 int EthernetClient::available() {
-  if (_sock != MAX_SOCK_NUM)
-    return recvAvailable(_sock);
-  return 0;
+  if (_sock == MAX_SOCK_NUM)
+    return 0;
+  checkWriteDelay();
+  // only what is already buffered, so a parser checking available() before
+  // each read() does not go to the chip
+  if (readAhead() && _rxLen[_sock] != 0)
+    return _rxLen[_sock];
+  return recvAvailable(_sock);
 }
 
 int EthernetClient::read() {
   uint8_t b;
+  if (readAhead())
+  {
+    if (fillReadAhead() <= 0)
+      return -1;
+    _rxLen[_sock]--;
+    return _rxBuffer[_sock][_rxPos[_sock]++];
+  }
   if ( recv(_sock, &b, 1) > 0 )
   {
     // recv worked
@@ -107,11 +156,30 @@ int EthernetClient::read() {
 }
 
 int EthernetClient::read(uint8_t *buf, size_t size) {
+  if (readAhead() && (_rxLen[_sock] != 0 || size < _readAhead))
+  {
+    int16_t ret = fillReadAhead();
+    if (ret <= 0)
+      return ret;
+    if (size > (size_t)ret)
+      size = ret;
+    memcpy(buf, _rxBuffer[_sock] + _rxPos[_sock], size);
+    _rxPos[_sock] += size;
+    _rxLen[_sock] -= size;
+    return size;
+  }
+  // large reads go straight from the chip into buf
   return recv(_sock, buf, size);
 }
 
 int EthernetClient::peek() {
   uint8_t b;
+  if (readAhead())
+  {
+    if (fillReadAhead() <= 0)
+      return -1;
+    return _rxBuffer[_sock][_rxPos[_sock]];
+  }
   // Unlike recv, peek doesn't check to see if there's any data available, so we must
   if (!available())
     return -1;
@@ -120,6 +188,10 @@ int EthernetClient::peek() {
 }
 
 void EthernetClient::flush() {
+  if (_sock == MAX_SOCK_NUM)
+    return;
+  if (!flushWriteBuffer())
+    setWriteError();
   ::flush(_sock);
 }
 
@@ -127,6 +199,8 @@ void EthernetClient::stop() {
   if (_sock == MAX_SOCK_NUM)
     return;
 
+  flushWriteBuffer();
+
   // attempt to close the connection gracefully (send a FIN to other side)
   disconnect(_sock);
   unsigned long start = millis();
@@ -145,12 +219,14 @@ void EthernetClient::stop() {
     close(_sock);
 
   EthernetClass::_server_port[_sock] = 0;
+  discardBuffers(_sock);
   _sock = MAX_SOCK_NUM;
 }
 
 uint8_t EthernetClient::connected() {
   if (_sock == MAX_SOCK_NUM) return 0;
 
+  checkWriteDelay();
   uint8_t s = status();
   return !(s == SnSR::LISTEN || s == SnSR::CLOSED || s == SnSR::FIN_WAIT ||
     (s == SnSR::CLOSE_WAIT && !available()));
@@ -175,3 +251,69 @@ bool EthernetClient::operator==(const EthernetClient& rhs) {
 uint8_t EthernetClient::getSocketNumber() {
   return _sock;
 }
+
+void EthernetClient::setReadAhead(uint16_t size) {
+  for (int i = 0; i < MAX_SOCK_NUM; i++) {
+    free(_rxBuffer[i]);
+    _rxBuffer[i] = NULL;
+    _rxLen[i] = 0;
+    // a socket without a buffer falls back to reading from the chip
+    if (size != 0)
+      _rxBuffer[i] = (uint8_t *)malloc(size);
+  }
+  _readAhead = size;
+}
+
+void EthernetClient::setWriteBuffer(uint16_t size, uint16_t delay) {
+  // a segment has to fit in the transmit memory of the socket
+  if (size > W5100.SSIZE)
+    size = W5100.SSIZE;
+  for (int i = 0; i < MAX_SOCK_NUM; i++) {
+    free(_txBuffer[i]);
+    _txBuffer[i] = NULL;
+    _txLen[i] = 0;
+    // a socket without a buffer sends every write directly
+    if (size != 0)
+      _txBuffer[i] = (uint8_t *)malloc(size);
+  }
+  _writeBuffer = size;
+  _writeDelay = delay;
+}
+
+// Send one segment (one SEND command) and count it
+bool EthernetClient::sendSegment(const uint8_t *buf, uint16_t len) {
+  if (!send(_sock, buf, len))
+    return false;
+  _segmentsSent++;
+  return true;
+}
+
+// Send the contents of the write buffer of the socket, if any
+bool EthernetClient::flushWriteBuffer() {
+  uint16_t len = _txLen[_sock];
+  if (len == 0)
+    return true;
+  _txLen[_sock] = 0;
+  return sendSegment(_txBuffer[_sock], len);
+}
+
+// Flush the write buffer if the oldest byte in it has waited for the delay
+void EthernetClient::checkWriteDelay() {
+  if (_writeDelay != 0 && _txLen[_sock] != 0 && millis() - _txStart[_sock] >= _writeDelay)
+    flushWriteBuffer();
+}
+
+// Refill the read ahead buffer of the socket if it is empty. One refill
+// reads up to _readAhead bytes and acknowledges them to the chip with a
+// single RECV command. Returns the number of bytes buffered, or the recv()
+// result (0 closed, -1 no data yet) when there is nothing to buffer.
+int16_t EthernetClient::fillReadAhead() {
+  if (_rxLen[_sock] == 0) {
+    int16_t ret = recv(_sock, _rxBuffer[_sock], _readAhead);
+    if (ret <= 0)
+      return ret;
+    _rxPos[_sock] = 0;
+    _rxLen[_sock] = ret;
+  }
+  return _rxLen[_sock];
+}
@@ -5,6 +5,10 @@
 #include "Client.h"
 #include "IPAddress.h"
 
+#ifndef MAX_SOCK_NUM
+#define MAX_SOCK_NUM 4
+#endif
+
 class EthernetClient : public Client {
 
 public:
@@ -30,13 +34,49 @@ public:
   virtual bool operator!=(const EthernetClient& rhs) { return !this->operator==(rhs); };
   uint8_t getSocketNumber();
 
+  // Read ahead: read(), peek() and available() are served from a buffer
+  // per socket that is refilled with up to size bytes at a time, so byte
+  // wise parsers do not go to the chip for every byte. 0 (the default)
+  // reads directly from the chip. Call before any connection is open.
+  static void setReadAhead(uint16_t size);
+  // Write buffer: Print output is collected in a buffer per socket of up
+  // to 2048 bytes (the socket transmit memory, larger sizes are clamped) and
+  // sent as one segment when the buffer is full, on flush() or stop(), or
+  // when the oldest byte is delay ms old (checked by write(), available(),
+  // connected() and EthernetServer::available()).
+  // size 0 (the default) sends every write() directly, delay 0 disables
+  // the timed flush. Call before any connection is open.
+  static void setWriteBuffer(uint16_t size, uint16_t delay = 0);
+  // Counters over all clients, for checking how well writes coalesce
+  static uint32_t getBytesWritten() { return _bytesWritten; };
+  static uint32_t getSegmentsSent() { return _segmentsSent; };
+  static void clearCounters() { _bytesWritten = 0; _segmentsSent = 0; };
+
   friend class EthernetServer;
   
   using Print::write;
 
 private:
   static uint16_t _srcport;
+  static uint16_t _readAhead;
+  static uint8_t *_rxBuffer[MAX_SOCK_NUM];
+  static uint16_t _rxPos[MAX_SOCK_NUM];
+  static uint16_t _rxLen[MAX_SOCK_NUM];
+  static uint16_t _writeBuffer;
+  static uint16_t _writeDelay;
+  static uint8_t *_txBuffer[MAX_SOCK_NUM];
+  static uint16_t _txLen[MAX_SOCK_NUM];
+  static unsigned long _txStart[MAX_SOCK_NUM];
+  static uint32_t _bytesWritten;
+  static uint32_t _segmentsSent;
   uint8_t _sock;
+
+  bool readAhead() { return _sock != MAX_SOCK_NUM && _rxBuffer[_sock] != NULL; };
+  int16_t fillReadAhead();
+  bool sendSegment(const uint8_t *buf, uint16_t len);
+  bool flushWriteBuffer();
+  void checkWriteDelay();
+  static void discardBuffers(uint8_t sock) { _rxLen[sock] = 0; _txLen[sock] = 0; };
 };
 
 #endif
@@ -18,6 +18,7 @@ void EthernetServer::begin()
   for (int sock = 0; sock < MAX_SOCK_NUM; sock++) {
     EthernetClient client(sock);
     if (client.status() == SnSR::CLOSED) {
+      EthernetClient::discardBuffers(sock);
       socket(sock, SnMR::TCP, _port, 0);
       listen(sock);
       EthernetClass::_server_port[sock] = _port;
@@ -34,6 +35,7 @@ void EthernetServer::accept()
     EthernetClient client(sock);
 
     if (EthernetClass::_server_port[sock] == _port) {
+      client.checkWriteDelay();
       if (client.status() == SnSR::LISTEN) {
         listening = 1;
       } 
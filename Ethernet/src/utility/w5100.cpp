@@ -134,85 +134,52 @@ void W5100Class::read_data(SOCKET s, volatile uint16_t src, volatile uint8_t *ds
 }
 
 
-uint8_t W5100Class::write(uint16_t _addr, uint8_t _data)
+// The W5100 has no address auto increment on SPI, every byte is a 4 byte
+// frame (opcode, address high, address low, data) and chip select has to
+// be released between frames. A burst is a run of back to back frames,
+// each sent as one block transfer so the SPI library can keep the shift
+// register busy.
+uint8_t W5100Class::transferFrame(uint8_t op, uint16_t addr, uint8_t data)
 {
+  uint8_t frame[4];
+  frame[0] = op;
+  frame[1] = addr >> 8;
+  frame[2] = addr & 0xFF;
+  frame[3] = data;
 #if !defined(SPI_HAS_EXTENDED_CS_PIN_HANDLING)
-  setSS();  
-  SPI.transfer(0xF0);
-  SPI.transfer(_addr >> 8);
-  SPI.transfer(_addr & 0xFF);
-  SPI.transfer(_data);
+  setSS();
+  SPI.transfer(frame, 4);
   resetSS();
 #else
-  SPI.transfer(ETHERNET_SHIELD_SPI_CS, 0xF0, SPI_CONTINUE);
-  SPI.transfer(ETHERNET_SHIELD_SPI_CS, _addr >> 8, SPI_CONTINUE);
-  SPI.transfer(ETHERNET_SHIELD_SPI_CS, _addr & 0xFF, SPI_CONTINUE);
-  SPI.transfer(ETHERNET_SHIELD_SPI_CS, _data);
+  SPI.transfer(ETHERNET_SHIELD_SPI_CS, frame, 4);
 #endif
+  return frame[3];
+}
+
+uint8_t W5100Class::write(uint16_t _addr, uint8_t _data)
+{
+  transferFrame(0xF0, _addr, _data);
   return 1;
 }
 
 uint16_t W5100Class::write(uint16_t _addr, const uint8_t *_buf, uint16_t _len)
 {
-  for (uint16_t i=0; i<_len; i++)
-  {
-#if !defined(SPI_HAS_EXTENDED_CS_PIN_HANDLING)
-    setSS();    
-    SPI.transfer(0xF0);
-    SPI.transfer(_addr >> 8);
-    SPI.transfer(_addr & 0xFF);
-    _addr++;
-    SPI.transfer(_buf[i]);
-    resetSS();
-#else
-    SPI.transfer(ETHERNET_SHIELD_SPI_CS, 0xF0, SPI_CONTINUE);
-    SPI.transfer(ETHERNET_SHIELD_SPI_CS, _addr >> 8, SPI_CONTINUE);
-    SPI.transfer(ETHERNET_SHIELD_SPI_CS, _addr & 0xFF, SPI_CONTINUE);
-    SPI.transfer(ETHERNET_SHIELD_SPI_CS, _buf[i]);
-    _addr++;
-#endif
-  }
+  const uint8_t *end = _buf + _len;
+  while (_buf != end)
+    transferFrame(0xF0, _addr++, *_buf++);
   return _len;
 }
 
 uint8_t W5100Class::read(uint16_t _addr)
 {
-#if !defined(SPI_HAS_EXTENDED_CS_PIN_HANDLING)
-  setSS();  
-  SPI.transfer(0x0F);
-  SPI.transfer(_addr >> 8);
-  SPI.transfer(_addr & 0xFF);
-  uint8_t _data = SPI.transfer(0);
-  resetSS();
-#else
-  SPI.transfer(ETHERNET_SHIELD_SPI_CS, 0x0F, SPI_CONTINUE);
-  SPI.transfer(ETHERNET_SHIELD_SPI_CS, _addr >> 8, SPI_CONTINUE);
-  SPI.transfer(ETHERNET_SHIELD_SPI_CS, _addr & 0xFF, SPI_CONTINUE);
-  uint8_t _data = SPI.transfer(ETHERNET_SHIELD_SPI_CS, 0);
-#endif
-  return _data;
+  return transferFrame(0x0F, _addr, 0);
 }
 
 uint16_t W5100Class::read(uint16_t _addr, uint8_t *_buf, uint16_t _len)
 {
-  for (uint16_t i=0; i<_len; i++)
-  {
-#if !defined(SPI_HAS_EXTENDED_CS_PIN_HANDLING)
-    setSS();
-    SPI.transfer(0x0F);
-    SPI.transfer(_addr >> 8);
-    SPI.transfer(_addr & 0xFF);
-    _addr++;
-    _buf[i] = SPI.transfer(0);
-    resetSS();
-#else
-    SPI.transfer(ETHERNET_SHIELD_SPI_CS, 0x0F, SPI_CONTINUE);
-    SPI.transfer(ETHERNET_SHIELD_SPI_CS, _addr >> 8, SPI_CONTINUE);
-    SPI.transfer(ETHERNET_SHIELD_SPI_CS, _addr & 0xFF, SPI_CONTINUE);
-    _buf[i] = SPI.transfer(ETHERNET_SHIELD_SPI_CS, 0);
-    _addr++;
-#endif
-  }
+  uint8_t *end = _buf + _len;
+  while (_buf != end)
+    *_buf++ = transferFrame(0x0F, _addr++, 0);
   return _len;
 }
 
@@ -11,6 +11,10 @@ extern "C" {
 EthernetServer::EthernetServer(uint16_t port)
 {
   _port = port;
+  for (int i = 0; i < SERVER_EVENTS; i++)
+    _handler[i] = NULL;
+  _closing = 0;
+  _unread = 0;
 }
 
 void EthernetServer::begin()
@@ -18,9 +22,12 @@ void EthernetServer::begin()
   for (int sock = 0; sock < MAX_SOCK_NUM; sock++) {
     EthernetClient client(sock);
     if (client.status() == SnSR::CLOSED) {
+      EthernetClient::discardBuffers(sock);
       socket(sock, SnMR::TCP, _port, 0);
       listen(sock);
       EthernetClass::_server_port[sock] = _port;
+      _closing &= ~(1 << sock);
+      _unread &= ~(1 << sock);
       break;
     }
   }  
@@ -34,6 +41,7 @@ void EthernetServer::accept()
     EthernetClient client(sock);
 
     if (EthernetClass::_server_port[sock] == _port) {
+      client.checkWriteDelay();
       if (client.status() == SnSR::LISTEN) {
         listening = 1;
       } 
@@ -67,6 +75,94 @@ EthernetClient EthernetServer::available()
   return EthernetClient(MAX_SOCK_NUM);
 }
 
+// Set the function called for an event, NULL to ignore the event
+void EthernetServer::onEvent(EthernetServerEvent event, EthernetServerHandler handler)
+{
+  if (event < SERVER_EVENTS)
+    _handler[event] = handler;
+}
+
+// Event driven alternative to available(), call from loop(). The socket
+// interrupt register (SIR) is read once and only the sockets of this
+// server that have an interrupt pending, or are closing or have unread
+// data, are touched, so an idle server costs one register read. A receive
+// handler that leaves data unread is called again on the next pass. After
+// the disconnect handler returns the client is disconnected without
+// waiting for the other end, the socket listens again once the chip has
+// closed it. Returns the number of handlers called.
+uint8_t EthernetServer::handleEvents()
+{
+  uint8_t n = 0;
+  uint8_t changed = 0;
+  uint8_t pending = w5500.readSIR();
+
+  for (int sock = 0; sock < MAX_SOCK_NUM; sock++) {
+    uint8_t bit = 1 << sock;
+    if (EthernetClass::_server_port[sock] != _port)
+      continue;
+    EthernetClient client(sock);
+    // sends buffered writes that have waited for the write delay
+    client.checkWriteDelay();
+
+    uint8_t ir = 0;
+    if (pending & bit) {
+      ir = w5500.readSnIR(sock);
+      w5500.writeSnIR(sock, ir);
+    }
+    if (_closing & bit) {
+      // disconnected on an earlier pass, no more events for this client
+      if (client.status() == SnSR::CLOSED) {
+        _closing &= ~bit;
+        changed = 1;
+      }
+      continue;
+    }
+    if (ir & SnIR::CON) {
+      n += dispatch(SERVER_CONNECT, client);
+      changed = 1;
+    }
+    if ((ir & SnIR::RECV) || (_unread & bit)) {
+      _unread &= ~bit;
+      if (dispatch(SERVER_RECEIVE, client)) {
+        n++;
+        if (client.available())
+          _unread |= bit;
+      }
+    }
+    if (ir & SnIR::SEND_OK)
+      n += dispatch(SERVER_SEND_OK, client);
+    if (ir & (SnIR::DISCON | SnIR::TIMEOUT)) {
+      n += dispatch(SERVER_DISCONNECT, client);
+      _unread &= ~bit;
+      if (client) {
+        // the FIN goes out, the chip closes the socket when the other end
+        // answers or times out
+        client.flushWriteBuffer();
+        EthernetClient::discardBuffers(sock);
+        if (client.status() != SnSR::CLOSED) {
+          disconnect(sock);
+          _closing |= bit;
+        }
+      }
+      changed = 1;
+    }
+  }
+
+  // a socket stopped listening or was closed, make sure one is listening
+  if (changed)
+    accept();
+  return n;
+}
+
+uint8_t EthernetServer::dispatch(EthernetServerEvent event, EthernetClient &client)
+{
+  // the client may have been stopped by an earlier handler
+  if (_handler[event] == NULL || !client)
+    return 0;
+  (*_handler[event])(client);
+  return 1;
+}
+
 size_t EthernetServer::write(uint8_t b) 
 {
   return write(&b, 1);
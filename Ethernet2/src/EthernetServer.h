@@ -5,14 +5,31 @@
 
 class EthernetClient;
 
+// Events dispatched by EthernetServer::handleEvents()
+enum EthernetServerEvent {
+  SERVER_CONNECT,    // a client connected
+  SERVER_RECEIVE,    // new data arrived from a client
+  SERVER_DISCONNECT, // the client closed the connection, or it timed out
+  SERVER_SEND_OK,    // a SEND finished (client.write() waits for this itself)
+  SERVER_EVENTS
+};
+
+typedef void (*EthernetServerHandler)(EthernetClient &client);
+
 class EthernetServer : 
 public Server {
 private:
   uint16_t _port;
+  EthernetServerHandler _handler[SERVER_EVENTS];
+  uint8_t _closing; // sockets disconnected by handleEvents(), one bit each
+  uint8_t _unread;  // sockets a receive handler left data in
   void accept();
+  uint8_t dispatch(EthernetServerEvent event, EthernetClient &client);
 public:
   EthernetServer(uint16_t);
   EthernetClient available();
+  void onEvent(EthernetServerEvent event, EthernetServerHandler handler);
+  uint8_t handleEvents();
   virtual void begin();
   virtual size_t write(uint8_t);
   virtual size_t write(const uint8_t *buf, size_t size);
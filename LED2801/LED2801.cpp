@@ -9,6 +9,7 @@
  * Rev 5 3/2013 Keegan Morrow - Fixed a bug in send() causing non-SPI communications to fail
  * Rev 6 6/2013 Keegan Morrow - disable interrupts during send operation (a pause >0.7ms is a latch signal)
  * Rev 7 11/2013 Keegan Morrow - Added colorReorder() to allow access to the current color order function
+ * Rev 8 10/2026 - Color order is applied as byte positions instead of a call per pixel, added LED2801Order, LED2801Segment and setChunkSize()
  * 
  */
 #include "LED2801.h"
@@ -42,7 +43,8 @@ void LED2801::startup()
 	if (outputBuffer == NULL)
 		while (1);
 	autoUpdate = true;
-	colorOrder = &_RGB;
+	chunkSize = 0;
+	setColorOrder(&_RGB);
 }
 
 LED2801::~LED2801()
@@ -84,7 +86,34 @@ LED2801::LED2801(byte dataPin, byte clockPin, word numLEDs)
 
 void LED2801::setColorOrder(uint32_t (*ordFP)(uint32_t))
 {
+	uint32_t positions;
 	colorOrder = ordFP;
+	customOrder = (ordFP != &_RGB) && (ordFP != &_GRB) && (ordFP != &_RBG)
+	              && (ordFP != &_GBR) && (ordFP != &_BRG) && (ordFP != &_BGR);
+	if (customOrder)
+		return; // unknown function, setColor() has to call it for every pixel
+	// the built in orders are reduced to the byte position of each color, found by running 0x000102 through the order
+	positions = (*colorOrder)(0x000102UL);
+	for (byte pos = 0; pos < 3; pos++)
+	{
+		byte col = (positions >> (8 * (2 - pos))) & 0xFF;
+		if (col == 0)
+			redPos = pos;
+		else if (col == 1)
+			greenPos = pos;
+		else
+			bluePos = pos;
+	}
+}
+
+/**
+ * Sets how many pixels are sent with interrupts off before they are briefly turned back on.
+ * Any interrupt that runs between chunks must finish well within the 0.7ms WS2801 latch time.
+ * @param chunkSize Number of (logical) pixels per chunk, 0 sends the whole buffer with interrupts off (default)
+ */
+void LED2801::setChunkSize(word chunkSize)
+{
+	this->chunkSize = chunkSize;
 }
 
 void LED2801::sendSPI(byte data)
@@ -107,16 +136,29 @@ void LED2801::sendBB(byte data)
 	}
 }
 
+/* private function, lets any pending interrupts run if they were on when send() was called */
+void LED2801::interruptWindow(boolean interruptStatus)
+{
+	if (!interruptStatus)
+		return;
+	interrupts();
+	// the instruction after sei always runs before an interrupt is taken, so a sei directly followed by cli never
+	// lets one in
+	__asm__ __volatile__ ("nop");
+	noInterrupts();
+}
+
 void LED2801::send()
 {
 	boolean interruptStatus;
+	word chunkCount = 0;
 
 	interruptStatus = LED2801getInterruptStatus();
 	noInterrupts();
 	byte *bufP = outputBuffer;
 	if (hwSPI)
 	{
-		for (word i = 0; i < numLEDs; i++)
+		for (word i = 0; i < numLEDs; i += 3)
 		{
 			byte r = *bufP++;
 			byte g = *bufP++;
@@ -127,11 +169,16 @@ void LED2801::send()
 				sendSPI(g);
 				sendSPI(b);
 			}
+			if ((chunkSize != 0) && (++chunkCount >= chunkSize))
+			{
+				chunkCount = 0;
+				interruptWindow(interruptStatus);
+			}
 		}
 	}
 	else
 	{
-		for (word i = 0; i < numLEDs; i++)
+		for (word i = 0; i < numLEDs; i += 3)
 		{
 			byte r = *bufP++;
 			byte g = *bufP++;
@@ -142,6 +189,11 @@ void LED2801::send()
 				sendBB(g);
 				sendBB(b);
 			}
+			if ((chunkSize != 0) && (++chunkCount >= chunkSize))
+			{
+				chunkCount = 0;
+				interruptWindow(interruptStatus);
+			}
 		}
 	}
 	LED2801setInterruptStatus(interruptStatus);
@@ -160,12 +212,20 @@ void LED2801::setColor(word pixNum, uint32_t col)
 	if ((pixNum * 3) >= numLEDs)
 		return;
 
-	uint32_t color = (*colorOrder)(col);
-
 	byte *bufP = outputBuffer + (pixNum * 3);
-	*bufP++ = (color >> 16) & 0xFF; //red
-	*bufP++ = (color >> 8) & 0xFF; //green
-	*bufP++ = color & 0xFF; //blue
+	if (customOrder)
+	{
+		uint32_t color = (*colorOrder)(col);
+		*bufP++ = (color >> 16) & 0xFF;
+		*bufP++ = (color >> 8) & 0xFF;
+		*bufP++ = color & 0xFF;
+	}
+	else
+	{
+		*(bufP + redPos) = (col >> 16) & 0xFF;
+		*(bufP + greenPos) = (col >> 8) & 0xFF;
+		*(bufP + bluePos) = col & 0xFF;
+	}
 
 	if (autoUpdate)
 		send();
@@ -173,7 +233,10 @@ void LED2801::setColor(word pixNum, uint32_t col)
 
 uint32_t LED2801::colorReorder(uint32_t c)
 {
-	return (*colorOrder)(c);
+	if (customOrder)
+		return (*colorOrder)(c);
+	return (((c >> 16) & 0xFF) << (8 * (2 - redPos))) | (((c >> 8) & 0xFF) << (8 * (2 - greenPos)))
+	       | ((c & 0xFF) << (8 * (2 - bluePos)));
 }
 
 uint32_t LED2801::colorReorder(byte r, byte g, byte b)
@@ -184,7 +247,7 @@ uint32_t LED2801::colorReorder(byte r, byte g, byte b)
 	c |= g;
 	c <<= 8;
 	c |= b;
-	return (*colorOrder)(c);
+	return colorReorder(c);
 }
 
 void LED2801::setAllColor(uint32_t col)
@@ -194,13 +257,13 @@ void LED2801::setAllColor(uint32_t col)
 
 void LED2801::setColor(uint32_t col)
 {
-	uint32_t color = (*colorOrder)(col);
+	uint32_t color = colorReorder(col); // the byte positions, set by setColorOrder() or LED2801Order
 	byte red = (color >> 16) & 0xFF;
 	byte green = (color >> 8) & 0xFF;
 	byte blue = color & 0xFF;
 	byte *bufP = outputBuffer;
 
-	for (byte i = 0; i < numLEDs; i += 3)
+	for (word i = 0; i < numLEDs; i += 3)
 	{
 		*bufP++ = red;
 		*bufP++ = green;
@@ -220,6 +283,62 @@ word LED2801::getByteCount()
 	return numLEDs;
 }
 
+word LED2801::getPixelCount()
+{
+	return numLEDs / 3;
+}
+
+/**
+ * @param strip Pointer to the LED2801 object that holds the pixels
+ * @param offset First pixel of the segment
+ * @param count Number of pixels in the segment, truncated to fit the strip
+ */
+LED2801Segment::LED2801Segment(LED2801 *strip, word offset, word count)
+{
+	word stripCount = strip->getPixelCount();
+	this->strip = strip;
+	this->offset = (offset < stripCount) ? offset : stripCount;
+	this->count = ((this->offset + count) > stripCount) ? (stripCount - this->offset) : count;
+}
+
+void LED2801Segment::setColor(word pixNum, uint32_t col)
+{
+	if (pixNum >= count)
+		return;
+	strip->setColor(offset + pixNum, col);
+}
+
+void LED2801Segment::setColor(uint32_t col)
+{
+	boolean autoUpdate = strip->autoUpdate;
+	strip->autoUpdate = false;
+	for (word i = 0; i < count; i++)
+		strip->setColor(offset + i, col);
+	strip->autoUpdate = autoUpdate;
+	if (autoUpdate)
+		strip->send();
+}
+
+void LED2801Segment::setAllColor(uint32_t col)
+{
+	setColor(col);
+}
+
+byte *LED2801Segment::getPtr()
+{
+	return strip->getPtr() + (offset * 3);
+}
+
+word LED2801Segment::getPixelCount()
+{
+	return count;
+}
+
+void LED2801Segment::send()
+{
+	strip->send();
+}
+
 uint32_t _RGB(uint32_t color)
 {
 	return color;
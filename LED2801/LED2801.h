@@ -9,13 +9,14 @@
  * Rev 5 3/2013 Keegan Morrow - Fixed a bug in send() causing non-SPI communications to fail
  * Rev 6 6/2013 Keegan Morrow - disable interrupts during send operation (a pause >0.7ms is a latch signal)
  * Rev 7 11/2013 Keegan Morrow - Added colorReorder() to allow access to the current color order function
+ * Rev 8 10/2026 - Color order is applied as byte positions instead of a call per pixel, added LED2801Order, LED2801Segment and setChunkSize()
  * 
  */
 
 #ifndef __LED2801_h_
 #define __LED2801_h_
 
-#define LED2801REV 7 //revision number
+#define LED2801REV 8 //revision number
 #if defined(ARDUINO) && ARDUINO >= 100
 #include "Arduino.h"
 #else
@@ -47,9 +48,12 @@ private:
 	byte groupSize;
 
 	uint32_t (*colorOrder)(uint32_t);
+	boolean customOrder;
+	word chunkSize;
 
 	void sendSPI(byte);
 	void sendBB(byte);
+	void interruptWindow(boolean);
 
 	void startup();
 	void startup_spi();
@@ -59,6 +63,9 @@ protected:
 	byte *outputBuffer;
 	word numLEDs;
 	boolean hwSPI;
+	byte redPos; // position of each color in a pixel, set by setColorOrder()
+	byte greenPos;
+	byte bluePos;
 
 public:
 	boolean autoUpdate;
@@ -76,12 +83,94 @@ public:
 	void setAllColor(uint32_t);
 	void setColor(uint32_t);
 	void send();
+	void setChunkSize(word); // number of pixels sent between interrupt windows, 0 = whole buffer
 	
 	uint32_t colorReorder(uint32_t);
 	uint32_t colorReorder(uint8_t, uint8_t, uint8_t);
 
 	byte *getPtr();
 	word getByteCount();
+	word getPixelCount();
 
 };
+
+/*
+ * Color orders for LED2801Order, each gives the position of the red, green and blue bytes in a pixel.
+ */
+struct LED2801_RGB { enum { red = 0, green = 1, blue = 2 }; };
+struct LED2801_RBG { enum { red = 0, green = 2, blue = 1 }; };
+struct LED2801_GRB { enum { red = 1, green = 0, blue = 2 }; };
+struct LED2801_GBR { enum { red = 2, green = 0, blue = 1 }; };
+struct LED2801_BRG { enum { red = 1, green = 2, blue = 0 }; };
+struct LED2801_BGR { enum { red = 2, green = 1, blue = 0 }; };
+
+/**
+ * LED2801 with the color order fixed at compile time, setColor() writes straight to the buffer.
+ * Use this in place of LED2801 and setColorOrder(), e.g. LED2801Order<LED2801_GRB> pixels = LED2801Order<LED2801_GRB>(count);
+ * The color order of the base class is set to match, so the LED2801 functions (called through a base class pointer,
+ * or by LED2801Segment) and colorReorder() give the same result. The order can not be changed with setColorOrder().
+ */
+template <class ORDER>
+class LED2801Order: public LED2801
+{
+private:
+	void setColorOrder(uint32_t (*)(uint32_t)); // not defined, the order is fixed
+	void setOrder()
+	{
+		redPos = ORDER::red;
+		greenPos = ORDER::green;
+		bluePos = ORDER::blue;
+	}
+	inline void write(byte *bufP, uint32_t col)
+	{
+		*(bufP + ORDER::red) = (col >> 16) & 0xFF;
+		*(bufP + ORDER::green) = (col >> 8) & 0xFF;
+		*(bufP + ORDER::blue) = col & 0xFF;
+	}
+public:
+	LED2801Order(word numLEDs, byte groupSize) : LED2801(numLEDs, groupSize) { setOrder(); }
+	LED2801Order(byte dataPin, byte clockPin, word numLEDs, byte groupSize) : LED2801(dataPin, clockPin, numLEDs, groupSize) { setOrder(); }
+	LED2801Order(word numLEDs) : LED2801(numLEDs) { setOrder(); }
+	LED2801Order(byte dataPin, byte clockPin, word numLEDs) : LED2801(dataPin, clockPin, numLEDs) { setOrder(); }
+
+	void setColor(word pixNum, uint32_t col)
+	{
+		if ((pixNum * 3) >= numLEDs)
+			return;
+		write(outputBuffer + (pixNum * 3), col);
+		if (autoUpdate)
+			send();
+	}
+	void setColor(uint32_t col)
+	{
+		for (word i = 0; i < numLEDs; i += 3)
+			write(outputBuffer + i, col);
+		if (autoUpdate)
+			send();
+	}
+	void setAllColor(uint32_t col)
+	{
+		setColor(col);
+	}
+};
+
+/**
+ * A logical strip made from a range of pixels in an LED2801 object. Segments write directly into the
+ * output buffer of the LED2801 object, so any number of them can share one buffer without copies.
+ */
+class LED2801Segment
+{
+private:
+	LED2801 *strip;
+	word offset;
+	word count;
+public:
+	LED2801Segment(LED2801 *, word, word); // strip, first pixel, number of pixels
+	void setColor(word, uint32_t);
+	void setColor(uint32_t);
+	void setAllColor(uint32_t);
+	byte *getPtr();
+	word getPixelCount();
+	void send();
+};
 #endif //__LED2801_h_
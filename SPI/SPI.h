@@ -33,9 +33,57 @@
 #define SPI_CLOCK_MASK 0x03  // SPR1 = bit 1, SPR0 = bit 0 on SPCR
 #define SPI_2XCLOCK_MASK 0x01  // SPI2X = bit 0 on SPSR
 
+// SPI_HAS_TRANSACTION means SPI has beginTransaction(), endTransaction()
+// and SPISettings
+#define SPI_HAS_TRANSACTION 1
+
+// Clock, bit order and data mode of one device on the bus. The register
+// values are worked out when the settings are made, so beginTransaction()
+// only has to copy them.
+class SPISettings {
+public:
+  SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) {
+    init(clock, bitOrder, dataMode);
+  }
+  SPISettings() {
+    init(4000000, MSBFIRST, SPI_MODE0);
+  }
+private:
+  void init(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) {
+    // Find the fastest clock that is not faster than the one asked for,
+    // 0 = F_CPU/2 up to 6 = F_CPU/128
+    uint32_t rate = F_CPU / 2;
+    uint8_t clockDiv = 0;
+    while (clockDiv < 6 && clock < rate) {
+      rate >>= 1;
+      clockDiv++;
+    }
+    // F_CPU/64 with SPI2X is the same as F_CPU/128 without it
+    if (clockDiv == 6)
+      clockDiv = 7;
+    // SPI2X is set for the odd powers of two, so invert it
+    clockDiv ^= 0x1;
+
+    spcr = _BV(SPE) | _BV(MSTR) | ((bitOrder == LSBFIRST) ? _BV(DORD) : 0) |
+      (dataMode & SPI_MODE_MASK) | ((clockDiv >> 1) & SPI_CLOCK_MASK);
+    spsr = clockDiv & SPI_2XCLOCK_MASK;
+  }
+  uint8_t spcr;
+  uint8_t spsr;
+  friend class SPIClass;
+};
+
 class SPIClass {
 public:
   inline static byte transfer(byte _data);
+  inline static uint16_t transfer16(uint16_t _data);
+  inline static void transfer(void *_buf, size_t _count);
+  inline static void writeBytes(const void *_buf, size_t _count);
+
+  // Set the bus up for one device, call before selecting it
+  inline static void beginTransaction(SPISettings settings);
+  // Call after the device is deselected
+  inline static void endTransaction();
 
   // SPI Configuration methods
 
@@ -59,6 +107,66 @@ byte SPIClass::transfer(byte _data) {
   return SPDR;
 }
 
+// Sends the high byte first for MSBFIRST, the low byte first for LSBFIRST
+uint16_t SPIClass::transfer16(uint16_t _data) {
+  union { uint16_t val; struct { uint8_t lsb; uint8_t msb; }; } in, out;
+  in.val = _data;
+  if (!(SPCR & _BV(DORD))) {
+    out.msb = transfer(in.msb);
+    out.lsb = transfer(in.lsb);
+  } else {
+    out.lsb = transfer(in.lsb);
+    out.msb = transfer(in.msb);
+  }
+  return out.val;
+}
+
+// Full duplex transfer of a block, the data received replaces the data sent.
+// The next byte is fetched while the current one is shifting, so the bus
+// is only idle for the few cycles it takes to reload SPDR.
+void SPIClass::transfer(void *_buf, size_t _count) {
+  if (_count == 0)
+    return;
+  uint8_t *p = (uint8_t *)_buf;
+  SPDR = *p;
+  while (--_count > 0) {
+    uint8_t out = *(p + 1);
+    while (!(SPSR & _BV(SPIF)))
+      ;
+    uint8_t in = SPDR;
+    SPDR = out;
+    *p++ = in;
+  }
+  while (!(SPSR & _BV(SPIF)))
+    ;
+  *p = SPDR;
+}
+
+// Write only block transfer, the data received is thrown away
+void SPIClass::writeBytes(const void *_buf, size_t _count) {
+  if (_count == 0)
+    return;
+  const uint8_t *p = (const uint8_t *)_buf;
+  SPDR = *p++;
+  while (--_count > 0) {
+    uint8_t out = *p++;
+    while (!(SPSR & _BV(SPIF)))
+      ;
+    SPDR = out;
+  }
+  while (!(SPSR & _BV(SPIF)))
+    ;
+  SPDR; // clears SPIF
+}
+
+void SPIClass::beginTransaction(SPISettings settings) {
+  SPCR = settings.spcr;
+  SPSR = settings.spsr;
+}
+
+void SPIClass::endTransaction() {
+}
+
 void SPIClass::attachInterrupt() {
   SPCR |= _BV(SPIE);
 }
@@ -43,6 +43,12 @@ http://arduiniana.org.
 #include <Arduino.h>
 #include "SegSerial.h"
 #include <util/delay_basic.h>
+#include <stdlib.h>
+
+//
+// Statics
+//
+SegSerial * volatile SegSerial::tx_object = NULL;
 
 //
 // Debugging
@@ -75,6 +81,86 @@ inline void SegSerial::tunedDelay(uint16_t delay) {
   _delay_loop_2(delay);
 }
 
+/* static */
+inline void SegSerial::handle_tx_interrupt()
+{
+  SegSerial *p = tx_object;
+  if (p == NULL)
+    return;
+
+  volatile uint8_t *reg = p->_transmitPortRegister;
+  uint8_t reg_mask = p->_transmitBitMask;
+  bool inv = p->_inverse_logic;
+
+  // Data bits
+  if (p->_tx_bit < 8)
+  {
+    if (p->_tx_byte & 1)
+      *reg |= reg_mask;
+    else
+      *reg &= ~reg_mask;
+    p->_tx_byte >>= 1;
+    p->_tx_bit++;
+    return;
+  }
+
+  // Stop bit
+  if (p->_tx_bit == 8)
+  {
+    if (inv)
+      *reg &= ~reg_mask;
+    else
+      *reg |= reg_mask;
+    p->_tx_bit++;
+    return;
+  }
+
+  // The last stop bit is done, start the next byte
+  uint8_t tail = p->_tx_tail;
+  if (p->_tx_head == tail)
+  {
+    stopTx();
+    return;
+  }
+  uint8_t b = p->_tx_buffer[tail];
+  if (++tail == p->_tx_size)
+    tail = 0;
+  p->_tx_tail = tail;
+
+  if (p->_tx_bytemode)
+  {
+    // Too fast for one bit per interrupt, send the whole frame now
+    p->sendFrame(b);
+    return;
+  }
+
+  p->_tx_byte = inv ? ~b : b;
+  // Start bit
+  if (inv)
+    *reg |= reg_mask;
+  else
+    *reg &= ~reg_mask;
+  p->_tx_bit = 0;
+}
+
+#if defined(SEGSERIAL_TX_TIMER)
+ISR(TIMER2_COMPA_vect)
+{
+  SegSerial::handle_tx_interrupt();
+}
+
+// Runs the transmit interrupt by hand when interrupts are off, so that
+// waiting for the transmitter can't lock up
+static inline void pollTx()
+{
+  if (bit_is_clear(SREG, SREG_I) && bit_is_set(TIFR2, OCF2A))
+  {
+    TIFR2 = _BV(OCF2A);
+    SegSerial::handle_tx_interrupt();
+  }
+}
+#endif
+
 #if GCC_VERSION < 40302
 // Work-around for avr-gcc 4.3.0 OSX version bug
 // Restore the registers that the compiler misses
@@ -93,7 +179,14 @@ inline void SegSerial::tunedDelay(uint16_t delay) {
 SegSerial::SegSerial(uint8_t transmitPin, bool inverse_logic /* = false */) :
 		_tx_delay(0),
 		_buffer_overflow(false),
-		_inverse_logic(inverse_logic)
+		_inverse_logic(inverse_logic),
+		_tx_buffer(NULL),
+		_tx_size(0),
+		_tx_head(0),
+		_tx_tail(0),
+		_tx_bit(9),
+		_tx_clock(0),
+		_tx_complete(NULL)
 {
 		Serial.begin(250000);
 		setTX(transmitPin);
@@ -103,7 +196,14 @@ SegSerial::SegSerial(uint8_t transmitPin, bool inverse_logic /* = false */) :
 SegSerial::SegSerial():
 	_tx_delay(0),
 	_buffer_overflow(false),
-	_inverse_logic(false)
+	_inverse_logic(false),
+	_tx_buffer(NULL),
+	_tx_size(0),
+	_tx_head(0),
+	_tx_tail(0),
+	_tx_bit(9),
+	_tx_clock(0),
+	_tx_complete(NULL)
 {
 	Serial.begin(9600);
 }
@@ -112,6 +212,8 @@ SegSerial::SegSerial():
 SegSerial::~SegSerial()
 {
   //end();
+  flush();
+  free(_tx_buffer);
 }
 
 void SegSerial::setTX(uint8_t tx)
@@ -132,6 +234,43 @@ uint8_t SegSerial::getTxPin(){
 	return txPin;
 }
 
+// Starts the transmit interrupt if it isn't running, the first bit or
+// byte is sent straight away
+void SegSerial::startTx()
+{
+#if defined(SEGSERIAL_TX_TIMER)
+  uint8_t oldSREG = SREG;
+  cli();
+  if (tx_object == NULL && _tx_head != _tx_tail)
+  {
+    tx_object = this;
+    _tx_bit = 9;
+    TCCR2B = 0;
+    TCCR2A = _BV(WGM21); // CTC
+    OCR2A = _tx_ocr;
+    TCNT2 = 0;
+    TIFR2 = _BV(OCF2A);
+    TIMSK2 |= _BV(OCIE2A);
+    TCCR2B = _tx_clock;
+    handle_tx_interrupt();
+  }
+  SREG = oldSREG;
+#endif
+}
+
+/* static */
+void SegSerial::stopTx()
+{
+#if defined(SEGSERIAL_TX_TIMER)
+  SegSerial *p = tx_object;
+  TIMSK2 &= ~_BV(OCIE2A);
+  TCCR2B = 0;
+  tx_object = NULL;
+  if (p != NULL && p->_tx_complete != NULL)
+    (*p->_tx_complete)();
+#endif
+}
+
 uint16_t SegSerial::subtract_cap(uint16_t num, uint16_t sub) {
   if (num > sub)
     return num - sub;
@@ -146,25 +285,129 @@ uint16_t SegSerial::subtract_cap(uint16_t num, uint16_t sub) {
 void SegSerial::begin(long speed){
   _tx_delay = 0;
 
-  // Precalculate the various delays, in number of 4-cycle delays
-  uint16_t bit_delay = (F_CPU / speed) / 4;
+  // Precalculate the various delays, in number of 4-cycle delays. Rounded to
+  // the nearest, truncating made the bits 2% short at 115200
+  uint16_t bit_delay = (F_CPU / speed + 2) / 4;
 
   // These are all close enough to just use 15 cycles, since the inter-bit
   // timings are the most critical (deviations stack 8 times)
   _tx_delay = subtract_cap(bit_delay, 15 / 4);
 
+  // Timer2 settings for the transmit buffer. Send one bit per interrupt if
+  // there is time for it, otherwise one frame per byte slot
+  static const uint16_t prescale[] = {1, 8, 32, 64, 128, 256, 1024};
+  uint32_t cycles = F_CPU / speed;
+  _tx_bytemode = cycles < _SS_MIN_BIT_CYCLES;
+  if (_tx_bytemode)
+    cycles *= _SS_BYTE_SLOT_BITS;
+  _tx_clock = 0; // too slow for the timer, writes will block
+  for (uint8_t i = 0; i < 7; i++)
+  {
+    uint32_t ticks = (cycles + prescale[i] / 2) / prescale[i];
+    if (ticks <= 256)
+    {
+      _tx_ocr = ticks - 1;
+      _tx_clock = i + 1; // CS22:0
+      break;
+    }
+  }
+
 #if _DEBUG
   pinMode(_DEBUG_PIN1, OUTPUT);
   pinMode(_DEBUG_PIN2, OUTPUT);
 #endif
 }
 
+// Sets the size of the transmit buffer in bytes, 0 (the default) to send
+// each byte as it is written. Returns false if there is no timer for it (built
+// without SEGSERIAL_TX_TIMER) or no memory for the buffer, the writes then
+// block as they do without a buffer.
+// Above 40000 baud (16 MHz) the buffer only saves the sketch from waiting for
+// the buffer to drain, not the CPU time of sending: each byte is sent whole
+// from the interrupt with interrupts off (40 us at 250000 baud), and the
+// frames go out one per 20 bit byte slot, so the throughput is half the baud
+// rate. At those rates a blocking write of a frame is faster overall.
+bool SegSerial::setTxBuffer(uint8_t size)
+{
+  flush();
+  free(_tx_buffer);
+  _tx_buffer = NULL;
+  _tx_size = 0;
+  _tx_head = 0;
+  _tx_tail = 0;
+  if (size == 0)
+    return true;
+#if defined(SEGSERIAL_TX_TIMER)
+  if (size == 0xFF)
+    size = 0xFE;
+  // One slot is always left empty to tell a full buffer from an empty one
+  _tx_buffer = (uint8_t *)calloc(size + 1, sizeof(uint8_t));
+  if (_tx_buffer == NULL)
+    return false;
+  _tx_size = size + 1;
+  return true;
+#else
+  return false;
+#endif
+}
+
+// Number of bytes that can be written without waiting, 0 without a buffer
+int SegSerial::availableForWrite()
+{
+  if (_tx_buffer == NULL)
+    return 0;
+  int n = (int)_tx_tail - _tx_head - 1;
+  if (n < 0)
+    n += _tx_size;
+  return n;
+}
+
+// Waits for the buffer to empty and the last stop bit to finish
+void SegSerial::flush()
+{
+#if defined(SEGSERIAL_TX_TIMER)
+  while (tx_object == this)
+    pollTx();
+#endif
+}
+
+// The function is called from the interrupt when the last byte in the buffer
+// has been sent, keep it short
+void SegSerial::attachTxComplete(void (*function)(void))
+{
+  _tx_complete = function;
+}
+
 size_t SegSerial::write(uint8_t b){
   if (_tx_delay == 0) {
     setWriteError();
     return 0;
   }
 
+#if defined(SEGSERIAL_TX_TIMER)
+  if (_tx_buffer != NULL && _tx_clock != 0)
+  {
+    // Only one instance can use the timer at a time
+    while (tx_object != NULL && tx_object != this)
+      pollTx();
+
+    uint8_t next = _tx_head + 1;
+    if (next == _tx_size)
+      next = 0;
+    while (next == _tx_tail)
+      pollTx();
+    _tx_buffer[_tx_head] = b;
+    _tx_head = next;
+    startTx();
+    return 1;
+  }
+#endif
+
+  sendFrame(b);
+  return 1;
+}
+
+void SegSerial::sendFrame(uint8_t b){
   // By declaring these as local variables, the compiler will put them
   // in registers _before_ disabling interrupts and entering the
   // critical timing sections below, which makes it a lot easier to
@@ -209,6 +452,5 @@ size_t SegSerial::write(uint8_t b){
 
   SREG = oldSREG; // turn interrupts back on
   tunedDelay(_tx_delay);
-  return 1;
 }
 
@@ -44,6 +44,22 @@ http://arduiniana.org.
 #define GCC_VERSION (__GNUC__ * 10000 + __GNUC_MINOR__ * 100 + __GNUC_PATCHLEVEL__)
 #endif
 
+// Buffered transmit runs from the Timer2 compare A interrupt, which tone() and
+// other libraries also use. It is only built when SEGSERIAL_TX_TIMER is
+// defined in the build flags (-DSEGSERIAL_TX_TIMER), else setTxBuffer() fails
+// and every write waits for its byte.
+#if defined(SEGSERIAL_TX_TIMER) && !defined(TIMER2_COMPA_vect)
+#undef SEGSERIAL_TX_TIMER
+#endif
+
+// Bit times shorter than this are too short to send one bit per interrupt,
+// each interrupt sends a whole byte instead
+#define _SS_MIN_BIT_CYCLES 400
+// Length of one byte slot in byte mode, in bit times. The frame takes 10
+// with interrupts off, the other 10 are left for the sketch, so buffered
+// writes in byte mode run at half the baud rate
+#define _SS_BYTE_SLOT_BITS 20
+
 class SegSerial : public Print{
 private:
   // per object data
@@ -72,6 +88,26 @@ private:
 
   uint8_t txPin;
 
+  // transmit buffer, empty when _tx_head == _tx_tail
+  uint8_t *_tx_buffer;
+  uint8_t _tx_size;
+  volatile uint8_t _tx_head;
+  volatile uint8_t _tx_tail;
+  // bit being sent by the interrupt, 0-7 data, 8 stop, 9 stop complete
+  volatile uint8_t _tx_bit;
+  uint8_t _tx_byte;
+  // Timer2 settings calculated by begin()
+  uint8_t _tx_ocr;
+  uint8_t _tx_clock;
+  bool _tx_bytemode;
+  void (*_tx_complete)(void);
+
+  static SegSerial * volatile tx_object;
+
+  void sendFrame(uint8_t b);
+  void startTx();
+  static void stopTx();
+
 public:
   // public methods
   SegSerial(uint8_t transmitPin, bool inverse_logic = false);
@@ -84,11 +120,17 @@ public:
   operator bool() { return true; }
   void setTX(uint8_t transmitPin);
   uint8_t getTxPin();
+  bool setTxBuffer(uint8_t size);
+  virtual int availableForWrite();
+  virtual void flush();
+  void attachTxComplete(void (*function)(void));
+  bool isSending() { return tx_object == this; }
   
   using Print::write;
 
   // public only for easy access by interrupt handlers
   static inline void handle_interrupt() __attribute__((__always_inline__));
+  static inline void handle_tx_interrupt() __attribute__((__always_inline__));
 };
 
 // Arduino 0012 workaround
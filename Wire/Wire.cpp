@@ -292,6 +292,31 @@ void TwoWire::onRequest( void (*function)(void) )
   user_onRequest = function;
 }
 
+// starts a master transfer without waiting for it, the transfer's
+// callback is called from the interrupt when it is done
+uint8_t TwoWire::queueTransfer(twi_transfer* transfer)
+{
+  return twi_queueTransfer(transfer);
+}
+
+// true if no queued transfers are running or waiting
+uint8_t TwoWire::isIdle(void)
+{
+  return twi_isIdle();
+}
+
+// sets how long the bus can stall before it is reset, in ms (0 to wait forever)
+void TwoWire::setBusTimeout(uint16_t timeout)
+{
+  twi_setTimeout(timeout);
+}
+
+// checks for a stalled bus, call from loop() when using queueTransfer()
+void TwoWire::poll(void)
+{
+  twi_poll();
+}
+
 // Preinstantiate Objects //////////////////////////////////////////////////////
 
 TwoWire Wire = TwoWire();
@@ -24,8 +24,17 @@
 
 #include <inttypes.h>
 #include "Stream.h"
+extern "C" {
+  #include "utility/twi.h"
+}
 
-#define BUFFER_LENGTH 32
+// Set TWI_BUFFER_LENGTH in the build flags to change both buffers
+#ifndef BUFFER_LENGTH
+#define BUFFER_LENGTH TWI_BUFFER_LENGTH
+#endif
+#if BUFFER_LENGTH > TWI_BUFFER_LENGTH
+#error BUFFER_LENGTH can not be longer than TWI_BUFFER_LENGTH
+#endif
 
 class TwoWire : public Stream
 {
@@ -65,6 +74,10 @@ class TwoWire : public Stream
 	virtual void flush(void);
     void onReceive( void (*)(int) );
     void onRequest( void (*)(void) );
+    uint8_t queueTransfer(twi_transfer*);
+    uint8_t isIdle(void);
+    void setBusTimeout(uint16_t);
+    void poll(void);
   
     inline size_t write(unsigned long n) { return write((uint8_t)n); }
     inline size_t write(long n) { return write((uint8_t)n); }
@@ -17,6 +17,8 @@
   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
   Modified 2012 by Todd Krein (todd@krein.org) to implement repeated starts
+  Modified 10/2026 to run master transfers from a queue, with a timeout
+  Modified 10/2026 to reset a stuck bus from twi_poll() instead of the ISR
 */
 
 #include <math.h>
@@ -48,7 +50,18 @@ static void (*twi_onSlaveReceive)(uint8_t*, int);
 
 static uint8_t twi_masterBuffer[TWI_BUFFER_LENGTH];
 static volatile uint8_t twi_masterBufferIndex;
-static volatile uint8_t twi_masterBufferLength;
+
+// master transfers, twi_current is on the bus and twi_head is next
+static twi_transfer* volatile twi_current;
+static twi_transfer* volatile twi_head;
+static twi_transfer* volatile twi_tail;
+// transfer used by twi_readFrom and twi_writeTo
+static twi_transfer twi_blocking;
+static uint8_t twi_blockingStop;
+
+static uint16_t twi_timeout = TWI_TIMEOUT;
+static volatile unsigned long twi_activity;	// millis() when the bus last made progress
+static volatile uint8_t twi_stuck;		// a stop did not complete, twi_poll() resets the bus
 
 static uint8_t twi_txBuffer[TWI_BUFFER_LENGTH];
 static volatile uint8_t twi_txBufferIndex;
@@ -57,7 +70,11 @@ static volatile uint8_t twi_txBufferLength;
 static uint8_t twi_rxBuffer[TWI_BUFFER_LENGTH];
 static volatile uint8_t twi_rxBufferIndex;
 
-static volatile uint8_t twi_error;
+static void twi_startNext(void);
+static void twi_endTransfer(void);
+static void twi_finish(uint8_t);
+static void twi_recover(void);
+static uint8_t twi_waitBlocking(void);
 
 /* 
  * Function twi_init
@@ -114,64 +131,27 @@ void twi_setAddress(uint8_t address)
  */
 uint8_t twi_readFrom(uint8_t address, uint8_t* data, uint8_t length, uint8_t sendStop)
 {
-  uint8_t i;
-
   // ensure data will fit into buffer
-  if(TWI_BUFFER_LENGTH < length){
+  if(TWI_BUFFER_LENGTH < length || 0 == length){
     return 0;
   }
 
-  // wait until twi is ready, become master receiver
-  while(TWI_READY != twi_state){
-    continue;
-  }
-  twi_state = TWI_MRX;
-  twi_sendStop = sendStop;
-  // reset error state (0xFF.. no error occured)
-  twi_error = 0xFF;
-
-  // initialize buffer iteration vars
-  twi_masterBufferIndex = 0;
-  twi_masterBufferLength = length-1;  // This is not intuitive, read on...
-  // On receive, the previously configured ACK/NACK setting is transmitted in
-  // response to the received byte before the interrupt is signalled. 
-  // Therefor we must actually set NACK when the _next_ to last byte is
-  // received, causing that NACK to be sent in response to receiving the last
-  // expected byte of data.
+  // wait for a write that didn't wait to finish
+  twi_waitBlocking();
 
-  // build sla+w, slave device address + w bit
-  twi_slarw = TW_READ;
-  twi_slarw |= address << 1;
-
-  if (true == twi_inRepStart) {
-    // if we're in the repeated start state, then we've already sent the start,
-    // (@@@ we hope), and the TWI statemachine is just waiting for the address byte.
-    // We need to remove ourselves from the repeated start state before we enable interrupts,
-    // since the ISR is ASYNC, and we could get confused if we hit the ISR before cleaning
-    // up. Also, don't enable the START interrupt. There may be one pending from the 
-    // repeated start that we sent outselves, and that would really confuse things.
-    twi_inRepStart = false;			// remember, we're dealing with an ASYNC ISR
-    TWDR = twi_slarw;
-    TWCR = _BV(TWINT) | _BV(TWEA) | _BV(TWEN) | _BV(TWIE);	// enable INTs, but not START
-  }
-  else
-    // send start condition
-    TWCR = _BV(TWEN) | _BV(TWIE) | _BV(TWEA) | _BV(TWINT) | _BV(TWSTA);
+  // the data is read straight into the caller's array
+  twi_blocking.address = address;
+  twi_blocking.txLength = 0;
+  twi_blocking.rxData = data;
+  twi_blocking.rxLength = length;
+  twi_blocking.callback = NULL;
+  twi_blockingStop = sendStop;
+  twi_queueTransfer(&twi_blocking);
 
   // wait for read operation to complete
-  while(TWI_MRX == twi_state){
-    continue;
-  }
+  twi_waitBlocking();
 
-  if (twi_masterBufferIndex < length)
-    length = twi_masterBufferIndex;
-
-  // copy twi buffer to data
-  for(i = 0; i < length; ++i){
-    data[i] = twi_masterBuffer[i];
-  }
-	
-  return length;
+  return twi_blocking.rxCount;
 }
 
 /* 
@@ -198,31 +178,184 @@ uint8_t twi_writeTo(uint8_t address, uint8_t* data, uint8_t length, uint8_t wait
     return 1;
   }
 
-  // wait until twi is ready, become master transmitter
-  while(TWI_READY != twi_state){
-    continue;
-  }
-  twi_state = TWI_MTX;
-  twi_sendStop = sendStop;
-  // reset error state (0xFF.. no error occured)
-  twi_error = 0xFF;
+  // wait for a write that didn't wait to finish, it uses the buffer
+  twi_waitBlocking();
 
-  // initialize buffer iteration vars
-  twi_masterBufferIndex = 0;
-  twi_masterBufferLength = length;
-  
   // copy data to twi buffer
   for(i = 0; i < length; ++i){
     twi_masterBuffer[i] = data[i];
   }
-  
-  // build sla+w, slave device address + w bit
-  twi_slarw = TW_WRITE;
-  twi_slarw |= address << 1;
-  
-  // if we're in a repeated start, then we've already sent the START
-  // in the ISR. Don't do it again.
-  //
+
+  twi_blocking.address = address;
+  twi_blocking.txData = twi_masterBuffer;
+  twi_blocking.txLength = length;
+  twi_blocking.rxLength = 0;
+  twi_blocking.callback = NULL;
+  twi_blockingStop = sendStop;
+  twi_queueTransfer(&twi_blocking);
+
+  if (!wait)
+    return 0;
+
+  // wait for write operation to complete
+  return twi_waitBlocking();
+}
+
+/* 
+ * Function twi_waitBlocking
+ * Desc     waits for the transfer used by twi_readFrom and twi_writeTo,
+ *          resetting the bus if it stops making progress
+ * Input    none
+ * Output   status of the transfer
+ */
+static uint8_t twi_waitBlocking(void)
+{
+  while(TWI_PENDING == twi_blocking.status){
+    twi_poll();
+  }
+  return twi_blocking.status;
+}
+
+/* 
+ * Function twi_queueTransfer
+ * Desc     adds a master transfer to the queue, it is started by the
+ *          interrupt as soon as the bus is free. The callback is called
+ *          from the interrupt when it is complete.
+ * Input    transfer: the transfer, see twi_transfer in twi.h
+ * Output   1 .. added
+ *          0 .. already in the queue
+ */
+uint8_t twi_queueTransfer(twi_transfer* transfer)
+{
+  twi_transfer* p;
+  uint8_t oldSREG = SREG;
+  cli();
+  if(transfer == twi_current){
+    SREG = oldSREG;
+    return 0;
+  }
+  for(p = twi_head; p != NULL; p = p->next){
+    if(p == transfer){
+      SREG = oldSREG;
+      return 0;
+    }
+  }
+
+  transfer->status = TWI_PENDING;
+  transfer->rxCount = 0;
+  if(NULL == twi_head && NULL == twi_current){
+    twi_activity = millis();
+  }
+  if(transfer == &twi_blocking){
+    // the blocking calls go first so that a repeated start isn't split
+    transfer->next = twi_head;
+    twi_head = transfer;
+    if(NULL == twi_tail){
+      twi_tail = transfer;
+    }
+  }else{
+    transfer->next = NULL;
+    if(NULL == twi_tail){
+      twi_head = transfer;
+    }else{
+      twi_tail->next = transfer;
+    }
+    twi_tail = transfer;
+  }
+  twi_startNext();
+  SREG = oldSREG;
+  return 1;
+}
+
+/* 
+ * Function twi_isIdle
+ * Desc     checks for queued master transfers
+ * Input    none
+ * Output   1 if there are none running or waiting
+ */
+uint8_t twi_isIdle(void)
+{
+  return (NULL == twi_current) && (NULL == twi_head);
+}
+
+/* 
+ * Function twi_setTimeout
+ * Desc     sets how long the bus can go without progress during a master
+ *          transfer before it is reset
+ * Input    timeout: time in ms, 0 to wait forever
+ * Output   none
+ */
+void twi_setTimeout(uint16_t timeout)
+{
+  twi_timeout = timeout;
+}
+
+/* 
+ * Function twi_poll
+ * Desc     resets the bus if a stop got stuck or the running transfer has
+ *          timed out, and fails that transfer. Call from loop() when using
+ *          twi_queueTransfer, the blocking functions call it while they wait.
+ * Input    none
+ * Output   none
+ */
+void twi_poll(void)
+{
+  uint8_t oldSREG = SREG;
+
+  cli();
+  if(twi_stuck || (0 != twi_timeout && (NULL != twi_current || NULL != twi_head) &&
+                   (millis() - twi_activity) >= twi_timeout)){
+    twi_stuck = false;
+    twi_recover();
+    twi_activity = millis();
+    if(NULL != twi_current){
+      twi_finish(TWI_ERROR_TIMEOUT);
+    }else{
+      twi_startNext();
+    }
+  }
+  SREG = oldSREG;
+}
+
+/* 
+ * Function twi_startNext
+ * Desc     starts the transfer at the head of the queue if the bus is free,
+ *          interrupts must be off
+ * Input    none
+ * Output   none
+ */
+static void twi_startNext(void)
+{
+  twi_transfer* t = twi_head;
+
+  if(NULL == t || NULL != twi_current || TWI_READY != twi_state || twi_stuck){
+    return;
+  }
+  // the bus is held for a repeated start by the blocking calls
+  if(twi_inRepStart && t != &twi_blocking){
+    return;
+  }
+
+  twi_head = t->next;
+  if(NULL == twi_head){
+    twi_tail = NULL;
+  }
+  t->next = NULL;
+  twi_current = t;
+  twi_sendStop = (t == &twi_blocking) ? twi_blockingStop : true;
+  twi_masterBufferIndex = 0;
+  twi_activity = millis();
+
+  // build sla+r/w, read only if there is nothing to write
+  if(0 == t->txLength && 0 != t->rxLength){
+    twi_state = TWI_MRX;
+    twi_slarw = TW_READ;
+  }else{
+    twi_state = TWI_MTX;
+    twi_slarw = TW_WRITE;
+  }
+  twi_slarw |= t->address << 1;
+
   if (true == twi_inRepStart) {
     // if we're in the repeated start state, then we've already sent the start,
     // (@@@ we hope), and the TWI statemachine is just waiting for the address byte.
@@ -231,26 +364,95 @@ uint8_t twi_writeTo(uint8_t address, uint8_t* data, uint8_t length, uint8_t wait
     // up. Also, don't enable the START interrupt. There may be one pending from the 
     // repeated start that we sent outselves, and that would really confuse things.
     twi_inRepStart = false;			// remember, we're dealing with an ASYNC ISR
-    TWDR = twi_slarw;				
+    TWDR = twi_slarw;
     TWCR = _BV(TWINT) | _BV(TWEA) | _BV(TWEN) | _BV(TWIE);	// enable INTs, but not START
   }
   else
     // send start condition
     TWCR = _BV(TWINT) | _BV(TWEA) | _BV(TWEN) | _BV(TWIE) | _BV(TWSTA);	// enable INTs
+}
 
-  // wait for write operation to complete
-  while(wait && (TWI_MTX == twi_state)){
-    continue;
+/* 
+ * Function twi_endTransfer
+ * Desc     ends a master transfer that completed, with a stop or by holding
+ *          the bus for a repeated start
+ * Input    none
+ * Output   none
+ */
+static void twi_endTransfer(void)
+{
+  if (twi_sendStop)
+    twi_stop();
+  else {
+    twi_inRepStart = true;	// we're gonna send the START
+    // don't enable the interrupt. We'll generate the start, but we 
+    // avoid handling the interrupt until we're in the next transaction,
+    // at the point where we would normally issue the start.
+    TWCR = _BV(TWINT) | _BV(TWSTA)| _BV(TWEN) ;
+    twi_state = TWI_READY;
   }
-  
-  if (twi_error == 0xFF)
-    return 0;	// success
-  else if (twi_error == TW_MT_SLA_NACK)
-    return 2;	// error: address send, nack received
-  else if (twi_error == TW_MT_DATA_NACK)
-    return 3;	// error: data send, nack received
-  else
-    return 4;	// other twi error
+  twi_finish(TWI_OK);
+}
+
+/* 
+ * Function twi_finish
+ * Desc     reports the result of the running master transfer and starts
+ *          the next one
+ * Input    status: TWI_OK or TWI_ERROR_*
+ * Output   none
+ */
+static void twi_finish(uint8_t status)
+{
+  twi_transfer* t = twi_current;
+
+  if(NULL == t){
+    return;
+  }
+  twi_current = NULL;
+  t->status = status;
+  if(NULL != t->callback){
+    t->callback(t);
+  }
+  twi_startNext();
+}
+
+/* 
+ * Function twi_recover
+ * Desc     resets the twi module, clocks SCL until a device that is
+ *          holding SDA low lets go of it and sends a stop
+ * Input    none
+ * Output   none
+ */
+static void twi_recover(void)
+{
+  uint8_t i;
+
+  TWCR = 0;
+  twi_inRepStart = false;
+  pinMode(SDA, INPUT);
+  digitalWrite(SDA, 1);
+  for(i = 0; i < 9 && !digitalRead(SDA); ++i){
+    pinMode(SCL, OUTPUT);
+    digitalWrite(SCL, 0);
+    delayMicroseconds(5);
+    pinMode(SCL, INPUT);
+    digitalWrite(SCL, 1);
+    delayMicroseconds(5);
+  }
+
+  // stop condition, SDA goes low while SCL is low and rises while it is high
+  digitalWrite(SCL, 0);
+  pinMode(SCL, OUTPUT);
+  digitalWrite(SDA, 0);
+  pinMode(SDA, OUTPUT);
+  delayMicroseconds(5);
+  pinMode(SCL, INPUT);
+  digitalWrite(SCL, 1);
+  delayMicroseconds(5);
+  pinMode(SDA, INPUT);
+  digitalWrite(SDA, 1);
+  delayMicroseconds(5);
+  twi_init();
 }
 
 /* 
@@ -332,13 +534,21 @@ void twi_reply(uint8_t ack)
  */
 void twi_stop(void)
 {
+  // a stop takes one SCL period, 16 + 2 * TWBR cycles, and a pass of the
+  // loop takes more than two
+  uint16_t n = TWBR + 16;
+
   // send stop condition
   TWCR = _BV(TWEN) | _BV(TWIE) | _BV(TWEA) | _BV(TWINT) | _BV(TWSTO);
 
   // wait for stop condition to be exectued on bus
   // TWINT is not set after a stop condition!
   while(TWCR & _BV(TWSTO)){
-    continue;
+    // something is holding SCL low, leave the reset to twi_poll()
+    if(0 == --n){
+      twi_stuck = true;
+      return;
+    }
   }
 
   // update twi state
@@ -362,6 +572,9 @@ void twi_releaseBus(void)
 
 ISR(TWI_vect)
 {
+  twi_transfer* t = twi_current;
+
+  twi_activity = millis();
   switch(TW_STATUS){
     // All Master
     case TW_START:     // sent start condition
@@ -375,43 +588,45 @@ ISR(TWI_vect)
     case TW_MT_SLA_ACK:  // slave receiver acked address
     case TW_MT_DATA_ACK: // slave receiver acked data
       // if there is data to send, send it, otherwise stop 
-      if(twi_masterBufferIndex < twi_masterBufferLength){
+      if(twi_masterBufferIndex < t->txLength){
         // copy data to output register and ack
-        TWDR = twi_masterBuffer[twi_masterBufferIndex++];
+        TWDR = t->txData[twi_masterBufferIndex++];
         twi_reply(1);
+      }else if(0 != t->rxLength){
+        // repeated start to read the reply
+        twi_state = TWI_MRX;
+        twi_slarw = TW_READ | (t->address << 1);
+        twi_masterBufferIndex = 0;
+        TWCR = _BV(TWINT) | _BV(TWEA) | _BV(TWEN) | _BV(TWIE) | _BV(TWSTA);
       }else{
-	if (twi_sendStop)
-          twi_stop();
-	else {
-	  twi_inRepStart = true;	// we're gonna send the START
-	  // don't enable the interrupt. We'll generate the start, but we 
-	  // avoid handling the interrupt until we're in the next transaction,
-	  // at the point where we would normally issue the start.
-	  TWCR = _BV(TWINT) | _BV(TWSTA)| _BV(TWEN) ;
-	  twi_state = TWI_READY;
-	}
+        twi_endTransfer();
       }
       break;
     case TW_MT_SLA_NACK:  // address sent, nack received
-      twi_error = TW_MT_SLA_NACK;
       twi_stop();
+      twi_finish(TWI_ERROR_ADDR_NACK);
       break;
     case TW_MT_DATA_NACK: // data sent, nack received
-      twi_error = TW_MT_DATA_NACK;
       twi_stop();
+      twi_finish(TWI_ERROR_DATA_NACK);
       break;
     case TW_MT_ARB_LOST: // lost bus arbitration
-      twi_error = TW_MT_ARB_LOST;
       twi_releaseBus();
+      twi_finish(TWI_ERROR_OTHER);
       break;
 
     // Master Receiver
     case TW_MR_DATA_ACK: // data received, ack sent
       // put byte into buffer
-      twi_masterBuffer[twi_masterBufferIndex++] = TWDR;
+      t->rxData[twi_masterBufferIndex++] = TWDR;
+      t->rxCount = twi_masterBufferIndex;
     case TW_MR_SLA_ACK:  // address sent, ack received
-      // ack if more bytes are expected, otherwise nack
-      if(twi_masterBufferIndex < twi_masterBufferLength){
+      // On receive, the previously configured ACK/NACK setting is transmitted in
+      // response to the received byte before the interrupt is signalled. 
+      // Therefor we must actually set NACK when the _next_ to last byte is
+      // received, causing that NACK to be sent in response to receiving the last
+      // expected byte of data.
+      if(twi_masterBufferIndex + 1 < t->rxLength){
         twi_reply(1);
       }else{
         twi_reply(0);
@@ -419,20 +634,13 @@ ISR(TWI_vect)
       break;
     case TW_MR_DATA_NACK: // data received, nack sent
       // put final byte into buffer
-      twi_masterBuffer[twi_masterBufferIndex++] = TWDR;
-	if (twi_sendStop)
-          twi_stop();
-	else {
-	  twi_inRepStart = true;	// we're gonna send the START
-	  // don't enable the interrupt. We'll generate the start, but we 
-	  // avoid handling the interrupt until we're in the next transaction,
-	  // at the point where we would normally issue the start.
-	  TWCR = _BV(TWINT) | _BV(TWSTA)| _BV(TWEN) ;
-	  twi_state = TWI_READY;
-	}    
-	break;
+      t->rxData[twi_masterBufferIndex++] = TWDR;
+      t->rxCount = twi_masterBufferIndex;
+      twi_endTransfer();
+      break;
     case TW_MR_SLA_NACK: // address sent, nack received
       twi_stop();
+      twi_finish(TWI_ERROR_ADDR_NACK);
       break;
     // TW_MR_ARB_LOST handled by TW_MT_ARB_LOST case
 
@@ -441,6 +649,8 @@ ISR(TWI_vect)
     case TW_SR_GCALL_ACK: // addressed generally, returned ack
     case TW_SR_ARB_LOST_SLA_ACK:   // lost arbitration, returned ack
     case TW_SR_ARB_LOST_GCALL_ACK: // lost arbitration, returned ack
+      // a master transfer that lost arbitration has failed
+      twi_finish(TWI_ERROR_OTHER);
       // enter slave receiver mode
       twi_state = TWI_SRX;
       // indicate that rx buffer can be overwritten and ack
@@ -472,6 +682,7 @@ ISR(TWI_vect)
       twi_rxBufferIndex = 0;
       // ack future responses and leave slave receiver state
       twi_releaseBus();
+      twi_startNext();
       break;
     case TW_SR_DATA_NACK:       // data received, returned nack
     case TW_SR_GCALL_DATA_NACK: // data received generally, returned nack
@@ -482,6 +693,8 @@ ISR(TWI_vect)
     // Slave Transmitter
     case TW_ST_SLA_ACK:          // addressed, returned ack
     case TW_ST_ARB_LOST_SLA_ACK: // arbitration lost, returned ack
+      // a master transfer that lost arbitration has failed
+      twi_finish(TWI_ERROR_OTHER);
       // enter slave transmitter mode
       twi_state = TWI_STX;
       // ready the tx buffer index for iteration
@@ -513,14 +726,15 @@ ISR(TWI_vect)
       twi_reply(1);
       // leave slave receiver state
       twi_state = TWI_READY;
+      twi_startNext();
       break;
 
     // All
     case TW_NO_INFO:   // no state information
       break;
     case TW_BUS_ERROR: // bus error, illegal stop/start
-      twi_error = TW_BUS_ERROR;
       twi_stop();
+      twi_finish(TWI_ERROR_OTHER);
       break;
   }
 }
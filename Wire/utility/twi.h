@@ -28,16 +28,52 @@
   #define TWI_FREQ 100000L
   #endif
 
+  // The buffer length can be changed in the build flags, e.g.
+  // -DTWI_BUFFER_LENGTH=64. Wire's BUFFER_LENGTH follows it.
   #ifndef TWI_BUFFER_LENGTH
   #define TWI_BUFFER_LENGTH 32
   #endif
+  #if TWI_BUFFER_LENGTH > 255
+  #error TWI_BUFFER_LENGTH must be 255 or less
+  #endif
+
+  // Default time the bus can go without any progress before it is reset, in ms
+  #ifndef TWI_TIMEOUT
+  #define TWI_TIMEOUT 25
+  #endif
 
   #define TWI_READY 0
   #define TWI_MRX   1
   #define TWI_MTX   2
   #define TWI_SRX   3
   #define TWI_STX   4
-  
+
+  // twi_transfer status
+  #define TWI_PENDING         0xFF
+  #define TWI_OK              0
+  #define TWI_ERROR_LENGTH    1
+  #define TWI_ERROR_ADDR_NACK 2
+  #define TWI_ERROR_DATA_NACK 3
+  #define TWI_ERROR_OTHER     4
+  #define TWI_ERROR_TIMEOUT   5
+
+  // A master transfer run by the interrupt. txLength bytes are written, then
+  // if rxLength is not 0 there is a repeated start and rxLength bytes are
+  // read. The transfer and its buffers belong to the caller and must not be
+  // touched until status is no longer TWI_PENDING.
+  typedef struct twi_transfer {
+    uint8_t address;
+    uint8_t* txData;
+    uint8_t txLength;
+    uint8_t* rxData;
+    uint8_t rxLength;
+    volatile uint8_t rxCount;  // bytes read
+    volatile uint8_t status;   // TWI_PENDING, TWI_OK or TWI_ERROR_*
+    void (*callback)(struct twi_transfer*);  // called from the interrupt, may be NULL
+    void* context;             // not used by twi, for the callback
+    struct twi_transfer* next;
+  } twi_transfer;
+
   void twi_init(void);
   void twi_setAddress(uint8_t);
   uint8_t twi_readFrom(uint8_t, uint8_t*, uint8_t, uint8_t);
@@ -48,6 +84,10 @@
   void twi_reply(uint8_t);
   void twi_stop(void);
   void twi_releaseBus(void);
+  uint8_t twi_queueTransfer(twi_transfer*);
+  uint8_t twi_isIdle(void);
+  void twi_setTimeout(uint16_t);
+  void twi_poll(void);
 
 #endif
 
@@ -12,6 +12,7 @@
  *                          Added getRemainingTime() to alarmClock and repeatAlarm
  * Rev 6 - Keegan Morrow -  Bugfix in alarmClock::poll() preventing the alarm from being set from the ringer function
  * Rev 7 - Keegan Morrow -	Added the ability to alarmClock to not call a function
+ * Rev 8 - Added alarmScheduler, alarmClock and repeatAlarm can be owned by a scheduler and polled together
  *
  */
 #include "alarmClock.h"
@@ -19,7 +20,7 @@
 /** Constructor
  * @param ringer Function pointer to the event handler funcion. Must be a function witout parameters or a return. This can also be set to NULL to just use the timer.
  */
-alarmClock::alarmClock(void (*ringer)(void))
+alarmClock::alarmClock(void (*ringer)(void)) : scheduledAlarm()
 {
 	this->ringer = ringer;
 	set = false;
@@ -28,7 +29,7 @@ alarmClock::alarmClock(void (*ringer)(void))
 /** Constructor
  * 
  */
-alarmClock::alarmClock()
+alarmClock::alarmClock() : scheduledAlarm()
 {
 	ringer = NULL;
 	set = false;
@@ -49,6 +50,7 @@ void alarmClock::setAlarm(unsigned long Time)
 {
 	setTime = Time + millis();
 	set = true;
+	reschedule();
 }
 
 /** Deactivates the timer.
@@ -57,6 +59,7 @@ void alarmClock::setAlarm(unsigned long Time)
 void alarmClock::unSetAlarm()
 {
 	set = false;
+	reschedule();
 }
 
 /** Polling function, this should be called as often as possible ( normally from loop() ).
@@ -65,9 +68,10 @@ void alarmClock::unSetAlarm()
  */
 boolean alarmClock::poll()
 {
-	if ((set == true) && (setTime <= millis()))
+	if ((set == true) && ((long)(millis() - setTime) >= 0)) // safe across the millis() rollover
 	{
 		set = false;
+		reschedule();
 		if (ringer != NULL) { (*ringer)(); }
 		return true;
 	}
@@ -79,22 +83,31 @@ boolean alarmClock::poll()
  */
 unsigned long alarmClock::getRemainingTime()
 {
-	unsigned long millisTemp = millis();
+	long remaining = (long)(setTime - millis());
 	if (!set)
 	{
 		return 0;
 	}
-	if (setTime > millisTemp)
-	{
-		return (setTime - millis());
-	}
-	return 0;
+	return (remaining > 0) ? remaining : 0;
+}
+
+/* Called by alarmScheduler::poll() */
+boolean alarmClock::isActive()
+{
+	return set;
+}
+
+/* Called by alarmScheduler::poll() */
+void alarmClock::expire(unsigned long)
+{
+	set = false;
+	if (ringer != NULL) { (*ringer)(); }
 }
 
 /** Constructor
  * @param ringer Function pointer to the event handler funcion. Must be a function witout parameters or a return.
  */
-repeatAlarm::repeatAlarm(void (*ringer)(void))
+repeatAlarm::repeatAlarm(void (*ringer)(void)) : scheduledAlarm()
 {
 	this->ringer = ringer;
 }
@@ -114,6 +127,7 @@ void repeatAlarm::setIntervalReset(unsigned long interval)
 {
 	this->interval = interval;
 	setTime = millis() + interval;
+	reschedule();
 }
 
 /** Reset the time remaining to the current interval time.
@@ -122,6 +136,7 @@ void repeatAlarm::setIntervalReset(unsigned long interval)
 void repeatAlarm::reset()
 {
 	setTime = millis() + interval;
+	reschedule();
 }
 
 /** Polling function, this should be called as often as possible ( normally from loop() ).
@@ -131,9 +146,10 @@ void repeatAlarm::reset()
 boolean repeatAlarm::poll()
 {
 	unsigned long millisTemp = millis();
-	if (setTime <= millisTemp)
+	if ((long)(millisTemp - setTime) >= 0)
 	{
 		setTime = interval + millisTemp;
+		reschedule();
 		(*ringer)();
 		return true;
 	}
@@ -145,12 +161,8 @@ boolean repeatAlarm::poll()
  */
 unsigned long repeatAlarm::getRemainingTime()
 {
-	unsigned long millisTemp = millis();
-	if (setTime > millisTemp)
-	{
-		return (setTime - millis());
-	}
-	return 0;
+	long remaining = (long)(setTime - millis());
+	return (remaining > 0) ? remaining : 0;
 }
 
 /** Gets the current interval time.
@@ -159,4 +171,170 @@ unsigned long repeatAlarm::getRemainingTime()
 unsigned long repeatAlarm::getInterval()
 {
 	return interval;
-}
\ No newline at end of file
+}
+/* Called by alarmScheduler::poll() */
+boolean repeatAlarm::isActive()
+{
+	return true;
+}
+
+/* Called by alarmScheduler::poll() */
+void repeatAlarm::expire(unsigned long now)
+{
+	setTime = interval + now;
+	reschedule();
+	(*ringer)();
+}
+
+/* Constructor */
+scheduledAlarm::scheduledAlarm()
+{
+	setTime = 0;
+	scheduler = NULL;
+	next = NULL;
+}
+
+/* Destructor, an alarm that goes out of scope is removed from its scheduler */
+scheduledAlarm::~scheduledAlarm()
+{
+	if (scheduler != NULL)
+	{
+		scheduler->remove(this);
+	}
+}
+
+/* Moves the alarm to its place in the scheduler after the set time has changed */
+void scheduledAlarm::reschedule()
+{
+	if (scheduler == NULL)
+	{
+		return;
+	}
+	scheduler->unlink(this);
+	if (isActive())
+	{
+		scheduler->insert(this);
+	}
+}
+
+/** Constructor
+ *
+ */
+alarmScheduler::alarmScheduler()
+{
+	head = NULL;
+	count = 0;
+}
+
+/** Gives the scheduler ownership of an alarm, after this the alarm is serviced by alarmScheduler::poll().
+ * The alarm keeps working as before, setAlarm(), reset() etc. can still be called on it directly.
+ * @param alarm Pointer to an alarmClock or repeatAlarm
+ */
+void alarmScheduler::add(scheduledAlarm *alarm)
+{
+	if (alarm->scheduler != NULL)
+	{
+		alarm->scheduler->remove(alarm);
+	}
+	alarm->scheduler = this;
+	alarm->reschedule();
+}
+
+/** Releases an alarm from the scheduler, it will need to be polled on its own again.
+ * @param alarm Pointer to an alarmClock or repeatAlarm
+ */
+void alarmScheduler::remove(scheduledAlarm *alarm)
+{
+	if (alarm->scheduler != this)
+	{
+		return;
+	}
+	unlink(alarm);
+	alarm->scheduler = NULL;
+}
+
+/** Polling function, this should be called as often as possible ( normally from loop() ).
+ * The event handlers of all of the alarms that are due are called from inside this.
+ * Only the alarms that are due are looked at, but each one that is set again (repeatAlarm, or set from its
+ * event handler) is re-inserted into the sorted list, which takes time in proportion to the number of alarms.
+ * @return Number of alarms that occurred
+ */
+unsigned int alarmScheduler::poll()
+{
+	unsigned long now = millis();
+	unsigned int fired = 0;
+	scheduledAlarm *alarm;
+
+	// at most one pass through the alarms, so an alarm that is re-set to now from its event handler can not lock up poll()
+	for (unsigned int i = count; (i != 0) && (head != NULL) && ((long)(now - head->setTime) >= 0); i--)
+	{
+		alarm = head;
+		head = alarm->next;
+		alarm->next = NULL;
+		count--;
+		alarm->expire(now);
+		fired++;
+	}
+	return fired;
+}
+
+/** Gets the number of active alarms.
+ * @return Number of alarms waiting to occur
+ */
+unsigned int alarmScheduler::getCount()
+{
+	return count;
+}
+
+/** Gets the time of the next alarm, this can be used to sleep until there is something to do.
+ * Only valid if getCount() is not 0.
+ * @return Time of the next alarm, in the same units as millis()
+ */
+unsigned long alarmScheduler::nextDeadline()
+{
+	return (head != NULL) ? head->setTime : millis();
+}
+
+/** Gets the time remaining until the next alarm.
+ * @return Time in milliseconds from now, 0 if an alarm is due or there are no active alarms
+ */
+unsigned long alarmScheduler::getRemainingTime()
+{
+	long remaining;
+	if (head == NULL)
+	{
+		return 0;
+	}
+	remaining = (long)(head->setTime - millis());
+	return (remaining > 0) ? remaining : 0;
+}
+
+/* private function, sorted insert, the new alarm goes after any with the same time */
+void alarmScheduler::insert(scheduledAlarm *alarm)
+{
+	scheduledAlarm **link = &head;
+	while ((*link != NULL) && ((long)(alarm->setTime - (*link)->setTime) >= 0))
+	{
+		link = &((*link)->next);
+	}
+	alarm->next = *link;
+	*link = alarm;
+	count++;
+}
+
+/* private function */
+void alarmScheduler::unlink(scheduledAlarm *alarm)
+{
+	scheduledAlarm **link = &head;
+	while (*link != NULL)
+	{
+		if (*link == alarm)
+		{
+			*link = alarm->next;
+			alarm->next = NULL;
+			count--;
+			return;
+		}
+		link = &((*link)->next);
+	}
+}
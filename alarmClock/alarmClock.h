@@ -12,6 +12,7 @@
  *                          Added getRemainingTime() to alarmClock and repeatAlarm
  * Rev 6 - Keegan Morrow -  Bugfix in alarmClock::poll() preventing the alarm from being set from the ringer function
  * Rev 7 - Keegan Morrow -	Added the ability to alarmClock to not call a function
+ * Rev 8 - Added alarmScheduler, alarmClock and repeatAlarm can be owned by a scheduler and polled together
  *
  */
 
@@ -24,14 +25,36 @@
 #include <WProgram.h>
 #endif
 
-#define ALARMCLOCKREV 7
+#define ALARMCLOCKREV 8
+
+class alarmScheduler;
+
+/**
+ * Base class for alarms that can be owned by an alarmScheduler.
+ * @author Keegan Morrow
+ * @version 8
+ */
+class scheduledAlarm
+{
+	friend class alarmScheduler;
+protected:
+	unsigned long setTime;
+	scheduledAlarm();
+	virtual ~scheduledAlarm();
+	void reschedule();
+	virtual boolean isActive() = 0;
+	virtual void expire(unsigned long) = 0;
+private:
+	alarmScheduler *scheduler;
+	scheduledAlarm *next;
+};
 
 /**
  * Utility class for managing one-shot time events.
  * @author Keegan Morrow
- * @version 7
+ * @version 8
  */
-class alarmClock
+class alarmClock: public scheduledAlarm
 {
 public:
 	boolean isSet();
@@ -41,8 +64,10 @@ public:
 	unsigned long getRemainingTime();
 	alarmClock();
 	alarmClock(void (*ringer)(void));
+protected:
+	boolean isActive();
+	void expire(unsigned long);
 private:
-	unsigned long setTime;
 	void (*ringer)(void);
 	boolean set;
 
@@ -51,9 +76,9 @@ private:
 /**
  * Utility class for managing repeating time events.
  * @author Keegan Morrow
- * @version 7
+ * @version 8
  */
-class repeatAlarm
+class repeatAlarm: public scheduledAlarm
 {
 public:
 	repeatAlarm(void (*ringer)(void));
@@ -63,10 +88,42 @@ public:
 	boolean poll();
 	unsigned long getRemainingTime();
 	unsigned long getInterval();
+protected:
+	boolean isActive();
+	void expire(unsigned long);
 private:
-	unsigned long setTime;
 	unsigned long interval;
 	void (*ringer)(void);
 };
 
+/**
+ * Owns any number of alarmClock and repeatAlarm objects so they can all be serviced with one poll().
+ * Alarms are kept in a list sorted by deadline, so poll() only looks at the alarms that are due
+ * and the next deadline is always at the head of the list.
+ * Setting an alarm, or a repeatAlarm firing, puts the alarm back into the sorted list, which walks the list
+ * (O(n) in the number of active alarms), so poll() costs O(due * n). poll() with nothing due only looks at the head
+ * and costs the same with 4 alarms or 256. The list is used instead of a heap because it needs no allocation, and
+ * the walk stays short for the number of alarms that fit in the RAM of an AVR (see the alarmScheduler benchmarks
+ * in hostSim).
+ * @author Keegan Morrow
+ * @version 8
+ */
+class alarmScheduler
+{
+	friend class scheduledAlarm;
+public:
+	alarmScheduler();
+	void add(scheduledAlarm *);
+	void remove(scheduledAlarm *);
+	unsigned int poll();
+	unsigned int getCount();
+	unsigned long nextDeadline();
+	unsigned long getRemainingTime();
+private:
+	scheduledAlarm *head;
+	unsigned int count;
+	void insert(scheduledAlarm *);
+	void unlink(scheduledAlarm *);
+};
+
 #endif //__alarmClock_h_
@@ -0,0 +1,41 @@
+#include <alarmClock.h>
+
+alarmScheduler scheduler;
+repeatAlarm fast = repeatAlarm(fastAlarm);
+repeatAlarm slow = repeatAlarm(slowAlarm);
+alarmClock timeout = alarmClock(timeoutAlarm);
+
+void setup()
+{
+  Serial.begin(9600);
+  fast.setIntervalReset(250);
+  slow.setIntervalReset(1000);
+  timeout.setAlarm(5000);
+
+  scheduler.add(&fast);
+  scheduler.add(&slow);
+  scheduler.add(&timeout);
+}
+
+void loop()
+{
+  scheduler.poll(); // one call services every alarm
+
+  // there is nothing to do until scheduler.getRemainingTime() has passed
+}
+
+void fastAlarm()
+{
+  Serial.println("tick");
+}
+
+void slowAlarm()
+{
+  Serial.println("tock");
+}
+
+void timeoutAlarm()
+{
+  Serial.println("ring!!!");
+  timeout.setAlarm(5000);
+}
@@ -19,31 +19,104 @@ buttonBoard::buttonBoard(byte data595Pin, byte data165Pin, byte clockPin,
 	data165PortPtr = portInputRegister(digitalPinToPort(data165Pin));
 	data595PortPtr = portOutputRegister(digitalPinToPort(data595Pin));
 	clkPortPtr = portOutputRegister(digitalPinToPort(clockPin));
-	latch165PortPtr = portOutputRegister(digitalPinToPort(latch165Pin));
-	latch595PortPtr = portOutputRegister(digitalPinToPort(latch595Pin));
 
 	data165Mask = digitalPinToBitMask(data165Pin);
 	data595Mask = digitalPinToBitMask(data595Pin);
 	clkMask = digitalPinToBitMask(clockPin);
-	latch165Mask = digitalPinToBitMask(latch165Pin);
-	latch595Mask = digitalPinToBitMask(latch595Pin);
 
 	this->numBoards = numBoards;
+	hwTransport = false;
+
+	pinMode(data165Pin, INPUT);
+	pinMode(data595Pin, OUTPUT);
+	pinMode(clockPin, OUTPUT);
+	digitalWrite(data165Pin, HIGH);
+	digitalWrite(clockPin, LOW);
+
+	startup(latch165Pin, latch595Pin);
+}
+
+/**
+ *  \brief Hardware transport constructor, the lamp data is shifted out while the button data is shifted in.
+ *  The transport is started by begin().
+ *  For shiftSPI DI must be on pin 11, DO on pin 12 and CLK on pin 13, for shiftUSART DI must be on pin 1,
+ *  DO on pin 0 and CLK on pin 4 (Uno). If the USART is not available the SPI module is used.
+ *
+ *  \param latch165Pin Input latch pin, connect to ILT on buttonBoard
+ *  \param latch595Pin Output latch pin, connect to OLT on buttonBoard
+ *  \param numBoards Number of boards in use
+ *  \param mode Transport to use, shiftSPI or shiftUSART
+ *
+ */
+buttonBoard::buttonBoard(byte latch165Pin, byte latch595Pin, byte numBoards, shiftTransportMode mode)
+{
+	transport.select(mode);
+	this->numBoards = numBoards;
+	hwTransport = true;
+
+	startup(latch165Pin, latch595Pin);
+}
+
+/**
+ *  \brief Starts the SPI or USART transport, this should be called from setup().
+ *  A global object is constructed before init(), which would undo the USART set up, so the hardware transport
+ *  constructor does not touch the hardware. If begin() is not called the transport is started by the first update().
+ *  Does nothing for the bit-bang transport.
+ *
+ */
+void buttonBoard::begin()
+{
+	transport.begin();
+}
+
+/**
+ *  \brief Constructor for derived classes that supply the buffers and override shiftChain(), see buttonBoardT.
+ *  Only the latch pins are set up.
+ *
+ *  \param latch165Pin Input latch pin, connect to ILT on buttonBoard
+ *  \param latch595Pin Output latch pin, connect to OLT on buttonBoard
+ *  \param numBoards Number of boards in use
+ *  \param buffer Buffer of 3 * numBoards bytes, used for the input, output and new press buffers
+ *
+ */
+buttonBoard::buttonBoard(byte latch165Pin, byte latch595Pin, byte numBoards, byte *buffer)
+{
+	this->numBoards = numBoards;
+	hwTransport = false;
+	memset(buffer, 0, numBoards * 3);
+	inBuffer = buffer;
+	outBuffer = buffer + numBoards;
+	newPressBuffer = buffer + (numBoards * 2);
+
+	startLatch(latch165Pin, latch595Pin);
+}
 
+/*private function*/
+void buttonBoard::startup(byte latch165Pin, byte latch595Pin)
+{
 	inBuffer = (byte *) calloc(numBoards, 1);
 	if (inBuffer == NULL)
 		while (1);
 	outBuffer = (byte *) calloc(numBoards, 1);
 	if (outBuffer == NULL)
 		while (1);
+	newPressBuffer = (byte *) calloc(numBoards, 1);
+	if (newPressBuffer == NULL)
+		while (1);
+
+	startLatch(latch165Pin, latch595Pin);
+}
+
+/*private function*/
+void buttonBoard::startLatch(byte latch165Pin, byte latch595Pin)
+{
+	latch165PortPtr = portOutputRegister(digitalPinToPort(latch165Pin));
+	latch595PortPtr = portOutputRegister(digitalPinToPort(latch595Pin));
+	latch165Mask = digitalPinToBitMask(latch165Pin);
+	latch595Mask = digitalPinToBitMask(latch595Pin);
 
-	pinMode(data165Pin, INPUT);
-	pinMode(data595Pin, OUTPUT);
 	pinMode(latch165Pin, OUTPUT);
 	pinMode(latch595Pin, OUTPUT);
-	pinMode(clockPin, OUTPUT);
-	digitalWrite(data165Pin, HIGH);
-	digitalWrite(clockPin, LOW);
 	digitalWrite(latch595Pin, LOW);
 	digitalWrite(latch165Pin, HIGH);
 
@@ -158,19 +231,94 @@ word buttonBoard::countPressed()
 word buttonBoard::countPressed(byte offset, byte count)
 {
 	word result = 0;
+	word first = offset;
+	word last = first + count; // one past the last button
+	byte mask;
 	if (autoUpdate)
 	{
 		update();
 	}
-	for (byte i = offset; i < (offset + count); i++)
+	if (last > ((word)numBoards << 3))
+	{
+		last = (word)numBoards << 3;
+	}
+	while (first < last)
 	{
-		byte byteNumber = i >> 3;
-		byte bitNumber = i - (byteNumber << 3);
-		result += bitRead(*(inBuffer + byteNumber), bitNumber) ? 1 : 0;
+		// mask off the buttons outside of the range in this byte, then count the whole byte
+		mask = 0xFF << (first & 0x07);
+		if ((last - (first & ~0x07)) < 8)
+		{
+			mask &= 0xFF >> (8 - (last & 0x07));
+		}
+		result += __builtin_popcount(*(inBuffer + (first >> 3)) & mask);
+		first = (first & ~0x07) + 8;
 	}
 	return result;
 }
 
+/**
+ * @brief Find the lowest numbered button being pressed
+ *
+ * @return Button number, buttonReset if no buttons are pressed
+ */
+byte buttonBoard::firstPressed()
+{
+	if (autoUpdate)
+	{
+		update();
+	}
+	if (*inBuffer & 0x01)
+	{
+		return 0;
+	}
+	return nextPressed(0);
+}
+
+/**
+ * @brief Find the next button being pressed, use with firstPressed() to step through the pressed buttons.
+ * This does not update the inputs, so a scan is not changed part way through.
+ *
+ * @param buttonNumber Button number to start after
+ * @return Button number, buttonReset if there are no more pressed buttons
+ */
+byte buttonBoard::nextPressed(byte buttonNumber)
+{
+	word next = (word)buttonNumber + 1;
+	byte byteNumber = next >> 3;
+	byte temp;
+	if (byteNumber >= numBoards)
+	{
+		return buttonReset;
+	}
+	temp = *(inBuffer + byteNumber) & (0xFF << (next & 0x07));
+	while (temp == 0)
+	{
+		if (++byteNumber >= numBoards)
+		{
+			return buttonReset;
+		}
+		temp = *(inBuffer + byteNumber);
+	}
+	return (byteNumber << 3) + __builtin_ctz(temp);
+}
+
+/**
+ * @brief Check if a button was pressed in the last update (it was released in the update before)
+ *
+ * @param buttonNumber Button number
+ * @return True if the button has just been pressed
+ */
+boolean buttonBoard::getNewPress(byte buttonNumber)
+{
+	byte byteNumber = buttonNumber >> 3;
+	byte bitNumber = buttonNumber - (byteNumber << 3);
+	if (byteNumber >= numBoards)
+	{
+		return false;
+	}
+	return bitRead(*(newPressBuffer + byteNumber), bitNumber);
+}
+
 /**
  *  @brief Low level access, writes a byte value to the lamp outputs of an individual board.
  *
@@ -229,6 +377,17 @@ byte *buttonBoard::getOutPtr()
 	return outBuffer;
 }
 
+/**
+ *  @brief Gets a pointer to the buffer of buttons that were pressed in the last update
+ *
+ *  @return Pointer to the new press buffer
+ *
+ */
+byte *buttonBoard::getNewPressPtr()
+{
+	return newPressBuffer;
+}
+
 /**
  *  @brief Gets the size of the input and output buffers. Same as the number of boards.
  *
@@ -267,39 +426,345 @@ void buttonBoard::setOutputInvert(boolean outputInvert)
 void buttonBoard::update()
 {
 	byte inTemp;
-	byte outTemp;
+	boolean changed = false;
 
+	callHook(hookBeforeUpdate);
 	*latch165PortPtr |= latch165Mask; // latch the input registers
+	shiftChain(newPressBuffer); // the raw data is replaced by the new presses below
+	*latch165PortPtr &= ~latch165Mask;
+	*latch595PortPtr |= latch595Mask; // latch the output registers
+	*latch595PortPtr &= ~latch595Mask;
+
+	for (byte i = 0; i < numBoards; i++)
+	{
+		inTemp = *(newPressBuffer + i);
+		if (!inputInvert) { inTemp = ~inTemp; }
+		*(newPressBuffer + i) = (*(inBuffer + i) ^ inTemp) & inTemp;
+		if (*(inBuffer + i) != inTemp)
+		{
+			*(inBuffer + i) = inTemp;
+			changed = true;
+		}
+	}
+
+	if (changed)
+		callHook(hookOnChange);
+	callHook();
+}
+
+/**
+ *  @brief Shifts the output buffer out (last board first) while the button data is shifted in. Derived classes can
+ *  override this to use a different transport, the latches are handled by the caller.
+ *
+ *  @param in Buffer for the raw button data, numBoards bytes, in[0] is the first board
+ *
+ */
+void buttonBoard::shiftChain(byte *in)
+{
+	byte inTemp;
+	byte outTemp;
 
 	for (byte i = 0; i < numBoards; i++)
 	{
 		inTemp = 0;
 		if (outputInvert) { outTemp = ~(*(outBuffer + ((numBoards - 1) - i))); }
 		else { outTemp = *(outBuffer + ((numBoards - 1) - i)); }
-		for (byte j = 0; j < 8; j++)
+		if (hwTransport)
+		{
+			inTemp = transport.transfer(outTemp); // full duplex, the lamp byte goes out as the button byte comes in
+		}
+		else
 		{
-			if (outTemp & 0x80)
+			for (byte j = 0; j < 8; j++)
 			{
-				*data595PortPtr |= data595Mask;
+				if (outTemp & 0x80)
+				{
+					*data595PortPtr |= data595Mask;
+				}
+				else
+				{
+					*data595PortPtr &= ~data595Mask;
+				}
+				outTemp <<= 1;
+				inTemp <<= 1;
+				inTemp |= ((*data165PortPtr & data165Mask) == data165Mask);
+				*clkPortPtr |= clkMask;
+				*clkPortPtr &= ~clkMask;
+			}
+		}
+		*(in + i) = inTemp;
+	}
+}
+
+/**
+ *  @brief Central de-bounce engine for all of the buttons on a buttonBoard
+ *
+ *  @param bb         Pointer to buttonBoard object
+ *  @param sampleTime Time between samples in ms, a button is de-bounced after 4 samples
+ *
+ */
+buttonDebounce::buttonDebounce(buttonBoard *bb, byte sampleTime)
+{
+	this->bb = bb;
+	this->sampleTime = sampleTime;
+	numBoards = bb->getSize();
+	bb->autoUpdate = false;
+
+	state = (byte *) calloc(numBoards * (3 + buttonNumEvents), 1);
+	if (state == NULL)
+		while (1);
+	count0 = state + numBoards;
+	count1 = count0 + numBoards;
+	events = count1 + numBoards;
+	memset(count0, 0xFF, numBoards * 2); // the counters start at 3 and count down to roll over
+
+	holdTicks = NULL;
+	clickTicks = NULL;
+	clickPending = NULL;
+	longTicks = 0;
+	repeatTicks = 0;
+	doubleTicks = 0;
+	lastSample = millis();
+}
+
+/**
+ *  @brief Set the times for the long press, repeat and double click events. The first call allocates 2 bytes per button.
+ *  The times are counted in samples, the longest time is 255 samples.
+ *
+ *  @param longPress   Time a button has to be held for a buttonLongPress event in ms, 0 = off
+ *  @param repeat      Time between buttonRepeat events once a button has been long pressed in ms, 0 = off
+ *  @param doubleClick Time from a release to the next press for a buttonDoubleClick event in ms, 0 = off
+ *
+ */
+void buttonDebounce::setTiming(word longPress, word repeat, word doubleClick)
+{
+	if (holdTicks == NULL)
+	{
+		holdTicks = (byte *) calloc((numBoards << 4) + numBoards, 1);
+		if (holdTicks == NULL)
+			while (1);
+		clickTicks = holdTicks + (numBoards << 3);
+		clickPending = clickTicks + (numBoards << 3);
+	}
+	longTicks = msToTicks(longPress);
+	repeatTicks = msToTicks(repeat);
+	doubleTicks = msToTicks(doubleClick);
+}
+
+/*private function*/
+byte buttonDebounce::msToTicks(word ms)
+{
+	word ticks;
+	if (ms == 0)
+	{
+		return 0;
+	}
+	ticks = ms / sampleTime;
+	if (ticks == 0)
+	{
+		return 1;
+	}
+	return (ticks > 0xFF) ? 0xFF : ticks;
+}
+
+/**
+ *  @brief Take a sample if the sample time has passed, this should be called from loop() (or the poll() of the helper classes).
+ *
+ *  @return True if a sample was taken
+ *
+ */
+boolean buttonDebounce::poll()
+{
+	if ((millis() - lastSample) < sampleTime)
+	{
+		return false;
+	}
+	lastSample += sampleTime;
+	if ((millis() - lastSample) >= sampleTime)
+	{
+		lastSample = millis(); // fell behind, don't try to catch up
+	}
+	sample();
+	return true;
+}
+
+/**
+ *  @brief Update the buttonBoard and run the de-bounce counters for every button
+ *
+ */
+void buttonDebounce::sample()
+{
+	byte *inBuffer;
+	byte changed;
+	byte pressed;
+	byte released;
+
+	bb->update();
+	inBuffer = bb->getInPtr();
+	for (byte i = 0; i < numBoards; i++)
+	{
+		// 2 bit vertical counter per button, reset when the input matches the state, the state flips when it rolls over
+		changed = *(state + i) ^ *(inBuffer + i);
+		*(count0 + i) = ~(*(count0 + i) & changed);
+		*(count1 + i) = *(count0 + i) ^ (*(count1 + i) & changed);
+		changed &= *(count0 + i) & *(count1 + i);
+		*(state + i) ^= changed;
+
+		pressed = changed & *(state + i);
+		released = changed & ~*(state + i);
+		*(events + (buttonPress * numBoards) + i) |= pressed;
+		*(events + (buttonRelease * numBoards) + i) |= released;
+		if ((holdTicks != NULL) && (*(state + i) | *(clickPending + i) | changed))
+		{
+			gestures(i, pressed, released);
+		}
+	}
+}
+
+/*private function*/
+void buttonDebounce::gestures(byte board, byte pressed, byte released)
+{
+	byte held = *(state + board);
+	byte active = held | *(clickPending + board) | released;
+	byte mask;
+	byte *hold;
+	byte *click;
+
+	for (byte j = 0; j < 8; j++)
+	{
+		mask = 1 << j;
+		if (!(active & mask))
+		{
+			continue;
+		}
+		hold = holdTicks + (board << 3) + j;
+		click = clickTicks + (board << 3) + j;
+		if (pressed & mask)
+		{
+			*hold = 0;
+			if ((*click != 0) && (*click != 0xFF))
+			{
+				*(events + (buttonDoubleClick * numBoards) + board) |= mask;
+				*click = 0xFF; // don't start a new window on this release
+			}
+		}
+		if (held & mask)
+		{
+			if (*hold != 0xFF)
+			{
+				(*hold)++;
+			}
+			if ((longTicks != 0) && (*hold == longTicks))
+			{
+				*(events + (buttonLongPress * numBoards) + board) |= mask;
+			}
+			else if ((longTicks != 0) && (repeatTicks != 0) && (*hold >= longTicks + repeatTicks))
+			{
+				*(events + (buttonRepeat * numBoards) + board) |= mask;
+				*hold = longTicks;
+			}
+		}
+		else if (released & mask)
+		{
+			if ((*click == 0xFF) || ((longTicks != 0) && (*hold >= longTicks)))
+			{
+				*click = 0;
 			}
 			else
 			{
-				*data595PortPtr &= ~data595Mask;
+				*click = doubleTicks;
 			}
-			outTemp <<= 1;
-			inTemp <<= 1;
-			inTemp |= ((*data165PortPtr & data165Mask) == data165Mask);
-			*clkPortPtr |= clkMask;
-			*clkPortPtr &= ~clkMask;
 		}
-		if (inputInvert) { *(inBuffer + i) = inTemp; }
-		else { *(inBuffer + i) = ~inTemp; }
+		else if ((*click != 0) && (*click != 0xFF))
+		{
+			(*click)--;
+		}
+		if (*click != 0)
+		{
+			*(clickPending + board) |= mask;
+		}
+		else
+		{
+			*(clickPending + board) &= ~mask;
+		}
 	}
-	*latch165PortPtr &= ~latch165Mask;
-	*latch595PortPtr |= latch595Mask; // latch the output registers
-	*latch595PortPtr &= ~latch595Mask;
+}
 
-	callHook();
+/**
+ *  @brief Get the de-bounced state of a button
+ *
+ *  @param buttonNumber Button number
+ *  @return State of the button, true = pressed
+ *
+ */
+boolean buttonDebounce::getState(byte buttonNumber)
+{
+	byte byteNumber = buttonNumber >> 3;
+	byte bitNumber = buttonNumber - (byteNumber << 3);
+	if (byteNumber >= numBoards)
+	{
+		return false;
+	}
+	return bitRead(*(state + byteNumber), bitNumber);
+}
+
+/**
+ *  @brief Check for an event on a button, the event is cleared
+ *  There is one copy of each event, so only one part of the sketch should read a given button and event.
+ *  The helper classes (buttonToggle etc.) use the de-bounced state with a latch of their own and do not read events.
+ *
+ *  @param buttonNumber Button number
+ *  @param event        Event to check for
+ *  @return True if the event has happened since the last call
+ *
+ */
+boolean buttonDebounce::getEvent(byte buttonNumber, buttonEvent event)
+{
+	byte byteNumber = buttonNumber >> 3;
+	byte mask = 1 << (buttonNumber - (byteNumber << 3));
+	byte *eventByte;
+	if ((byteNumber >= numBoards) || (event >= buttonNumEvents))
+	{
+		return false;
+	}
+	eventByte = events + (event * numBoards) + byteNumber;
+	if (*eventByte & mask)
+	{
+		*eventByte &= ~mask;
+		return true;
+	}
+	return false;
+}
+
+/**
+ *  @brief Clear all of the pending events
+ *
+ */
+void buttonDebounce::clearEvents()
+{
+	memset(events, 0x00, numBoards * buttonNumEvents);
+}
+
+/**
+ *  @brief Gets a pointer to the de-bounced state buffer
+ *
+ *  @return Pointer to the state buffer
+ *
+ */
+byte *buttonDebounce::getStatePtr()
+{
+	return state;
+}
+
+/**
+ *  @brief Gets the buttonBoard used by the engine
+ *
+ *  @return Pointer to the buttonBoard object
+ *
+ */
+buttonBoard *buttonDebounce::getBoard()
+{
+	return bb;
 }
 
 /**
@@ -313,9 +778,27 @@ buttonToggle::buttonToggle(buttonBoard *bb, byte buttonNumber)
 {
 	this->bb = bb;
 	this->buttonNumber = buttonNumber;
+	engine = NULL;
 	state = false;
 }
 
+/**
+ *  @brief Toggle functionality for an individual button, using the de-bounced events from a buttonDebounce object
+ *
+ *  @param engine       Pointer to buttonDebounce object
+ *  @param buttonNumber Button number to manage
+ *
+ */
+buttonToggle::buttonToggle(buttonDebounce *engine, byte buttonNumber)
+{
+	this->engine = engine;
+	this->buttonNumber = buttonNumber;
+	bb = engine->getBoard();
+	state = false;
+	latch = false;
+	eventState = false;
+}
+
 /**
  *  @brief Get the state of the toggled button.
  *
@@ -353,6 +836,21 @@ boolean buttonToggle::poll()
 {
 	boolean buttonState;
 	boolean returnState = false;
+	if (engine != NULL)
+	{
+		// edge of the de-bounced state with a latch of its own, the engine events are left for the sketch
+		engine->poll();
+		buttonState = engine->getState(buttonNumber);
+		if (buttonState && !latch)
+		{
+			state = state ? false : true;
+			returnState = true;
+			eventState = true;
+		}
+		latch = buttonState;
+		bb->setLamp(buttonNumber, state); // sent with the next sample
+		return returnState;
+	}
 	if (bb->autoUpdate == false)
 	{
 		bb->update();
@@ -412,7 +910,29 @@ buttonSelect::buttonSelect(buttonBoard *bb, byte offset, byte count,
 	this->offset = offset;
 	this->count = count;
 	this->defaultState = defaultState;
+	engine = NULL;
+	state = buttonReset;
+}
+
+/**
+ *  @brief Selector functionality for a group of buttons, using the de-bounced events from a buttonDebounce object
+ *
+ *  @param engine       Pointer to buttonDebounce object
+ *  @param offset       First button number
+ *  @param count        Number of buttons in the group
+ *  @param defaultState State of the buttons in the reset state, true = on
+ *
+ */
+buttonSelect::buttonSelect(buttonDebounce *engine, byte offset, byte count,
+                           boolean defaultState)
+{
+	this->engine = engine;
+	this->offset = offset;
+	this->count = count;
+	this->defaultState = defaultState;
+	bb = engine->getBoard();
 	state = buttonReset;
+	eventState = false;
 }
 
 /**
@@ -447,15 +967,29 @@ void buttonSelect::setState(byte state)
 boolean buttonSelect::poll()
 {
 	byte stateTemp = buttonReset;
-	if (bb->autoUpdate == false)
+	if (engine != NULL)
 	{
-		bb->update();
+		engine->poll();
+		for (byte i = offset; i < (offset + count); i++)
+		{
+			if (engine->getState(i)) // the de-bounced state, the engine events are left for the sketch
+			{
+				stateTemp = i;
+			}
+		}
 	}
-	for (byte i = offset; i < (offset + count); i++)
+	else
 	{
-		if (bb->getButton(i) == true)
+		if (bb->autoUpdate == false)
+		{
+			bb->update();
+		}
+		for (byte i = offset; i < (offset + count); i++)
 		{
-			stateTemp = i;
+			if (bb->getButton(i) == true)
+			{
+				stateTemp = i;
+			}
 		}
 	}
 	if (stateTemp == buttonReset)
@@ -518,7 +1052,7 @@ void buttonSelect::updateLamps()
 			}
 		}
 	}
-	if (bb->autoUpdate == false)
+	if ((bb->autoUpdate == false) && (engine == NULL))
 	{
 		bb->update();
 	}
@@ -528,6 +1062,7 @@ buttonToggleNoLamp::buttonToggleNoLamp(buttonBoard *bb, byte buttonNumber)
 {
 	this->bb = bb;
 	this->buttonNumber = buttonNumber;
+	engine = NULL;
 	states = 2;
 	state = false;
 }
@@ -536,10 +1071,33 @@ buttonToggleNoLamp::buttonToggleNoLamp(buttonBoard *bb, byte buttonNumber, byte
 {
 	this->bb = bb;
 	this->buttonNumber = buttonNumber;
+	engine = NULL;
 	this->states = states;
 	state = false;
 }
 
+buttonToggleNoLamp::buttonToggleNoLamp(buttonDebounce *engine, byte buttonNumber)
+{
+	this->engine = engine;
+	this->buttonNumber = buttonNumber;
+	bb = engine->getBoard();
+	states = 2;
+	state = false;
+	latch = false;
+	eventState = false;
+}
+
+buttonToggleNoLamp::buttonToggleNoLamp(buttonDebounce *engine, byte buttonNumber, byte states)
+{
+	this->engine = engine;
+	this->buttonNumber = buttonNumber;
+	bb = engine->getBoard();
+	this->states = states;
+	state = false;
+	latch = false;
+	eventState = false;
+}
+
 byte buttonToggleNoLamp::getState()
 {
 	return state;
@@ -554,11 +1112,19 @@ boolean buttonToggleNoLamp::poll()
 {
 	boolean buttonState;
 	boolean returnState = false;
-	if (bb->autoUpdate == false)
+	if (engine != NULL)
 	{
-		bb->update();
+		engine->poll();
+		buttonState = engine->getState(buttonNumber); // the engine events are left for the sketch
+	}
+	else
+	{
+		if (bb->autoUpdate == false)
+		{
+			bb->update();
+		}
+		buttonState = bb->getButton(buttonNumber);
 	}
-	buttonState = bb->getButton(buttonNumber);
 	if (buttonState && !latch)
 	{
 		if (states == 2)
@@ -577,7 +1143,7 @@ boolean buttonToggleNoLamp::poll()
 	{
 		latch = false;
 	}
-	if (bb->autoUpdate == false)
+	if ((bb->autoUpdate == false) && (engine == NULL))
 	{
 		bb->update();
 	}
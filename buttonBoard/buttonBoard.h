@@ -2,7 +2,7 @@
 *  @file buttonBoard.h
 *  @brief Hardware interface for the buttonBoard board with interface helpers.
 *  @author Keegan Morrow
-*  @version 7 08.18.2015
+*  @version 12 10.17.2026
 *
 *  @details Revision history
 *
@@ -22,12 +22,23 @@
 *  
 *  Rev 7 - 8/2015 Keegan Morrow - Added countPressed()
 *
+*  Rev 8 - 10/2026 - Moved hook to the shared hook library, update() calls the before update and on change events
+*
+*  Rev 9 - 10/2026 - Added the full duplex SPI/USART transport, firstPressed(), nextPressed() and getNewPress(), countPressed(offset, count) works a byte at a time
+*
+*  Rev 10 - 10/2026 - Added buttonDebounce (vertical counter debouncing with press, release, long press, repeat and double click events),
+*                     buttonSelect, buttonToggle and buttonToggleNoLamp can use it in place of their own de-bouncing
+*
+*  Rev 11 - 10/2026 - Added buttonBoardT, a template version with the pins and buffer size fixed at compile time
+*
+*  Rev 12 - 10/2026 - The SPI and USART transports are started by begin() instead of the constructor
+*
 */
 
 #ifndef __buttonBoard_h_
 #define __buttonBoard_h_
 
-#define BUTTONBOARD 7 //revision number
+#define BUTTONBOARD 12 //revision number
 #if defined(ARDUINO) && ARDUINO >= 100
 #include "Arduino.h"
 #else
@@ -36,7 +47,8 @@
 
 #include <inttypes.h>
 
-#include "utility/hook.h"
+#include "../hook/hook.h"
+#include "../shiftTransport/shiftTransport.h"
 
 #define buttonReset 0xFF
 
@@ -54,17 +66,27 @@ private:
 	volatile byte *clkPortPtr;
 	volatile byte *latch165PortPtr;
 	volatile byte *latch595PortPtr;
+	shiftTransport transport;
+	boolean hwTransport;
+	void startup(byte, byte);
+	void startLatch(byte, byte);
 
 protected:
 	byte *inBuffer;
 	byte *outBuffer;
+	byte *newPressBuffer; // buttons that were pressed in the last update()
 	byte numBoards;
 	boolean inputInvert;
 	boolean outputInvert;
 
+	buttonBoard(byte, byte, byte, byte *); // ILT, OLT, boardCount, buffer of 3 * boardCount bytes (for derived classes that do their own shifting)
+	virtual void shiftChain(byte *); // shifts the output buffer out and the raw button data into a buffer, the latches are handled by the caller
+
 public:
 	boolean autoUpdate; // setting this to false and calling update() can speed up some applications (use caution)
 	buttonBoard(byte, byte, byte, byte, byte, byte); // DI, DO, CLK, ILT, OLT, boardCount
+	buttonBoard(byte, byte, byte, shiftTransportMode); // ILT, OLT, boardCount, transport (DI = MOSI/TX, DO = MISO/RX, CLK = SCK/XCK)
+	void begin(); // starts the SPI or USART transport, call from setup()
 	void byteWrite(byte, byte); // boardNumber, byte
 	byte byteRead(byte); // boardNumber
 	void setLamp(byte, boolean); // buttonNumber, state
@@ -72,24 +94,113 @@ public:
 	boolean getButton(byte); // buttonNumber
 	word countPressed();
 	word countPressed(byte, byte);
+	byte firstPressed(); // returns buttonReset if no buttons are pressed
+	byte nextPressed(byte); // buttonNumber, returns the next pressed button after buttonNumber or buttonReset
+	boolean getNewPress(byte); // buttonNumber, true if the button was pressed in the last update
 	boolean getLampState(byte); // buttonNumber
 	void update();
 	byte *getInPtr(); // this will return a pointer to the input buffer, it can also be used like an array
 	byte *getOutPtr(); // this will return a pointer to the output buffer, it can also be used like an array
+	byte *getNewPressPtr(); // this will return a pointer to the buffer of buttons pressed in the last update
 	byte getSize(); // returns the size of the input and output buffers (number of boards)
 	void setInputInvert(boolean);
 	void setOutputInvert(boolean);
 };
 
+/*
+ * buttonBoard with the pins and the number of boards fixed at compile time.
+ * The buffers are part of the object instead of being allocated, and the shift loop is unrolled with the port
+ * addresses and masks as constants (single instruction pin accesses on the ATmega168/328).
+ * e.g. buttonBoardT<2, 3, 4, 5, 6, 1> buttons; // DI, DO, CLK, ILT, OLT, boardCount
+ */
+template <byte DATA595_PIN, byte DATA165_PIN, byte CLOCK_PIN, byte LATCH165_PIN, byte LATCH595_PIN, byte NUM_BOARDS>
+class buttonBoardT: public buttonBoard
+{
+private:
+	byte buffer[NUM_BOARDS * 3];
+
+protected:
+	void shiftChain(byte *in)
+	{
+		for (byte i = 0; i < NUM_BOARDS; i++)
+		{
+			byte outTemp = buffer[NUM_BOARDS + (NUM_BOARDS - 1) - i];
+			if (outputInvert) { outTemp = ~outTemp; }
+			*(in + i) = shiftPinsDuplex<DATA595_PIN, DATA165_PIN, CLOCK_PIN>::transfer(outTemp);
+		}
+	}
+
+public:
+	buttonBoardT() : buttonBoard(LATCH165_PIN, LATCH595_PIN, NUM_BOARDS, buffer)
+	{
+		shiftPinsDuplex<DATA595_PIN, DATA165_PIN, CLOCK_PIN>::begin();
+	}
+};
+
+/*
+ * Events generated by buttonDebounce
+ */
+enum buttonEvent
+{
+	buttonPress = 0,
+	buttonRelease,
+	buttonLongPress, // the button has been held for the long press time
+	buttonRepeat, // sent every repeat time while the button is held after a long press
+	buttonDoubleClick, // the button was pressed again within the double click time of being released
+	buttonNumEvents
+};
+
+/*
+ * De-bounces every button on a buttonBoard in one pass, 8 buttons at a time with vertical counters.
+ * A button has to read the same for 4 samples in a row to change state.
+ * poll() takes a sample (and updates the buttonBoard) once every sample time, so it can be called as often as needed.
+ * The buttonBoard is set to autoUpdate = false, lamp changes are sent with the next sample.
+ */
+class buttonDebounce
+{
+private:
+	buttonBoard *bb;
+	byte numBoards;
+	byte *state; // de-bounced button state
+	byte *count0; // vertical counter, bit 0
+	byte *count1; // vertical counter, bit 1
+	byte *events; // buttonNumEvents masks of numBoards bytes, set by the engine and cleared by getEvent()
+	byte *holdTicks; // per button, samples the button has been held (NULL until setTiming() is called)
+	byte *clickTicks; // per button, samples left in the double click window, 0xFF while the second click is held
+	byte *clickPending; // buttons with clickTicks != 0
+	byte sampleTime;
+	byte longTicks;
+	byte repeatTicks;
+	byte doubleTicks;
+	unsigned long lastSample;
+	void gestures(byte, byte, byte);
+	byte msToTicks(word);
+
+public:
+	buttonDebounce(buttonBoard *, byte = 10); // &bb, sample time in ms
+	void setTiming(word, word, word); // long press, repeat, double click time in ms (0 = off), allocates the gesture timers
+	boolean poll(); // returns true if a sample was taken
+	void sample(); // take a sample now
+	boolean getState(byte); // buttonNumber, de-bounced state
+	boolean getEvent(byte, buttonEvent); // buttonNumber, event, returns true if the event happened since the last call
+	void clearEvents();
+	byte *getStatePtr(); // this will return a pointer to the de-bounced state buffer
+	buttonBoard *getBoard();
+};
+
 /*
  * For buttonSelect and buttonToggle poll() should be called once every 10-50 ms
  * if it is called faster then there will be de-bounce issues, if slower it may miss a press.
+ * When they are built on a buttonDebounce object they follow the de-bounced state (getState()) and leave the events
+ * alone, so a helper and the sketch can both watch the same button. poll() can be called at any rate, as long as it
+ * is called at least once every 3 sample times if the engine is also polled from somewhere else.
  */
 
 class buttonSelect
 {
 private:
 	buttonBoard *bb;
+	buttonDebounce *engine;
 	byte state;
 	byte offset;
 	byte count;
@@ -102,6 +213,7 @@ public:
 	 */
 	boolean defaultState;
 	buttonSelect(buttonBoard *, byte, byte, boolean); // &bb, offset, count, resetState
+	buttonSelect(buttonDebounce *, byte, byte, boolean); // &engine, offset, count, resetState
 	byte getState();
 	void setState(byte); // call .setState(buttonReset) to return to the default state
 	boolean poll(); // this will return true if the state has changed, useful for time-outs
@@ -120,6 +232,7 @@ class buttonToggle
 {
 private:
 	buttonBoard *bb;
+	buttonDebounce *engine;
 	boolean state;
 	boolean latch;
 	boolean eventState;
@@ -127,6 +240,7 @@ private:
 
 public:
 	buttonToggle(buttonBoard *, byte); // &bb, buttonNumber
+	buttonToggle(buttonDebounce *, byte); // &engine, buttonNumber
 	boolean getState();
 	void setState(boolean);
 	boolean poll(); // this will return true if the state has changed, useful for time-outs
@@ -137,6 +251,7 @@ class buttonToggleNoLamp
 {
 private:
 	buttonBoard *bb;
+	buttonDebounce *engine;
 	byte state;
 	byte states;
 	boolean latch;
@@ -146,6 +261,8 @@ private:
 public:
 	buttonToggleNoLamp(buttonBoard *, byte); // &bb, buttonNumber
 	buttonToggleNoLamp(buttonBoard *, byte, byte); // &bb, buttonNumber, number of states
+	buttonToggleNoLamp(buttonDebounce *, byte); // &engine, buttonNumber
+	buttonToggleNoLamp(buttonDebounce *, byte, byte); // &engine, buttonNumber, number of states
 	byte getState();
 	void setState(byte);
 	boolean poll(); // this will return true if the state has changed, useful for time-outs
@@ -10,14 +10,48 @@
  * Rev 5 - 21.04.2015 KM - Updated update() to support the AS1109 LED driver chip
  * Rev 6 - 07.03.2016 KM - Added copySection() to the digits class, fixed autoUpdate bug
  * Rev 7 - 26.08.2016 KM - Added chaseAnimation8() to digitGroup
+ * Rev 8 - 17.10.2026 - Moved the data transfer to shiftTransport, added SPI and USART transports
+ * Rev 9 - 17.10.2026 - Number formatting uses a digit pair table instead of a division per digit, added segDispHex() and segDispFixed()
+ * Rev 10 - 17.10.2026 - Moved hook to the shared hook library, update() calls the before update event
+ * Rev 11 - 17.10.2026 - Added digitsT, a template version with the pins and buffer size fixed at compile time
+ * Rev 12 - 17.10.2026 - The SPI and USART transports are started by begin() instead of the constructor
+ * Rev 13 - 17.10.2026 - The static helper functions are declared in digits.cpp instead of the header
  *
  */
 
 #include "digits.h"
 
+static uint8_t _digits_mapToSegs(uint8_t);
+static uint8_t _digits_iToSegs(uint32_t, uint8_t *, uint8_t, uint8_t);
+
 static const uint8_t _digits_dashSeg = 0x80;
 static const uint8_t _digits_blankDigit = 0x0A;
 
+/*
+ * Segment patterns for 0-9 and A-F
+ */
+static const uint8_t _digits_segMap[16] PROGMEM =
+{ 0x7E, 0x0C, 0xB6, 0x9E, 0xCC, 0xDA, 0xFA, 0x0E, 0xFE, 0xDE, 0xEE, 0xF8, 0x72, 0xBC, 0xF2, 0xE2 };
+
+/*
+ * 0-99 in BCD, (tens << 4) | ones, so a number can be converted two digits at a time
+ */
+static const uint8_t _digits_bcdPairs[100] PROGMEM =
+{
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,
+	0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19,
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29,
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39,
+	0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+	0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+	0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79,
+	0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+	0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99
+};
+
+static uint8_t _digits_splitSegs(uint32_t, uint8_t *);
+
 
 /**
  *  @brief Sets the direction of the pins used and allocates memory.
@@ -31,27 +65,80 @@ static const uint8_t _digits_blankDigit = 0x0A;
  */
 digits::digits(uint8_t dataPin, uint8_t clockPin, uint8_t latchPin, uint8_t numChips)
 {
-	dataPortPtr = portOutputRegister(digitalPinToPort(dataPin));
-	clkPortPtr = portOutputRegister(digitalPinToPort(clockPin));
-	latchPortPtr = portOutputRegister(digitalPinToPort(latchPin));
+	transport.beginBitBang(dataPin, clockPin, false);
+	this->numChips = numChips;
+	startup(latchPin, true);
+}
 
-	dataMask = digitalPinToBitMask(dataPin);
-	clkMask = digitalPinToBitMask(clockPin);
-	latchMask = digitalPinToBitMask(latchPin);
+/**
+ *  @brief Sets the direction of the latch pin and allocates memory, the transport is started by begin().
+ *
+ *  @param latchPin Pin number connected to latch
+ *  @param numChips Number of total digits in the chain
+ *  @param mode     Transport to use, shiftSPI or shiftUSART
+ *
+ *  @details For shiftSPI data must be on pin 11 and clock on pin 13, for shiftUSART data must be on pin 1
+ *  and clock on pin 4 (Uno). If the USART is not available the SPI module is used.
+ */
+digits::digits(uint8_t latchPin, uint8_t numChips, shiftTransportMode mode)
+{
+	transport.select(mode);
+	this->numChips = numChips;
+	startup(latchPin, false); // the display is cleared by begin()
+}
 
+/**
+ *  @brief Starts the SPI or USART transport and clears the display, this should be called from setup().
+ *
+ *  @details A global object is constructed before init(), which would undo the USART set up, so the hardware
+ *  transport constructor does not touch the hardware. If begin() is not called the transport is started by
+ *  the first update(). For the bit-bang transport this only sends the buffer again.
+ */
+void digits::begin()
+{
+	transport.begin();
+	update();
+}
+
+/**
+ *  @brief Constructor for derived classes that supply the buffer and override shiftOut(), see digitsT.
+ *
+ *  @param latchPin Pin number connected to latch
+ *  @param numChips Number of total digits in the chain
+ *  @param buffer   Output buffer, numChips bytes
+ *
+ *  @details Only the latch pin is set up, update() is not called.
+ */
+digits::digits(uint8_t latchPin, uint8_t numChips, uint8_t *buffer)
+{
 	this->numChips = numChips;
+	chips = buffer;
+	memset(chips, 0, numChips);
+	startLatch(latchPin);
+}
 
+/* Private Function */
+void digits::startup(uint8_t latchPin, boolean send)
+{
 	chips = (uint8_t *) calloc(numChips, sizeof(uint8_t));
 	if (chips == NULL)
 		while (1); //this is a (kludgy) catch-all for out of memory errors
 
-	pinMode(dataPin, OUTPUT);
+	startLatch(latchPin);
+	if (send)
+		update();
+}
+
+/* Private Function */
+void digits::startLatch(uint8_t latchPin)
+{
+	latchPortPtr = portOutputRegister(digitalPinToPort(latchPin));
+	latchMask = digitalPinToBitMask(latchPin);
+
 	pinMode(latchPin, OUTPUT);
-	pinMode(clockPin, OUTPUT);
 	digitalWrite(latchPin, LOW);
 
 	autoUpdate = true;
-	update();
 }
 
 /**
@@ -74,32 +161,21 @@ void digits::copySection(uint8_t fromStart, uint8_t toStart, uint8_t length)
  */
 void digits::update()
 {
-	for (uint8_t i = numChips; i != 0; i--)
-	{
-		sendByte(*(chips + (i - 1)));
-	}
+	callHook(hookBeforeUpdate);
+	shiftOut();
 	*latchPortPtr |= latchMask;
 	*latchPortPtr &= ~latchMask;
 	callHook();
 }
 
-/* Private Function */
-void digits::sendByte(uint8_t data)
+/**
+ *  @brief Shift the output buffer into the chain, last digit first
+ *
+ *  @details Derived classes can override this to use a different transport, the latch is pulsed by the caller.
+ */
+void digits::shiftOut()
 {
-	for (uint8_t j = 0; j < 8; j++)
-	{
-		if (data & 0x80)
-		{
-			*dataPortPtr |= dataMask;
-		}
-		else
-		{
-			*dataPortPtr &= ~dataMask;
-		}
-		*clkPortPtr |= clkMask;
-		*clkPortPtr &= ~clkMask;
-		data = data << 1;
-	}
+	transport.writeReverse(chips, numChips);
 }
 
 /**
@@ -303,6 +379,42 @@ boolean digitGroup::segDispSign(int32_t number, uint8_t dpPos)
 	return signOverflow;
 }
 
+/**
+ *  @brief Display a signed fixed point number
+ *
+ *  @param number   Number to display, in units of the last decimal place (1234 with 2 places is 12.34)
+ *  @param decimals Number of decimal places (0 = none)
+ *  @return [boolean] true if there is a sign overflow
+ *
+ *  @details Leading zeros are shown up to the decimal point, see segDispSign().
+ */
+boolean digitGroup::segDispFixed(int32_t number, uint8_t decimals)
+{
+	return segDispSign(number, (decimals != 0) ? (decimals + 1) : 0);
+}
+
+/**
+ *  @brief Display a number in hexadecimal
+ *
+ *  @param number Number to display
+ */
+void digitGroup::segDispHex(uint32_t number)
+{
+	uint8_t pos = 0;
+	do
+	{
+		*(digPtr + pos) = pgm_read_byte(&_digits_segMap[number & 0x0F]);
+		number >>= 4;
+		pos++;
+	}
+	while ((number != 0) && (pos < numDigits));
+	if (pos < numDigits)
+	{
+		memset(digPtr + pos, _digits_mapToSegs(_digits_blankDigit), numDigits - pos);
+	}
+	if (digitsPtr->autoUpdate) { digitsPtr->update(); }
+}
+
 /**
  *  @brief Display an animation, each call advances the position
  */
@@ -365,41 +477,92 @@ uint8_t digitGroup::getNumDigits()
 
 uint8_t _digits_iToSegs(uint32_t inp, uint8_t *outPtr, uint8_t len, uint8_t fill)
 {
-	uint8_t digitCount = 0;
-	if (inp == 0)
+	uint8_t segs[10];
+	uint8_t digitCount = _digits_splitSegs(inp, segs);
+	if (digitCount > len)
+	{
+		digitCount = len;
+	}
+	memcpy(outPtr, segs, digitCount);
+	if (len > digitCount)
 	{
-		if (len > 1)
+		memset((outPtr + digitCount), _digits_mapToSegs(fill), len - digitCount);
+	}
+	return digitCount;
+}
+
+/*
+ * Splits a number into a quotient (less than 2^bits) and remainder without a division. The quotient is built one
+ * bit at a time by subtracting the divisor shifted down from divisor << (bits - 1); inp is left holding the remainder.
+ * This is cheaper on AVR than the general 32 bit division routine, which has to run all 32 steps.
+ */
+static uint16_t _digits_divSub(uint32_t *inp, uint32_t divisor, uint8_t bits)
+{
+	uint16_t quotient = 0;
+	uint32_t step = divisor << (bits - 1);
+	for (uint8_t i = bits; i != 0; i--)
+	{
+		quotient <<= 1;
+		if (*inp >= step)
 		{
-			memset((outPtr + 1), _digits_mapToSegs(fill), len - 1);
+			*inp -= step;
+			quotient |= 1;
 		}
-		*outPtr = _digits_mapToSegs(0);
-		digitCount = 1;
+		step >>= 1;
 	}
-	else
+	return quotient;
+}
+
+/*
+ * Converts a number to segment patterns, least significant digit first, returns the number of digits (1-10).
+ * The number is split into 4 digit chunks with _digits_divSub (no division), each chunk is split into two
+ * pairs with a multiply and shift (x * 5243 >> 19 == x / 100 for x < 43699) and each pair is looked up in _digits_bcdPairs.
+ * Only the digits of the top chunk that are not leading zeros are written, so segs needs 10 bytes.
+ */
+static uint8_t _digits_splitSegs(uint32_t inp, uint8_t *segs)
+{
+	uint16_t chunk[3];
+	uint8_t digs[4];
+	uint8_t chunks = 1;
+	uint8_t count = 0;
+	uint8_t high;
+	uint8_t pair;
+	uint8_t n;
+
+	chunk[2] = _digits_divSub(&inp, 100000000UL, 6); // 0-42
+	chunk[1] = _digits_divSub(&inp, 10000, 14); // 0-9999
+	chunk[0] = inp;
+	if (chunk[2] != 0)
 	{
-		for (uint8_t pos = 0; pos < len; pos++)
+		chunks = 3;
+	}
+	else if (chunk[1] != 0)
+	{
+		chunks = 2;
+	}
+	for (uint8_t i = 0; i < chunks; i++)
+	{
+		high = ((uint32_t)chunk[i] * 5243) >> 19;
+		pair = pgm_read_byte(&_digits_bcdPairs[chunk[i] - (high * 100)]);
+		digs[0] = pair & 0x0F;
+		digs[1] = pair >> 4;
+		pair = pgm_read_byte(&_digits_bcdPairs[high]);
+		digs[2] = pair & 0x0F;
+		digs[3] = pair >> 4;
+		n = 4;
+		if (i == (chunks - 1))
 		{
-			if (inp != 0)
-			{
-				*outPtr = _digits_mapToSegs(inp % 10);
-				inp /= 10;
-				digitCount++;
-			}
-			else
-			{
-				*outPtr = _digits_mapToSegs(fill);
-			}
-			outPtr++;
+			n = (chunk[i] < 10) ? 1 : (chunk[i] < 100) ? 2 : (chunk[i] < 1000) ? 3 : 4; // drop the leading zeros
+		}
+		for (uint8_t j = 0; j < n; j++)
+		{
+			segs[count++] = pgm_read_byte(&_digits_segMap[digs[j]]);
 		}
 	}
-	return digitCount;
+	return count;
 }
 
 uint8_t _digits_mapToSegs(uint8_t i) // input > 9 will blank the digit
 {
-	const uint8_t segMap[10] =
-	{ 0x7E, 0x0C, 0xB6, 0x9E, 0xCC, 0xDA, 0xFA, 0x0E, 0xFE, 0xDE };
-	return (i < 10) ? segMap[i] : 0;
+	return (i < 10) ? pgm_read_byte(&_digits_segMap[i]) : 0;
 }
-
-
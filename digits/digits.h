@@ -10,13 +10,19 @@
  * Rev 5 - 21.04.2015 KM - Updated update() to support the AS1109 LED driver chip
  * Rev 6 - 07.03.2016 KM - Added copySection() to the digits class, fixed autoUpdate bug
  * Rev 7 - 26.08.2016 KM - Added chaseAnimation8() to digitGroup
+ * Rev 8 - 17.10.2026 - Moved the data transfer to shiftTransport, added SPI and USART transports
+ * Rev 9 - 17.10.2026 - Number formatting uses a digit pair table instead of a division per digit, added segDispHex() and segDispFixed()
+ * Rev 10 - 17.10.2026 - Moved hook to the shared hook library, update() calls the before update event
+ * Rev 11 - 17.10.2026 - Added digitsT, a template version with the pins and buffer size fixed at compile time
+ * Rev 12 - 17.10.2026 - The SPI and USART transports are started by begin() instead of the constructor
+ * Rev 13 - 17.10.2026 - The static helper functions are declared in digits.cpp instead of the header
  *
  */
 
 #ifndef __digits_h_
 #define __digits_h_
 
-#define DIGITS 7 //revision number
+#define DIGITS 13 //revision number
 #if defined(ARDUINO) && ARDUINO >= 100
 #include "Arduino.h"
 #else
@@ -25,32 +31,28 @@
 
 #include <inttypes.h>
 
-#include "utility/hook.h"
+#include "../shiftTransport/shiftTransport.h"
+#include "../hook/hook.h"
 
 enum symType
 {
 	blank = 1, err = 2, foul = 3, dash = 4, test = 5 // don't change this!
 };
 
-static uint8_t _digits_mapToSegs(uint8_t);
-static uint8_t _digits_iToSegs(uint32_t, uint8_t *, uint8_t, uint8_t);
-
 
 /**
  *  Hardware interface class for a chain of digits.
  *  @author Keegan Morrow
- *  @version 7 2016.08.26
+ *  @version 13 2026.10.17
  */
 class digits: public hook
 {
 private:
-	uint8_t dataMask;
-	uint8_t clkMask;
 	uint8_t latchMask;
-	volatile uint8_t *dataPortPtr;
-	volatile uint8_t *clkPortPtr;
 	volatile uint8_t *latchPortPtr;
-	void sendByte(uint8_t);
+	shiftTransport transport;
+	void startup(uint8_t, boolean);
+	void startLatch(uint8_t);
 protected:
 	/**
 	 * Buffer size, derived classes should not modify this.
@@ -61,12 +63,17 @@ protected:
 	 *  Output buffer, derived classes can modify the data, but should not change the pointer address.
 	 */
 	uint8_t *chips;
+
+	digits(uint8_t, uint8_t, uint8_t *); // latch, numBoards, buffer (for derived classes that do their own shifting)
+	virtual void shiftOut(); // shifts the output buffer into the chain, the latch is pulsed by the caller
 public:
 	/**
 	 *  Determines if digits::update() is called automatically. Default is true.
 	 */
 	boolean autoUpdate; // setting this to false and calling update() can speed up some applications (use caution)
 	digits(uint8_t, uint8_t, uint8_t, uint8_t); // data, clock, latch, numBoards
+	digits(uint8_t, uint8_t, shiftTransportMode); // latch, numBoards, transport (shiftSPI or shiftUSART)
+	void begin(); // starts the SPI or USART transport and clears the display, call from setup()
 	void update(); // see autoUpdate
 	uint8_t *getPtr(); // pointer to the output buffer
 	uint8_t getSize(); // returns the total number of digits (the size of the buffer)
@@ -74,10 +81,36 @@ public:
 	void copySection(uint8_t, uint8_t, uint8_t);
 };
 
+/**
+ *  digits with the pins and the number of digits fixed at compile time.
+ *  The buffer is part of the object instead of being allocated, and the shift loop is unrolled with the port
+ *  addresses and masks as constants (single instruction pin writes on the ATmega168/328).
+ *  e.g. digitsT<2, 3, 4, 6> display; // data, clock, latch, numBoards
+ *  @author Keegan Morrow
+ *  @version 13 2026.10.17
+ */
+template <uint8_t DATA_PIN, uint8_t CLOCK_PIN, uint8_t LATCH_PIN, uint8_t NUM_CHIPS>
+class digitsT: public digits
+{
+private:
+	uint8_t buffer[NUM_CHIPS];
+protected:
+	void shiftOut()
+	{
+		shiftPins<DATA_PIN, CLOCK_PIN>::writeReverse(buffer, NUM_CHIPS);
+	}
+public:
+	digitsT() : digits(LATCH_PIN, NUM_CHIPS, buffer)
+	{
+		shiftPins<DATA_PIN, CLOCK_PIN>::begin(false);
+		update();
+	}
+};
+
 /**
  *  Interface to the digits hardware interface class for logical groups of digits.
  *  @author Keegan Morrow
- *  @version 7 2016.08.26
+ *  @version 13 2026.10.17
  */
 class digitGroup
 {
@@ -93,6 +126,8 @@ public:
 	void segDisp(symType); // [ blank, err, foul, dash, test ] (test will turn all segments on)
 	boolean segDispSign(int32_t); // display a signed number and generate a '-' if negative or return true if not enough digits
 	boolean segDispSign(int32_t, uint8_t); // signed number, position of decimal point
+	boolean segDispFixed(int32_t, uint8_t); // signed fixed point number, number of decimal places
+	void segDispHex(uint32_t); // display a number in hexadecimal
 	void chaseAnimation(); // display a spinning animation (will advance when called)
 	void chaseAnimation(uint8_t); // jump to a particular point in chaseAnimation (input is modulo 6)
 	void chaseAnimation8(); // display a figure eight animation (will advance when called)
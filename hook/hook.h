@@ -0,0 +1,203 @@
+/*
+ * hook.h
+ * Utility class to add the ability to attach a hook to an event in another class
+ * Rev 1 - 31.01.2014 - Keegan Morrow
+ * Rev 2 - 10/2026 - Moved to a shared library, added named events, multiple subscribers with a context pointer
+ *                   and deferred dispatch of events raised from an interrupt
+ *
+ */
+
+#ifndef __hook_h_
+#define __hook_h_
+
+#define HOOK 2 // revision number
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+/**
+ * Events that a class inheriting hook can call.
+ */
+enum hookEvent
+{
+	hookBeforeUpdate = 0, // at the start of update()
+	hookAfterUpdate, // at the end of update(), this is the event used by attachHook()
+	hookOnChange, // when the data has changed
+	hookNumEvents
+};
+
+class hook;
+
+/**
+ * A subscriber to one event of a hook object.
+ * The subscriber is owned by the caller and must stay in scope while it is subscribed (use a global or static).
+ * A subscriber can only be subscribed to one hook object at a time, use one subscriber per object.
+ * e.g. hookSubscriber onChange(hookOnChange, &inputsChanged, &myData); inputs.subscribe(&onChange);
+ */
+class hookSubscriber
+{
+	friend class hook;
+private:
+	hookSubscriber *next;
+	hook *owner; // object the subscriber is subscribed to, NULL if none
+public:
+	void (*function)(void *);
+	void *context;
+	hookEvent event;
+
+	/**
+	 * @param event Event to subscribe to
+	 * @param function Function to call, in the form void foo(void *context)
+	 * @param context Pointer passed to the function, may be NULL
+	 */
+	hookSubscriber(hookEvent event, void (*function)(void *), void *context = NULL)
+	{
+		this->event = event;
+		this->function = function;
+		this->context = context;
+		next = NULL;
+		owner = NULL;
+	}
+};
+
+/**
+ * Calls a member function of the object passed as the context of a subscriber.
+ * e.g. hookSubscriber sub(hookAfterUpdate, &hookMethod<display, &display::redraw>, &myDisplay);
+ */
+template <class T, void (T::*METHOD)()>
+void hookMethod(void *context)
+{
+	(static_cast<T *>(context)->*METHOD)();
+}
+
+/**
+ * Utility class providing inheritable methods to implement hooks.
+ * @author Keegan Morrow
+ * @version 2 10/2026
+ */
+class hook
+{
+private:
+	void (*eventHook)(void);
+	hookSubscriber *subscribers;
+	volatile byte pending; // bit mask of events raised by raiseHook() and not yet dispatched
+protected:
+	/**
+	 * Calls the hooked function and any subscribers to the after update event.
+	 * This should be placed in the function in the inheriting class to call the hook.
+	 */
+	inline void callHook()
+	{
+		callHook(hookAfterUpdate);
+	}
+	/**
+	 * Calls all of the subscribers to an event, in the order they were subscribed.
+	 * @param event The event that happened
+	 */
+	void callHook(hookEvent event)
+	{
+		if ((event == hookAfterUpdate) && (eventHook != NULL))
+			(*eventHook)();
+		for (hookSubscriber *sub = subscribers; sub != NULL; sub = sub->next)
+		{
+			if (sub->event == event)
+				(*sub->function)(sub->context);
+		}
+	}
+	/**
+	 * Marks an event as pending, the subscribers are called on the next dispatchHooks().
+	 * This is safe to use from an interrupt.
+	 * @param event The event that happened
+	 */
+	inline void raiseHook(hookEvent event)
+	{
+		pending |= (1 << event);
+	}
+public:
+	hook()
+	{
+		eventHook = NULL;
+		subscribers = NULL;
+		pending = 0;
+	}
+	/**
+	 * Attach the function to be called.
+	 * @param eventHook Function pointer to the function to be attached. In the form void foo().
+	 */
+	void attachHook(void (*eventHook)(void)) // pointer to a void foo() function -> bar.attachHook(foo);
+	{
+		this->eventHook = eventHook;
+	}
+	/**
+	 * Detach the hook.
+	 */
+	void detachHook()
+	{
+		eventHook = NULL;
+	}
+	/**
+	 * Add a subscriber to the end of the list.
+	 * @param sub Pointer to the subscriber
+	 * @return false if the subscriber is already subscribed to this or another object
+	 */
+	boolean subscribe(hookSubscriber *sub)
+	{
+		hookSubscriber **link = &subscribers;
+		if (sub->owner != NULL)
+			return false;
+		while (*link != NULL)
+			link = &((*link)->next);
+		sub->next = NULL;
+		sub->owner = this;
+		*link = sub;
+		return true;
+	}
+	/**
+	 * Remove a subscriber.
+	 * @param sub Pointer to the subscriber
+	 * @return false if the subscriber was not found
+	 */
+	boolean unsubscribe(hookSubscriber *sub)
+	{
+		if (sub->owner != this)
+			return false;
+		for (hookSubscriber **link = &subscribers; *link != NULL; link = &((*link)->next))
+		{
+			if (*link == sub)
+			{
+				*link = sub->next;
+				sub->next = NULL;
+				sub->owner = NULL;
+				return true;
+			}
+		}
+		return false;
+	}
+	/**
+	 * Calls the subscribers to any events raised from an interrupt since the last call.
+	 * This should be called from loop().
+	 * @return true if any events were dispatched
+	 */
+	boolean dispatchHooks()
+	{
+		byte events;
+		byte oldSREG = SREG;
+		cli();
+		events = pending;
+		pending = 0;
+		SREG = oldSREG;
+		if (events == 0)
+			return false;
+		for (byte i = 0; i < hookNumEvents; i++)
+		{
+			if (events & (1 << i))
+				callHook((hookEvent) i);
+		}
+		return true;
+	}
+};
+
+#endif //__hook_h_
@@ -0,0 +1,513 @@
+/*
+ * bench.cpp
+ * Host benchmarks of the hot paths changed in the series. The times are host times and only useful to compare
+ * one version of a library with another, the bus bytes per operation are the same as on the board.
+ *
+ * Rev 7 - 10/2026 - LED2801 and the W5100 read-ahead
+ * Rev 6 - 10/2026 - newDigits frame buffer
+ * Rev 5 - 10/2026 - ADS1x15 scan engine
+ * Rev 4 - 10/2026 - SPI block transfers on a loopback
+ * Rev 3 - 10/2026 - DNS lookups against a simulated server
+ * Rev 2 - 10/2026 - W5100 throughput
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "bench.h"
+#include <SPI.h>
+#include <Wire.h>
+#include "wireUtil.h"
+#include "../../smooth/smooth.h"
+#include "../../alarmClock/alarmClock.h"
+#include "../../outputExtend/outputExtend.h"
+#include "../../inputExtend/inputExtend.h"
+#include "../../buttonBoard/buttonBoard.h"
+#include "../../digits/digits.h"
+#include "../../pwmBoard/pwmBoard.h"
+#include "../../SegSerial.h"
+#include "../../newDigits.h"
+#include "../../LED2801/LED2801.h"
+#include "../../ADS1x15/src/ADS1x15.h"
+#include "../../Ethernet/src/Ethernet.h"
+#include "../../Ethernet/src/utility/w5100.h"
+#include "../../Ethernet/src/Dns.h"
+
+#define BENCH_LATCH 9
+#define BENCH_ILT 8
+
+static uint8_t benchMac[6] = {0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED};
+static const uint8_t benchPeer[4] = {192, 168, 1, 20};
+static uint8_t benchStream[1024];
+
+class benchDevice: public wireUtil<uint8_t, uint8_t>
+{
+public:
+	void begin() { Wire.begin(); address = 0x40; }
+};
+
+/**
+ * SPI device with MISO tied to MOSI, every byte comes back as it was sent.
+ */
+class benchLoopback: public simSpiDevice
+{
+public:
+	void exchange(uint8_t out, uint8_t *in) { *in = out; }
+};
+
+static void benchRinger()
+{
+	benchSink++;
+}
+
+/*
+ * SegSerial in simulated time: bytes/s on the wire and the CPU time per byte in write() and in the interrupt.
+ * The delay loops are counted, the code around them is not.
+ */
+static void benchSegSerial(long baud, uint8_t buffer)
+{
+	const int count = 64;
+	char name[48];
+	simReset();
+	SegSerial tx(4);
+	tx.begin(baud);
+	tx.setTxBuffer(buffer);
+	unsigned long start = simCycles();
+	for (int i = 0; i < count; i++)
+	{
+		tx.write(i);
+	}
+	unsigned long writing = simCycles() - start;
+	while (tx.isSending())
+	{
+		simAdvance(10);
+	}
+	double elapsed = (double) (simCycles() - start) / F_CPU;
+	snprintf(name, sizeof(name), "SegSerial::write %s (%ld)", buffer ? "buffered" : "blocking", baud);
+	printf("%-36s %10.0f B/s %10.1f us/B in write() %8.1f us/B in the interrupt\n", name, count / elapsed,
+	       (writing * 1e6) / ((double) F_CPU * count), (simInterruptCycles() * 1e6) / ((double) F_CPU * count));
+}
+
+/*
+ * DNS lookups in simulated time, one every 100 ms, of 8 names from a skewed workload (half of them for the first
+ * name, a quarter for the second and so on) against a server that answers after latency ms with a TTL of ttl s.
+ * Prints the cache hit rate, the mean and worst time to an answer, and the SPI bytes per lookup.
+ */
+static void benchDns(unsigned long latency, uint32_t ttl)
+{
+	static const char *names[8] = {"a.example", "b.example", "c.example", "d.example", "e.example", "f.example",
+	                               "g.example", "h.example"};
+	const unsigned long count = 2000;
+	char name[48];
+	simReset();
+	simW5100 chip;
+	simDnsServer server;
+	simSpiAttach(&chip);
+	chip.peer = &server;
+	memset(EthernetClass::_server_port, 0, sizeof(EthernetClass::_server_port));
+	Ethernet.begin(benchMac, IPAddress(192, 168, 1, 10));
+	for (uint8_t i = 0; i < 8; i++)
+	{
+		const uint8_t address[4] = {10, 0, 0, (uint8_t) (i + 1)};
+		server.add(names[i], address, ttl, latency * 1000);
+	}
+	DNSClient::clearCache();
+	DNSClient dns;
+	dns.begin(Ethernet.dnsServerIP());
+
+	uint32_t random = 1;
+	unsigned long total = 0, worst = 0, failed = 0;
+	unsigned long spi = simSpiBytes();
+	for (unsigned long i = 0; i < count; i++)
+	{
+		random = (random * 1103515245UL) + 12345;
+		IPAddress address;
+		unsigned long start = micros();
+		int q = dns.startHostByName(names[__builtin_ctz((random >> 16) | 0x80)]);
+		int result;
+		while ((result = dns.queryResult(q, address)) == DNS_PENDING)
+		{
+			simAdvance(100);
+		}
+		unsigned long elapsed = micros() - start;
+		failed += (result != 1);
+		total += elapsed;
+		worst = (elapsed > worst) ? elapsed : worst;
+		simAdvance(100000);
+	}
+	snprintf(name, sizeof(name), "DNS lookup (%lu ms, TTL %lu s)", latency, (unsigned long) ttl);
+	printf("%-36s %9.1f %% hits %8.2f ms mean %8.2f ms worst %8.1f SPI B/op %lu failed\n", name,
+	       (100.0 * (count - server.requests)) / count, total / (1000.0 * count), worst / 1000.0,
+	       (double) (simSpiBytes() - spi) / count, failed);
+	DNSClient::clearCache();
+}
+
+/*
+ * The ADS1115 scan engine in simulated time, polled every 100 us: samples/s against the data rate, the TWI
+ * bytes per sample and the time to a sample after its conversion is complete.
+ */
+static void benchAdsScan(uint8_t count, ADS1115_DR_t rate, unsigned int sps)
+{
+	static const ADS1x15_MUX_t channels[4] = {SE0, SE1, SE2, SE3};
+	char name[48];
+	simReset();
+	simRegisterDevice chip(ADS1x15_defaultAddress);
+	simTwiAttach(&chip);
+	chip.regs[CONVERSION_REG] = 0x12;
+	chip.regs[CONVERSION_REG + 1] = 0x34;
+	ADS1115 adc;
+	adc.begin();
+	adc.setDataRate(rate);
+	adc.beginScan(channels, count, 4);
+	unsigned long samples = 0;
+	unsigned long twi = simTwiBytes();
+	unsigned long start = micros();
+	while (micros() - start < 1000000)
+	{
+		simAdvance(100);
+		if (adc.pollScan())
+		{
+			samples++;
+			for (uint8_t i = 0; i < count; i++)
+			{
+				ADS1x15_sample_t s;
+				while (adc.readScan(i, &s))
+				{
+					benchSink += s.raw;
+				}
+			}
+		}
+	}
+	adc.stopScan();
+	snprintf(name, sizeof(name), "ADS1115 scan %u ch (%u SPS)", count, sps);
+	printf("%-36s %10lu samples/s %7.1f %% of the rate %8.2f TWI B/sample\n", name, samples,
+	       (100.0 * samples) / sps, (double) (simTwiBytes() - twi) / samples);
+}
+
+/*
+ * newDigits with size digits in 4 groups: a digit and a number written to the frame buffer in host time, then
+ * one frame sent to the displays in simulated time (4 bytes a digit at 250000 baud).
+ */
+static void benchNewDigits(uint8_t size, unsigned long n)
+{
+	char name[48];
+	simReset();
+	Digits display(4, size);
+	display.autoUpdate = false;
+	DigitGroup *groups[4];
+	for (uint8_t g = 0; g < 4; g++)
+	{
+		groups[g] = display.addGroup(1 + (g * (size / 4)), size / 4);
+		groups[g]->autoUpdate = false;
+	}
+	snprintf(name, sizeof(name), "Digits::setDigit (%u)", size);
+	bench(name, n, [&](unsigned long i) { display.setDigit(i % size, i & 0x0F, false); });
+	snprintf(name, sizeof(name), "Digits::segDisp (%u)", size);
+	bench(name, n / 10, [&](unsigned long i) { display.segDisp(i, 0); });
+	snprintf(name, sizeof(name), "DigitGroup::segDisp last group (%u)", size);
+	bench(name, n / 10, [&](unsigned long i) { groups[3]->segDisp(i, 0); });
+	unsigned long start = simCycles();
+	display.update();
+	double elapsed = (double) (simCycles() - start) / F_CPU;
+	snprintf(name, sizeof(name), "Digits::update (%u)", size);
+	printf("%-36s %10.2f ms/frame %10.1f frames/s\n", name, elapsed * 1e3, 1 / elapsed);
+	for (uint8_t g = 0; g < 4; g++)
+	{
+		delete groups[g];
+	}
+}
+
+/*
+ * A parser reading a stream from a W5100 one byte at a time with available() and read(), one op is one byte
+ */
+static void benchParse(const char *name, uint16_t readAhead, unsigned long n)
+{
+	simReset();
+	simW5100 chip;
+	simSpiAttach(&chip);
+	memset(EthernetClass::_server_port, 0, sizeof(EthernetClass::_server_port));
+	EthernetClient::setReadAhead(readAhead);
+	Ethernet.begin(benchMac, IPAddress(192, 168, 1, 10));
+	EthernetServer server(80);
+	server.begin();
+	chip.peerConnect(0, benchPeer, 40000);
+	chip.peerSend(0, benchStream, sizeof(benchStream));
+	EthernetClient client = server.available();
+	bench(name, n, [&](unsigned long) {
+		if (!client.available())
+		{
+			chip.peerSend(0, benchStream, sizeof(benchStream));
+		}
+		benchSink += client.read();
+	});
+	client.stop();
+	EthernetClient::setReadAhead(0);
+}
+
+int main()
+{
+	const unsigned long n = 1000000;
+
+	simReset();
+	{
+		smooth s(64);
+		bench("smooth::smoothData (64)", n, [&](unsigned long i) { s.smoothData(i & 0x3FF); benchSink += s.smoothedData; });
+		smoothMedian<int, 9> m;
+		bench("smoothMedian<int, 9>", n, [&](unsigned long i) { m.smoothData((i * 37) & 0x3FF); benchSink += m.smoothedData; });
+	}
+
+	for (int count = 4; count <= 256; count *= 4)
+	{
+		// staggered by 1 ms with an interval of count ms, so one alarm fires each ms and goes to the end of the list
+		char name[48];
+		simReset();
+		alarmScheduler scheduler;
+		repeatAlarm **alarms = new repeatAlarm *[count];
+		for (int i = 0; i < count; i++)
+		{
+			alarms[i] = new repeatAlarm(benchRinger);
+			scheduler.add(alarms[i]);
+			simSetMicros(i * 1000UL);
+			alarms[i]->setIntervalReset(count);
+		}
+		unsigned long start = millis();
+		snprintf(name, sizeof(name), "alarmScheduler::poll idle (%d)", count);
+		bench(name, n, [&](unsigned long) { benchSink += scheduler.poll(); });
+		snprintf(name, sizeof(name), "alarmScheduler::poll one due (%d)", count);
+		bench(name, n, [&](unsigned long i) { simSetMicros((start + i + 1) * 1000UL); benchSink += scheduler.poll(); });
+		for (int i = 0; i < count; i++)
+		{
+			delete alarms[i];
+		}
+		delete[] alarms;
+	}
+
+	simReset();
+	{
+		sim595 chain(BENCH_LATCH, 8);
+		simSpiAttach(&chain);
+		outputExtend out(BENCH_LATCH, 8);
+		bench("outputExtend::update SPI (8)", n, [&](unsigned long) { out.update(); });
+		out.setDeltaUpdate(true);
+		bench("outputExtend::update delta, same (8)", n, [&](unsigned long) { out.update(); });
+		bench("outputExtend::extendedWrite delta (8)", n, [&](unsigned long i) { out.extendedWrite(i & 0x3F, i & 0x40); });
+	}
+
+	simReset();
+	{
+		outputExtend out(2, 3, BENCH_LATCH, 8);
+		bench("outputExtend::update bit-bang (8)", n, [&](unsigned long) { out.update(); });
+		outputExtendT<2, 3, BENCH_LATCH, 8> outT;
+		bench("outputExtendT::update bit-bang (8)", n, [&](unsigned long) { outT.update(); });
+	}
+
+	simReset();
+	{
+		sim165 chain(BENCH_LATCH, 8);
+		simSpiAttach(&chain);
+		inputExtend in(BENCH_LATCH, 8, shiftSPI);
+		in.startScan(16);
+		inputEvent e;
+		bench("inputExtend::scan SPI (8)", n, [&](unsigned long i) {
+			chain.set(i & 0x07, i);
+			in.scan();
+			while (in.readEvent(&e)) { benchSink += e.pin; }
+		});
+	}
+
+	simReset();
+	{
+		sim165 buttons(BENCH_ILT, 4);
+		sim595 lamps(BENCH_LATCH, 4);
+		simSpiAttach(&buttons);
+		simSpiAttach(&lamps);
+		buttonBoard bb(BENCH_ILT, BENCH_LATCH, 4, shiftSPI);
+		bb.autoUpdate = false;
+		bench("buttonBoard::update duplex SPI (4)", n, [&](unsigned long i) { buttons.set(0, i); bb.update(); });
+		bench("buttonBoard first/nextPressed (4)", n, [&](unsigned long) {
+			for (byte b = bb.firstPressed(); b != buttonReset; b = bb.nextPressed(b)) { benchSink += b; }
+		});
+	}
+
+	simReset();
+	{
+		sim595 chain(BENCH_LATCH, 10);
+		simSpiAttach(&chain);
+		digits display(BENCH_LATCH, 10, shiftSPI);
+		display.autoUpdate = false;
+		digitGroup group(&display, 0, 10);
+		bench("digitGroup::segDisp (10 digits)", n, [&](unsigned long i) { group.segDisp(i * 2654435761UL); });
+		bench("digitGroup::segDispHex (10 digits)", n, [&](unsigned long i) { group.segDispHex(i * 2654435761UL); });
+	}
+
+	simReset();
+	{
+		simRegisterDevice chips[4] = { simRegisterDevice(0x1F), simRegisterDevice(0x1E), simRegisterDevice(0x1D),
+		                               simRegisterDevice(0x1C) };
+		for (int i = 0; i < 4; i++)
+		{
+			simTwiAttach(&chips[i]);
+		}
+		pwmBoard pwm(0, 4);
+		pwm.start();
+		pwm.autoUpdate = false;
+		bench("pwmBoard::update one channel (4)", n / 10, [&](unsigned long i) { pwm.setLevel(i & 0x1F, i); pwm.update(); });
+		bench("pwmBoard::update unchanged (4)", n, [&](unsigned long) { pwm.update(); });
+	}
+
+	simReset();
+	{
+		simRegisterDevice chip(0x40);
+		simTwiAttach(&chip);
+		benchDevice d;
+		d.begin();
+		bench("wireUtil::readRegister no shadow", n / 10, [&](unsigned long) { benchSink += d.readRegister(1); });
+		d.enableShadow(8);
+		bench("wireUtil::readRegister shadow", n, [&](unsigned long) { benchSink += d.readRegister(1); });
+		bench("wireUtil::setRegisterBit + flush", n / 10, [&](unsigned long i) {
+			d.setRegisterBit(i & 0x07, i & 0x07, i & 0x08);
+			d.flushRegisters();
+		});
+		wireTransaction t;
+		uint8_t data[4];
+		bench("WireQueue read + simTwiRun (4)", n / 10, [&](unsigned long) {
+			d.queueRead(&t, 0, data, 4);
+			simTwiRun();
+			WireQueue.run();
+		});
+	}
+
+	// SPI blocks a byte at a time and with the block calls, the sim sets SPIF at once so only the code around the
+	// shift register is timed
+	simReset();
+	{
+		benchLoopback loopback;
+		simSpiAttach(&loopback);
+		SPI.begin();
+		SPI.beginTransaction(SPISettings(8000000, MSBFIRST, SPI_MODE0));
+		static uint8_t block[512];
+		for (unsigned int i = 0; i < sizeof(block); i++)
+		{
+			block[i] = i;
+		}
+		static const unsigned int sizes[] = {8, 64, 512};
+		for (unsigned int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+		{
+			unsigned int size = sizes[s];
+			char name[48];
+			unsigned long count = (n * 4) / size;
+			snprintf(name, sizeof(name), "SPI.transfer byte loop (%u B)", size);
+			benchBytes(name, count, size, [&](unsigned long) {
+				for (unsigned int i = 0; i < size; i++)
+				{
+					block[i] = SPI.transfer(block[i]);
+				}
+			});
+			snprintf(name, sizeof(name), "SPI.transfer block (%u B)", size);
+			benchBytes(name, count, size, [&](unsigned long) { SPI.transfer(block, size); });
+			snprintf(name, sizeof(name), "SPI.writeBytes (%u B)", size);
+			benchBytes(name, count, size, [&](unsigned long) { SPI.writeBytes(block, size); });
+		}
+		SPI.endTransaction();
+		unsigned int wrong = 0;
+		for (unsigned int i = 0; i < sizeof(block); i++)
+		{
+			wrong += (block[i] != (uint8_t) i); // the loopback gave every byte back
+		}
+		if (wrong != 0)
+		{
+			printf("SPI loopback returned the wrong data\n");
+		}
+	}
+
+	// the ADS1x15 scan engine on the simulated bus: a poll with the conversion still running, one that reads
+	// the sample and starts the next conversion, and the sample rate kept up in simulated time
+	simReset();
+	{
+		simRegisterDevice chip(ADS1x15_defaultAddress);
+		simTwiAttach(&chip);
+		static const ADS1x15_MUX_t channels[4] = {SE0, SE1, SE2, SE3};
+		ADS1115 adc;
+		adc.begin();
+		adc.setDataRate(ADS1115_DR_860);
+		adc.beginScan(channels, 4, 4);
+		bench("ADS1x15::pollScan converting", n, [&](unsigned long) { benchSink += adc.pollScan(); });
+		bench("ADS1x15::pollScan sample ready", n / 10, [&](unsigned long) {
+			adc.conversionReady();
+			benchSink += adc.pollScan();
+		});
+		adc.stopScan();
+	}
+	benchAdsScan(1, ADS1115_DR_860, 860);
+	benchAdsScan(4, ADS1115_DR_860, 860);
+	benchAdsScan(4, ADS1115_DR_128, 128);
+
+	// sustained transfers through the simulated W5100, 4 SPI bytes for each byte of data
+	simReset();
+	{
+		simW5100 chip;
+		simSpiAttach(&chip);
+		memset(EthernetClass::_server_port, 0, sizeof(EthernetClass::_server_port));
+		Ethernet.begin(benchMac, IPAddress(192, 168, 1, 10));
+		static uint8_t block[1024];
+		benchBytes("W5100 TX memory burst (1 kB)", n / 1000, sizeof(block), [&](unsigned long) {
+			W5100.send_data_processing_offset(0, 0, block, sizeof(block));
+		});
+		benchBytes("W5100 RX memory burst (1 kB)", n / 1000, sizeof(block), [&](unsigned long) {
+			W5100.read_data(0, 0, block, sizeof(block));
+		});
+		EthernetServer server(80);
+		server.begin();
+		chip.peerConnect(0, benchPeer, 40000);
+		chip.peerSend(0, block, 1);
+		EthernetClient client = server.available();
+		client.read();
+		benchBytes("EthernetClient::write (1 kB)", n / 1000, sizeof(block), [&](unsigned long) {
+			benchSink += client.write(block, sizeof(block));
+			chip.sentReset(0);
+		});
+		benchBytes("EthernetClient::read (1 kB)", n / 1000, sizeof(block), [&](unsigned long) {
+			chip.peerSend(0, block, sizeof(block));
+			benchSink += client.read(block, sizeof(block));
+		});
+		client.stop();
+	}
+
+	// DNS with and without the cache, the server is a local one or one across the internet
+	benchDns(20, 60);
+	benchDns(20, 0);
+	benchDns(200, 60);
+
+	// LED2801 strip of 64 pixels: setColor() with the order set at run time and at compile time, send() on SPI,
+	// bit-banged and in chunks of 8 pixels
+	simReset();
+	{
+		LED2801 strip(64);
+		strip.autoUpdate = false;
+		LED2801Order<LED2801_GRB> grb(64);
+		grb.autoUpdate = false;
+		LED2801 bitBang(2, 3, 64);
+		bitBang.autoUpdate = false;
+		bench("LED2801::setColor (64)", n, [&](unsigned long i) { strip.setColor(i & 0x3F, i); });
+		bench("LED2801Order<GRB>::setColor (64)", n, [&](unsigned long i) { grb.setColor(i & 0x3F, i); });
+		bench("LED2801::send SPI (64)", n / 100, [&](unsigned long) { strip.send(); });
+		bench("LED2801::send bit-bang (64)", n / 100, [&](unsigned long) { bitBang.send(); });
+		strip.setChunkSize(8);
+		bench("LED2801::send SPI, chunks of 8 (64)", n / 100, [&](unsigned long) { strip.send(); });
+	}
+
+	benchParse("W5100 read() byte-wise", 0, n / 10);
+	benchParse("W5100 read() byte-wise, 64 B ahead", 64, n / 10);
+	benchParse("W5100 read() byte-wise, 512 B ahead", 512, n / 10);
+
+	benchNewDigits(8, n);
+	benchNewDigits(32, n);
+	benchNewDigits(128, n);
+
+	static const long bauds[] = {9600, 38400, 57600, 115200, 250000};
+	for (unsigned int i = 0; i < sizeof(bauds) / sizeof(bauds[0]); i++)
+	{
+		benchSegSerial(bauds[i], 0);
+		benchSegSerial(bauds[i], 64);
+	}
+	return 0;
+}
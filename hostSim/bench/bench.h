@@ -0,0 +1,64 @@
+/*
+ * bench.h
+ * Timing of the host benchmarks, shared by the benchmark programs.
+ *
+ * Rev 2 - 10/2026 - benchBytes()
+ * Rev 1 - 10/2026
+ *
+ */
+
+#ifndef __bench_h_
+#define __bench_h_
+
+#include <stdio.h>
+#include <time.h>
+#include "sim.h"
+
+static double benchNow()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + (ts.tv_nsec * 1e-9);
+}
+
+static volatile unsigned long benchSink;
+
+/*
+ * Runs op() count times and prints the time and the bus bytes per call
+ */
+template <typename OP>
+static void bench(const char *name, unsigned long count, OP op)
+{
+	unsigned long spi = simSpiBytes();
+	unsigned long twi = simTwiBytes();
+	double start = benchNow();
+	for (unsigned long i = 0; i < count; i++)
+	{
+		op(i);
+	}
+	double elapsed = benchNow() - start;
+	printf("%-36s %10.1f ns/op %10.2f Mop/s %8.2f SPI B/op %8.2f TWI B/op\n", name, (elapsed * 1e9) / count,
+	       (count / elapsed) * 1e-6, (double) (simSpiBytes() - spi) / count, (double) (simTwiBytes() - twi) / count);
+}
+
+/*
+ * Runs op() count times, each moving bytes bytes of data, and prints the throughput and the bus bytes per byte of
+ * data
+ */
+template <typename OP>
+static void benchBytes(const char *name, unsigned long count, unsigned long bytes, OP op)
+{
+	unsigned long spi = simSpiBytes();
+	unsigned long twi = simTwiBytes();
+	double start = benchNow();
+	for (unsigned long i = 0; i < count; i++)
+	{
+		op(i);
+	}
+	double elapsed = benchNow() - start;
+	double total = (double) count * bytes;
+	printf("%-36s %10.1f ns/B %10.2f MB/s %8.2f SPI B/B %8.2f TWI B/B\n", name, (elapsed * 1e9) / total,
+	       (total / elapsed) * 1e-6, (simSpiBytes() - spi) / total, (simTwiBytes() - twi) / total);
+}
+
+#endif // __bench_h_
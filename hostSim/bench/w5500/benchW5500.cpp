@@ -0,0 +1,110 @@
+/*
+ * benchW5500.cpp
+ * Host benchmarks of Ethernet2 on a simulated W5500, a program of its own as Ethernet2 and Ethernet have the
+ * same class names.
+ *
+ * Rev 3 - 10/2026 - byte-wise parsing with and without read-ahead
+ * Rev 2 - 10/2026 - EthernetServer::handleEvents() with 8 clients
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "../bench.h"
+#include "../../../Ethernet2/src/Ethernet2.h"
+
+static uint8_t benchMac[6] = {0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED};
+static const uint8_t benchPeer[4] = {192, 168, 1, 20};
+static const uint8_t benchData[64] = {0};
+static uint8_t benchStream[1024];
+
+static void benchReceive(EthernetClient &client)
+{
+	uint8_t buffer[64];
+	while (client.available())
+	{
+		benchSink += client.read(buffer, sizeof(buffer));
+	}
+}
+
+/*
+ * A parser reading a stream one byte at a time with available() and read(), one op is one byte
+ */
+static void benchParse(const char *name, uint16_t readAhead, unsigned long n)
+{
+	simReset();
+	simW5500 chip;
+	simSpiAttach(&chip);
+	memset(EthernetClass::_server_port, 0, sizeof(EthernetClass::_server_port));
+	EthernetClient::setReadAhead(readAhead);
+	Ethernet.begin(benchMac, IPAddress(192, 168, 1, 10));
+	EthernetServer server(80);
+	server.begin();
+	chip.peerConnect(0, benchPeer, 40000);
+	chip.peerSend(0, benchStream, sizeof(benchStream));
+	EthernetClient client = server.available();
+	bench(name, n, [&](unsigned long) {
+		if (!client.available())
+		{
+			chip.peerSend(0, benchStream, sizeof(benchStream));
+		}
+		benchSink += client.read();
+	});
+	client.stop();
+	EthernetClient::setReadAhead(0);
+}
+
+int main()
+{
+	const unsigned long n = 100000;
+
+	simReset();
+	{
+		simW5500 chip;
+		simSpiAttach(&chip);
+		Ethernet.begin(benchMac, IPAddress(192, 168, 1, 10));
+		EthernetServer server(80);
+		server.begin();
+		bench("EthernetServer::available idle", n, [&](unsigned long) { benchSink += (bool) server.available(); });
+	}
+
+	// every socket has a client, idle then each sending 64 bytes per pass
+	simReset();
+	{
+		simW5500 chip;
+		simSpiAttach(&chip);
+		memset(EthernetClass::_server_port, 0, sizeof(EthernetClass::_server_port));
+		Ethernet.begin(benchMac, IPAddress(192, 168, 1, 10));
+		EthernetServer server(80);
+		server.onEvent(SERVER_RECEIVE, benchReceive);
+		server.begin();
+		for (uint8_t s = 0; s < MAX_SOCK_NUM; s++)
+		{
+			chip.peerConnect(s, benchPeer, 40000 + s);
+			server.handleEvents();
+		}
+		bench("handleEvents 8 clients idle", n, [&](unsigned long) { benchSink += server.handleEvents(); });
+		bench("available 8 clients idle", n / 10, [&](unsigned long) { benchSink += (bool) server.available(); });
+		bench("handleEvents 8 clients busy", n / 10, [&](unsigned long) {
+			for (uint8_t s = 0; s < MAX_SOCK_NUM; s++)
+			{
+				chip.peerSend(s, benchData, sizeof(benchData));
+			}
+			benchSink += server.handleEvents();
+		});
+		bench("available 8 clients busy", n / 10, [&](unsigned long) {
+			for (uint8_t s = 0; s < MAX_SOCK_NUM; s++)
+			{
+				chip.peerSend(s, benchData, sizeof(benchData));
+			}
+			for (EthernetClient c = server.available(); c; c = server.available())
+			{
+				benchReceive(c);
+			}
+		});
+	}
+
+	benchParse("read() byte-wise", 0, n);
+	benchParse("read() byte-wise, 64 B read-ahead", 64, n);
+	benchParse("read() byte-wise, 512 B read-ahead", 512, n);
+	return 0;
+}
@@ -0,0 +1,102 @@
+/*
+ * Arduino.h
+ * Host build of the parts of the Arduino core used by the in-house libraries, see hostSim/README.md.
+ * The pins, ports and SPI registers follow the ATmega328 (Uno), they are plain variables that the
+ * simulation in hostSim/sim reads and drives.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#ifndef __hostSim_Arduino_h_
+#define __hostSim_Arduino_h_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef uint16_t word; // 16 bits like the AVR core
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define lowByte(w) ((uint8_t) ((w) & 0xff))
+#define highByte(w) ((uint8_t) ((w) >> 8))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) ((bitvalue) ? bitSet(value, bit) : bitClear(value, bit))
+#define bit(b) (1UL << (b))
+#define word(...) makeWord(__VA_ARGS__)
+inline word makeWord(uint16_t w) { return w; }
+inline word makeWord(uint8_t h, uint8_t l) { return (h << 8) | l; }
+#define _BV(b) (1 << (b))
+
+#include "avr/io.h"
+#include "avr/interrupt.h"
+#include "avr/pgmspace.h"
+
+/*
+ * Pins, Uno numbering: 0-7 are PORTD, 8-13 PORTB and 14-19 (A0-A5) PORTC
+ */
+#define NOT_A_PIN 0
+#define NOT_A_PORT 0
+#define PB 2
+#define PC 3
+#define PD 4
+#define NUM_DIGITAL_PINS 20
+#define digitalPinToPort(p) ((p) < 8 ? PD : ((p) < 14 ? PB : ((p) < 20 ? PC : NOT_A_PORT)))
+#define digitalPinToBitMask(p) ((uint8_t) _BV((p) < 8 ? (p) : ((p) < 14 ? (p) - 8 : (p) - 14)))
+#define digitalPinToTimer(p) 0
+#define digitalPinToInterrupt(p) ((p) == 2 ? 0 : ((p) == 3 ? 1 : -1))
+#define portOutputRegister(port) simPortRegister(port, 0)
+#define portInputRegister(port) simPortRegister(port, 1)
+#define portModeRegister(port) simPortRegister(port, 2)
+volatile uint8_t *simPortRegister(uint8_t, uint8_t); // port, 0 = PORTx, 1 = PINx, 2 = DDRx
+
+void pinMode(uint8_t, uint8_t);
+void digitalWrite(uint8_t, uint8_t);
+int digitalRead(uint8_t);
+void attachInterrupt(uint8_t, void (*)(void), int);
+void detachInterrupt(uint8_t);
+
+/*
+ * Time, only moves when the simulation advances it (see simAdvance()) or the sketch waits. The clock counts
+ * CPU cycles at F_CPU.
+ */
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long);
+void delayMicroseconds(unsigned int);
+inline void yield(void) {}
+
+// the sequence starts again at each simReset()
+long random(long);
+long random(long, long);
+void randomSeed(unsigned long);
+
+#define interrupts() sei()
+#define noInterrupts() cli()
+
+#include "Print.h"
+#include "HardwareSerial.h"
+
+#endif // __hostSim_Arduino_h_
@@ -0,0 +1,29 @@
+/*
+ * HardwareSerial.h
+ * Host build, the USART is not simulated: Serial accepts and drops everything.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#ifndef __hostSim_HardwareSerial_h_
+#define __hostSim_HardwareSerial_h_
+
+#include "Stream.h"
+
+class HardwareSerial: public Stream
+{
+public:
+	void begin(unsigned long) {}
+	void end() {}
+	int available() { return 0; }
+	int read() { return -1; }
+	int peek() { return -1; }
+	size_t write(uint8_t) { return 1; }
+	using Print::write;
+	operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif // __hostSim_HardwareSerial_h_
@@ -0,0 +1,54 @@
+/*
+ * IPAddress.h
+ * Host build, the IPv4 address class of the core without the printing and string parsing.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#ifndef __hostSim_IPAddress_h_
+#define __hostSim_IPAddress_h_
+
+#include <stdint.h>
+#include <string.h>
+
+class IPAddress
+{
+private:
+	union
+	{
+		uint8_t bytes[4];
+		uint32_t dword;
+	} _address;
+	uint8_t *raw_address() { return _address.bytes; }
+public:
+	IPAddress() { _address.dword = 0; }
+	IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t fourth)
+	{
+		_address.bytes[0] = first;
+		_address.bytes[1] = second;
+		_address.bytes[2] = third;
+		_address.bytes[3] = fourth;
+	}
+	IPAddress(uint32_t address) { _address.dword = address; }
+	IPAddress(const uint8_t *address) { memcpy(_address.bytes, address, 4); }
+	operator uint32_t() const { return _address.dword; }
+	bool operator==(const IPAddress &addr) const { return _address.dword == addr._address.dword; }
+	bool operator!=(const IPAddress &addr) const { return _address.dword != addr._address.dword; }
+	bool operator==(const uint8_t *addr) const { return memcmp(addr, _address.bytes, 4) == 0; }
+	uint8_t operator[](int index) const { return _address.bytes[index]; }
+	uint8_t &operator[](int index) { return _address.bytes[index]; }
+	IPAddress &operator=(const uint8_t *address) { memcpy(_address.bytes, address, 4); return *this; }
+	IPAddress &operator=(uint32_t address) { _address.dword = address; return *this; }
+
+	friend class EthernetClass;
+	friend class UDP;
+	friend class Client;
+	friend class Server;
+	friend class DhcpClass;
+	friend class DNSClient;
+};
+
+const IPAddress INADDR_NONE(0, 0, 0, 0);
+
+#endif // __hostSim_IPAddress_h_
@@ -0,0 +1,49 @@
+/*
+ * Print.h
+ * Host build, only the write functions that the libraries use.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#ifndef __hostSim_Print_h_
+#define __hostSim_Print_h_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+class Print
+{
+private:
+	int writeError;
+protected:
+	void setWriteError(int err = 1) { writeError = err; }
+public:
+	Print() : writeError(0) {}
+	virtual ~Print() {}
+	int getWriteError() { return writeError; }
+	void clearWriteError() { setWriteError(0); }
+	virtual size_t write(uint8_t) = 0;
+	virtual size_t write(const uint8_t *buffer, size_t size)
+	{
+		size_t n = 0;
+		while (size--)
+		{
+			n += write(*buffer++);
+		}
+		return n;
+	}
+	size_t write(const char *str)
+	{
+		return (str == NULL) ? 0 : write((const uint8_t *) str, strlen(str));
+	}
+	size_t write(const char *buffer, size_t size)
+	{
+		return write((const uint8_t *) buffer, size);
+	}
+	virtual int availableForWrite() { return 0; }
+	virtual void flush() {}
+};
+
+#endif // __hostSim_Print_h_
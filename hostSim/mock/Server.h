@@ -0,0 +1,20 @@
+/*
+ * Server.h
+ * Host build, the network server interface of the core.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#ifndef __hostSim_Server_h_
+#define __hostSim_Server_h_
+
+#include "Print.h"
+
+class Server: public Print
+{
+public:
+	virtual void begin() = 0;
+};
+
+#endif // __hostSim_Server_h_
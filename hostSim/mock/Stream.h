@@ -0,0 +1,22 @@
+/*
+ * Stream.h
+ * Host build, only the interface, none of the parsing functions.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#ifndef __hostSim_Stream_h_
+#define __hostSim_Stream_h_
+
+#include "Print.h"
+
+class Stream: public Print
+{
+public:
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+};
+
+#endif // __hostSim_Stream_h_
@@ -0,0 +1,19 @@
+/*
+ * avr/interrupt.h
+ * Host build, cli() and sei() only change the I bit in SREG, sei() runs the pending interrupts. An ISR is a
+ * plain function, the simulation calls it when its flag is set (see simCore.cpp) and a test can call it.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#ifndef __hostSim_avr_interrupt_h_
+#define __hostSim_avr_interrupt_h_
+
+#include "io.h"
+
+#define cli() (SREG &= (uint8_t) ~(1 << SREG_I))
+#define sei() (SREG |= (uint8_t) (1 << SREG_I))
+#define ISR(vector, ...) extern "C" void vector(void)
+
+#endif // __hostSim_avr_interrupt_h_
@@ -0,0 +1,155 @@
+/*
+ * avr/io.h
+ * ATmega328 registers used by the in-house libraries and the bundled SPI library, host build.
+ * The port registers are plain variables. SREG is an object so that turning the interrupts on runs the
+ * pending ones, SPDR and SPSR so that a write to SPDR exchanges a byte with the simulated SPI bus and SPIF
+ * always reads as set, the interrupt flag registers so that writing a one clears a flag, and TWCR so that a
+ * write starts an operation on the simulated TWI bus.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#ifndef __hostSim_avr_io_h_
+#define __hostSim_avr_io_h_
+
+#include <stdint.h>
+
+extern volatile uint8_t PORTB, PINB, DDRB;
+extern volatile uint8_t PORTC, PINC, DDRC;
+extern volatile uint8_t PORTD, PIND, DDRD;
+
+#define SREG_I 7
+
+/**
+ * Status register, setting the I bit runs the interrupts that are pending (see simCore.cpp).
+ */
+class simStatusRegister
+{
+private:
+	uint8_t bits;
+public:
+	simStatusRegister &operator=(uint8_t);
+	simStatusRegister &operator|=(uint8_t b) { return *this = bits | b; }
+	simStatusRegister &operator&=(uint8_t b) { return *this = bits & b; }
+	operator uint8_t() const { return bits; }
+};
+
+extern simStatusRegister SREG;
+
+/**
+ * Interrupt flag register, the simulation sets the flags and writing a one clears one.
+ */
+class simFlagRegister
+{
+private:
+	uint8_t bits;
+public:
+	simFlagRegister &operator=(uint8_t b) { bits &= ~b; return *this; }
+	operator uint8_t() const { return bits; }
+	void set(uint8_t b) { bits |= b; }
+};
+
+#define bit_is_set(sfr, bit) ((sfr) & (1 << (bit)))
+#define bit_is_clear(sfr, bit) (!((sfr) & (1 << (bit))))
+
+/*
+ * Timer2, normal and CTC mode with compare match A (see simCore.cpp)
+ */
+#define WGM21 1
+#define WGM20 0
+#define CS22 2
+#define CS21 1
+#define CS20 0
+#define OCIE2A 1
+#define OCF2A 1
+
+extern volatile uint8_t TCCR2A, TCCR2B, OCR2A, TCNT2, TIMSK2;
+extern simFlagRegister TIFR2;
+
+#define TIMER2_COMPA_vect __vector_7
+
+/*
+ * TWI (see simTwi.cpp)
+ */
+#define TWINT 7
+#define TWEA 6
+#define TWSTA 5
+#define TWSTO 4
+#define TWWC 3
+#define TWEN 2
+#define TWIE 0
+#define TWPS1 1
+#define TWPS0 0
+#define TWGCE 0
+
+#define _SFR_BYTE(sfr) (sfr)
+
+extern volatile uint8_t TWBR, TWSR, TWAR, TWDR;
+
+/**
+ * TWI control register, a write with TWINT set starts the next operation on the bus. A read while an
+ * operation is on the bus moves the clock on, as the code polling it would.
+ */
+class simTwiControlRegister
+{
+public:
+	simTwiControlRegister &operator=(uint8_t);
+	simTwiControlRegister &operator|=(uint8_t b) { return *this = (uint8_t) *this | b; }
+	simTwiControlRegister &operator&=(uint8_t b) { return *this = (uint8_t) *this & b; }
+	operator uint8_t() const;
+};
+
+extern simTwiControlRegister TWCR;
+
+#define TWI_vect __vector_24
+
+/*
+ * SPI
+ */
+#define SPIE 7
+#define SPE 6
+#define DORD 5
+#define MSTR 4
+#define CPOL 3
+#define CPHA 2
+#define SPR1 1
+#define SPR0 0
+#define SPIF 7
+#define WCOL 6
+#define SPI2X 0
+
+extern volatile uint8_t SPCR;
+
+/**
+ * SPI data register, a write sends the byte on the simulated bus and a read returns the byte received.
+ */
+class simSpiDataRegister
+{
+private:
+	uint8_t received;
+public:
+	simSpiDataRegister &operator=(uint8_t);
+	operator uint8_t() const { return received; }
+};
+
+/**
+ * SPI status register, the transfer is complete as soon as it starts so SPIF always reads as set.
+ */
+class simSpiStatusRegister
+{
+private:
+	uint8_t bits;
+public:
+	simSpiStatusRegister &operator=(uint8_t b) { bits = b & ~(1 << SPIF); return *this; }
+	simSpiStatusRegister &operator|=(uint8_t b) { return *this = bits | b; }
+	simSpiStatusRegister &operator&=(uint8_t b) { return *this = bits & b; }
+	operator uint8_t() const { return bits | (1 << SPIF); }
+};
+
+// a function so that a read on its own (SPDR; to clear SPIF) is not a statement without effect
+simSpiDataRegister &simSpiData();
+#define SPDR simSpiData()
+extern simSpiStatusRegister SPSR;
+
+#endif // __hostSim_avr_io_h_
@@ -0,0 +1,24 @@
+/*
+ * avr/pgmspace.h
+ * Host build, program memory is ordinary memory.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#ifndef __hostSim_avr_pgmspace_h_
+#define __hostSim_avr_pgmspace_h_
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *) (addr))
+#define pgm_read_word(addr) (*(const uint16_t *) (addr))
+#define pgm_read_dword(addr) (*(const uint32_t *) (addr))
+#define pgm_read_ptr(addr) (*(void * const *) (addr))
+#define memcpy_P memcpy
+#define strlen_P strlen
+
+#endif // __hostSim_avr_pgmspace_h_
@@ -0,0 +1,22 @@
+/*
+ * pins_arduino.h
+ * Host build, Uno pin assignments (the pin tables are in Arduino.h).
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#ifndef __hostSim_pins_arduino_h_
+#define __hostSim_pins_arduino_h_
+
+#include <stdint.h>
+
+static const uint8_t SS = 10;
+static const uint8_t MOSI = 11;
+static const uint8_t MISO = 12;
+static const uint8_t SCK = 13;
+
+static const uint8_t SDA = 18;
+static const uint8_t SCL = 19;
+
+#endif // __hostSim_pins_arduino_h_
@@ -0,0 +1,17 @@
+/*
+ * util/delay_basic.h
+ * Host build, the busy loops move the simulated clock by the cycles they take on the ATmega328.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#ifndef __hostSim_util_delay_basic_h_
+#define __hostSim_util_delay_basic_h_
+
+#include <stdint.h>
+
+void _delay_loop_1(uint8_t); // 3 cycles a count, 0 is 256
+void _delay_loop_2(uint16_t); // 4 cycles a count, 0 is 65536
+
+#endif // __hostSim_util_delay_basic_h_
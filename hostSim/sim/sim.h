@@ -0,0 +1,334 @@
+/*
+ * sim.h
+ * Simulated hardware for the host build of the in-house libraries: the clock, the pins, Timer2, an SPI bus
+ * with 74HC595 and 74HC165 chains and the WIZnet Ethernet chips, and the TWI module with a bus of register devices.
+ *
+ * Rev 2 - 10/2026 - DNS server for the UDP sockets of the WIZnet chips
+ * Rev 1 - 10/2026
+ *
+ */
+
+#ifndef __sim_h_
+#define __sim_h_
+
+#include "Arduino.h"
+#include <util/delay_basic.h>
+
+/*
+ * Clock and pins
+ */
+void simReset(); // clears the pins, the clock, both buses and their counters, call before each test
+void simAdvance(unsigned long); // moves the clock on, in us, the timers and interrupts run on the way
+void simAdvanceCycles(unsigned long); // moves the clock on, in CPU cycles
+void simSetMicros(unsigned long); // sets the clock, in us
+unsigned long simCycles(); // clock in CPU cycles
+unsigned long simInterruptCycles(); // CPU cycles spent in the interrupts since simReset()
+boolean simPinOutput(uint8_t); // level the sketch is driving on an output pin
+void simSetInput(uint8_t, boolean); // level on an input pin as read by digitalRead() and PINx
+void simInterrupt(uint8_t); // calls the function attached to an external interrupt
+
+/**
+ * A change of the level driven on a probed pin.
+ */
+struct simEdge
+{
+	unsigned long cycle; // clock in CPU cycles
+	uint8_t pin;
+	boolean level;
+};
+
+void simProbe(uint8_t); // records the level changes on a pin, up to 4 pins
+unsigned int simProbeEdges(); // edges recorded since simReset()
+simEdge simProbeEdge(unsigned int);
+
+/*
+ * SPI bus
+ */
+
+/**
+ * A device on the simulated SPI bus, every attached device sees every byte.
+ */
+class simSpiDevice
+{
+	friend void simSpiAttach(simSpiDevice *);
+	friend void simSpiDetach(simSpiDevice *);
+	friend uint8_t simSpiExchange(uint8_t);
+	friend void simSpiPins();
+private:
+	simSpiDevice *next;
+public:
+	simSpiDevice() { next = NULL; }
+	virtual ~simSpiDevice() {}
+	/**
+	 * Exchange one byte.
+	 * @param out Byte sent by the master (MOSI)
+	 * @param in Set to the byte driven on MISO, left alone if the device does not drive MISO
+	 */
+	virtual void exchange(uint8_t out, uint8_t *in) = 0;
+	/**
+	 * Called after pinMode() and digitalWrite(), for a device that needs to see its chip select change.
+	 */
+	virtual void pins() {}
+};
+
+void simSpiAttach(simSpiDevice *);
+void simSpiDetach(simSpiDevice *);
+uint8_t simSpiExchange(uint8_t); // one byte on the bus, used by SPDR, returns 0xFF if no device drives MISO
+unsigned long simSpiBytes(); // bytes on the bus since simReset()
+
+/**
+ * Chain of 74HC595 shift registers. Chip 0 is the one connected to the master, so after a frame chip 0
+ * holds the last byte sent. The storage register latch pulse can not be seen by the simulation (the
+ * libraries write the port directly), so the outputs are read from the shift register.
+ */
+class sim595: public simSpiDevice
+{
+private:
+	uint8_t latchPin;
+	uint8_t numChips;
+	uint8_t *chips;
+	unsigned long latchErrors;
+public:
+	sim595(uint8_t latchPin, uint8_t numChips);
+	~sim595();
+	void exchange(uint8_t, uint8_t *);
+	uint8_t get(uint8_t chip) { return chips[chip]; }
+	unsigned long getLatchErrors() { return latchErrors; } // bytes shifted while the latch was high
+};
+
+/**
+ * Chain of 74HC165 shift registers. Chip 0 is the one connected to the master and is shifted out first.
+ * The parallel load can not be seen by the simulation, so the chain is read in frames of numChips bytes,
+ * each frame starting again at chip 0.
+ */
+class sim165: public simSpiDevice
+{
+private:
+	uint8_t latchPin;
+	uint8_t numChips;
+	uint8_t *inputs;
+	uint8_t position;
+	unsigned long latchErrors;
+public:
+	sim165(uint8_t latchPin, uint8_t numChips);
+	~sim165();
+	void exchange(uint8_t, uint8_t *);
+	void set(uint8_t chip, uint8_t state) { inputs[chip] = state; }
+	unsigned long getLatchErrors() { return latchErrors; } // bytes shifted while the latch was low (loading)
+};
+
+/*
+ * WIZnet TCP/IP chips on the SPI bus
+ */
+
+class simWiznet;
+
+/**
+ * The other end of the UDP sockets of a simulated chip, for example a DNS server (see simWiznet::peer).
+ */
+class simUdpPeer
+{
+public:
+	virtual ~simUdpPeer() {}
+	/**
+	 * A datagram sent by a socket of the chip.
+	 */
+	virtual void sent(simWiznet &chip, uint8_t s, const uint8_t *ip, uint16_t port, const uint8_t *data,
+	                  uint16_t length) = 0;
+	/**
+	 * Called at the start of each register access, to pass on the datagrams that have come due.
+	 */
+	virtual void poll(simWiznet &chip) { (void) chip; }
+};
+
+/**
+ * The register file, socket memory and socket commands of a W5100 or W5500, 2 kB of transmit and receive
+ * memory per socket. The test plays the network: peerConnect(), peerSend() and peerClose() on a TCP socket,
+ * peerSendTo() on a UDP socket, and the data the sockets send is kept for the test to read back. A command
+ * completes as soon as it is written, except a DISCON with lingerDisconnect set, which waits in FIN_WAIT (or
+ * LAST_ACK after the other end closed) for peerClose(). The socket interrupt bits are set as on the chip (Sn_IR, and IR or SIR).
+ */
+class simWiznet: public simSpiDevice
+{
+protected:
+	struct simSocket
+	{
+		uint8_t regs[0x30];
+		uint8_t ir;
+		uint8_t sr;
+		uint16_t txRd;
+		uint16_t rxWr;
+		uint16_t rxRsr;
+		uint8_t tx[2048];
+		uint8_t rx[2048];
+		uint8_t sent[4096]; // TCP data sent, the first 4096 bytes since sentReset()
+		unsigned long sentBytes;
+	};
+	uint8_t csPin;
+	uint8_t numSockets;
+	uint8_t common[0x40];
+	simSocket *sockets;
+	void reset();
+	void command(uint8_t s, uint8_t cmd);
+	void interrupt(uint8_t s, uint8_t bits);
+	uint8_t read(uint8_t block, uint16_t offset);
+	void write(uint8_t block, uint16_t offset, uint8_t data);
+	virtual uint8_t readCommon(uint16_t offset);
+public:
+	simUdpPeer *peer; // gets the datagrams the UDP sockets send, not owned
+	boolean lingerDisconnect; // a DISCON waits in FIN_WAIT or LAST_ACK for peerClose()
+	boolean refuseConnect; // a CONNECT times out
+	simWiznet(uint8_t csPin, uint8_t numSockets);
+	~simWiznet();
+	// network side
+	boolean peerConnect(uint8_t s, const uint8_t *ip, uint16_t port); // a client connects to a listening socket
+	uint16_t peerSend(uint8_t s, const uint8_t *data, uint16_t length); // returns the bytes that fit
+	boolean peerSendTo(uint8_t s, const uint8_t *ip, uint16_t port, const uint8_t *data, uint16_t length);
+	void peerClose(uint8_t s); // the other end closes, or acknowledges a DISCON
+	// socket state
+	uint8_t status(uint8_t s) { return sockets[s].sr; }
+	uint8_t socketInterrupts(uint8_t s) { return sockets[s].ir; } // Sn_IR
+	uint16_t port(uint8_t s) { return (sockets[s].regs[0x04] << 8) | sockets[s].regs[0x05]; }
+	uint16_t received(uint8_t s) { return sockets[s].rxRsr; } // bytes the sketch has not read
+	unsigned long sentBytes(uint8_t s) { return sockets[s].sentBytes; }
+	const uint8_t *sent(uint8_t s) { return sockets[s].sent; }
+	void sentReset(uint8_t s) { sockets[s].sentBytes = 0; }
+	const uint8_t *ipAddress() { return common + 0x0F; } // SIPR
+};
+
+/**
+ * W5100 (Ethernet library), 4 sockets. Each byte is a frame of 4 bytes: 0xF0 (write) or 0x0F (read), the
+ * address and the data. Chip select is sampled with each byte, the frames are counted from when it goes low.
+ */
+class simW5100: public simWiznet
+{
+private:
+	uint8_t frame[3];
+	uint8_t position;
+	uint8_t readCommon(uint16_t offset);
+public:
+	simW5100(uint8_t csPin = 10);
+	void exchange(uint8_t, uint8_t *);
+};
+
+/**
+ * W5500 (Ethernet2 library), 8 sockets. A frame is the address, the control byte (block, read or write) and
+ * any number of data bytes at incrementing addresses, it ends when chip select goes high.
+ */
+class simW5500: public simWiznet
+{
+private:
+	uint8_t header[3];
+	uint8_t position;
+	uint16_t offset;
+	uint8_t readCommon(uint16_t offset);
+public:
+	simW5500(uint8_t csPin = 10);
+	void exchange(uint8_t, uint8_t *);
+	void pins();
+};
+
+#define SIM_DNS_NAMES 16
+#define SIM_DNS_ANSWERS 8
+#define SIM_DNS_PACKET 128
+
+/**
+ * DNS server on the other end of the UDP sockets of a simulated chip (set it as simWiznet::peer). It answers
+ * the A queries for the names it has been given after the latency of the name, any other name with NXDOMAIN.
+ * The answers wait until they are due and go to the socket the query came from, from port 53 of the address
+ * it was sent to.
+ */
+class simDnsServer: public simUdpPeer
+{
+private:
+	struct simDnsName
+	{
+		char name[32];
+		uint8_t address[4];
+		uint32_t ttl;
+		unsigned long latency;
+	};
+	struct simDnsAnswer
+	{
+		unsigned long due; // clock cycle
+		uint8_t s;
+		uint8_t from[4];
+		uint8_t data[SIM_DNS_PACKET];
+		uint16_t length;
+	};
+	simDnsName names[SIM_DNS_NAMES];
+	uint8_t numNames;
+	simDnsAnswer answers[SIM_DNS_ANSWERS];
+	uint8_t numAnswers;
+public:
+	unsigned long requests; // queries received
+	unsigned long answered; // answers passed on to a socket
+	uint16_t lastId; // ID of the last query
+	uint16_t lastPort; // source port of the last query
+	boolean silent; // queries are counted but not answered
+	simDnsServer();
+	void add(const char *name, const uint8_t *address, uint32_t ttl, unsigned long latency); // latency in us
+	void sent(simWiznet &chip, uint8_t s, const uint8_t *ip, uint16_t port, const uint8_t *data, uint16_t length);
+	void poll(simWiznet &chip);
+	uint8_t pending() { return numAnswers; } // answers not yet due
+};
+
+/*
+ * TWI bus, behind the TWI module registers that the real Wire/utility/twi.c drives
+ */
+
+/**
+ * A device on the simulated TWI bus. A write goes to every device that matches the address (so a broadcast
+ * address can be modelled), a read comes from the first one. The bytes of a write are passed on at the stop
+ * or repeated start that ends it, a read asks for one byte at a time.
+ */
+class simTwiDevice
+{
+	friend void simTwiAttach(simTwiDevice *);
+	friend void simTwiDetach(simTwiDevice *);
+	friend class simTwiBus;
+private:
+	simTwiDevice *next;
+public:
+	simTwiDevice() { next = NULL; }
+	virtual ~simTwiDevice() {}
+	virtual boolean matches(uint8_t address) = 0;
+	virtual void write(const uint8_t *data, uint8_t length) = 0;
+	virtual void read(uint8_t *data, uint8_t length) = 0;
+	/**
+	 * @param index Data byte being written, 0 is the first after the address
+	 * @return false to NACK it
+	 */
+	virtual boolean ackData(uint8_t index) { (void) index; return true; }
+};
+
+/**
+ * Device with 8 bit registers and a register pointer that is set by the first byte written and
+ * incremented by each byte read or written.
+ */
+class simRegisterDevice: public simTwiDevice
+{
+protected:
+	uint8_t address;
+	uint8_t pointer;
+public:
+	uint8_t regs[256];
+	unsigned long writes; // write transactions addressed to the device
+	boolean nack; // the device does not answer while set
+	simRegisterDevice(uint8_t address);
+	boolean matches(uint8_t addr) { return !nack && (addr == address); }
+	void write(const uint8_t *, uint8_t);
+	void read(uint8_t *, uint8_t);
+};
+
+void simTwiAttach(simTwiDevice *);
+void simTwiDetach(simTwiDevice *);
+int simTwiRun(); // runs the clock until the queued transfers are done, returns the number of stop conditions
+void simTwiHoldClock(boolean); // a device stretches SCL, the bus makes no progress while set
+void simTwiHoldData(uint8_t); // a device holds SDA low until SCL has been clocked this many times
+void simTwiLoseArbitration(uint8_t, const uint8_t *, uint8_t); // another master wins the next address byte
+unsigned long simTwiBytes(); // bytes on the bus since simReset(), including the address bytes
+unsigned long simTwiTransactions(); // start and repeated start conditions since simReset()
+const char *simTwiTrace(); // the bus conditions and bytes since simReset(), see simTwi.cpp
+
+#endif // __sim_h_
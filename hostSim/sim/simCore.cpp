@@ -0,0 +1,444 @@
+/*
+ * simCore.cpp
+ * Simulated clock, pins, Timer2 and interrupts, and the core functions the libraries call.
+ * The clock counts CPU cycles. It is moved on in steps that end at the next timer or TWI event, and the pending
+ * interrupts run between the steps when the I bit is set. Code only takes time in the delay functions, busy
+ * loops and waits for the TWI (see simTwi.cpp), the cycles of the instructions around them are not counted.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "sim.h"
+
+volatile uint8_t PORTB, PINB, DDRB;
+volatile uint8_t PORTC, PINC, DDRC;
+volatile uint8_t PORTD, PIND, DDRD;
+simStatusRegister SREG;
+volatile uint8_t TCCR2A, TCCR2B, OCR2A, TCNT2, TIMSK2;
+simFlagRegister TIFR2;
+HardwareSerial Serial;
+
+#define SIM_CYCLES_PER_US (F_CPU / 1000000L)
+#define SIM_PROBE_PINS 4
+#define SIM_PROBE_EDGES 4096
+
+static unsigned long simClock; // CPU cycles
+static unsigned long simTimer2Cycles; // cycles into the current Timer2 tick
+static unsigned long simIsrCycles;
+static boolean simInIsr;
+static void (*simInterrupts[2])(void);
+
+static uint8_t simProbePins[SIM_PROBE_PINS];
+static boolean simProbeLevels[SIM_PROBE_PINS];
+static uint8_t simProbeCount;
+static simEdge simEdges[SIM_PROBE_EDGES];
+static unsigned int simEdgeCount;
+
+// vectors of the libraries that are linked in
+extern "C" void TIMER2_COMPA_vect(void) __attribute__((weak));
+extern "C" void TWI_vect(void) __attribute__((weak));
+unsigned long simTwiNext();
+void simTwiStep(unsigned long);
+boolean simTwiPending();
+void simTwiWait();
+void simTwiPins();
+
+void simSpiReset();
+void simSpiPins();
+void simTwiReset();
+
+/**
+ * Clears the pins, the clock, both buses and their counters. Call before each test.
+ */
+void simReset()
+{
+	PORTB = PINB = DDRB = 0;
+	PORTC = PINC = DDRC = 0;
+	PORTD = PIND = DDRD = 0;
+	TCCR2A = TCCR2B = OCR2A = TCNT2 = TIMSK2 = 0;
+	TIFR2 = 0xFF;
+	SREG = _BV(SREG_I);
+	simClock = 0;
+	simTimer2Cycles = 0;
+	simIsrCycles = 0;
+	simInterrupts[0] = NULL;
+	simInterrupts[1] = NULL;
+	simProbeCount = 0;
+	simEdgeCount = 0;
+	srandom(1);
+	simSpiReset();
+	simTwiReset();
+}
+
+/*
+ * Timer2, counts up to OCR2A in CTC mode (WGM21) or to 0xFF, and sets OCF2A when it starts again at 0
+ */
+static unsigned long simTimer2Prescale()
+{
+	static const uint16_t prescale[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+	return prescale[TCCR2B & 0x07];
+}
+
+static uint8_t simTimer2Top()
+{
+	return (TCCR2A & _BV(WGM21)) ? OCR2A : 0xFF;
+}
+
+// Cycles to the next compare match, 0 if the timer is stopped
+static unsigned long simTimer2Next()
+{
+	unsigned long prescale = simTimer2Prescale();
+	if (prescale == 0)
+	{
+		return 0;
+	}
+	unsigned long ticks = (TCNT2 <= simTimer2Top()) ? simTimer2Top() - TCNT2 + 1 : 0x100 - TCNT2;
+	return (ticks * prescale) - simTimer2Cycles;
+}
+
+static void simTimer2Step(unsigned long cycles)
+{
+	unsigned long prescale = simTimer2Prescale();
+	if (prescale == 0)
+	{
+		return;
+	}
+	simTimer2Cycles += cycles;
+	unsigned int count = TCNT2 + (simTimer2Cycles / prescale);
+	simTimer2Cycles %= prescale;
+	if ((TCNT2 <= simTimer2Top()) && (count > simTimer2Top()))
+	{
+		count = 0;
+		TIFR2.set(_BV(OCF2A));
+	}
+	TCNT2 = count;
+}
+
+/*
+ * Interrupts
+ */
+
+/**
+ * Runs the pending interrupts while the I bit is set. An interrupt runs with the I bit clear and does not
+ * nest.
+ */
+static void simRunInterrupts()
+{
+	if (simInIsr)
+	{
+		return;
+	}
+	simInIsr = true;
+	while (SREG & _BV(SREG_I))
+	{
+		void (*vector)(void) = NULL;
+		if ((TIMSK2 & _BV(OCIE2A)) && (TIFR2 & _BV(OCF2A)) && (TIMER2_COMPA_vect != NULL))
+		{
+			TIFR2 = _BV(OCF2A);
+			vector = TIMER2_COMPA_vect;
+		}
+		else if (simTwiPending() && (TWI_vect != NULL))
+		{
+			vector = TWI_vect; // TWINT stays set until the interrupt writes TWCR
+		}
+		if (vector == NULL)
+		{
+			break;
+		}
+		unsigned long start = simClock;
+		cli();
+		(*vector)();
+		sei();
+		simIsrCycles += simClock - start;
+	}
+	simInIsr = false;
+}
+
+simStatusRegister &simStatusRegister::operator=(uint8_t b)
+{
+	boolean enable = !(bits & _BV(SREG_I)) && (b & _BV(SREG_I));
+	bits = b;
+	if (enable)
+	{
+		simRunInterrupts();
+	}
+	return *this;
+}
+
+/*
+ * Probe
+ */
+static void simProbeSample()
+{
+	for (uint8_t i = 0; i < simProbeCount; i++)
+	{
+		boolean level = simPinOutput(simProbePins[i]);
+		if ((level != simProbeLevels[i]) && (simEdgeCount < SIM_PROBE_EDGES))
+		{
+			simProbeLevels[i] = level;
+			simEdges[simEdgeCount].cycle = simClock;
+			simEdges[simEdgeCount].pin = simProbePins[i];
+			simEdges[simEdgeCount].level = level;
+			simEdgeCount++;
+		}
+	}
+}
+
+/**
+ * Records the changes of the level driven on a pin (its PORTx bit), as seen each time the clock moves. The
+ * first edge of a pin is its level when the probe is attached.
+ * @param pin Pin number, up to 4 pins
+ */
+void simProbe(uint8_t pin)
+{
+	if ((simProbeCount < SIM_PROBE_PINS) && (simEdgeCount < SIM_PROBE_EDGES))
+	{
+		simProbePins[simProbeCount] = pin;
+		simProbeLevels[simProbeCount] = simPinOutput(pin);
+		simProbeCount++;
+		simEdges[simEdgeCount].cycle = simClock;
+		simEdges[simEdgeCount].pin = pin;
+		simEdges[simEdgeCount].level = simPinOutput(pin);
+		simEdgeCount++;
+	}
+}
+
+/**
+ * @return Number of edges recorded by the probe, up to 4096
+ */
+unsigned int simProbeEdges()
+{
+	simProbeSample();
+	return simEdgeCount;
+}
+
+/**
+ * @param index Edge, 0 is the first
+ * @return The edge, in the order they were seen
+ */
+simEdge simProbeEdge(unsigned int index)
+{
+	return simEdges[index];
+}
+
+/*
+ * Clock
+ */
+
+/**
+ * Moves the clock on. The timers count and the interrupts that come due run on the way, the time they take is
+ * added (as it would be to a delay loop they interrupt).
+ * @param cycles Time in CPU cycles
+ */
+void simAdvanceCycles(unsigned long cycles)
+{
+	unsigned long end = simClock + cycles;
+	while (simClock < end)
+	{
+		simProbeSample();
+		unsigned long step = end - simClock;
+		unsigned long next = simTimer2Next();
+		if ((next != 0) && (next < step))
+		{
+			step = next;
+		}
+		next = simTwiNext();
+		if ((next != 0) && (next < step))
+		{
+			step = next;
+		}
+		simClock += step;
+		simTimer2Step(step);
+		simTwiStep(step);
+		unsigned long isr = simIsrCycles;
+		simRunInterrupts();
+		end += simIsrCycles - isr;
+	}
+	simProbeSample();
+}
+
+/**
+ * Moves the clock on.
+ * @param us Time in us
+ */
+void simAdvance(unsigned long us)
+{
+	simAdvanceCycles(us * SIM_CYCLES_PER_US);
+}
+
+/**
+ * Sets the clock, moving it on if the time is ahead.
+ * @param us Time in us
+ */
+void simSetMicros(unsigned long us)
+{
+	unsigned long cycles = us * SIM_CYCLES_PER_US;
+	if (cycles > simClock)
+	{
+		simAdvanceCycles(cycles - simClock);
+	}
+	else
+	{
+		simClock = cycles;
+	}
+}
+
+/**
+ * @return Clock in CPU cycles
+ */
+unsigned long simCycles()
+{
+	return simClock;
+}
+
+/**
+ * @return CPU cycles spent in the interrupts the simulation ran since simReset()
+ */
+unsigned long simInterruptCycles()
+{
+	return simIsrCycles;
+}
+
+/**
+ * @param pin Pin number
+ * @return Level the sketch is driving on the pin (the PORTx bit)
+ */
+boolean simPinOutput(uint8_t pin)
+{
+	return (*portOutputRegister(digitalPinToPort(pin)) & digitalPinToBitMask(pin)) != 0;
+}
+
+/**
+ * Sets the level seen on an input pin.
+ * @param pin Pin number
+ * @param state Level
+ */
+void simSetInput(uint8_t pin, boolean state)
+{
+	volatile uint8_t *reg = portInputRegister(digitalPinToPort(pin));
+	if (state)
+		*reg |= digitalPinToBitMask(pin);
+	else
+		*reg &= ~digitalPinToBitMask(pin);
+}
+
+/**
+ * Calls the function attached to an external interrupt, if interrupts are on.
+ * @param interruptNum Interrupt number (0 is pin 2, 1 is pin 3)
+ */
+void simInterrupt(uint8_t interruptNum)
+{
+	if ((interruptNum < 2) && (simInterrupts[interruptNum] != NULL) && (SREG & _BV(SREG_I)))
+		(*simInterrupts[interruptNum])();
+}
+
+volatile uint8_t *simPortRegister(uint8_t port, uint8_t reg)
+{
+	static volatile uint8_t dummy;
+	switch (port)
+	{
+	case PB:
+		return (reg == 0) ? &PORTB : ((reg == 1) ? &PINB : &DDRB);
+	case PC:
+		return (reg == 0) ? &PORTC : ((reg == 1) ? &PINC : &DDRC);
+	case PD:
+		return (reg == 0) ? &PORTD : ((reg == 1) ? &PIND : &DDRD);
+	}
+	return &dummy;
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+	uint8_t mask = digitalPinToBitMask(pin);
+	uint8_t port = digitalPinToPort(pin);
+	if (mode == OUTPUT)
+	{
+		*portModeRegister(port) |= mask;
+	}
+	else
+	{
+		*portModeRegister(port) &= ~mask;
+		if (mode == INPUT_PULLUP)
+			*portOutputRegister(port) |= mask;
+		else
+			*portOutputRegister(port) &= ~mask;
+	}
+	simSpiPins();
+	simTwiPins();
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+	if (val == LOW)
+		*portOutputRegister(digitalPinToPort(pin)) &= ~digitalPinToBitMask(pin);
+	else
+		*portOutputRegister(digitalPinToPort(pin)) |= digitalPinToBitMask(pin);
+	simSpiPins();
+	simTwiPins();
+}
+
+int digitalRead(uint8_t pin)
+{
+	return (*portInputRegister(digitalPinToPort(pin)) & digitalPinToBitMask(pin)) ? HIGH : LOW;
+}
+
+void attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int)
+{
+	if (interruptNum < 2)
+		simInterrupts[interruptNum] = userFunc;
+}
+
+void detachInterrupt(uint8_t interruptNum)
+{
+	if (interruptNum < 2)
+		simInterrupts[interruptNum] = NULL;
+}
+
+unsigned long millis()
+{
+	simTwiWait();
+	return simClock / (SIM_CYCLES_PER_US * 1000);
+}
+
+unsigned long micros()
+{
+	simTwiWait();
+	return simClock / SIM_CYCLES_PER_US;
+}
+
+void delay(unsigned long ms)
+{
+	simAdvanceCycles(ms * SIM_CYCLES_PER_US * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	simAdvanceCycles(us * SIM_CYCLES_PER_US);
+}
+
+long random(long howbig)
+{
+	return (howbig <= 0) ? 0 : ::random() % howbig;
+}
+
+long random(long howsmall, long howbig)
+{
+	return (howsmall >= howbig) ? howsmall : howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed)
+{
+	if (seed != 0)
+		srandom(seed);
+}
+
+void _delay_loop_1(uint8_t count)
+{
+	simAdvanceCycles(3 * ((count == 0) ? 0x100UL : count));
+}
+
+void _delay_loop_2(uint16_t count)
+{
+	simAdvanceCycles(4 * ((count == 0) ? 0x10000UL : count));
+}
@@ -0,0 +1,153 @@
+/*
+ * simDns.cpp
+ * Simulated DNS server on the other end of the UDP sockets of a simulated WIZnet chip, with an answer time and
+ * a TTL for each name.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "sim.h"
+#include <strings.h>
+
+#define SIMDNS_HEADER 12
+#define SIMDNS_PORT 53
+#define SIMDNS_FLAGS 0x8180 // response, recursion desired and available
+#define SIMDNS_NXDOMAIN 0x0003
+
+simDnsServer::simDnsServer()
+{
+	numNames = 0;
+	numAnswers = 0;
+	requests = 0;
+	answered = 0;
+	lastId = 0;
+	lastPort = 0;
+	silent = false;
+}
+
+/**
+ * Adds a name the server knows
+ * @param name Name, up to 31 characters, matched without regard to case
+ * @param address Address, 4 bytes
+ * @param ttl TTL of the answer, in seconds
+ * @param latency Time from the query to the answer, in us
+ */
+void simDnsServer::add(const char *name, const uint8_t *address, uint32_t ttl, unsigned long latency)
+{
+	if (numNames < SIM_DNS_NAMES)
+	{
+		simDnsName &n = names[numNames++];
+		strncpy(n.name, name, sizeof(n.name) - 1);
+		n.name[sizeof(n.name) - 1] = 0;
+		memcpy(n.address, address, 4);
+		n.ttl = ttl;
+		n.latency = latency;
+	}
+}
+
+/**
+ * A query from a socket of the chip: the answer is built now and queued until it is due. Datagrams that are
+ * not a single question, or for which the queue is full, are dropped.
+ */
+void simDnsServer::sent(simWiznet &chip, uint8_t s, const uint8_t *ip, uint16_t port, const uint8_t *data,
+                        uint16_t length)
+{
+	if ((port != SIMDNS_PORT) || (length < SIMDNS_HEADER) || (data[4] != 0) || (data[5] != 1))
+	{
+		return;
+	}
+	requests++;
+	lastId = (data[0] << 8) | data[1];
+	lastPort = chip.port(s);
+
+	// the name, as dotted labels
+	char name[64];
+	uint8_t nameLength = 0;
+	uint16_t i = SIMDNS_HEADER;
+	while ((i < length) && (data[i] != 0))
+	{
+		uint8_t label = data[i++];
+		if ((i + label > length) || (nameLength + label + 1 >= (uint8_t) sizeof(name)))
+		{
+			return;
+		}
+		if (nameLength > 0)
+		{
+			name[nameLength++] = '.';
+		}
+		memcpy(name + nameLength, data + i, label);
+		nameLength += label;
+		i += label;
+	}
+	name[nameLength] = 0;
+	uint16_t questionEnd = i + 5; // the terminating label, type and class
+	if ((questionEnd > length) || silent || (numAnswers == SIM_DNS_ANSWERS) ||
+	    (questionEnd + 16 > SIM_DNS_PACKET))
+	{
+		return;
+	}
+	const simDnsName *known = NULL;
+	for (uint8_t n = 0; n < numNames; n++)
+	{
+		if (strcasecmp(names[n].name, name) == 0)
+		{
+			known = names + n;
+		}
+	}
+
+	// header and question as in the query, then the answer with a pointer to the question name
+	simDnsAnswer &a = answers[numAnswers++];
+	a.s = s;
+	memcpy(a.from, ip, 4);
+	memcpy(a.data, data, questionEnd);
+	uint16_t flags = SIMDNS_FLAGS | ((known == NULL) ? SIMDNS_NXDOMAIN : 0);
+	a.data[2] = flags >> 8;
+	a.data[3] = flags;
+	a.data[6] = 0;
+	a.data[7] = (known == NULL) ? 0 : 1;
+	memset(a.data + 8, 0, 4);
+	a.length = questionEnd;
+	a.due = simCycles();
+	if (known != NULL)
+	{
+		uint8_t record[16] = {0xC0, SIMDNS_HEADER, 0x00, 0x01, 0x00, 0x01,
+		                      (uint8_t) (known->ttl >> 24), (uint8_t) (known->ttl >> 16),
+		                      (uint8_t) (known->ttl >> 8), (uint8_t) known->ttl, 0x00, 0x04,
+		                      known->address[0], known->address[1], known->address[2], known->address[3]};
+		memcpy(a.data + a.length, record, sizeof(record));
+		a.length += sizeof(record);
+		a.due += known->latency * (F_CPU / 1000000L);
+	}
+}
+
+/**
+ * Passes the answers that are due to their sockets, in the order they come due. An answer for a socket that
+ * has been closed is lost.
+ */
+void simDnsServer::poll(simWiznet &chip)
+{
+	unsigned long now = simCycles();
+	for (;;)
+	{
+		uint8_t next = numAnswers;
+		for (uint8_t i = 0; i < numAnswers; i++)
+		{
+			if ((answers[i].due <= now) && ((next == numAnswers) || (answers[i].due < answers[next].due)))
+			{
+				next = i;
+			}
+		}
+		if (next == numAnswers)
+		{
+			return;
+		}
+		simDnsAnswer &a = answers[next];
+		if (chip.peerSendTo(a.s, a.from, SIMDNS_PORT, a.data, a.length))
+		{
+			answered++;
+		}
+		numAnswers--;
+		memmove(answers + next, answers + next + 1, (numAnswers - next) * sizeof(simDnsAnswer));
+	}
+}
@@ -0,0 +1,172 @@
+/*
+ * simSpi.cpp
+ * Simulated SPI bus and the 74HC595 and 74HC165 chains on it (the Ethernet chips are in simWiznet.cpp).
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "sim.h"
+
+volatile uint8_t SPCR;
+static simSpiDataRegister spiData;
+simSpiStatusRegister SPSR;
+
+static simSpiDevice *spiDevices;
+static unsigned long spiBytes;
+
+void simSpiReset()
+{
+	SPCR = 0;
+	SPSR = 0;
+	SPDR = 0;
+	spiDevices = NULL;
+	spiBytes = 0;
+}
+
+simSpiDataRegister &simSpiData()
+{
+	return spiData;
+}
+
+simSpiDataRegister &simSpiDataRegister::operator=(uint8_t data)
+{
+	received = simSpiExchange(data);
+	return *this;
+}
+
+/**
+ * Attach a device to the bus, it is not owned by the bus.
+ * @param device Device to attach
+ */
+void simSpiAttach(simSpiDevice *device)
+{
+	device->next = spiDevices;
+	spiDevices = device;
+}
+
+/**
+ * @param device Device to remove from the bus
+ */
+void simSpiDetach(simSpiDevice *device)
+{
+	simSpiDevice **p = &spiDevices;
+	while (*p != NULL)
+	{
+		if (*p == device)
+		{
+			*p = device->next;
+			device->next = NULL;
+			return;
+		}
+		p = &(*p)->next;
+	}
+}
+
+/**
+ * Exchange one byte with every device on the bus.
+ * @param out Byte sent by the master
+ * @return Byte on MISO, 0xFF (pulled up) if no device drives it
+ */
+uint8_t simSpiExchange(uint8_t out)
+{
+	uint8_t in = 0xFF;
+	spiBytes++;
+	for (simSpiDevice *d = spiDevices; d != NULL; d = d->next)
+	{
+		d->exchange(out, &in);
+	}
+	return in;
+}
+
+/**
+ * Lets the devices see the pins after pinMode() or digitalWrite().
+ */
+void simSpiPins()
+{
+	for (simSpiDevice *d = spiDevices; d != NULL; d = d->next)
+	{
+		d->pins();
+	}
+}
+
+/**
+ * @return Bytes on the bus since simReset()
+ */
+unsigned long simSpiBytes()
+{
+	return spiBytes;
+}
+
+/*
+ * sim595
+ */
+
+sim595::sim595(uint8_t latchPin, uint8_t numChips)
+{
+	this->latchPin = latchPin;
+	this->numChips = numChips;
+	chips = (uint8_t *) calloc(numChips, sizeof(uint8_t));
+	latchErrors = 0;
+}
+
+sim595::~sim595()
+{
+	simSpiDetach(this);
+	free(chips);
+}
+
+/**
+ * Shift one byte into chip 0, every chip passes its byte on to the next one.
+ */
+void sim595::exchange(uint8_t out, uint8_t *)
+{
+	if (simPinOutput(latchPin))
+	{
+		latchErrors++;
+	}
+	for (uint8_t i = numChips - 1; i != 0; i--)
+	{
+		chips[i] = chips[i - 1];
+	}
+	chips[0] = out;
+}
+
+/*
+ * sim165
+ */
+
+sim165::sim165(uint8_t latchPin, uint8_t numChips)
+{
+	this->latchPin = latchPin;
+	this->numChips = numChips;
+	inputs = (uint8_t *) calloc(numChips, sizeof(uint8_t));
+	position = 0;
+	latchErrors = 0;
+}
+
+sim165::~sim165()
+{
+	simSpiDetach(this);
+	free(inputs);
+}
+
+/**
+ * Shift one byte out of the chain, the frame starts again at chip 0 after numChips bytes. While the latch is
+ * low the chain is loading and does not shift.
+ */
+void sim165::exchange(uint8_t, uint8_t *in)
+{
+	if (!simPinOutput(latchPin))
+	{
+		latchErrors++;
+		position = 0;
+		*in = inputs[0];
+		return;
+	}
+	*in = inputs[position];
+	if (++position >= numChips)
+	{
+		position = 0;
+	}
+}
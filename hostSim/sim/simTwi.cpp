@@ -0,0 +1,614 @@
+/*
+ * simTwi.cpp
+ * Simulated TWI module and bus under the real Wire/utility/twi.c. A TWCR write with TWINT set starts the next
+ * operation on the bus, it takes its time at the SCL rate set by TWBR and TWSR (a start or a stop one SCL
+ * period, a byte and its acknowledge nine), then the status goes in TWSR and TWINT is set, so the twi
+ * interrupt runs from the simulated clock. While an operation is on the bus, each millis() or micros() call and
+ * each TWCR read moves the clock on to its end, as the code waiting for it would.
+ *
+ * The trace (simTwiTrace()) has one word per condition or byte: S start, Sr repeated start, P stop, an address
+ * as 40W or 40R, a data byte as A5, a NACK as a - after the byte, and L where another master won the
+ * arbitration.
+ *
+ * Rev 2 - 10/2026 - the twi module registers in place of the twi_ functions
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include <stdio.h>
+#include "sim.h"
+#include "pins_arduino.h"
+#include <compat/twi.h>
+extern "C" {
+#include "utility/twi.h"
+}
+
+volatile uint8_t TWBR, TWSR, TWAR, TWDR;
+simTwiControlRegister TWCR;
+
+#define SIM_TWI_POLL_CYCLES 16 // one pass of a polling loop, while the bus is held
+#define SIM_TWI_TRACE 1024
+
+// operation on the bus
+enum { SIM_TWI_NONE, SIM_TWI_START, SIM_TWI_STOP, SIM_TWI_ADDRESS, SIM_TWI_WRITE, SIM_TWI_READ, SIM_TWI_SLAVE_BYTE,
+       SIM_TWI_SLAVE_STOP };
+// what clearing TWINT does next
+enum { SIM_TWI_FREE, SIM_TWI_SEND_ADDRESS, SIM_TWI_MT, SIM_TWI_MR, SIM_TWI_SR, SIM_TWI_NACKED };
+
+static simTwiDevice *twiDevices;
+static uint8_t twiControl; // TWEA, TWSTA, TWSTO, TWEN and TWIE as written
+static boolean twiInt; // TWINT
+static boolean twiMaster;
+static uint8_t twiPhase;
+static uint8_t twiOp;
+static unsigned long twiOpCycles; // left of the operation
+static uint8_t twiOpByte;
+static boolean twiOpAck;
+static int twiDeferred; // TWCR write made while an operation was on the bus, -1 if none
+static uint8_t twiAddress;
+static boolean twiWriting; // a write is addressed, the devices get it at the stop or repeated start
+static uint8_t twiBuffer[256];
+static uint8_t twiLength;
+static simTwiDevice *twiReader;
+static boolean twiHoldScl;
+static uint8_t twiHoldSda; // SCL clocks until a device lets go of SDA
+static boolean twiSclLow;
+static boolean twiArbitration;
+static uint8_t twiArbAddress;
+static const uint8_t *twiArbData;
+static uint8_t twiArbLength;
+static uint8_t twiArbIndex;
+static unsigned long twiBytes;
+static unsigned long twiTransactions;
+static unsigned long twiStops;
+static char twiTrace[SIM_TWI_TRACE];
+static unsigned int twiTraceLength;
+
+void simTwiPins();
+void simTwiWait();
+
+/**
+ * Access to the device list for the bus.
+ */
+class simTwiBus
+{
+public:
+	static simTwiDevice *next(simTwiDevice *d) { return d->next; }
+};
+
+void simTwiReset()
+{
+	twiDevices = NULL;
+	TWBR = TWSR = TWAR = TWDR = 0;
+	twiControl = 0;
+	twiInt = false;
+	twiMaster = false;
+	twiPhase = SIM_TWI_FREE;
+	twiOp = SIM_TWI_NONE;
+	twiOpCycles = 0;
+	twiDeferred = -1;
+	twiWriting = false;
+	twiLength = 0;
+	twiReader = NULL;
+	twiHoldScl = false;
+	twiHoldSda = 0;
+	twiSclLow = false;
+	twiArbitration = false;
+	twiBytes = 0;
+	twiTransactions = 0;
+	twiStops = 0;
+	twiTraceLength = 0;
+	twiTrace[0] = '\0';
+	simTwiPins();
+}
+
+static void simTwiLog(const char *word)
+{
+	size_t length = strlen(word);
+	if (twiTraceLength + length + 2 < SIM_TWI_TRACE)
+	{
+		if (twiTraceLength != 0)
+		{
+			twiTrace[twiTraceLength++] = ' ';
+		}
+		strcpy(twiTrace + twiTraceLength, word);
+		twiTraceLength += length;
+	}
+}
+
+static void simTwiLogByte(uint8_t b, const char *suffix, boolean ack)
+{
+	char word[8];
+	snprintf(word, sizeof(word), "%02X%s%s", b, suffix, ack ? "" : "-");
+	simTwiLog(word);
+}
+
+/*
+ * Bus
+ */
+
+static boolean simTwiHeld()
+{
+	return twiHoldScl || (twiHoldSda != 0);
+}
+
+// SCL period in CPU cycles
+static unsigned long simTwiPeriod()
+{
+	return 16 + (2UL * TWBR * (1UL << (2 * (TWSR & 0x03))));
+}
+
+static void simTwiBegin(uint8_t op, unsigned long periods)
+{
+	twiOp = op;
+	twiOpCycles = periods * simTwiPeriod();
+	twiOpByte = TWDR;
+}
+
+// The devices addressed by a write get its bytes
+static void simTwiEndWrite()
+{
+	if (!twiWriting)
+	{
+		return;
+	}
+	twiWriting = false;
+	for (simTwiDevice *d = twiDevices; d != NULL; d = simTwiBus::next(d))
+	{
+		if (d->matches(twiAddress))
+		{
+			d->write(twiBuffer, twiLength);
+		}
+	}
+}
+
+// Starts what a TWCR write with TWINT set asks for
+static void simTwiAction(uint8_t control)
+{
+	if (control & _BV(TWSTO))
+	{
+		if (twiMaster)
+		{
+			simTwiBegin(SIM_TWI_STOP, 1);
+		}
+		else
+		{
+			twiControl &= ~_BV(TWSTO); // a slave only recovers, there is no stop on the bus
+			twiPhase = SIM_TWI_FREE;
+		}
+		return;
+	}
+	if (control & _BV(TWSTA))
+	{
+		simTwiBegin(SIM_TWI_START, 1);
+		return;
+	}
+	twiOpAck = (control & _BV(TWEA)) != 0;
+	switch (twiPhase)
+	{
+	case SIM_TWI_SEND_ADDRESS:
+		simTwiBegin(SIM_TWI_ADDRESS, 9);
+		break;
+	case SIM_TWI_MT:
+		simTwiBegin(SIM_TWI_WRITE, 9);
+		break;
+	case SIM_TWI_MR:
+		simTwiBegin(SIM_TWI_READ, 9);
+		break;
+	case SIM_TWI_SR:
+		simTwiBegin((twiArbIndex < twiArbLength) ? SIM_TWI_SLAVE_BYTE : SIM_TWI_SLAVE_STOP,
+		            (twiArbIndex < twiArbLength) ? 9 : 1);
+		break;
+	}
+}
+
+// The operation on the bus is done
+static void simTwiComplete()
+{
+	uint8_t op = twiOp;
+	uint8_t status = TW_NO_INFO;
+	boolean interrupt = true;
+	twiOp = SIM_TWI_NONE;
+	switch (op)
+	{
+	case SIM_TWI_START:
+		if (twiMaster)
+		{
+			simTwiEndWrite();
+			status = TW_REP_START;
+			simTwiLog("Sr");
+		}
+		else
+		{
+			status = TW_START;
+			simTwiLog("S");
+		}
+		twiMaster = true;
+		twiPhase = SIM_TWI_SEND_ADDRESS;
+		twiTransactions++;
+		break;
+	case SIM_TWI_STOP:
+		simTwiEndWrite();
+		twiMaster = false;
+		twiPhase = SIM_TWI_FREE;
+		twiControl &= ~_BV(TWSTO);
+		twiStops++;
+		interrupt = false; // TWINT is not set after a stop
+		simTwiLog("P");
+		break;
+	case SIM_TWI_ADDRESS:
+		twiBytes++;
+		if (twiArbitration)
+		{
+			// the other master sent a lower address, this one drops out and may be the one addressed
+			twiArbitration = false;
+			twiMaster = false;
+			simTwiLog("L");
+			if ((twiArbAddress == (TWAR >> 1)) && (twiControl & _BV(TWEA)))
+			{
+				status = TW_SR_ARB_LOST_SLA_ACK;
+				twiPhase = SIM_TWI_SR;
+			}
+			else
+			{
+				status = TW_MT_ARB_LOST;
+				twiPhase = SIM_TWI_FREE;
+			}
+			break;
+		}
+		twiAddress = twiOpByte >> 1;
+		if (twiOpByte & TW_READ)
+		{
+			twiReader = NULL;
+			for (simTwiDevice *d = twiDevices; (d != NULL) && (twiReader == NULL); d = simTwiBus::next(d))
+			{
+				if (d->matches(twiAddress))
+				{
+					twiReader = d;
+				}
+			}
+			status = (twiReader != NULL) ? TW_MR_SLA_ACK : TW_MR_SLA_NACK;
+			twiPhase = (twiReader != NULL) ? SIM_TWI_MR : SIM_TWI_NACKED;
+			simTwiLogByte(twiAddress, "R", twiReader != NULL);
+		}
+		else
+		{
+			twiWriting = false;
+			for (simTwiDevice *d = twiDevices; d != NULL; d = simTwiBus::next(d))
+			{
+				twiWriting |= d->matches(twiAddress);
+			}
+			twiLength = 0;
+			status = twiWriting ? TW_MT_SLA_ACK : TW_MT_SLA_NACK;
+			twiPhase = twiWriting ? SIM_TWI_MT : SIM_TWI_NACKED;
+			simTwiLogByte(twiAddress, "W", twiWriting);
+		}
+		break;
+	case SIM_TWI_WRITE:
+	{
+		boolean ack = true;
+		twiBytes++;
+		for (simTwiDevice *d = twiDevices; d != NULL; d = simTwiBus::next(d))
+		{
+			if (d->matches(twiAddress) && !d->ackData(twiLength))
+			{
+				ack = false;
+			}
+		}
+		twiBuffer[twiLength++] = twiOpByte;
+		status = ack ? TW_MT_DATA_ACK : TW_MT_DATA_NACK;
+		twiPhase = ack ? SIM_TWI_MT : SIM_TWI_NACKED;
+		simTwiLogByte(twiOpByte, "", ack);
+		break;
+	}
+	case SIM_TWI_READ:
+	{
+		uint8_t b = 0xFF;
+		twiBytes++;
+		twiReader->read(&b, 1);
+		TWDR = b;
+		status = twiOpAck ? TW_MR_DATA_ACK : TW_MR_DATA_NACK;
+		twiPhase = twiOpAck ? SIM_TWI_MR : SIM_TWI_NACKED;
+		simTwiLogByte(b, "", twiOpAck);
+		break;
+	}
+	case SIM_TWI_SLAVE_BYTE:
+		twiBytes++;
+		TWDR = twiArbData[twiArbIndex++];
+		status = twiOpAck ? TW_SR_DATA_ACK : TW_SR_DATA_NACK;
+		simTwiLogByte(TWDR, "", twiOpAck);
+		break;
+	case SIM_TWI_SLAVE_STOP:
+		status = TW_SR_STOP;
+		twiPhase = SIM_TWI_FREE;
+		simTwiLog("P");
+		break;
+	}
+	TWSR = (TWSR & 0x03) | status;
+	if (twiDeferred >= 0)
+	{
+		// written while the operation was on the bus, it takes effect now
+		uint8_t control = twiDeferred;
+		twiDeferred = -1;
+		simTwiAction(control);
+		return;
+	}
+	if (interrupt)
+	{
+		twiInt = true;
+	}
+}
+
+/*
+ * Registers
+ */
+
+simTwiControlRegister &simTwiControlRegister::operator=(uint8_t control)
+{
+	twiControl = control & (_BV(TWEA) | _BV(TWSTA) | _BV(TWSTO) | _BV(TWEN) | _BV(TWIE));
+	if (!(control & _BV(TWEN)))
+	{
+		// off, the module lets go of the bus and forgets the transfer
+		twiInt = false;
+		twiOp = SIM_TWI_NONE;
+		twiDeferred = -1;
+		twiMaster = false;
+		twiPhase = SIM_TWI_FREE;
+		twiWriting = false;
+		twiReader = NULL;
+		return *this;
+	}
+	if (!(control & _BV(TWINT)))
+	{
+		return *this;
+	}
+	if (twiOp != SIM_TWI_NONE)
+	{
+		twiDeferred = control;
+		return *this;
+	}
+	twiInt = false;
+	simTwiAction(control);
+	return *this;
+}
+
+simTwiControlRegister::operator uint8_t() const
+{
+	simTwiWait();
+	uint8_t control = twiControl & ~_BV(TWSTO);
+	if (twiInt)
+	{
+		control |= _BV(TWINT);
+	}
+	if (twiOp == SIM_TWI_STOP)
+	{
+		control |= _BV(TWSTO); // cleared by the module when the stop is done
+	}
+	return control;
+}
+
+/*
+ * Hooks for the clock (simCore.cpp)
+ */
+
+/**
+ * @return Cycles to the end of the operation on the bus, 0 if there is none or the bus is held
+ */
+unsigned long simTwiNext()
+{
+	return ((twiOp == SIM_TWI_NONE) || simTwiHeld()) ? 0 : twiOpCycles;
+}
+
+/**
+ * Moves the operation on the bus on.
+ * @param cycles CPU cycles
+ */
+void simTwiStep(unsigned long cycles)
+{
+	if ((twiOp == SIM_TWI_NONE) || simTwiHeld())
+	{
+		return;
+	}
+	twiOpCycles = (cycles < twiOpCycles) ? twiOpCycles - cycles : 0;
+	if (twiOpCycles == 0)
+	{
+		simTwiComplete();
+	}
+}
+
+/**
+ * @return true if the twi interrupt is due
+ */
+boolean simTwiPending()
+{
+	return twiInt && ((twiControl & (_BV(TWEN) | _BV(TWIE))) == (_BV(TWEN) | _BV(TWIE)));
+}
+
+/**
+ * The code is waiting for the bus: moves the clock to the end of the operation on the bus, or on by one
+ * pass of a polling loop if the bus is held or a transfer is waiting.
+ */
+void simTwiWait()
+{
+	if ((twiOp != SIM_TWI_NONE) && !simTwiHeld())
+	{
+		simAdvanceCycles(twiOpCycles);
+	}
+	else if ((twiOp != SIM_TWI_NONE) || !twi_isIdle())
+	{
+		simAdvanceCycles(SIM_TWI_POLL_CYCLES);
+	}
+}
+
+/**
+ * SDA and SCL as read on the pins: low if the sketch drives them low or a device holds them. Called when the
+ * pins change, a device holding SDA lets go after enough SCL clocks.
+ */
+void simTwiPins()
+{
+	uint8_t scl = digitalPinToBitMask(SCL);
+	uint8_t sda = digitalPinToBitMask(SDA);
+	boolean sclLow = twiHoldScl || ((DDRC & scl) && !(PORTC & scl));
+	if (twiSclLow && !sclLow && (twiHoldSda != 0))
+	{
+		twiHoldSda--;
+	}
+	twiSclLow = sclLow;
+	boolean sdaLow = (twiHoldSda != 0) || ((DDRC & sda) && !(PORTC & sda));
+	simSetInput(SCL, !sclLow);
+	simSetInput(SDA, !sdaLow);
+}
+
+/*
+ * Test interface
+ */
+
+/**
+ * Attach a device to the bus, it is not owned by the bus.
+ * @param device Device to attach
+ */
+void simTwiAttach(simTwiDevice *device)
+{
+	device->next = twiDevices;
+	twiDevices = device;
+}
+
+/**
+ * @param device Device to remove from the bus
+ */
+void simTwiDetach(simTwiDevice *device)
+{
+	simTwiDevice **p = &twiDevices;
+	while (*p != NULL)
+	{
+		if (*p == device)
+		{
+			*p = device->next;
+			device->next = NULL;
+			return;
+		}
+		p = &(*p)->next;
+	}
+}
+
+/**
+ * Runs the clock until the queued transfers are done, or the bus is held or waiting for the sketch (a
+ * repeated start held for a blocking call).
+ * @return Number of stop conditions on the bus
+ */
+int simTwiRun()
+{
+	unsigned long stops = twiStops;
+	while (!simTwiHeld())
+	{
+		if (twiOp != SIM_TWI_NONE)
+		{
+			simAdvanceCycles(twiOpCycles);
+		}
+		else if (simTwiPending() && (SREG & _BV(SREG_I)))
+		{
+			simAdvanceCycles(1);
+		}
+		else
+		{
+			break;
+		}
+	}
+	return twiStops - stops;
+}
+
+/**
+ * A device stretches the clock: the bus makes no progress while it holds SCL low.
+ * @param hold true to hold SCL low
+ */
+void simTwiHoldClock(boolean hold)
+{
+	twiHoldScl = hold;
+	simTwiPins();
+}
+
+/**
+ * A device holds SDA low, as one left in the middle of a byte by a reset does, and lets go of it after a
+ * number of SCL clocks. The bus makes no progress while it is held.
+ * @param clocks SCL clocks until it lets go, 0 lets go at once
+ */
+void simTwiHoldData(uint8_t clocks)
+{
+	twiHoldSda = clocks;
+	simTwiPins();
+}
+
+/**
+ * Another master starts at the same time as the next start and wins the arbitration on the address byte.
+ * If it addresses this one (TWAR) the data is received in slave mode, then it sends a stop.
+ * @param address 7 bit address the other master sends to
+ * @param data Bytes it writes, kept by the caller until the stop
+ * @param length Number of bytes
+ */
+void simTwiLoseArbitration(uint8_t address, const uint8_t *data, uint8_t length)
+{
+	twiArbitration = true;
+	twiArbAddress = address;
+	twiArbData = data;
+	twiArbLength = length;
+	twiArbIndex = 0;
+}
+
+/**
+ * @return Bytes on the bus since simReset(), including the address bytes
+ */
+unsigned long simTwiBytes()
+{
+	return twiBytes;
+}
+
+/**
+ * @return Start and repeated start conditions since simReset()
+ */
+unsigned long simTwiTransactions()
+{
+	return twiTransactions;
+}
+
+/**
+ * @return The bus trace since simReset(), up to 1 kB
+ */
+const char *simTwiTrace()
+{
+	return twiTrace;
+}
+
+/*
+ * simRegisterDevice
+ */
+
+simRegisterDevice::simRegisterDevice(uint8_t address)
+{
+	this->address = address;
+	pointer = 0;
+	memset(regs, 0, sizeof(regs));
+	writes = 0;
+	nack = false;
+}
+
+void simRegisterDevice::write(const uint8_t *data, uint8_t length)
+{
+	writes++;
+	if (length == 0)
+	{
+		return;
+	}
+	pointer = data[0];
+	for (uint8_t i = 1; i < length; i++)
+	{
+		regs[pointer++] = data[i];
+	}
+}
+
+void simRegisterDevice::read(uint8_t *data, uint8_t length)
+{
+	for (uint8_t i = 0; i < length; i++)
+	{
+		data[i] = regs[pointer++];
+	}
+}
@@ -0,0 +1,580 @@
+/*
+ * simWiznet.cpp
+ * Simulated W5100 and W5500 Ethernet chips on the SPI bus. The register file and socket memory are shared, the
+ * two chips only differ in how a frame addresses them. The registers are addressed the W5500 way inside: block 0
+ * is the common registers, block 4s+1 the registers of socket s, 4s+2 its transmit and 4s+3 its receive memory.
+ *
+ * Rev 3 - 10/2026 - Sn_TX_WR reads back the pointer of the last SEND
+ * Rev 2 - 10/2026 - a lingering DISCON from CLOSE_WAIT waits in LAST_ACK
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "sim.h"
+
+#define SIMWIZ_MEMORY 2048
+#define SIMWIZ_MASK (SIMWIZ_MEMORY - 1)
+
+// socket registers
+#define SIMWIZ_MR 0x00
+#define SIMWIZ_CR 0x01
+#define SIMWIZ_IR 0x02
+#define SIMWIZ_SR 0x03
+#define SIMWIZ_DIPR 0x0C
+#define SIMWIZ_DPORT 0x10
+#define SIMWIZ_TX_FSR 0x20
+#define SIMWIZ_TX_RD 0x22
+#define SIMWIZ_TX_WR 0x24
+#define SIMWIZ_RX_RSR 0x26
+#define SIMWIZ_RX_RD 0x28
+#define SIMWIZ_RX_WR 0x2A
+#define SIMWIZ_IMR 0x2C
+
+// socket modes, commands, interrupts and states
+#define SIMWIZ_TCP 0x01
+#define SIMWIZ_UDP 0x02
+#define SIMWIZ_OPEN 0x01
+#define SIMWIZ_LISTEN 0x02
+#define SIMWIZ_CONNECT 0x04
+#define SIMWIZ_DISCON 0x08
+#define SIMWIZ_CLOSE 0x10
+#define SIMWIZ_SEND 0x20
+#define SIMWIZ_RECV 0x40
+#define SIMWIZ_IR_SEND_OK 0x10
+#define SIMWIZ_IR_TIMEOUT 0x08
+#define SIMWIZ_IR_RECV 0x04
+#define SIMWIZ_IR_DISCON 0x02
+#define SIMWIZ_IR_CON 0x01
+#define SIMWIZ_CLOSED 0x00
+#define SIMWIZ_INIT 0x13
+#define SIMWIZ_LISTENING 0x14
+#define SIMWIZ_ESTABLISHED 0x17
+#define SIMWIZ_FIN_WAIT 0x18
+#define SIMWIZ_CLOSE_WAIT 0x1C
+#define SIMWIZ_LAST_ACK 0x1D
+#define SIMWIZ_UDP_OPEN 0x22
+
+static uint16_t simWizGet16(const uint8_t *reg)
+{
+	return (reg[0] << 8) | reg[1];
+}
+
+simWiznet::simWiznet(uint8_t csPin, uint8_t numSockets)
+{
+	this->csPin = csPin;
+	this->numSockets = numSockets;
+	sockets = (simSocket *) calloc(numSockets, sizeof(simSocket));
+	peer = NULL;
+	lingerDisconnect = false;
+	refuseConnect = false;
+	reset();
+}
+
+simWiznet::~simWiznet()
+{
+	simSpiDetach(this);
+	free(sockets);
+}
+
+/*
+ * Clears the registers and closes the sockets, as a reset (MR bit 7) does
+ */
+void simWiznet::reset()
+{
+	memset(common, 0, sizeof(common));
+	for (uint8_t s = 0; s < numSockets; s++)
+	{
+		memset(sockets[s].regs, 0, sizeof(sockets[s].regs));
+		sockets[s].regs[SIMWIZ_IMR] = 0xFF;
+		sockets[s].ir = 0;
+		sockets[s].sr = SIMWIZ_CLOSED;
+		sockets[s].txRd = 0;
+		sockets[s].rxWr = 0;
+		sockets[s].rxRsr = 0;
+	}
+}
+
+/*
+ * Sets socket interrupt bits that are not masked by Sn_IMR
+ */
+void simWiznet::interrupt(uint8_t s, uint8_t bits)
+{
+	sockets[s].ir |= bits & sockets[s].regs[SIMWIZ_IMR];
+}
+
+/*
+ * Runs a socket command, every command completes at once
+ */
+void simWiznet::command(uint8_t s, uint8_t cmd)
+{
+	simSocket &sock = sockets[s];
+	switch (cmd)
+	{
+	case SIMWIZ_OPEN:
+		sock.txRd = 0;
+		sock.rxWr = 0;
+		sock.rxRsr = 0;
+		memset(sock.regs + SIMWIZ_TX_WR, 0, 2);
+		memset(sock.regs + SIMWIZ_RX_RD, 0, 2);
+		switch (sock.regs[SIMWIZ_MR] & 0x0F)
+		{
+		case SIMWIZ_TCP:
+			sock.sr = SIMWIZ_INIT;
+			break;
+		case SIMWIZ_UDP:
+			sock.sr = SIMWIZ_UDP_OPEN;
+			break;
+		default:
+			sock.sr = SIMWIZ_CLOSED; // IPRAW, MACRAW and PPPoE are not modelled
+			break;
+		}
+		break;
+	case SIMWIZ_LISTEN:
+		if (sock.sr == SIMWIZ_INIT)
+		{
+			sock.sr = SIMWIZ_LISTENING;
+		}
+		break;
+	case SIMWIZ_CONNECT:
+		if (sock.sr == SIMWIZ_INIT)
+		{
+			sock.sr = refuseConnect ? SIMWIZ_CLOSED : SIMWIZ_ESTABLISHED;
+			interrupt(s, refuseConnect ? SIMWIZ_IR_TIMEOUT : SIMWIZ_IR_CON);
+		}
+		break;
+	case SIMWIZ_DISCON:
+		if ((sock.sr == SIMWIZ_ESTABLISHED) || (sock.sr == SIMWIZ_CLOSE_WAIT))
+		{
+			if (lingerDisconnect)
+			{
+				sock.sr = (sock.sr == SIMWIZ_ESTABLISHED) ? SIMWIZ_FIN_WAIT : SIMWIZ_LAST_ACK;
+			}
+			else
+			{
+				sock.sr = SIMWIZ_CLOSED;
+				interrupt(s, SIMWIZ_IR_DISCON);
+			}
+		}
+		break;
+	case SIMWIZ_CLOSE:
+		sock.sr = SIMWIZ_CLOSED;
+		break;
+	case SIMWIZ_SEND:
+	{
+		uint16_t txWr = simWizGet16(sock.regs + SIMWIZ_TX_WR);
+		uint16_t length = txWr - sock.txRd;
+		if ((sock.sr == SIMWIZ_ESTABLISHED) || (sock.sr == SIMWIZ_CLOSE_WAIT))
+		{
+			for (uint16_t i = 0; i < length; i++, sock.sentBytes++)
+			{
+				if (sock.sentBytes < sizeof(sock.sent))
+				{
+					sock.sent[sock.sentBytes] = sock.tx[(sock.txRd + i) & SIMWIZ_MASK];
+				}
+			}
+		}
+		else if (sock.sr == SIMWIZ_UDP_OPEN)
+		{
+			uint8_t data[SIMWIZ_MEMORY];
+			for (uint16_t i = 0; i < length; i++)
+			{
+				data[i] = sock.tx[(sock.txRd + i) & SIMWIZ_MASK];
+			}
+			if (peer != NULL)
+			{
+				peer->sent(*this, s, sock.regs + SIMWIZ_DIPR, simWizGet16(sock.regs + SIMWIZ_DPORT), data, length);
+			}
+		}
+		sock.txRd = txWr;
+		interrupt(s, SIMWIZ_IR_SEND_OK);
+		break;
+	}
+	case SIMWIZ_RECV:
+		sock.rxRsr = sock.rxWr - simWizGet16(sock.regs + SIMWIZ_RX_RD);
+		break;
+	}
+}
+
+/*
+ * Register and memory access
+ */
+
+uint8_t simWiznet::readCommon(uint16_t offset)
+{
+	return (offset < sizeof(common)) ? common[offset] : 0;
+}
+
+uint8_t simWiznet::read(uint8_t block, uint16_t offset)
+{
+	uint8_t s = block >> 2;
+	if (block == 0)
+	{
+		return readCommon(offset);
+	}
+	if (s >= numSockets)
+	{
+		return 0;
+	}
+	simSocket &sock = sockets[s];
+	switch (block & 0x03)
+	{
+	case 1:
+		break;
+	case 2:
+		return sock.tx[offset & SIMWIZ_MASK];
+	default:
+		return sock.rx[offset & SIMWIZ_MASK];
+	}
+	if (offset == SIMWIZ_CR)
+	{
+		return 0; // done
+	}
+	if (offset == SIMWIZ_IR)
+	{
+		return sock.ir;
+	}
+	if (offset == SIMWIZ_SR)
+	{
+		return sock.sr;
+	}
+	uint16_t value;
+	switch (offset & ~1)
+	{
+	case SIMWIZ_TX_FSR:
+		value = SIMWIZ_MEMORY - (uint16_t) (simWizGet16(sock.regs + SIMWIZ_TX_WR) - sock.txRd);
+		break;
+	case SIMWIZ_TX_RD:
+	case SIMWIZ_TX_WR: // the value written takes effect with the next SEND, EthernetUDP::write() counts on this
+		value = sock.txRd;
+		break;
+	case SIMWIZ_RX_RSR:
+		value = sock.rxRsr;
+		break;
+	case SIMWIZ_RX_WR:
+		value = sock.rxWr;
+		break;
+	default:
+		return (offset < sizeof(sock.regs)) ? sock.regs[offset] : 0;
+	}
+	return (offset & 1) ? (value & 0xFF) : (value >> 8);
+}
+
+void simWiznet::write(uint8_t block, uint16_t offset, uint8_t data)
+{
+	uint8_t s = block >> 2;
+	if (block == 0)
+	{
+		if ((offset == 0) && (data & 0x80))
+		{
+			reset();
+		}
+		else if (offset < sizeof(common))
+		{
+			common[offset] = data;
+		}
+		return;
+	}
+	if (s >= numSockets)
+	{
+		return;
+	}
+	simSocket &sock = sockets[s];
+	switch (block & 0x03)
+	{
+	case 1:
+		break;
+	case 2:
+		sock.tx[offset & SIMWIZ_MASK] = data;
+		return;
+	default:
+		return; // the receive memory is written by the network
+	}
+	if (offset == SIMWIZ_CR)
+	{
+		command(s, data);
+	}
+	else if (offset == SIMWIZ_IR)
+	{
+		sock.ir &= ~data;
+	}
+	else if (offset < sizeof(sock.regs))
+	{
+		sock.regs[offset] = data;
+	}
+}
+
+/*
+ * Network side
+ */
+
+/**
+ * A client connects to a listening TCP socket.
+ * @param s Socket
+ * @param ip Address of the client, 4 bytes
+ * @param port Port of the client
+ * @return false if the socket is not listening
+ */
+boolean simWiznet::peerConnect(uint8_t s, const uint8_t *ip, uint16_t port)
+{
+	simSocket &sock = sockets[s];
+	if (sock.sr != SIMWIZ_LISTENING)
+	{
+		return false;
+	}
+	memcpy(sock.regs + SIMWIZ_DIPR, ip, 4);
+	sock.regs[SIMWIZ_DPORT] = port >> 8;
+	sock.regs[SIMWIZ_DPORT + 1] = port & 0xFF;
+	sock.sr = SIMWIZ_ESTABLISHED;
+	interrupt(s, SIMWIZ_IR_CON);
+	return true;
+}
+
+/**
+ * Data arrives on a connected TCP socket.
+ * @param s Socket
+ * @param data Data
+ * @param length Bytes
+ * @return Bytes stored, less than length if the receive memory is full
+ */
+uint16_t simWiznet::peerSend(uint8_t s, const uint8_t *data, uint16_t length)
+{
+	simSocket &sock = sockets[s];
+	if ((sock.sr != SIMWIZ_ESTABLISHED) && (sock.sr != SIMWIZ_FIN_WAIT))
+	{
+		return 0;
+	}
+	uint16_t used = sock.rxWr - simWizGet16(sock.regs + SIMWIZ_RX_RD);
+	if (length > SIMWIZ_MEMORY - used)
+	{
+		length = SIMWIZ_MEMORY - used;
+	}
+	for (uint16_t i = 0; i < length; i++)
+	{
+		sock.rx[(sock.rxWr++) & SIMWIZ_MASK] = data[i];
+	}
+	sock.rxRsr += length;
+	if (length != 0)
+	{
+		interrupt(s, SIMWIZ_IR_RECV);
+	}
+	return length;
+}
+
+/**
+ * A datagram arrives on a UDP socket, it is stored after the 8 byte header of the chip (address, port and
+ * length).
+ * @param s Socket
+ * @param ip Address of the sender, 4 bytes
+ * @param port Port of the sender
+ * @param data Data
+ * @param length Bytes
+ * @return false if the socket is not open for UDP or the datagram does not fit
+ */
+boolean simWiznet::peerSendTo(uint8_t s, const uint8_t *ip, uint16_t port, const uint8_t *data, uint16_t length)
+{
+	simSocket &sock = sockets[s];
+	uint16_t used = sock.rxWr - simWizGet16(sock.regs + SIMWIZ_RX_RD);
+	if ((sock.sr != SIMWIZ_UDP_OPEN) || (length + 8 > SIMWIZ_MEMORY - used))
+	{
+		return false;
+	}
+	uint8_t header[8] = {ip[0], ip[1], ip[2], ip[3], (uint8_t) (port >> 8), (uint8_t) port,
+	                     (uint8_t) (length >> 8), (uint8_t) length};
+	for (uint8_t i = 0; i < sizeof(header); i++)
+	{
+		sock.rx[(sock.rxWr++) & SIMWIZ_MASK] = header[i];
+	}
+	for (uint16_t i = 0; i < length; i++)
+	{
+		sock.rx[(sock.rxWr++) & SIMWIZ_MASK] = data[i];
+	}
+	sock.rxRsr += length + 8;
+	interrupt(s, SIMWIZ_IR_RECV);
+	return true;
+}
+
+/**
+ * The other end closes the connection: an established socket goes to CLOSE_WAIT, a socket waiting in
+ * FIN_WAIT after a DISCON is closed. Or it acknowledges the FIN of a socket in LAST_ACK, which is closed
+ * without an interrupt.
+ * @param s Socket
+ */
+void simWiznet::peerClose(uint8_t s)
+{
+	simSocket &sock = sockets[s];
+	if (sock.sr == SIMWIZ_ESTABLISHED)
+	{
+		sock.sr = SIMWIZ_CLOSE_WAIT;
+		interrupt(s, SIMWIZ_IR_DISCON);
+	}
+	else if (sock.sr == SIMWIZ_FIN_WAIT)
+	{
+		sock.sr = SIMWIZ_CLOSED;
+		interrupt(s, SIMWIZ_IR_DISCON);
+	}
+	else if (sock.sr == SIMWIZ_LAST_ACK)
+	{
+		sock.sr = SIMWIZ_CLOSED;
+	}
+}
+
+/*
+ * W5100
+ */
+
+simW5100::simW5100(uint8_t csPin) : simWiznet(csPin, 4)
+{
+	position = 0;
+}
+
+// IR has a bit for each socket with an interrupt pending
+uint8_t simW5100::readCommon(uint16_t offset)
+{
+	if (offset == 0x15)
+	{
+		uint8_t ir = common[offset] & 0xF0;
+		for (uint8_t s = 0; s < numSockets; s++)
+		{
+			if (sockets[s].ir != 0)
+			{
+				ir |= 1 << s;
+			}
+		}
+		return ir;
+	}
+	return simWiznet::readCommon(offset);
+}
+
+/**
+ * One byte of a 4 byte frame. The chip answers the first three bytes with 0, 1 and 2.
+ */
+void simW5100::exchange(uint8_t out, uint8_t *in)
+{
+	if (simPinOutput(csPin))
+	{
+		position = 0;
+		return;
+	}
+	if ((position == 0) && (peer != NULL))
+	{
+		peer->poll(*this);
+	}
+	if (position < 3)
+	{
+		frame[position] = out;
+		*in = position++;
+		return;
+	}
+	position = 0;
+	uint16_t addr = (frame[1] << 8) | frame[2];
+	uint8_t block;
+	uint16_t offset;
+	if (addr < 0x0400)
+	{
+		block = 0;
+		offset = addr;
+	}
+	else if (addr < 0x0800)
+	{
+		block = (((addr - 0x0400) >> 8) << 2) + 1;
+		offset = addr & 0xFF;
+	}
+	else if ((addr >= 0x4000) && (addr < 0x8000))
+	{
+		// 2 kB per socket, transmit memory from 0x4000 and receive memory from 0x6000
+		block = ((((addr & 0x1FFF) >> 11) << 2) + ((addr < 0x6000) ? 2 : 3));
+		offset = addr & SIMWIZ_MASK;
+	}
+	else
+	{
+		*in = 0;
+		return;
+	}
+	if (frame[0] == 0xF0)
+	{
+		write(block, offset, out);
+		*in = 3;
+	}
+	else if (frame[0] == 0x0F)
+	{
+		*in = read(block, offset);
+	}
+}
+
+/*
+ * W5500
+ */
+
+simW5500::simW5500(uint8_t csPin) : simWiznet(csPin, 8)
+{
+	position = 0;
+	offset = 0;
+}
+
+// SIR has a bit for each socket with an interrupt pending, the PHY reports a 100 Mb/s full duplex link
+uint8_t simW5500::readCommon(uint16_t offset)
+{
+	if (offset == 0x17)
+	{
+		uint8_t sir = 0;
+		for (uint8_t s = 0; s < numSockets; s++)
+		{
+			if (sockets[s].ir != 0)
+			{
+				sir |= 1 << s;
+			}
+		}
+		return sir;
+	}
+	if (offset == 0x2E)
+	{
+		return 0xBF; // PHYCFGR
+	}
+	if (offset == 0x39)
+	{
+		return 0x04; // VERSIONR
+	}
+	return simWiznet::readCommon(offset);
+}
+
+/**
+ * One byte of a frame, the address and control byte are followed by the data bytes.
+ */
+void simW5500::exchange(uint8_t out, uint8_t *in)
+{
+	if (simPinOutput(csPin))
+	{
+		return;
+	}
+	if ((position == 0) && (peer != NULL))
+	{
+		peer->poll(*this);
+	}
+	if (position < 3)
+	{
+		header[position++] = out;
+		offset = (header[0] << 8) | header[1];
+		return;
+	}
+	uint8_t block = header[2] >> 3;
+	if (header[2] & 0x04)
+	{
+		write(block, offset, out);
+	}
+	else
+	{
+		*in = read(block, offset);
+	}
+	offset++;
+}
+
+/**
+ * The frame ends when chip select goes high.
+ */
+void simW5500::pins()
+{
+	if (simPinOutput(csPin))
+	{
+		position = 0;
+	}
+}
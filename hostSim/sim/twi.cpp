@@ -0,0 +1,16 @@
+/*
+ * twi.cpp
+ * Builds the real Wire/utility/twi.c for the host. It is compiled as C++ with C linkage, so that the TWI
+ * registers it writes are the simulated ones (objects, see avr/io.h) and Wire.cpp links against it as before.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include <inttypes.h>
+#include "Arduino.h"
+#include <compat/twi.h>
+
+extern "C" {
+#include "utility/twi.c"
+}
@@ -0,0 +1,168 @@
+/*
+ * DnsTest.cpp
+ * DNSClient against a simulated DNS server on a W5100: several queries outstanding on one socket, answers
+ * matched up by ID when one comes late, and cached answers expiring with their TTL.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "simTest.h"
+#include "../../Ethernet/src/Ethernet.h"
+#include "../../Ethernet/src/Dns.h"
+#include "../../Ethernet/src/utility/w5100.h"
+
+static uint8_t dnsTestMac[6] = {0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED};
+static const uint8_t dnsTestA[4] = {10, 0, 0, 1};
+static const uint8_t dnsTestB[4] = {10, 0, 0, 2};
+static const uint8_t dnsTestC[4] = {10, 0, 0, 3};
+
+static void dnsTestBegin(simW5100 &chip, simDnsServer &server, DNSClient &dns)
+{
+	simSpiAttach(&chip);
+	chip.peer = &server;
+	memset(EthernetClass::_server_port, 0, sizeof(EthernetClass::_server_port));
+	Ethernet.begin(dnsTestMac, IPAddress(192, 168, 1, 10));
+	DNSClient::clearCache();
+	dns.begin(Ethernet.dnsServerIP());
+}
+
+/*
+ * Polls every 10 ms for ms
+ */
+static void dnsTestRun(DNSClient &dns, unsigned long ms)
+{
+	for (unsigned long t = 0; t < ms; t += 10)
+	{
+		simAdvance(10000);
+		dns.poll();
+	}
+}
+
+/*
+ * Resolves name, polling every 10 ms, returns the result of the query
+ */
+static int dnsTestResolve(DNSClient &dns, const char *name, IPAddress &address)
+{
+	int q = dns.startHostByName(name);
+	if (q < 0)
+	{
+		return q;
+	}
+	int result;
+	while ((result = dns.queryResult(q, address)) == DNS_PENDING)
+	{
+		simAdvance(10000);
+	}
+	return result;
+}
+
+SIMTEST(DnsOutstandingQueries)
+{
+	simW5100 chip;
+	simDnsServer server;
+	DNSClient dns;
+	dnsTestBegin(chip, server, dns);
+	server.add("a.example", dnsTestA, 60, 300000);
+	server.add("b.example", dnsTestB, 60, 100000);
+
+	int qa = dns.startHostByName("a.example");
+	uint16_t portA = server.lastPort;
+	int qb = dns.startHostByName("B.Example");
+	CHECK(qa >= 0);
+	CHECK(qb >= 0);
+	CHECK(qa != qb);
+	CHECK_EQUAL(-11, dns.startHostByName("c.example")); // NO_QUERY_SLOT
+	CHECK_EQUAL(2, server.requests);
+	CHECK_EQUAL(portA, server.lastPort); // one socket for both
+
+	// b is answered first
+	IPAddress address;
+	dnsTestRun(dns, 150);
+	CHECK_EQUAL(DNS_PENDING, dns.queryResult(qa, address));
+	CHECK_EQUAL(1, dns.queryResult(qb, address));
+	CHECK(address == IPAddress(dnsTestB));
+	dnsTestRun(dns, 200);
+	CHECK_EQUAL(1, dns.queryResult(qa, address));
+	CHECK(address == IPAddress(dnsTestA));
+
+	// an unknown name, the socket is closed when nothing is outstanding
+	CHECK(dnsTestResolve(dns, "c.example", address) < 0);
+	CHECK_EQUAL(3, server.requests);
+	for (uint8_t s = 0; s < MAX_SOCK_NUM; s++)
+	{
+		CHECK_EQUAL(SnSR::CLOSED, chip.status(s));
+	}
+}
+
+SIMTEST(DnsLateAnswer)
+{
+	simW5100 chip;
+	simDnsServer server;
+	DNSClient dns;
+	dnsTestBegin(chip, server, dns);
+	server.add("a.example", dnsTestA, 60, 7000000);
+	server.add("b.example", dnsTestB, 60, 6500000);
+
+	// a is sent again with the same ID after DNS_TIMEOUT, both requests are answered 7 s after they were sent
+	int qa = dns.startHostByName("a.example");
+	uint16_t idA = server.lastId;
+	dnsTestRun(dns, DNS_TIMEOUT + 50);
+	CHECK_EQUAL(2, server.requests);
+	CHECK_EQUAL(idA, server.lastId);
+	dnsTestRun(dns, 6000 - (DNS_TIMEOUT + 50));
+	int qb = dns.startHostByName("b.example");
+	CHECK(server.lastId != idA);
+	IPAddress address;
+	dnsTestRun(dns, 1050);
+	CHECK_EQUAL(1, dns.queryResult(qa, address));
+	CHECK(address == IPAddress(dnsTestA));
+
+	// the second answer to a arrives at 12 s, while b is outstanding, and must not complete b
+	dnsTestRun(dns, 12050 - 7050);
+	CHECK_EQUAL(2, server.answered);
+	CHECK_EQUAL(DNS_PENDING, dns.queryResult(qb, address));
+	dnsTestRun(dns, 500);
+	CHECK_EQUAL(1, dns.queryResult(qb, address));
+	CHECK(address == IPAddress(dnsTestB));
+}
+
+SIMTEST(DnsTtlExpiry)
+{
+	simW5100 chip;
+	simDnsServer server;
+	DNSClient dns;
+	dnsTestBegin(chip, server, dns);
+	server.add("a.example", dnsTestA, 2, 20000);
+	server.add("b.example", dnsTestB, 0, 20000);
+	server.add("c.example", dnsTestC, 100000, 20000);
+	IPAddress address;
+
+	// cached for the TTL
+	CHECK_EQUAL(1, dnsTestResolve(dns, "a.example", address));
+	CHECK_EQUAL(1, server.requests);
+	simAdvance(1900000);
+	CHECK_EQUAL(1, dnsTestResolve(dns, "A.EXAMPLE", address));
+	CHECK(address == IPAddress(dnsTestA));
+	CHECK_EQUAL(1, server.requests);
+	simAdvance(200000);
+	CHECK_EQUAL(1, dnsTestResolve(dns, "a.example", address));
+	CHECK(address == IPAddress(dnsTestA));
+	CHECK_EQUAL(2, server.requests);
+
+	// a TTL of 0 is not cached
+	CHECK_EQUAL(1, dnsTestResolve(dns, "b.example", address));
+	CHECK_EQUAL(1, dnsTestResolve(dns, "b.example", address));
+	CHECK(address == IPAddress(dnsTestB));
+	CHECK_EQUAL(4, server.requests);
+
+	// a long TTL is cut to DNS_MAX_TTL
+	CHECK_EQUAL(1, dnsTestResolve(dns, "c.example", address));
+	simAdvance((DNS_MAX_TTL - 1) * 1000000UL);
+	CHECK_EQUAL(1, dnsTestResolve(dns, "c.example", address));
+	CHECK_EQUAL(5, server.requests);
+	simAdvance(2000000);
+	CHECK_EQUAL(1, dnsTestResolve(dns, "c.example", address));
+	CHECK(address == IPAddress(dnsTestC));
+	CHECK_EQUAL(6, server.requests);
+}
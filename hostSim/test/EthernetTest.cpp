@@ -0,0 +1,47 @@
+/*
+ * EthernetTest.cpp
+ * Ethernet on a simulated W5100: the configuration reaches the chip and a server exchanges data with a client.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "simTest.h"
+#include "../../Ethernet/src/Ethernet.h"
+#include "../../Ethernet/src/utility/w5100.h"
+
+static uint8_t ethernetTestMac[6] = {0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED};
+static const uint8_t ethernetTestPeer[4] = {192, 168, 1, 20};
+
+SIMTEST(EthernetServerExchange)
+{
+	simW5100 chip;
+	simSpiAttach(&chip);
+	Ethernet.begin(ethernetTestMac, IPAddress(192, 168, 1, 10));
+	CHECK(memcmp(chip.ipAddress(), "\xC0\xA8\x01\x0A", 4) == 0);
+	CHECK(Ethernet.localIP() == IPAddress(192, 168, 1, 10));
+
+	EthernetServer server(80);
+	server.begin();
+	CHECK_EQUAL(SnSR::LISTEN, chip.status(0));
+	CHECK_EQUAL(80, chip.port(0));
+	CHECK(!server.available());
+
+	CHECK(chip.peerConnect(0, ethernetTestPeer, 40000));
+	CHECK_EQUAL(5, chip.peerSend(0, (const uint8_t *) "hello", 5));
+	EthernetClient client = server.available();
+	CHECK(client);
+	CHECK(client.connected());
+	CHECK_EQUAL(SnSR::LISTEN, chip.status(1)); // a new socket listens for the next client
+	CHECK_EQUAL(5, client.available());
+	uint8_t data[8];
+	CHECK_EQUAL(5, client.read(data, sizeof(data)));
+	CHECK(memcmp(data, "hello", 5) == 0);
+	CHECK_EQUAL(0, chip.received(0));
+
+	CHECK_EQUAL(2, client.write("OK"));
+	CHECK_EQUAL(2, chip.sentBytes(0));
+	CHECK(memcmp(chip.sent(0), "OK", 2) == 0);
+	client.stop();
+	CHECK_EQUAL(SnSR::CLOSED, chip.status(0));
+}
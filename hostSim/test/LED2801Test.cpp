@@ -0,0 +1,85 @@
+/*
+ * LED2801Test.cpp
+ * LED2801 color orders through the base class and LED2801Order, and the bytes sent with interrupts off.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "simTest.h"
+#include "../../LED2801/LED2801.h"
+
+/*
+ * WS2801 chain on the SPI bus, records the bytes and whether interrupts were on for each one
+ */
+class simWs2801: public simSpiDevice
+{
+public:
+	uint8_t data[64];
+	uint8_t length;
+	unsigned long interruptBytes;
+	simWs2801() { length = 0; interruptBytes = 0; }
+	void exchange(uint8_t out, uint8_t *)
+	{
+		if (length < sizeof(data))
+			data[length++] = out;
+		if (SREG & _BV(SREG_I))
+			interruptBytes++;
+	}
+};
+
+SIMTEST(LED2801OrderThroughBase)
+{
+	LED2801Order<LED2801_GRB> grb(4);
+	LED2801 *base = &grb;
+	grb.autoUpdate = false;
+	base->setColor(0x112233UL); // the base class functions use the fixed order
+	for (word i = 0; i < 12; i += 3)
+	{
+		CHECK_EQUAL(0x22, grb.getPtr()[i]);
+		CHECK_EQUAL(0x11, grb.getPtr()[i + 1]);
+		CHECK_EQUAL(0x33, grb.getPtr()[i + 2]);
+	}
+	base->setColor(1, 0x445566UL);
+	CHECK_EQUAL(0x55, grb.getPtr()[3]);
+	CHECK_EQUAL(0x44, grb.getPtr()[4]);
+	CHECK_EQUAL(0x552244UL, base->colorReorder(0x225544UL));
+	LED2801Segment segment(base, 2, 2);
+	segment.setColor(0x0A0B0CUL);
+	CHECK_EQUAL(0x0B, grb.getPtr()[6]);
+	CHECK_EQUAL(0x0A, grb.getPtr()[10]);
+}
+
+SIMTEST(LED2801SetColorOrder)
+{
+	LED2801 strip(3);
+	strip.autoUpdate = false;
+	strip.setColorOrder(&_BGR);
+	strip.setColor(0x010203UL);
+	CHECK_EQUAL(0x03, strip.getPtr()[0]);
+	CHECK_EQUAL(0x02, strip.getPtr()[1]);
+	CHECK_EQUAL(0x01, strip.getPtr()[2]);
+	strip.setColor(2, 0x040506UL); // one pixel and the whole strip agree
+	CHECK_EQUAL(0x06, strip.getPtr()[6]);
+	CHECK_EQUAL(0x04, strip.getPtr()[8]);
+}
+
+SIMTEST(LED2801SendChunks)
+{
+	simWs2801 chain;
+	simSpiAttach(&chain);
+	LED2801 strip(5, 2); // 5 logical pixels, each sent twice
+	strip.autoUpdate = false;
+	strip.setChunkSize(2);
+	strip.setColor(0x102030UL);
+	strip.send();
+	CHECK_EQUAL(30, chain.length);
+	CHECK_EQUAL(0x10, chain.data[0]);
+	CHECK_EQUAL(0x30, chain.data[5]);
+	CHECK_EQUAL(0, chain.interruptBytes);
+	CHECK(SREG & _BV(SREG_I)); // restored
+	noInterrupts();
+	strip.send(); // called with interrupts off, they stay off between the chunks
+	CHECK(!(SREG & _BV(SREG_I)));
+	interrupts();
+}
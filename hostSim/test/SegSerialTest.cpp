@@ -0,0 +1,207 @@
+/*
+ * SegSerialTest.cpp
+ * SegSerial bit timing at each baud rate, blocking and from the Timer2 transmit buffer, decoded from the level
+ * changes on the transmit pin as a receiver would see them.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "simTest.h"
+#include "../../SegSerial.h"
+
+#define SEGSERIALTEST_PIN 4
+// sendFrame() takes 12 cycles (15 / 4 delay counts) off each bit for the code around the delay loop, the
+// simulation only counts the delay loop, so a blocking bit is this much shorter here than on the board
+#define SEGSERIALTEST_LOOP_CYCLES 12
+#define SEGSERIALTEST_EDGES 256
+
+static const long segSerialTestBauds[] = {9600, 19200, 38400, 57600, 115200, 250000};
+
+static unsigned long segSerialTestTimes[SEGSERIALTEST_EDGES];
+static boolean segSerialTestLevels[SEGSERIALTEST_EDGES];
+static unsigned int segSerialTestCount;
+
+/*
+ * Copies the edges of the transmit pin recorded since the edge from
+ */
+static void segSerialTestCapture(unsigned int from)
+{
+	segSerialTestCount = 0;
+	for (unsigned int i = from; (i < simProbeEdges()) && (segSerialTestCount < SEGSERIALTEST_EDGES); i++)
+	{
+		simEdge e = simProbeEdge(i);
+		if (e.pin == SEGSERIALTEST_PIN)
+		{
+			segSerialTestTimes[segSerialTestCount] = e.cycle;
+			segSerialTestLevels[segSerialTestCount] = e.level;
+			segSerialTestCount++;
+		}
+	}
+}
+
+static boolean segSerialTestLevel(double cycle)
+{
+	boolean level = HIGH; // idle
+	for (unsigned int i = 0; (i < segSerialTestCount) && (segSerialTestTimes[i] <= cycle); i++)
+	{
+		level = segSerialTestLevels[i];
+	}
+	return level;
+}
+
+/*
+ * Decodes the frames from the falling edge of each start bit, with one sample in the middle of each bit.
+ * Returns the number of bytes, a frame without its stop bit ends the decoding.
+ */
+static uint8_t segSerialTestDecode(double bitCycles, uint8_t *data, uint8_t size, unsigned long *starts)
+{
+	uint8_t n = 0;
+	unsigned int i = 0;
+	while (n < size)
+	{
+		while ((i < segSerialTestCount) && (segSerialTestLevels[i] != LOW))
+		{
+			i++;
+		}
+		if (i == segSerialTestCount)
+		{
+			break;
+		}
+		double start = segSerialTestTimes[i];
+		uint8_t b = 0;
+		for (uint8_t bit = 0; bit < 8; bit++)
+		{
+			if (segSerialTestLevel(start + ((bit + 1.5) * bitCycles)))
+			{
+				b |= 1 << bit;
+			}
+		}
+		if (!segSerialTestLevel(start + (9.5 * bitCycles)))
+		{
+			break;
+		}
+		starts[n] = segSerialTestTimes[i];
+		data[n++] = b;
+		while ((i < segSerialTestCount) && (segSerialTestTimes[i] <= start + (9.5 * bitCycles)))
+		{
+			i++;
+		}
+	}
+	return n;
+}
+
+/*
+ * Bit time of the first frame, which must be 0x55 so there is an edge at every bit. Checks that the edges
+ * are evenly spaced to within jitter cycles.
+ */
+static double segSerialTestBitCycles(unsigned long jitter)
+{
+	unsigned int s = 0;
+	while ((s < segSerialTestCount) && (segSerialTestLevels[s] != LOW))
+	{
+		s++;
+	}
+	CHECK(s + 9 < segSerialTestCount);
+	if (s + 9 >= segSerialTestCount)
+	{
+		return 1;
+	}
+	double bitCycles = (segSerialTestTimes[s + 9] - segSerialTestTimes[s]) / 9.0;
+	for (unsigned int k = 1; k < 9; k++)
+	{
+		double error = (segSerialTestTimes[s + k] - segSerialTestTimes[s]) - (k * bitCycles);
+		CHECK((error <= jitter) && (error >= -(double) jitter));
+	}
+	return bitCycles;
+}
+
+/*
+ * Sends 0x55 "Hi!" and checks the bit time against the baud rate (to 2 %) and the data
+ */
+static void segSerialTestFrames(SegSerial &tx, long baud, boolean buffered)
+{
+	const uint8_t expected[4] = {0x55, 'H', 'i', '!'};
+	boolean byteMode = (F_CPU / baud) < _SS_MIN_BIT_CYCLES;
+	unsigned int from = simProbeEdges();
+	unsigned long isr = simInterruptCycles();
+	tx.begin(baud);
+	tx.write(expected, sizeof(expected));
+	for (int i = 0; tx.isSending() && (i < 1000); i++)
+	{
+		simAdvance(100);
+	}
+	CHECK(!tx.isSending());
+	segSerialTestCapture(from);
+
+	double nominal = (double) F_CPU / baud;
+	// the first frame of a buffer starts at once and the timer prescaler is not reset, so its first bit can be
+	// short by up to one prescaler count
+	double bitCycles = segSerialTestBitCycles((buffered && !byteMode) ? 8 : 0);
+	double board = (buffered && !byteMode) ? bitCycles : bitCycles + SEGSERIALTEST_LOOP_CYCLES;
+	CHECK(fabs(board - nominal) < 0.02 * nominal);
+
+	uint8_t data[8];
+	unsigned long starts[8];
+	CHECK_EQUAL(sizeof(expected), segSerialTestDecode(bitCycles, data, sizeof(data), starts));
+	CHECK(memcmp(expected, data, sizeof(expected)) == 0);
+
+	if (buffered)
+	{
+		// one frame every 10 bit times from the interrupt, or one every byte slot
+		double slot = (starts[3] - starts[1]) / 2.0;
+		double expectedSlot = (byteMode ? _SS_BYTE_SLOT_BITS : 10) * nominal;
+		CHECK(fabs(slot - expectedSlot) < 0.02 * expectedSlot);
+		// in byte mode the interrupt sends the frames after the first one, with interrupts off
+		unsigned long isrCycles = simInterruptCycles() - isr;
+		if (byteMode)
+		{
+			CHECK(isrCycles >= 3 * 10 * bitCycles);
+		}
+		else
+		{
+			CHECK_EQUAL(0, isrCycles);
+		}
+	}
+}
+
+SIMTEST(SegSerialBlockingBitTiming)
+{
+	SegSerial tx(SEGSERIALTEST_PIN);
+	simProbe(SEGSERIALTEST_PIN);
+	CHECK(simPinOutput(SEGSERIALTEST_PIN)); // idles high
+	for (uint8_t i = 0; i < sizeof(segSerialTestBauds) / sizeof(segSerialTestBauds[0]); i++)
+	{
+		segSerialTestFrames(tx, segSerialTestBauds[i], false);
+	}
+	CHECK_EQUAL(0, TIMSK2);
+}
+
+SIMTEST(SegSerialBufferedBitTiming)
+{
+	SegSerial tx(SEGSERIALTEST_PIN);
+	simProbe(SEGSERIALTEST_PIN);
+	CHECK(tx.setTxBuffer(8));
+	CHECK_EQUAL(8, tx.availableForWrite());
+	for (uint8_t i = 0; i < sizeof(segSerialTestBauds) / sizeof(segSerialTestBauds[0]); i++)
+	{
+		segSerialTestFrames(tx, segSerialTestBauds[i], true);
+	}
+	CHECK_EQUAL(0, TIMSK2 & _BV(OCIE2A)); // the timer is released when the buffer is empty
+	CHECK_EQUAL(0, TCCR2B);
+}
+
+SIMTEST(SegSerialBufferedWriteReturns)
+{
+	SegSerial tx(SEGSERIALTEST_PIN);
+	tx.begin(9600);
+	CHECK(tx.setTxBuffer(16));
+	unsigned long start = simCycles();
+	tx.write("0123456789");
+	CHECK_EQUAL(start, simCycles()); // nothing waited for the bits
+	CHECK(tx.isSending());
+	CHECK_EQUAL(7, tx.availableForWrite()); // the first byte went straight out
+	simAdvance(12 * 1000);
+	CHECK(!tx.isSending());
+	CHECK_EQUAL(16, tx.availableForWrite());
+}
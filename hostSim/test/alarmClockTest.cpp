@@ -0,0 +1,131 @@
+/*
+ * alarmClockTest.cpp
+ * alarmScheduler ordering, repeats, re-setting from the ringer and removal on destruction.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "simTest.h"
+#include "../../alarmClock/alarmClock.h"
+
+static char alarmTestLog[16];
+static byte alarmTestLength;
+
+static void alarmTestLogEvent(char c)
+{
+	if (alarmTestLength < sizeof(alarmTestLog) - 1)
+	{
+		alarmTestLog[alarmTestLength++] = c;
+		alarmTestLog[alarmTestLength] = '\0';
+	}
+}
+
+static void alarmTestA() { alarmTestLogEvent('a'); }
+static void alarmTestB() { alarmTestLogEvent('b'); }
+static void alarmTestR() { alarmTestLogEvent('r'); }
+
+static alarmClock *alarmTestRearm;
+static void alarmTestRearmRinger()
+{
+	alarmTestLogEvent('x');
+	alarmTestRearm->setAlarm(0); // due again at once
+}
+
+static void alarmTestClear()
+{
+	alarmTestLength = 0;
+	alarmTestLog[0] = '\0';
+}
+
+SIMTEST(alarmSchedulerOrder)
+{
+	alarmScheduler scheduler;
+	alarmClock a(alarmTestA);
+	alarmClock b(alarmTestB);
+	repeatAlarm r(alarmTestR);
+	alarmTestClear();
+	scheduler.add(&a);
+	scheduler.add(&b);
+	scheduler.add(&r);
+	r.setIntervalReset(10);
+	a.setAlarm(25);
+	b.setAlarm(5);
+	CHECK_EQUAL(3, scheduler.getCount());
+	CHECK_EQUAL(5, scheduler.nextDeadline());
+	for (int ms = 0; ms <= 40; ms++)
+	{
+		simSetMicros(ms * 1000UL);
+		scheduler.poll();
+	}
+	CHECK(strcmp("brrarr", alarmTestLog) == 0);
+	CHECK_EQUAL(1, scheduler.getCount()); // only the repeat is left
+	CHECK_EQUAL(50, scheduler.nextDeadline());
+}
+
+SIMTEST(alarmRepeatNoSlip)
+{
+	alarmScheduler scheduler;
+	repeatAlarm r(alarmTestR);
+	alarmTestClear();
+	scheduler.add(&r);
+	r.setIntervalReset(10);
+	simSetMicros(10000);
+	CHECK_EQUAL(1, scheduler.poll());
+	CHECK_EQUAL(20, scheduler.nextDeadline());
+	simSetMicros(10999);
+	CHECK_EQUAL(0, scheduler.poll());
+	CHECK_EQUAL(10, scheduler.getRemainingTime());
+}
+
+SIMTEST(alarmRearmFromRinger)
+{
+	alarmScheduler scheduler;
+	alarmClock a(alarmTestRearmRinger);
+	alarmTestRearm = &a;
+	alarmTestClear();
+	scheduler.add(&a);
+	a.setAlarm(0);
+	CHECK_EQUAL(1, scheduler.poll()); // one pass, does not lock up
+	CHECK_EQUAL(1, scheduler.poll());
+	CHECK(strcmp("xx", alarmTestLog) == 0);
+	CHECK(a.isSet());
+}
+
+SIMTEST(alarmDestroyedUnlinks)
+{
+	alarmScheduler scheduler;
+	alarmClock a(alarmTestA);
+	alarmTestClear();
+	scheduler.add(&a);
+	a.setAlarm(20);
+	{
+		alarmClock b(alarmTestB);
+		scheduler.add(&b);
+		b.setAlarm(10);
+		CHECK_EQUAL(2, scheduler.getCount());
+	}
+	CHECK_EQUAL(1, scheduler.getCount());
+	simSetMicros(30000);
+	CHECK_EQUAL(1, scheduler.poll());
+	CHECK(strcmp("a", alarmTestLog) == 0);
+}
+
+SIMTEST(alarmUnsetAndMove)
+{
+	alarmScheduler first;
+	alarmScheduler second;
+	alarmClock a(alarmTestA);
+	alarmTestClear();
+	first.add(&a);
+	a.setAlarm(10);
+	second.add(&a); // moves it
+	CHECK_EQUAL(0, first.getCount());
+	CHECK_EQUAL(1, second.getCount());
+	a.unSetAlarm();
+	CHECK_EQUAL(0, second.getCount());
+	simSetMicros(20000);
+	CHECK_EQUAL(0, second.poll());
+	CHECK(!a.poll());
+	CHECK_EQUAL(0, alarmTestLength);
+}
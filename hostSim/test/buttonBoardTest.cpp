@@ -0,0 +1,181 @@
+/*
+ * buttonBoardTest.cpp
+ * buttonBoard on the full duplex SPI transport (lamps on a 74HC595 chain, buttons on a 74HC165 chain), the
+ * pressed button iterators and the buttonDebounce engine.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "simTest.h"
+#include "../../buttonBoard/buttonBoard.h"
+
+#define BUTTONTEST_ILT 8
+#define BUTTONTEST_OLT 9
+#define BUTTONTEST_BOARDS 3
+
+SIMTEST(buttonBoardDuplex)
+{
+	sim165 buttons(BUTTONTEST_ILT, BUTTONTEST_BOARDS);
+	sim595 lamps(BUTTONTEST_OLT, BUTTONTEST_BOARDS);
+	simSpiAttach(&buttons);
+	simSpiAttach(&lamps);
+	for (byte i = 0; i < BUTTONTEST_BOARDS; i++)
+	{
+		buttons.set(i, 0xFF); // active low, nothing pressed
+	}
+	buttonBoard bb(BUTTONTEST_ILT, BUTTONTEST_OLT, BUTTONTEST_BOARDS, shiftSPI);
+	buttons.set(0, (byte) ~0x01);
+	buttons.set(2, (byte) ~0x90);
+	bb.setLamp(3, true); // one update, lamps out and buttons in at the same time
+	bb.setLamp(17, true);
+	CHECK_EQUAL(2 * BUTTONTEST_BOARDS, simSpiBytes());
+	CHECK_EQUAL(0x08, lamps.get(0));
+	CHECK_EQUAL(0x00, lamps.get(1));
+	CHECK_EQUAL(0x02, lamps.get(2));
+	bb.autoUpdate = false;
+	CHECK(bb.getButton(0));
+	CHECK(!bb.getButton(1));
+	CHECK(bb.getButton(20));
+	CHECK(bb.getButton(23));
+	CHECK_EQUAL(3, bb.countPressed());
+	CHECK_EQUAL(2, bb.countPressed(1, 23));
+	CHECK_EQUAL(1, bb.countPressed(20, 3));
+	CHECK_EQUAL(0, bb.firstPressed());
+	CHECK_EQUAL(20, bb.nextPressed(0));
+	CHECK_EQUAL(23, bb.nextPressed(20));
+	CHECK_EQUAL(buttonReset, bb.nextPressed(23));
+	CHECK(!bb.getNewPress(0)); // pressed in the first update, held in the second
+	buttons.set(0, (byte) ~0x03);
+	bb.update();
+	CHECK(bb.getNewPress(1));
+	CHECK(!bb.getNewPress(0));
+	CHECK_EQUAL(0, buttons.getLatchErrors());
+	CHECK_EQUAL(0, lamps.getLatchErrors());
+	CHECK(!simPinOutput(BUTTONTEST_OLT));
+}
+
+SIMTEST(buttonBoardInvert)
+{
+	sim165 buttons(BUTTONTEST_ILT, 1);
+	sim595 lamps(BUTTONTEST_OLT, 1);
+	simSpiAttach(&buttons);
+	simSpiAttach(&lamps);
+	buttonBoard bb(BUTTONTEST_ILT, BUTTONTEST_OLT, 1, shiftSPI);
+	bb.setInputInvert(true);
+	bb.setOutputInvert(true);
+	buttons.set(0, 0x40);
+	bb.setLamp(false);
+	CHECK_EQUAL(0xFF, lamps.get(0));
+	CHECK_EQUAL(6, bb.firstPressed());
+	CHECK_EQUAL(1, bb.countPressed());
+}
+
+SIMTEST(buttonDebounce)
+{
+	sim165 buttons(BUTTONTEST_ILT, 1);
+	sim595 lamps(BUTTONTEST_OLT, 1);
+	simSpiAttach(&buttons);
+	simSpiAttach(&lamps);
+	buttons.set(0, 0xFF);
+	buttonBoard bb(BUTTONTEST_ILT, BUTTONTEST_OLT, 1, shiftSPI);
+	buttonDebounce engine(&bb, 10);
+	unsigned long ms = 0;
+	CHECK(!bb.autoUpdate);
+	CHECK(!engine.poll()); // not time yet
+
+	// a one sample glitch is ignored
+	buttons.set(0, (byte) ~0x02);
+	ms += 10;
+	simSetMicros(ms * 1000);
+	CHECK(engine.poll());
+	buttons.set(0, 0xFF);
+	for (byte i = 0; i < 4; i++)
+	{
+		ms += 10;
+		simSetMicros(ms * 1000);
+		engine.poll();
+	}
+	CHECK(!engine.getState(1));
+	CHECK(!engine.getEvent(1, buttonPress));
+
+	// a held button is pressed after four samples
+	buttons.set(0, (byte) ~0x02);
+	for (byte i = 0; i < 3; i++)
+	{
+		ms += 10;
+		simSetMicros(ms * 1000);
+		engine.poll();
+	}
+	CHECK(!engine.getState(1));
+	ms += 10;
+	simSetMicros(ms * 1000);
+	engine.poll();
+	CHECK(engine.getState(1));
+	CHECK(engine.getEvent(1, buttonPress));
+	CHECK(!engine.getEvent(1, buttonPress)); // cleared when read
+	CHECK_EQUAL(0, buttons.getLatchErrors());
+}
+
+SIMTEST(buttonDebounceSharedButton)
+{
+	// a helper and the sketch watch the same button, neither takes the press from the other
+	sim165 buttons(BUTTONTEST_ILT, 1);
+	sim595 lamps(BUTTONTEST_OLT, 1);
+	simSpiAttach(&buttons);
+	simSpiAttach(&lamps);
+	buttons.set(0, 0xFF);
+	buttonBoard bb(BUTTONTEST_ILT, BUTTONTEST_OLT, 1, shiftSPI);
+	buttonDebounce engine(&bb, 10);
+	buttonToggle toggle(&engine, 2);
+	buttonSelect select(&engine, 2, 2, false);
+	int toggles = 0;
+	int selects = 0;
+	for (unsigned long ms = 10; ms <= 300; ms += 10)
+	{
+		buttons.set(0, ((ms >= 50) && (ms < 150)) ? (byte) ~0x04 : 0xFF); // button 2 held for 100 ms
+		simSetMicros(ms * 1000);
+		toggles += toggle.poll();
+		selects += select.poll();
+	}
+	CHECK_EQUAL(1, toggles);
+	CHECK_EQUAL(1, selects);
+	CHECK(toggle.getState());
+	CHECK_EQUAL(0, select.getState());
+	CHECK(engine.getEvent(2, buttonPress)); // still there for the sketch
+	CHECK(engine.getEvent(2, buttonRelease));
+}
+
+SIMTEST(buttonDebounceLongPress)
+{
+	sim165 buttons(BUTTONTEST_ILT, 1);
+	sim595 lamps(BUTTONTEST_OLT, 1);
+	simSpiAttach(&buttons);
+	simSpiAttach(&lamps);
+	buttons.set(0, 0xFF);
+	buttonBoard bb(BUTTONTEST_ILT, BUTTONTEST_OLT, 1, shiftSPI);
+	buttonDebounce engine(&bb, 10);
+	engine.setTiming(500, 100, 0);
+	buttons.set(0, (byte) ~0x01);
+	boolean longPress = false;
+	int repeats = 0;
+	for (unsigned long ms = 10; ms <= 1000; ms += 10)
+	{
+		simSetMicros(ms * 1000);
+		engine.poll();
+		if (engine.getEvent(0, buttonLongPress))
+		{
+			CHECK(!longPress);
+			CHECK(ms >= 500);
+			longPress = true;
+		}
+		if (engine.getEvent(0, buttonRepeat))
+		{
+			CHECK(longPress);
+			repeats++;
+		}
+	}
+	CHECK(longPress);
+	CHECK(repeats >= 3);
+	CHECK(repeats <= 5);
+}
@@ -0,0 +1,136 @@
+/*
+ * digitsTest.cpp
+ * digits number conversion against sprintf() over the edges of the digit pair and chunk conversion, the sign,
+ * fixed point and hex formats, and the transfer to the chain.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "simTest.h"
+#include "../../digits/digits.h"
+
+#define DIGITSTEST_LATCH 9
+
+static const uint8_t digitsTestSegs[10] = { 0x7E, 0x0C, 0xB6, 0x9E, 0xCC, 0xDA, 0xFA, 0x0E, 0xFE, 0xDE };
+
+/*
+ * Segments expected for a number, digit 0 is the least significant, leading digits are blank
+ */
+static void digitsTestExpected(uint32_t number, uint8_t *expected, uint8_t len)
+{
+	char text[12];
+	uint8_t count = snprintf(text, sizeof(text), "%lu", (unsigned long) number);
+	for (uint8_t i = 0; i < len; i++)
+	{
+		expected[i] = (i < count) ? digitsTestSegs[text[count - 1 - i] - '0'] : 0x00;
+	}
+}
+
+SIMTEST(digitsNumbers)
+{
+	static const uint32_t numbers[] =
+	{
+		0, 1, 9, 10, 99, 100, 101, 999, 1000, 9999, 10000, 10001, 99999, 100000, 999999, 1000000,
+		9999999, 10000000, 99999999, 100000000, 100000001, 999999999, 1000000000, 4199999999UL,
+		4200000000UL, 4294967295UL, 43698, 43699, 65535, 65536, 1234567890
+	};
+	sim595 chain(DIGITSTEST_LATCH, 10);
+	simSpiAttach(&chain);
+	digits display(DIGITSTEST_LATCH, 10, shiftSPI);
+	digitGroup wide(&display, 0, 10);
+	uint8_t expected[10];
+	for (uint8_t n = 0; n < sizeof(numbers) / sizeof(numbers[0]); n++)
+	{
+		wide.segDisp(numbers[n]);
+		digitsTestExpected(numbers[n], expected, 10);
+		CHECK(memcmp(expected, display.getPtr(), 10) == 0);
+		for (uint8_t i = 0; i < 10; i++)
+		{
+			CHECK_EQUAL(display.getPtr()[i], chain.get(i));
+		}
+	}
+	CHECK_EQUAL(0, chain.getLatchErrors());
+}
+
+SIMTEST(digitsSweep)
+{
+	// every chunk boundary region, and a pseudo random walk over the whole range
+	sim595 chain(DIGITSTEST_LATCH, 10);
+	simSpiAttach(&chain);
+	digits display(DIGITSTEST_LATCH, 10, shiftSPI);
+	CHECK_EQUAL(0, SPCR); // the constructor leaves the hardware alone
+	CHECK_EQUAL(0, simSpiBytes());
+	display.begin(); // clears the display
+	CHECK(SPCR & _BV(SPE));
+	display.autoUpdate = false;
+	digitGroup wide(&display, 0, 10);
+	uint8_t expected[10];
+	uint32_t number = 0;
+	for (uint32_t i = 0; i < 20000; i++)
+	{
+		wide.segDisp(i);
+		digitsTestExpected(i, expected, 10);
+		CHECK(memcmp(expected, display.getPtr(), 10) == 0);
+		number = number * 1664525UL + 1013904223UL;
+		wide.segDisp(number);
+		digitsTestExpected(number, expected, 10);
+		CHECK(memcmp(expected, display.getPtr(), 10) == 0);
+	}
+	CHECK_EQUAL(10, simSpiBytes()); // only begin() sent anything
+}
+
+SIMTEST(digitsGroups)
+{
+	sim595 chain(DIGITSTEST_LATCH, 8);
+	simSpiAttach(&chain);
+	digits display(DIGITSTEST_LATCH, 8, shiftSPI);
+	digitGroup low(&display, 0, 4);
+	digitGroup high(&display, 4, 4);
+	uint8_t expected[4];
+	high.segDisp(7);
+	low.segDisp(123456); // too long, the low digits are kept
+	digitsTestExpected(3456, expected, 4);
+	CHECK(memcmp(expected, display.getPtr(), 4) == 0);
+	digitsTestExpected(7, expected, 4);
+	CHECK(memcmp(expected, display.getPtr() + 4, 4) == 0);
+	CHECK_EQUAL(digitsTestSegs[7], chain.get(4));
+	CHECK_EQUAL(0x00, chain.get(5));
+}
+
+SIMTEST(digitsSignFixedHex)
+{
+	sim595 chain(DIGITSTEST_LATCH, 6);
+	simSpiAttach(&chain);
+	digits display(DIGITSTEST_LATCH, 6, shiftSPI);
+	digitGroup group(&display, 0, 6);
+	digitGroup small(&display, 0, 4);
+	uint8_t *d = display.getPtr();
+
+	CHECK(!group.segDispSign(-5));
+	CHECK_EQUAL(digitsTestSegs[5], d[0]);
+	CHECK_EQUAL(0x80, d[1]);
+	CHECK_EQUAL(0x00, d[2]);
+
+	CHECK(!group.segDispFixed(-1234, 2)); // -12.34
+	CHECK_EQUAL(digitsTestSegs[4], d[0]);
+	CHECK_EQUAL(digitsTestSegs[3], d[1]);
+	CHECK_EQUAL(digitsTestSegs[2] | 0x01, d[2]);
+	CHECK_EQUAL(digitsTestSegs[1], d[3]);
+	CHECK_EQUAL(0x80, d[4]);
+	CHECK(small.segDispFixed(-1234, 2)); // no room for the sign
+
+	group.segDispFixed(5, 2); // 0.05
+	CHECK_EQUAL(digitsTestSegs[5], d[0]);
+	CHECK_EQUAL(digitsTestSegs[0], d[1]);
+	CHECK_EQUAL(digitsTestSegs[0] | 0x01, d[2]);
+	CHECK_EQUAL(0x00, d[3]);
+
+	group.segDispHex(0xBEEF);
+	CHECK_EQUAL(0xE2, d[0]);
+	CHECK_EQUAL(0xF2, d[1]);
+	CHECK_EQUAL(0xF2, d[2]);
+	CHECK_EQUAL(0xF8, d[3]);
+	CHECK_EQUAL(0x00, d[4]);
+	CHECK_EQUAL(d[3], chain.get(3));
+}
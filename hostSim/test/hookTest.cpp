@@ -0,0 +1,91 @@
+/*
+ * hookTest.cpp
+ * Subscribers, named events and deferred dispatch.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "simTest.h"
+#include "../../hook/hook.h"
+
+class hookTestSource: public hook
+{
+public:
+	void call(hookEvent event) { callHook(event); }
+	void raise(hookEvent event) { raiseHook(event); }
+};
+
+static int hookTestCalls[4];
+static int hookTestPlainCalls;
+
+static void hookTestFunction(void *context)
+{
+	hookTestCalls[*(int *) context]++;
+}
+
+static void hookTestPlain()
+{
+	hookTestPlainCalls++;
+}
+
+SIMTEST(hookEvents)
+{
+	hookTestSource source;
+	int ids[3] = {0, 1, 2};
+	hookSubscriber before(hookBeforeUpdate, hookTestFunction, &ids[0]);
+	hookSubscriber after(hookAfterUpdate, hookTestFunction, &ids[1]);
+	hookSubscriber change(hookOnChange, hookTestFunction, &ids[2]);
+	memset(hookTestCalls, 0, sizeof(hookTestCalls));
+	hookTestPlainCalls = 0;
+	CHECK(source.subscribe(&before));
+	CHECK(source.subscribe(&after));
+	CHECK(source.subscribe(&change));
+	source.attachHook(hookTestPlain);
+	source.call(hookAfterUpdate);
+	source.call(hookOnChange);
+	CHECK_EQUAL(0, hookTestCalls[0]);
+	CHECK_EQUAL(1, hookTestCalls[1]);
+	CHECK_EQUAL(1, hookTestCalls[2]);
+	CHECK_EQUAL(1, hookTestPlainCalls);
+	CHECK(source.unsubscribe(&after));
+	CHECK(!source.unsubscribe(&after));
+	source.call(hookAfterUpdate);
+	CHECK_EQUAL(1, hookTestCalls[1]);
+	CHECK_EQUAL(2, hookTestPlainCalls);
+}
+
+SIMTEST(hookOneOwner)
+{
+	hookTestSource first;
+	hookTestSource second;
+	int id = 0;
+	hookSubscriber sub(hookOnChange, hookTestFunction, &id);
+	memset(hookTestCalls, 0, sizeof(hookTestCalls));
+	CHECK(first.subscribe(&sub));
+	CHECK(!second.subscribe(&sub)); // would join the two lists
+	CHECK(!second.unsubscribe(&sub));
+	second.call(hookOnChange);
+	CHECK_EQUAL(0, hookTestCalls[0]);
+	first.call(hookOnChange);
+	CHECK_EQUAL(1, hookTestCalls[0]);
+	CHECK(first.unsubscribe(&sub));
+	CHECK(second.subscribe(&sub));
+}
+
+SIMTEST(hookDeferred)
+{
+	hookTestSource source;
+	int id = 3;
+	hookSubscriber sub(hookOnChange, hookTestFunction, &id);
+	memset(hookTestCalls, 0, sizeof(hookTestCalls));
+	source.subscribe(&sub);
+	CHECK(!source.dispatchHooks());
+	source.raise(hookOnChange);
+	source.raise(hookOnChange); // events are flags, raised twice is dispatched once
+	CHECK_EQUAL(0, hookTestCalls[3]);
+	CHECK(source.dispatchHooks());
+	CHECK_EQUAL(1, hookTestCalls[3]);
+	CHECK(!source.dispatchHooks());
+	CHECK(SREG & _BV(SREG_I));
+}
@@ -0,0 +1,89 @@
+/*
+ * inputExtendTest.cpp
+ * inputExtend on a 74HC165 chain: reads, background scanning and the event queue capacity.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "simTest.h"
+#include "../../inputExtend/inputExtend.h"
+
+#define INPUTTEST_LATCH 9
+#define INPUTTEST_CHIPS 2
+
+SIMTEST(inputExtendRead)
+{
+	sim165 chain(INPUTTEST_LATCH, INPUTTEST_CHIPS);
+	simSpiAttach(&chain);
+	inputExtend in(INPUTTEST_LATCH, INPUTTEST_CHIPS, shiftSPI);
+	CHECK_EQUAL(0, SPCR); // begin() is not called, the first read starts the transport
+	chain.set(0, 0x81);
+	chain.set(1, 0x40);
+	CHECK(in.extendedRead(0));
+	CHECK(in.extendedRead(7));
+	CHECK(!in.extendedRead(1));
+	CHECK(in.extendedRead(14));
+	CHECK_EQUAL(0x40, in.byteRead(1));
+	CHECK_EQUAL(5 * INPUTTEST_CHIPS, simSpiBytes());
+	CHECK_EQUAL(0, chain.getLatchErrors());
+	CHECK(!simPinOutput(INPUTTEST_LATCH)); // loading between reads
+}
+
+SIMTEST(inputExtendScan)
+{
+	sim165 chain(INPUTTEST_LATCH, INPUTTEST_CHIPS);
+	simSpiAttach(&chain);
+	inputExtend in(INPUTTEST_LATCH, INPUTTEST_CHIPS, shiftSPI);
+	chain.set(1, 0x01);
+	in.startScan(8);
+	CHECK(!in.autoUpdate);
+	in.scan();
+	CHECK_EQUAL(0, in.eventsAvailable()); // the starting state is not an event
+	simSetMicros(5000);
+	chain.set(0, 0x04);
+	chain.set(1, 0x00);
+	in.scan();
+	CHECK_EQUAL(2, in.eventsAvailable());
+	inputEvent e;
+	CHECK(in.readEvent(&e));
+	CHECK_EQUAL(2, e.pin);
+	CHECK(e.state);
+	CHECK_EQUAL(5, e.time);
+	CHECK(in.readEvent(&e));
+	CHECK_EQUAL(8, e.pin);
+	CHECK(!e.state);
+	CHECK(!in.readEvent(&e));
+	CHECK(in.extendedRead(2)); // from the scan, no transfer
+	CHECK(in.dispatchHooks());
+	chain.set(0, 0x00);
+	in.scan();
+	in.startScan(2); // already scanning, the queue is kept
+	CHECK_EQUAL(1, in.eventsAvailable());
+	CHECK_EQUAL(0, chain.getLatchErrors());
+}
+
+SIMTEST(inputExtendQueueCapacity)
+{
+	// every size has to hold at least the requested number of events
+	for (byte size = 1; size <= 16; size++)
+	{
+		simReset();
+		sim165 chain(INPUTTEST_LATCH, INPUTTEST_CHIPS);
+		simSpiAttach(&chain);
+		inputExtend in(INPUTTEST_LATCH, INPUTTEST_CHIPS, shiftSPI);
+		in.startScan(size);
+		chain.set(0, 0xFF);
+		chain.set(1, 0xFF);
+		in.scan(); // 16 events
+		CHECK(in.eventsAvailable() >= size);
+		CHECK_EQUAL(16, in.eventsAvailable() + in.getEventsDropped());
+		inputEvent e;
+		byte pin = 0;
+		while (in.readEvent(&e))
+		{
+			CHECK_EQUAL(pin, e.pin); // oldest first
+			pin++;
+		}
+	}
+}
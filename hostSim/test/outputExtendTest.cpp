@@ -0,0 +1,97 @@
+/*
+ * outputExtendTest.cpp
+ * outputExtend on a 74HC595 chain: the bytes reach the right chips, delta update mode skips unchanged
+ * updates and frames send one update.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "simTest.h"
+#include "../../outputExtend/outputExtend.h"
+
+#define OUTPUTTEST_LATCH 9
+#define OUTPUTTEST_CHIPS 3
+
+SIMTEST(outputExtendChain)
+{
+	sim595 chain(OUTPUTTEST_LATCH, OUTPUTTEST_CHIPS);
+	simSpiAttach(&chain);
+	outputExtend out(OUTPUTTEST_LATCH, OUTPUTTEST_CHIPS);
+	CHECK_EQUAL(OUTPUTTEST_CHIPS, simSpiBytes()); // the constructor clears the outputs
+	out.byteWrite(0, 0xA5);
+	out.byteWrite(2, 0x3C);
+	out.extendedWrite(9, HIGH); // board 1 output 1
+	CHECK_EQUAL(0xA5, chain.get(0));
+	CHECK_EQUAL(0x02, chain.get(1));
+	CHECK_EQUAL(0x3C, chain.get(2));
+	CHECK(out.getState(9));
+	CHECK(!out.getState(8));
+	CHECK_EQUAL(0, chain.getLatchErrors());
+	CHECK(!simPinOutput(OUTPUTTEST_LATCH));
+	CHECK_EQUAL(4 * OUTPUTTEST_CHIPS, simSpiBytes());
+}
+
+SIMTEST(outputExtendDelta)
+{
+	sim595 chain(OUTPUTTEST_LATCH, OUTPUTTEST_CHIPS);
+	simSpiAttach(&chain);
+	outputExtend out(OUTPUTTEST_LATCH, OUTPUTTEST_CHIPS);
+	out.setDeltaUpdate(true);
+	out.clearCounters();
+	unsigned long before = simSpiBytes();
+	out.byteWrite(1, 0x00); // same as the outputs
+	out.extendedWrite(0, LOW);
+	out.update();
+	CHECK_EQUAL(3, out.getUpdatesRequested());
+	CHECK_EQUAL(0, out.getUpdatesPerformed());
+	CHECK_EQUAL(before, simSpiBytes());
+	out.extendedWrite(23, HIGH);
+	CHECK_EQUAL(1, out.getUpdatesPerformed());
+	CHECK_EQUAL(OUTPUTTEST_CHIPS, out.getBytesShifted());
+	CHECK_EQUAL(before + OUTPUTTEST_CHIPS, simSpiBytes());
+	CHECK_EQUAL(0x80, chain.get(2));
+	out.getPtr()[0] = 0x11; // changes made through the pointer are seen
+	out.update();
+	CHECK_EQUAL(2, out.getUpdatesPerformed());
+	CHECK_EQUAL(0x11, chain.get(0));
+	out.setDeltaUpdate(false);
+	out.update();
+	CHECK_EQUAL(3, out.getUpdatesPerformed());
+}
+
+SIMTEST(outputExtendFrame)
+{
+	sim595 chain(OUTPUTTEST_LATCH, OUTPUTTEST_CHIPS);
+	simSpiAttach(&chain);
+	outputExtend out(OUTPUTTEST_LATCH, OUTPUTTEST_CHIPS);
+	out.clearCounters();
+	out.beginFrame();
+	for (byte i = 0; i < 8 * OUTPUTTEST_CHIPS; i += 2)
+	{
+		out.extendedWrite(i, HIGH);
+	}
+	byte data[2] = {0xF0, 0x0F};
+	out.byteWrite(data, 2, 2); // truncated to the last board
+	CHECK_EQUAL(0, out.getUpdatesPerformed());
+	out.endFrame();
+	CHECK_EQUAL(1, out.getUpdatesPerformed());
+	CHECK_EQUAL(0x55, chain.get(0));
+	CHECK_EQUAL(0x55, chain.get(1));
+	CHECK_EQUAL(0xF0, chain.get(2));
+}
+
+SIMTEST(outputExtendTemplate)
+{
+	// the bit-bang kernel writes the port directly and can not be seen by the bus, check the buffer and counters
+	outputExtendT<2, 3, 4, 2> out;
+	CHECK_EQUAL(2, out.getSize());
+	CHECK_EQUAL(1, out.getUpdatesPerformed());
+	out.byteWrite(1, 0x81);
+	CHECK_EQUAL(0x81, out.getPtr()[1]);
+	CHECK_EQUAL(4, out.getBytesShifted());
+	CHECK(DDRD & _BV(2));
+	CHECK(DDRD & _BV(3));
+	CHECK(!simPinOutput(4));
+	CHECK_EQUAL(0, simSpiBytes());
+}
@@ -0,0 +1,163 @@
+/*
+ * pwmBoardTest.cpp
+ * pwmBoard on simulated PCA9634s: only the changed channel range is sent, a board that did not acknowledge is
+ * sent again in full, and identical boards are sent one ALLCALL broadcast.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "simTest.h"
+#include "../../pwmBoard/pwmBoard.h"
+
+/**
+ * PCA9634, the control byte selects the register (bits 4-0) and the auto-increment mode (bits 7-5).
+ */
+class simPca9634: public simTwiDevice
+{
+private:
+	uint8_t address;
+public:
+	uint8_t regs[0x20];
+	unsigned long writes;
+	boolean nack;
+	simPca9634(uint8_t address)
+	{
+		this->address = address;
+		memset(regs, 0, sizeof(regs));
+		regs[0x00] = 0x91; // MODE1, ALLCALL on
+		writes = 0;
+		nack = false;
+	}
+	boolean matches(uint8_t addr)
+	{
+		return !nack && ((addr == address) || ((addr == PWMBOARD_ALLCALL) && (regs[0x00] & 0x01)));
+	}
+	void write(const uint8_t *data, uint8_t length)
+	{
+		writes++;
+		if (length == 0)
+		{
+			return;
+		}
+		uint8_t reg = data[0] & 0x1F;
+		uint8_t mode = data[0] >> 5;
+		for (uint8_t i = 1; i < length; i++)
+		{
+			regs[reg] = data[i];
+			if (mode == 0x04) // all registers
+			{
+				reg = (reg + 1) & 0x1F;
+			}
+			else if (mode == 0x05) // PWM0-PWM7 only
+			{
+				reg = (reg >= 0x09) ? 0x02 : reg + 1;
+			}
+		}
+	}
+	void read(uint8_t *data, uint8_t length)
+	{
+		memset(data, 0, length);
+	}
+	uint8_t pwm(uint8_t channel) { return regs[0x02 + channel]; }
+};
+
+#define PWMTEST_ADDR(n) (((~(n)) & 0x0F) | 0x10)
+
+SIMTEST(pwmBoardChangedRange)
+{
+	simPca9634 chip(PWMTEST_ADDR(0));
+	simTwiAttach(&chip);
+	pwmBoard pwm(0);
+	pwm.start();
+	CHECK_EQUAL(0x81, chip.regs[0x00]);
+	CHECK_EQUAL(0xAA, chip.regs[0x0C]);
+	pwm.autoUpdate = false;
+	pwm.update(); // everything after start()
+	CHECK_EQUAL(1, pwm.getTransactions());
+	CHECK_EQUAL(9, pwm.getBytesSent());
+	pwm.clearCounters();
+	pwm.update();
+	CHECK_EQUAL(0, pwm.getTransactions()); // nothing changed
+	pwm.setLevel(2, 100);
+	pwm.setLevel(5, 200);
+	pwm.update();
+	CHECK_EQUAL(1, pwm.getTransactions());
+	CHECK_EQUAL(5, pwm.getBytesSent()); // control byte and PWM2-PWM5
+	CHECK_EQUAL(100, chip.pwm(2));
+	CHECK_EQUAL(200, chip.pwm(5));
+	pwm.getPtr()[7] = 7;
+	pwm.update();
+	CHECK_EQUAL(7, chip.pwm(7));
+	CHECK_EQUAL(2, pwm.getTransactions());
+	CHECK_EQUAL(7, pwm.getBytesSent());
+	chip.regs[0x04] = 0; // the board lost its registers
+	pwm.update();
+	CHECK_EQUAL(2, pwm.getTransactions()); // not seen by update()
+	pwm.refresh();
+	pwm.update();
+	CHECK_EQUAL(3, pwm.getTransactions());
+	CHECK_EQUAL(16, pwm.getBytesSent());
+	CHECK_EQUAL(100, chip.pwm(2));
+}
+
+SIMTEST(pwmBoardNackResend)
+{
+	simPca9634 first(PWMTEST_ADDR(0));
+	simPca9634 second(PWMTEST_ADDR(1));
+	simTwiAttach(&first);
+	simTwiAttach(&second);
+	pwmBoard pwm(0, 2);
+	pwm.start();
+	pwm.autoUpdate = false;
+	pwm.update();
+	pwm.clearCounters();
+	second.nack = true;
+	pwm.setLevel(3, 30);
+	pwm.setLevel(11, 110);
+	pwm.update();
+	CHECK_EQUAL(1, pwm.getTransactions()); // the NACK is not counted
+	CHECK_EQUAL(30, first.pwm(3));
+	CHECK_EQUAL(0, second.pwm(3));
+	second.nack = false;
+	second.regs[0x02] = 0xEE; // lost state on the board that did not answer
+	pwm.update();
+	CHECK_EQUAL(2, pwm.getTransactions());
+	CHECK_EQUAL(11, pwm.getBytesSent()); // first: 2, second: the whole board
+	CHECK_EQUAL(110, second.pwm(3));
+	CHECK_EQUAL(0, second.pwm(0));
+}
+
+SIMTEST(pwmBoardAllCall)
+{
+	simPca9634 first(PWMTEST_ADDR(4));
+	simPca9634 second(PWMTEST_ADDR(5));
+	simTwiAttach(&first);
+	simTwiAttach(&second);
+	pwmBoard pwm(4, 2);
+	pwm.start();
+	pwm.setAllCall(true);
+	pwm.autoUpdate = false;
+	pwm.update();
+	pwm.clearCounters();
+	unsigned long writes = first.writes;
+	pwm.setLevel(50);
+	pwm.update();
+	CHECK_EQUAL(1, pwm.getTransactions());
+	CHECK_EQUAL(writes + 1, first.writes);
+	for (uint8_t i = 0; i < 8; i++)
+	{
+		CHECK_EQUAL(50, first.pwm(i));
+		CHECK_EQUAL(50, second.pwm(i));
+	}
+	pwm.setLevel(9, 60); // the boards now differ
+	pwm.update();
+	CHECK_EQUAL(2, pwm.getTransactions());
+	CHECK_EQUAL(50, first.pwm(1));
+	CHECK_EQUAL(60, second.pwm(1));
+	CHECK_EQUAL(writes + 1, first.writes);
+	pwm.setAllCall(false);
+	pwm.setLevel(70);
+	pwm.update();
+	CHECK_EQUAL(4, pwm.getTransactions());
+}
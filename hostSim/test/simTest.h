@@ -0,0 +1,51 @@
+/*
+ * simTest.h
+ * Minimal test registration and checks for the host simulation tests.
+ * SIMTEST(name) defines a test, the simulation is reset before each one. A failed CHECK is reported
+ * and the test carries on.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#ifndef __simTest_h_
+#define __simTest_h_
+
+#include <stdio.h>
+#include "sim.h"
+
+/**
+ * One registered test, the tests are linked in the order they are constructed.
+ */
+class simTest
+{
+public:
+	const char *name;
+	void (*function)();
+	simTest *next;
+	simTest(const char *name, void (*function)());
+	static int runAll(const char *filter); // runs the tests whose names contain filter (all if NULL), returns the failure count
+	static void fail(const char *file, int line, const char *text);
+};
+
+#define SIMTEST(name) \
+	static void simTest_##name(); \
+	static simTest simTestEntry_##name(#name, simTest_##name); \
+	static void simTest_##name()
+
+#define CHECK(condition) \
+	do { if (!(condition)) simTest::fail(__FILE__, __LINE__, #condition); } while (0)
+
+#define CHECK_EQUAL(expected, actual) \
+	do { \
+		long simExpected_ = (long) (expected); \
+		long simActual_ = (long) (actual); \
+		if (simExpected_ != simActual_) \
+		{ \
+			char simText_[160]; \
+			snprintf(simText_, sizeof(simText_), "%s == %s (%ld != %ld)", #expected, #actual, simExpected_, simActual_); \
+			simTest::fail(__FILE__, __LINE__, simText_); \
+		} \
+	} while (0)
+
+#endif // __simTest_h_
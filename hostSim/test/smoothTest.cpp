@@ -0,0 +1,126 @@
+/*
+ * smoothTest.cpp
+ * smooth and the filter templates against a straight recomputation over the window.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "simTest.h"
+#include "../../smooth/smooth.h"
+
+static unsigned long seed;
+
+static unsigned int nextSample()
+{
+	seed = seed * 1103515245UL + 12345UL;
+	return (seed >> 16) & 0x03FF; // 10 bits, like analogRead()
+}
+
+SIMTEST(smoothRunningSum)
+{
+	const int size = 8;
+	unsigned int window[size];
+	smooth s(size);
+	seed = 1;
+	for (int n = 0; n < 100; n++)
+	{
+		window[n % size] = nextSample();
+		s.smoothData(window[n % size]);
+		int count = (n < size) ? n + 1 : size;
+		unsigned long sum = 0;
+		for (int i = 0; i < count; i++)
+		{
+			sum += window[i];
+		}
+		CHECK_EQUAL(sum / count, s.smoothedData);
+	}
+	CHECK(s.bufferFull);
+	s.clearData();
+	CHECK(!s.bufferFull);
+	s.smoothData(7);
+	CHECK_EQUAL(7, s.smoothedData);
+}
+
+SIMTEST(smoothAverage)
+{
+	const int size = 5;
+	int window[size];
+	smoothAverage<int, size> s;
+	seed = 2;
+	for (int n = 0; n < 100; n++)
+	{
+		window[n % size] = (int) nextSample() - 512;
+		s.smoothData(window[n % size]);
+		int count = (n < size) ? n + 1 : size;
+		long sum = 0;
+		for (int i = 0; i < count; i++)
+		{
+			sum += window[i];
+		}
+		CHECK_EQUAL(sum / count, s.smoothedData);
+	}
+}
+
+SIMTEST(smoothMedian)
+{
+	const int size = 7;
+	unsigned int window[size];
+	unsigned int sorted[size];
+	smoothMedian<unsigned int, size> s;
+	seed = 3;
+	for (int n = 0; n < 200; n++)
+	{
+		window[n % size] = nextSample() & 0x0F; // repeated values
+		s.smoothData(window[n % size]);
+		int count = (n < size) ? n + 1 : size;
+		memcpy(sorted, window, count * sizeof(unsigned int));
+		for (int i = 1; i < count; i++)
+		{
+			for (int j = i; (j != 0) && (sorted[j - 1] > sorted[j]); j--)
+			{
+				unsigned int t = sorted[j];
+				sorted[j] = sorted[j - 1];
+				sorted[j - 1] = t;
+			}
+		}
+		CHECK_EQUAL(sorted[(count - 1) >> 1], s.smoothedData);
+	}
+}
+
+SIMTEST(smoothMedianNaN)
+{
+	smoothMedian<float, 3> s;
+	s.smoothData(1.0f);
+	s.smoothData(NAN);
+	s.smoothData(2.0f);
+	for (int n = 0; n < 6; n++)
+	{
+		s.smoothData(3.0f); // the NaN has to be found to be removed
+	}
+	CHECK(s.smoothedData == 3.0f);
+}
+
+SIMTEST(smoothDecimate)
+{
+	smoothDecimate<int, 4> s;
+	CHECK(!s.smoothData(1));
+	CHECK(!s.smoothData(2));
+	CHECK(!s.smoothData(3));
+	CHECK(s.smoothData(6));
+	CHECK_EQUAL(3, s.smoothedData);
+	CHECK(!s.smoothData(100));
+	CHECK_EQUAL(3, s.smoothedData);
+}
+
+SIMTEST(smoothExponential)
+{
+	smoothExponential<int, 2> s;
+	s.smoothData(100);
+	CHECK_EQUAL(100, s.smoothedData);
+	for (int n = 0; n < 40; n++)
+	{
+		s.smoothData(200);
+	}
+	CHECK_EQUAL(200, s.smoothedData);
+}
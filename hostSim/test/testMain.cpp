@@ -0,0 +1,64 @@
+/*
+ * testMain.cpp
+ * Runs the host simulation tests, an argument selects the tests whose names contain it.
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "simTest.h"
+
+static simTest *simTestHead;
+static simTest *simTestTail;
+static int simTestFailures;
+
+simTest::simTest(const char *name, void (*function)())
+{
+	this->name = name;
+	this->function = function;
+	next = NULL;
+	if (simTestTail != NULL)
+	{
+		simTestTail->next = this;
+	}
+	else
+	{
+		simTestHead = this;
+	}
+	simTestTail = this;
+}
+
+void simTest::fail(const char *file, int line, const char *text)
+{
+	printf("  %s:%d: CHECK failed: %s\n", file, line, text);
+	simTestFailures++;
+}
+
+int simTest::runAll(const char *filter)
+{
+	int tests = 0;
+	int failed = 0;
+	for (simTest *t = simTestHead; t != NULL; t = t->next)
+	{
+		if ((filter != NULL) && (strstr(t->name, filter) == NULL))
+		{
+			continue;
+		}
+		int before = simTestFailures;
+		simReset();
+		(*t->function)();
+		tests++;
+		if (simTestFailures != before)
+		{
+			printf("FAIL %s\n", t->name);
+			failed++;
+		}
+	}
+	printf("%d tests, %d failed\n", tests, failed);
+	return failed;
+}
+
+int main(int argc, char **argv)
+{
+	return (simTest::runAll((argc > 1) ? argv[1] : NULL) == 0) ? 0 : 1;
+}
@@ -0,0 +1,252 @@
+/*
+ * twiTest.cpp
+ * The twi.c state machine on the simulated bus: a repeated start held between queued and blocking transfers,
+ * arbitration lost into slave mode, the NACK paths, a stop held by the clock and the bus reset from
+ * twi_poll().
+ *
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "simTest.h"
+#include <Wire.h>
+#include "pins_arduino.h"
+
+#define TWITEST_ADDRESS 0x40
+#define TWITEST_OTHER 0x41
+#define TWITEST_SLAVE 0x30
+
+static uint8_t twiTestReceived[8];
+static int twiTestReceivedLength;
+
+static void twiTestReceive(int length)
+{
+	twiTestReceivedLength = 0;
+	while (Wire.available() && (twiTestReceivedLength < (int) sizeof(twiTestReceived)))
+	{
+		twiTestReceived[twiTestReceivedLength++] = Wire.read();
+	}
+	(void) length;
+}
+
+static void twiTestWrite(twi_transfer *t, uint8_t address, uint8_t *data, uint8_t length)
+{
+	memset(t, 0, sizeof(*t));
+	t->address = address;
+	t->txData = data;
+	t->txLength = length;
+}
+
+/**
+ * Register device that NACKs the data bytes from an index on, or holds SCL low after acking one.
+ */
+class twiTestDevice: public simRegisterDevice
+{
+public:
+	uint8_t nackFrom;
+	uint8_t holdAfter;
+	twiTestDevice(uint8_t address): simRegisterDevice(address) { nackFrom = 0xFF; holdAfter = 0xFF; }
+	boolean ackData(uint8_t index)
+	{
+		if (index == holdAfter)
+		{
+			simTwiHoldClock(true);
+		}
+		return index < nackFrom;
+	}
+};
+
+SIMTEST(twiRepeatedStartOrder)
+{
+	simRegisterDevice chip(TWITEST_ADDRESS);
+	simRegisterDevice other(TWITEST_OTHER);
+	simTwiAttach(&chip);
+	simTwiAttach(&other);
+	chip.regs[0x10] = 0xA1;
+	chip.regs[0x11] = 0xA2;
+	Wire.begin();
+	uint8_t a[2] = {0x01, 0x55};
+	uint8_t b[2] = {0x02, 0x66};
+	twi_transfer ta, tb;
+	twiTestWrite(&ta, TWITEST_OTHER, a, 2);
+	twiTestWrite(&tb, TWITEST_OTHER, b, 2);
+	CHECK(Wire.queueTransfer(&ta));
+	CHECK(Wire.queueTransfer(&tb));
+
+	// the blocking write goes ahead of tb, after ta that is on the bus, and holds the bus for the read
+	Wire.beginTransmission(TWITEST_ADDRESS);
+	Wire.write(0x10);
+	CHECK_EQUAL(0, Wire.endTransmission(false));
+	CHECK_EQUAL(TWI_OK, ta.status);
+	CHECK_EQUAL(TWI_PENDING, tb.status);
+	simTwiRun();
+	CHECK_EQUAL(TWI_PENDING, tb.status); // not started while the repeated start is held
+	CHECK_EQUAL(2, Wire.requestFrom(TWITEST_ADDRESS, 2));
+	CHECK_EQUAL(0xA1, Wire.read());
+	CHECK_EQUAL(0xA2, Wire.read());
+	simTwiRun();
+	CHECK_EQUAL(TWI_OK, tb.status);
+	CHECK_EQUAL(0x66, other.regs[0x02]);
+	CHECK(strcmp("S 41W 01 55 P S 40W 10 Sr 40R A1 A2- P S 41W 02 66 P", simTwiTrace()) == 0);
+	CHECK(Wire.isIdle());
+}
+
+SIMTEST(twiArbitrationLostToSlave)
+{
+	simRegisterDevice chip(TWITEST_ADDRESS);
+	simTwiAttach(&chip);
+	Wire.begin(TWITEST_SLAVE);
+	Wire.onReceive(twiTestReceive);
+	twiTestReceivedLength = 0;
+	const uint8_t incoming[3] = {0x0A, 0x0B, 0x0C};
+	simTwiLoseArbitration(TWITEST_SLAVE, incoming, 3);
+	uint8_t a[2] = {0x00, 0x77};
+	uint8_t b[2] = {0x01, 0x88};
+	twi_transfer ta, tb;
+	twiTestWrite(&ta, TWITEST_ADDRESS, a, 2);
+	twiTestWrite(&tb, TWITEST_ADDRESS, b, 2);
+	CHECK(Wire.queueTransfer(&ta));
+	CHECK(Wire.queueTransfer(&tb));
+	simTwiRun();
+	// ta lost the bus to a master writing to this one, tb runs after its stop
+	CHECK_EQUAL(TWI_ERROR_OTHER, ta.status);
+	CHECK_EQUAL(3, twiTestReceivedLength);
+	CHECK(memcmp(incoming, twiTestReceived, 3) == 0);
+	CHECK_EQUAL(TWI_OK, tb.status);
+	CHECK_EQUAL(0, chip.regs[0x00]);
+	CHECK_EQUAL(0x88, chip.regs[0x01]);
+	CHECK(strcmp("S L 0A 0B 0C P S 40W 01 88 P", simTwiTrace()) == 0);
+}
+
+SIMTEST(twiNack)
+{
+	twiTestDevice chip(TWITEST_ADDRESS);
+	simTwiAttach(&chip);
+	Wire.begin();
+	uint8_t data[3] = {0x00, 0x11, 0x22};
+	uint8_t rx[2];
+	twi_transfer t, next;
+
+	// address NACK, written and read
+	chip.nack = true;
+	twiTestWrite(&t, TWITEST_ADDRESS, data, 3);
+	CHECK(Wire.queueTransfer(&t));
+	CHECK_EQUAL(1, simTwiRun());
+	CHECK_EQUAL(TWI_ERROR_ADDR_NACK, t.status);
+	twiTestWrite(&t, TWITEST_ADDRESS, NULL, 0);
+	t.rxData = rx;
+	t.rxLength = 2;
+	CHECK(Wire.queueTransfer(&t));
+	CHECK_EQUAL(1, simTwiRun());
+	CHECK_EQUAL(TWI_ERROR_ADDR_NACK, t.status);
+	CHECK_EQUAL(0, t.rxCount);
+	Wire.beginTransmission(TWITEST_ADDRESS);
+	CHECK_EQUAL(2, Wire.endTransmission()); // blocking, Wire's code for an address NACK
+
+	// data NACK on the second byte, the next transfer still runs
+	chip.nack = false;
+	chip.nackFrom = 1;
+	twiTestWrite(&t, TWITEST_ADDRESS, data, 3);
+	twiTestWrite(&next, TWITEST_ADDRESS, data, 1);
+	CHECK(Wire.queueTransfer(&t));
+	CHECK(Wire.queueTransfer(&next));
+	CHECK_EQUAL(2, simTwiRun());
+	CHECK_EQUAL(TWI_ERROR_DATA_NACK, t.status);
+	CHECK_EQUAL(TWI_OK, next.status);
+	CHECK(strcmp("S 40W- P S 40R- P S 40W- P S 40W 00 11- P S 40W 00 P", simTwiTrace()) == 0);
+}
+
+SIMTEST(twiStopHeld)
+{
+	twiTestDevice chip(TWITEST_ADDRESS);
+	simTwiAttach(&chip);
+	Wire.begin();
+	uint8_t a[2] = {0x00, 0x11};
+	uint8_t b[2] = {0x01, 0x22};
+	twi_transfer ta, tb;
+	twiTestWrite(&ta, TWITEST_ADDRESS, a, 2);
+	twiTestWrite(&tb, TWITEST_ADDRESS, b, 2);
+	chip.holdAfter = 1; // SCL is held low from the last byte of ta, so its stop does not complete
+	unsigned long isr = simInterruptCycles();
+	CHECK(Wire.queueTransfer(&ta));
+	CHECK(Wire.queueTransfer(&tb));
+	simTwiRun();
+	// the interrupt gave up on the stop after about one SCL period, without resetting the bus
+	CHECK(simInterruptCycles() - isr < 100 * (F_CPU / 1000000L));
+	CHECK_EQUAL(TWI_OK, ta.status); // every byte was acked
+	CHECK_EQUAL(TWI_PENDING, tb.status);
+	CHECK(strcmp("S 40W 00 11", simTwiTrace()) == 0);
+	CHECK(!Wire.isIdle());
+
+	// the device lets go, the next poll resets the bus and tb runs
+	simTwiHoldClock(false);
+	chip.holdAfter = 0xFF;
+	Wire.poll();
+	simTwiRun();
+	CHECK_EQUAL(TWI_OK, tb.status);
+	CHECK_EQUAL(0x22, chip.regs[0x01]);
+	CHECK(Wire.isIdle());
+}
+
+SIMTEST(twiRecoverClocks)
+{
+	simRegisterDevice chip(TWITEST_ADDRESS);
+	simTwiAttach(&chip);
+	Wire.begin();
+	Wire.setBusTimeout(5);
+	uint8_t a[2] = {0x00, 0x33};
+	twi_transfer t;
+	twiTestWrite(&t, TWITEST_ADDRESS, a, 2);
+
+	// a device left in the middle of a byte holds SDA until it has seen 5 more clocks
+	simTwiHoldData(5);
+	CHECK(Wire.queueTransfer(&t));
+	simAdvance(2000);
+	Wire.poll();
+	CHECK_EQUAL(TWI_PENDING, t.status); // not timed out yet
+	simAdvance(4000);
+	simProbe(SCL);
+	simProbe(SDA);
+	unsigned int from = simProbeEdges();
+	Wire.poll();
+	CHECK_EQUAL(TWI_ERROR_TIMEOUT, t.status);
+
+	// 5 clocks free SDA, then a stop: SDA goes low with SCL low and rises after SCL
+	int sclClocks = 0;
+	unsigned long sdaFall = 0, sclRise = 0, sdaRise = 0;
+	unsigned int edges = simProbeEdges();
+	for (unsigned int i = from; i < edges; i++)
+	{
+		simEdge e = simProbeEdge(i);
+		if (e.pin == SCL)
+		{
+			if (e.level)
+			{
+				sclRise = e.cycle;
+			}
+			else
+			{
+				sclClocks++;
+			}
+		}
+		else if (e.level)
+		{
+			sdaRise = e.cycle;
+		}
+		else
+		{
+			sdaFall = e.cycle;
+		}
+	}
+	CHECK_EQUAL(6, sclClocks);
+	CHECK(sdaFall != 0);
+	CHECK(sdaFall < sclRise);
+	CHECK(sclRise < sdaRise);
+
+	// the bus works again
+	CHECK(Wire.queueTransfer(&t));
+	CHECK_EQUAL(1, simTwiRun());
+	CHECK_EQUAL(TWI_OK, t.status);
+	CHECK_EQUAL(0x33, chip.regs[0x00]);
+	Wire.setBusTimeout(TWI_TIMEOUT);
+}
@@ -0,0 +1,132 @@
+/*
+ * Ethernet2Test.cpp
+ * Ethernet2 on a simulated W5500: the configuration reaches the chip, a server exchanges data with a client and
+ * the event driven server loop.
+ *
+ * Rev 2 - 10/2026 - EthernetServer::handleEvents()
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "simTest.h"
+#include "../../../Ethernet2/src/Ethernet2.h"
+#include "../../../Ethernet2/src/utility/w5500.h"
+
+static uint8_t ethernet2TestMac[6] = {0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED};
+static const uint8_t ethernet2TestPeer[4] = {192, 168, 1, 20};
+
+static int ethernet2TestConnects;
+static int ethernet2TestDisconnects;
+static char ethernet2TestReceived[32];
+static int ethernet2TestReceivedLength;
+
+static void ethernet2TestConnect(EthernetClient &)
+{
+	ethernet2TestConnects++;
+}
+
+// Reads 4 bytes at most, the rest is left for the next event
+static void ethernet2TestReceive(EthernetClient &client)
+{
+	for (int i = 0; (i < 4) && client.available() && (ethernet2TestReceivedLength < 31); i++)
+	{
+		ethernet2TestReceived[ethernet2TestReceivedLength++] = client.read();
+	}
+	ethernet2TestReceived[ethernet2TestReceivedLength] = '\0';
+}
+
+static void ethernet2TestDisconnect(EthernetClient &)
+{
+	ethernet2TestDisconnects++;
+}
+
+SIMTEST(Ethernet2ServerExchange)
+{
+	simW5500 chip;
+	simSpiAttach(&chip);
+	Ethernet.begin(ethernet2TestMac, IPAddress(192, 168, 1, 10));
+	CHECK(memcmp(chip.ipAddress(), "\xC0\xA8\x01\x0A", 4) == 0);
+	CHECK(Ethernet.localIP() == IPAddress(192, 168, 1, 10));
+
+	EthernetServer server(80);
+	server.begin();
+	CHECK_EQUAL(SnSR::LISTEN, chip.status(0));
+	CHECK_EQUAL(80, chip.port(0));
+	CHECK(!server.available());
+
+	CHECK(chip.peerConnect(0, ethernet2TestPeer, 40000));
+	CHECK_EQUAL(5, chip.peerSend(0, (const uint8_t *) "hello", 5));
+	EthernetClient client = server.available();
+	CHECK(client);
+	CHECK(client.connected());
+	CHECK_EQUAL(SnSR::LISTEN, chip.status(1)); // a new socket listens for the next client
+	CHECK_EQUAL(5, client.available());
+	uint8_t data[8];
+	CHECK_EQUAL(5, client.read(data, sizeof(data)));
+	CHECK(memcmp(data, "hello", 5) == 0);
+	CHECK_EQUAL(0, chip.received(0));
+
+	CHECK_EQUAL(2, client.write("OK"));
+	CHECK_EQUAL(2, chip.sentBytes(0));
+	CHECK(memcmp(chip.sent(0), "OK", 2) == 0);
+	client.stop();
+	CHECK_EQUAL(SnSR::CLOSED, chip.status(0));
+}
+
+SIMTEST(Ethernet2ServerEvents)
+{
+	simW5500 chip;
+	simSpiAttach(&chip);
+	memset(EthernetClass::_server_port, 0, sizeof(EthernetClass::_server_port));
+	Ethernet.begin(ethernet2TestMac, IPAddress(192, 168, 1, 10));
+	EthernetServer server(80);
+	server.onEvent(SERVER_CONNECT, ethernet2TestConnect);
+	server.onEvent(SERVER_RECEIVE, ethernet2TestReceive);
+	server.onEvent(SERVER_DISCONNECT, ethernet2TestDisconnect);
+	ethernet2TestConnects = 0;
+	ethernet2TestDisconnects = 0;
+	ethernet2TestReceivedLength = 0;
+	server.begin();
+
+	// idle, one read of SIR
+	unsigned long spi = simSpiBytes();
+	CHECK_EQUAL(0, server.handleEvents());
+	CHECK_EQUAL(4, simSpiBytes() - spi);
+
+	CHECK(chip.peerConnect(0, ethernet2TestPeer, 40000));
+	CHECK_EQUAL(1, server.handleEvents());
+	CHECK_EQUAL(1, ethernet2TestConnects);
+	CHECK_EQUAL(SnSR::LISTEN, chip.status(1));
+
+	// the handler reads 4 bytes at a time and is called again until it has read them all
+	CHECK_EQUAL(10, chip.peerSend(0, (const uint8_t *) "0123456789", 10));
+	CHECK_EQUAL(1, server.handleEvents());
+	CHECK(strcmp("0123", ethernet2TestReceived) == 0);
+	CHECK_EQUAL(1, server.handleEvents());
+	CHECK_EQUAL(1, server.handleEvents());
+	CHECK(strcmp("0123456789", ethernet2TestReceived) == 0);
+	CHECK_EQUAL(0, server.handleEvents());
+	spi = simSpiBytes();
+	CHECK_EQUAL(0, server.handleEvents());
+	CHECK_EQUAL(4, simSpiBytes() - spi);
+
+	// the other end closes and is slow to acknowledge the FIN, the loop does not wait for it
+	chip.lingerDisconnect = true;
+	chip.peerClose(0);
+	unsigned long start = millis();
+	CHECK_EQUAL(1, server.handleEvents());
+	CHECK(millis() - start < 2);
+	CHECK_EQUAL(1, ethernet2TestDisconnects);
+	CHECK_EQUAL(SnSR::LAST_ACK, chip.status(0));
+	CHECK_EQUAL(0, server.handleEvents());
+	chip.peerClose(0);
+	CHECK_EQUAL(SnSR::CLOSED, chip.status(0));
+	CHECK_EQUAL(0, server.handleEvents());
+	CHECK_EQUAL(1, ethernet2TestDisconnects);
+
+	// the closed socket listens again when the next client takes the listening one
+	CHECK(chip.peerConnect(1, ethernet2TestPeer, 40001));
+	CHECK_EQUAL(1, server.handleEvents());
+	CHECK_EQUAL(2, ethernet2TestConnects);
+	CHECK_EQUAL(SnSR::LISTEN, chip.status(0));
+}
@@ -0,0 +1,275 @@
+/*
+ * wireUtilTest.cpp
+ * wireQueue transactions run from the (simulated) twi interrupt, a stalled bus reset by run(), two devices
+ * sharing the queue, and the wireUtil register shadow with queued writes, volatile registers and the burst flush.
+ *
+ * Rev 2 - 10/2026 - stalled bus and two devices
+ * Rev 1 - 10/2026
+ *
+ */
+
+#include "simTest.h"
+#include <Wire.h>
+#include "wireUtil.h"
+
+#define WIRETEST_ADDRESS 0x40
+#define WIRETEST_OTHER 0x41
+
+enum wireTestReg { WT_R0, WT_R1, WT_R2, WT_R3 };
+
+class wireTestDevice: public wireUtil<wireTestReg, uint8_t>
+{
+public:
+	void begin(uint8_t a = WIRETEST_ADDRESS)
+	{
+		Wire.begin();
+		address = a;
+		timeoutTime = 10;
+	}
+};
+
+static int wireTestCallbacks;
+
+static void wireTestCallback(wireTransaction *)
+{
+	wireTestCallbacks++;
+}
+
+static char wireTestOrder[16];
+
+// Records the order the transactions complete in, by the letter in their context
+static void wireTestOrderCallback(wireTransaction *t)
+{
+	size_t n = strlen(wireTestOrder);
+	if (n + 1 < sizeof(wireTestOrder))
+	{
+		wireTestOrder[n] = *(const char *) t->context;
+		wireTestOrder[n + 1] = '\0';
+	}
+}
+
+SIMTEST(wireQueueAsync)
+{
+	simRegisterDevice chip(WIRETEST_ADDRESS);
+	simTwiAttach(&chip);
+	wireTestDevice d;
+	d.begin();
+	uint8_t readBuffer[3] = {0};
+	uint8_t writeBuffer[2] = {0x11, 0x22};
+	uint8_t result = 0;
+	wireTransaction a, b, c;
+	chip.regs[0] = 0xA0;
+	chip.regs[1] = 0xA1;
+	chip.regs[2] = 0xA2;
+	chip.regs[3] = 0xF0;
+	wireTestCallbacks = 0;
+	unsigned long completed = WireQueue.getCompleted();
+
+	CHECK(d.queueRead(&a, WT_R0, readBuffer, 3, wireTestCallback));
+	CHECK(d.queueWrite(&b, WT_R1, writeBuffer, 2, wireTestCallback));
+	CHECK(d.queueSetBits(&c, WT_R3, 0x0F, 0x05, &result, wireTestCallback));
+	CHECK(!d.queueSetBits(&c, WT_R3, 0xFF, 0x00, &result, wireTestCallback)); // already queued
+	CHECK_EQUAL(0x0F, c.mask);
+	CHECK_EQUAL(WIREQUEUE_PENDING, a.status);
+	CHECK(!WireQueue.isIdle());
+	CHECK(!WireQueue.cancel(&a)); // on the bus
+	CHECK_EQUAL(0, simTwiTransactions()); // nothing has blocked
+
+	CHECK_EQUAL(4, simTwiRun()); // read, write, modify read then write
+	CHECK_EQUAL(0, a.status);
+	CHECK_EQUAL(0xA0, readBuffer[0]);
+	CHECK_EQUAL(0xA2, readBuffer[2]);
+	CHECK_EQUAL(0, b.status);
+	CHECK_EQUAL(0x11, chip.regs[1]);
+	CHECK_EQUAL(0x22, chip.regs[2]);
+	CHECK_EQUAL(0, c.status);
+	CHECK_EQUAL(0xF5, chip.regs[3]);
+	CHECK_EQUAL(0xF5, result);
+	CHECK_EQUAL(3, wireTestCallbacks);
+	CHECK(WireQueue.isIdle());
+	CHECK_EQUAL(completed + 3, WireQueue.getCompleted());
+	CHECK_EQUAL(3, WireQueue.run());
+	CHECK_EQUAL(0, WireQueue.run());
+
+	unsigned long errors = WireQueue.getErrors();
+	chip.nack = true;
+	CHECK(d.queueRead(&a, WT_R0, readBuffer, 1));
+	simTwiRun();
+	CHECK_EQUAL(TWI_ERROR_ADDR_NACK, a.status);
+	CHECK_EQUAL(errors + 1, WireQueue.getErrors());
+	WireQueue.run();
+}
+
+SIMTEST(wireQueueStall)
+{
+	simRegisterDevice chip(WIRETEST_ADDRESS);
+	simRegisterDevice other(WIRETEST_OTHER);
+	simTwiAttach(&chip);
+	simTwiAttach(&other);
+	wireTestDevice d, e;
+	d.begin();
+	e.begin(WIRETEST_OTHER);
+	Wire.setBusTimeout(5);
+	uint8_t readBuffer[2] = {0};
+	uint8_t data = 0x5A;
+	wireTransaction a, b;
+	unsigned long errors = WireQueue.getErrors();
+	unsigned long completed = WireQueue.getCompleted();
+
+	// a device holds SDA, the read stalls at its start and the write waits behind it
+	simTwiHoldData(3);
+	CHECK(d.queueRead(&a, WT_R0, readBuffer, 2));
+	CHECK(e.queueWrite(&b, WT_R1, &data, 1));
+	simAdvance(2000);
+	CHECK_EQUAL(0, WireQueue.run());
+	CHECK_EQUAL(WIREQUEUE_PENDING, a.status);
+
+	// run() resets the bus once it has stalled for the bus timeout, the next transaction goes ahead
+	simAdvance(4000);
+	CHECK_EQUAL(1, WireQueue.run());
+	CHECK_EQUAL(WIREQUEUE_TIMEOUT, a.status); // no data, as the blocking run() reports it
+	CHECK_EQUAL(errors + 1, WireQueue.getErrors());
+	CHECK_EQUAL(1, simTwiRun());
+	CHECK_EQUAL(0, b.status);
+	CHECK_EQUAL(0x5A, other.regs[1]);
+	CHECK_EQUAL(completed + 1, WireQueue.getCompleted());
+	CHECK_EQUAL(1, WireQueue.run());
+
+	// a stalled write keeps the twi status
+	simTwiHoldData(3);
+	CHECK(e.queueWrite(&b, WT_R2, &data, 1));
+	simAdvance(6000);
+	WireQueue.run();
+	CHECK_EQUAL(TWI_ERROR_TIMEOUT, b.status);
+	CHECK(WireQueue.isIdle());
+	Wire.setBusTimeout(TWI_TIMEOUT);
+}
+
+SIMTEST(wireQueueTwoDevices)
+{
+	simRegisterDevice chip(WIRETEST_ADDRESS);
+	simRegisterDevice other(WIRETEST_OTHER);
+	simTwiAttach(&chip);
+	simTwiAttach(&other);
+	wireTestDevice d, e;
+	d.begin();
+	e.begin(WIRETEST_OTHER);
+	chip.regs[0] = 0x10;
+	other.regs[0] = 0x20;
+	other.regs[3] = 0x80;
+	uint8_t fromChip = 0, fromOther = 0, result = 0;
+	uint8_t data = 0x33;
+	wireTransaction a, b, c, f;
+	char names[] = "abcf";
+	wireTestOrder[0] = '\0';
+
+	// interleaved, they complete in the order they were added, each on its own device
+	CHECK(d.queueRead(&a, WT_R0, &fromChip, 1, wireTestOrderCallback, &names[0]));
+	CHECK(e.queueRead(&b, WT_R0, &fromOther, 1, wireTestOrderCallback, &names[1]));
+	CHECK(d.queueWrite(&c, WT_R2, &data, 1, wireTestOrderCallback, &names[2]));
+	CHECK(e.queueSetBits(&f, WT_R3, 0x01, 0x01, &result, wireTestOrderCallback, &names[3]));
+	CHECK_EQUAL(5, simTwiRun());
+	CHECK(strcmp("abcf", wireTestOrder) == 0);
+	CHECK_EQUAL(0x10, fromChip);
+	CHECK_EQUAL(0x20, fromOther);
+	CHECK_EQUAL(0x33, chip.regs[2]);
+	CHECK_EQUAL(0, other.regs[2]);
+	CHECK_EQUAL(0x81, other.regs[3]);
+	CHECK(strcmp("S 40W 00 Sr 40R 10- P S 41W 00 Sr 41R 20- P S 40W 02 33 P S 41W 03 Sr 41R 80- P S 41W 03 81 P",
+	              simTwiTrace()) == 0);
+	CHECK_EQUAL(4, WireQueue.run());
+}
+
+SIMTEST(wireUtilShadow)
+{
+	simRegisterDevice chip(WIRETEST_ADDRESS);
+	simTwiAttach(&chip);
+	wireTestDevice d;
+	d.begin();
+	CHECK(d.enableShadow(4));
+	chip.regs[1] = 0x10;
+	CHECK_EQUAL(0x10, d.readRegister(WT_R1));
+	unsigned long transactions = simTwiTransactions();
+	CHECK_EQUAL(0x10, d.readRegister(WT_R1)); // from the shadow
+	CHECK_EQUAL(transactions, simTwiTransactions());
+
+	// a blocking read before the queued write completes must not validate the old value. The blocking calls go
+	// ahead of the twi queue, the write waits behind a read that is on the bus
+	uint8_t data = 0x55;
+	wireTransaction t, first;
+	uint8_t firstValue;
+	CHECK(d.queueRead(&first, WT_R0, &firstValue, 1));
+	CHECK(d.queueWrite(&t, WT_R1, &data, 1));
+	CHECK_EQUAL(0x10, d.readRegister(WT_R1));
+	CHECK_EQUAL(WIREQUEUE_PENDING, t.status);
+	simTwiRun();
+	CHECK_EQUAL(0, t.status);
+	CHECK_EQUAL(0x55, chip.regs[1]);
+	CHECK_EQUAL(0x55, d.readRegister(WT_R1));
+	transactions = simTwiTransactions();
+	CHECK_EQUAL(0x55, d.readRegister(WT_R1));
+	CHECK_EQUAL(transactions, simTwiTransactions());
+
+	// a cancelled write releases its registers
+	wireTransaction blocker, t2;
+	uint8_t readBack;
+	CHECK(d.queueRead(&blocker, WT_R0, &readBack, 1));
+	CHECK(d.queueWrite(&t2, WT_R2, &data, 1));
+	CHECK(WireQueue.cancel(&t2));
+	simTwiRun();
+	transactions = simTwiTransactions();
+	d.readRegister(WT_R2);
+	d.readRegister(WT_R2);
+	CHECK_EQUAL(transactions + 2, simTwiTransactions()); // one register read, pointer write and data read
+	WireQueue.run();
+}
+
+SIMTEST(wireUtilVolatile)
+{
+	simRegisterDevice chip(WIRETEST_ADDRESS);
+	simTwiAttach(&chip);
+	wireTestDevice d;
+	d.begin();
+	CHECK(d.enableShadow(4));
+
+	// setVolatile() keeps a pending bit change
+	d.readRegister(WT_R3);
+	d.setRegisterBit(WT_R3, 0, true);
+	CHECK_EQUAL(0, chip.regs[3]);
+	d.setVolatile(WT_R3);
+	unsigned long writes = chip.writes;
+	CHECK(d.flushRegisters());
+	CHECK_EQUAL(writes + 1, chip.writes);
+	CHECK_EQUAL(0x01, chip.regs[3]);
+
+	// writes to a volatile register are never skipped
+	writes = chip.writes;
+	d.writeRegister(WT_R3, 7);
+	d.writeRegister(WT_R3, 7);
+	CHECK_EQUAL(writes + 2, chip.writes);
+	d.setVolatile(WT_R3, false);
+	writes = chip.writes;
+	d.writeRegister(WT_R3, 9);
+	d.writeRegister(WT_R3, 9);
+	CHECK_EQUAL(writes + 1, chip.writes);
+}
+
+SIMTEST(wireUtilFlushBurst)
+{
+	simRegisterDevice chip(WIRETEST_ADDRESS);
+	simTwiAttach(&chip);
+	wireTestDevice d;
+	d.begin();
+	CHECK(d.enableShadow(4));
+	uint8_t all[4];
+	CHECK(d.readRegisters(WT_R0, all, 4));
+	unsigned long writes = chip.writes;
+	d.setRegisterBit(WT_R1, 1, true);
+	d.setRegisterBit(WT_R2, 2, true);
+	d.setRegisterBit(WT_R2, 3, true);
+	CHECK_EQUAL(writes, chip.writes); // deferred
+	CHECK(d.flushRegisters());
+	CHECK_EQUAL(writes + 1, chip.writes); // adjacent dirty registers in one burst
+	CHECK_EQUAL(0x02, chip.regs[1]);
+	CHECK_EQUAL(0x0C, chip.regs[2]);
+}
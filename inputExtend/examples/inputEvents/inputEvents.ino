@@ -0,0 +1,63 @@
+/*
+ * Roto
+ * Example Code
+ *
+ * Library:
+ * inputExtend
+ *
+ * Background scanning with the input change event queue.
+ * The chain is scanned once per millisecond from the Timer0 compare interrupt (Timer0 already runs millis(),
+ * so this does not use up a timer), loop() only handles the inputs that changed.
+ *
+ */
+
+// Libraries:
+#include <inputExtend.h>
+
+// Pin Assignments:
+const byte inputDataPin  = 8;
+const byte inputClockPin = 9;
+const byte inputLatchPin = 10;
+
+// Constants:
+const byte numberOfInputChips = 8;
+const byte eventQueueSize = 32;
+
+// Global Variables:
+
+// Global Classes:
+inputExtend inputs = inputExtend(inputDataPin, inputClockPin, inputLatchPin, numberOfInputChips);
+
+ISR(TIMER0_COMPA_vect)
+{
+	inputs.scan();
+}
+
+void setup()
+{
+	Serial.begin(9600);
+	Serial.println("Startup");
+
+	inputs.startScan(eventQueueSize);
+
+	OCR0A = 0x80; // interrupt part way through the Timer0 count
+	TIMSK0 |= _BV(OCIE0A);
+}
+
+void loop()
+{
+	inputEvent event;
+
+	while (inputs.readEvent(&event))
+	{
+		Serial.print("pin ");
+		Serial.print(event.pin);
+		Serial.print(event.state ? " HIGH at " : " LOW at ");
+		Serial.println(event.time);
+	}
+
+	if (inputs.getEventsDropped() != 0)
+	{
+		Serial.println("event queue overflow");
+	}
+}
@@ -6,13 +6,18 @@
  * Rev 1 - Keegan Morrow - 10/2011
  * Rev 2 - Keegan Morrow - 6/2012 moved numChips and boards to protected
  * Rev 3 - Keegan Morrow - 1/2014 added getSize(), added hook utility
+ * Rev 4 - 10/2026 added background scanning with an input change event queue
+ * Rev 5 - 10/2026 moved the data transfer to shiftTransport, added SPI and USART transports
+ * Rev 6 - 10/2026 moved hook to the shared hook library, update() calls the before update event, scan() raises the on change event
+ * Rev 7 - 10/2026 added inputExtendT, a template version with the pins and buffer size fixed at compile time
+ * Rev 8 - 10/2026 the SPI and USART transports are started by begin() instead of the constructor
  * 
  */
 
 #include "inputExtend.h"
 
 /**
- * Sets the direction of the IO pins and allocates needed memory.
+ * Bitbanging mode constructor. Sets the direction of the IO pins and allocates needed memory.
  * This should be used to declare a global object.
  * @param dataPin Pin number attached to the data pin
  * @param clockPin Pin number attached to the data pin
@@ -22,28 +27,79 @@
 inputExtend::inputExtend(byte dataPin, byte clockPin, byte latchPin,
 		byte numChips)
 {
+	transport.beginBitBang(dataPin, clockPin, true);
+	this->numChips = numChips;
+	startup(latchPin);
+}
 
-	dataPortPtr = portInputRegister(digitalPinToPort(dataPin));
-	clkPortPtr = portOutputRegister(digitalPinToPort(clockPin));
-	latchPortPtr = portOutputRegister(digitalPinToPort(latchPin));
+/**
+ * Hardware transport constructor. Sets the direction of the latch pin and allocates needed memory, the transport is
+ * started by begin().
+ * For shiftSPI data must be on pin 12 and clock on pin 13, for shiftUSART data must be on pin 0 and clock on pin 4 (Uno).
+ * If the USART is not available the SPI module is used.
+ * This should be used to declare a global object.
+ * @param latchPin Pin number attached to the latch pin
+ * @param numChips Number of boards in use
+ * @param mode Transport to use, shiftSPI or shiftUSART
+ */
+inputExtend::inputExtend(byte latchPin, byte numChips, shiftTransportMode mode)
+{
+	transport.select(mode);
+	this->numChips = numChips;
+	startup(latchPin);
+}
 
-	dataMask = digitalPinToBitMask(dataPin);
-	clkMask = digitalPinToBitMask(clockPin);
-	latchMask = digitalPinToBitMask(latchPin);
+/**
+ * Starts the SPI or USART transport, this should be called from setup(). A global object is constructed before
+ * init(), which would undo the USART set up, so the constructor does not touch the hardware.
+ * If begin() is not called the transport is started by the first read. Does nothing for the bit-bang transport.
+ */
+void inputExtend::begin()
+{
+	transport.begin();
+}
 
+/**
+ * Constructor for derived classes that supply the buffer and override readChain(), see inputExtendT.
+ * Only the latch pin is set up.
+ * @param latchPin Pin number attached to the latch pin
+ * @param numChips Number of boards in use
+ * @param buffer Input buffer, numChips bytes
+ */
+inputExtend::inputExtend(byte latchPin, byte numChips, byte *buffer)
+{
 	this->numChips = numChips;
+	boards = buffer;
+	memset(boards, 0, numChips);
+	startLatch(latchPin);
+}
 
+/*private function*/
+void inputExtend::startup(byte latchPin)
+{
 	boards = (byte*) calloc(numChips, 1);
 	if (boards == NULL)
 		while (1); //this is a (kludgy) catch-all for out of memory errors
 
-	pinMode(dataPin, INPUT);
+	startLatch(latchPin);
+}
+
+/*private function*/
+void inputExtend::startLatch(byte latchPin)
+{
+	latchPortPtr = portOutputRegister(digitalPinToPort(latchPin));
+	latchMask = digitalPinToBitMask(latchPin);
+
 	pinMode(latchPin, OUTPUT);
-	pinMode(clockPin, OUTPUT);
-	digitalWrite(dataPin, HIGH); //for the internal pull-up
 	digitalWrite(latchPin, HIGH);
-	digitalWrite(clockPin, LOW);
-	
+
+	scanBuffer = NULL;
+	events = NULL;
+	eventMask = 0;
+	eventHead = 0;
+	eventTail = 0;
+	eventsDropped = 0;
+
 	autoUpdate = true;
 }
 
@@ -112,22 +168,147 @@ boolean inputExtend::extendedRead(byte pinNumber)
  */
 void inputExtend::update()
 {
-	byte temp = 0;
+	callHook(hookBeforeUpdate);
+	shiftIn(boards);
+	callHook();
+}
 
-	*latchPortPtr |= latchMask; //set latch pin
+/**
+ * Switches to background scanning. After this, scan() should be called at a fixed rate from a timer interrupt
+ * and input changes are read with readEvent(). autoUpdate is turned off, so extendedRead(), byteRead() and getPtr()
+ * return the state from the most recent scan without communicating with the boards.
+ * @param queueSize Number of events the queue can hold (1-127). One slot of the ring is always empty, so the ring
+ * is queueSize + 1 rounded up to a power of two and may hold a few more.
+ * Does nothing if scanning has already been started, the buffers are in use by scan() and are kept.
+ */
+void inputExtend::startScan(byte queueSize)
+{
+	byte size = 2;
+
+	if (scanBuffer != NULL)
+	{
+		return;
+	}
+	while ((size <= queueSize) && (size < 128))
+	{
+		size <<= 1;
+	}
+
+	scanBuffer = (byte*) calloc(numChips, 1);
+	events = (inputEvent*) calloc(size, sizeof(inputEvent));
+	if ((scanBuffer == NULL) || (events == NULL))
+		while (1); //this is a (kludgy) catch-all for out of memory errors
+
+	eventMask = size - 1;
+	eventHead = 0;
+	eventTail = 0;
+	eventsDropped = 0;
+	autoUpdate = false;
+	shiftIn(boards); // starting snapshot, so the current state does not generate events
+}
 
+/**
+ * Background scan, this should be called at a fixed rate from a timer interrupt after startScan().
+ * The chain is read into a second buffer and compared against the input buffer, an event is queued for
+ * each input that changed and the input buffer is updated.
+ * The hook is not called from here, use the event queue instead.
+ */
+void inputExtend::scan()
+{
+	byte diff;
+	unsigned long now;
+
+	if (scanBuffer == NULL)
+	{
+		return;
+	}
+	shiftIn(scanBuffer);
+	now = millis();
 	for (byte i = 0; i < numChips; i++)
 	{
-		temp = 0;
+		diff = *(scanBuffer + i) ^ *(boards + i);
+		if (diff == 0)
+		{
+			continue;
+		}
 		for (byte j = 0; j < 8; j++)
 		{
-			temp = temp << 1; //shift data over one place to make room for the new bit
-			temp |= ((*dataPortPtr & dataMask) == dataMask); //read data pin to the LSB of temp
-			*clkPortPtr |= clkMask; //set clock pin
-			*clkPortPtr &= ~clkMask; //clear clock pin
+			if (bitRead(diff, j))
+			{
+				pushEvent((i << 3) + j, bitRead(*(scanBuffer + i), j), now);
+			}
 		}
-		*(boards + i) = temp; //move the new input byte to the output array (pointer)
+		*(boards + i) = *(scanBuffer + i);
+		raiseHook(hookOnChange); // dispatched from loop() by dispatchHooks()
 	}
+}
+
+/**
+ * @return Number of events waiting in the queue
+ */
+byte inputExtend::eventsAvailable()
+{
+	return (eventHead - eventTail) & eventMask;
+}
+
+/**
+ * Takes the oldest event from the queue. This should be called from loop(), not from an interrupt.
+ * @param event Pointer to the event to be filled in
+ * @return true if there was an event, false if the queue is empty
+ */
+boolean inputExtend::readEvent(inputEvent *event)
+{
+	byte tail = eventTail;
+	if ((events == NULL) || (tail == eventHead))
+	{
+		return false;
+	}
+	event->pin = events[tail].pin;
+	event->state = events[tail].state;
+	event->time = events[tail].time;
+	eventTail = (tail + 1) & eventMask; // release the slot only after it has been copied
+	return true;
+}
+
+/**
+ * @return Number of events lost because the queue was full (stops counting at 255)
+ */
+byte inputExtend::getEventsDropped()
+{
+	return eventsDropped;
+}
+
+/* Private Function */
+void inputExtend::pushEvent(byte pin, boolean state, unsigned long time)
+{
+	byte head = eventHead;
+	byte next = (head + 1) & eventMask;
+	if (next == eventTail)
+	{
+		if (eventsDropped != 0xFF)
+			eventsDropped++;
+		return;
+	}
+	events[head].pin = pin;
+	events[head].state = state;
+	events[head].time = time;
+	eventHead = next; // publish the event only after it has been written
+}
+
+/* Private Function */
+void inputExtend::shiftIn(byte *buffer)
+{
+	*latchPortPtr |= latchMask; //set latch pin
+	readChain(buffer);
 	*latchPortPtr &= ~latchMask; //clear latch pin
-	callHook();
+}
+
+/**
+ * Reads the chain into a buffer, buffer[0] is the first board. Derived classes can override this to use a
+ * different transport, the latch is handled by the caller.
+ * @param buffer Buffer to fill, numChips bytes
+ */
+void inputExtend::readChain(byte *buffer)
+{
+	transport.read(buffer, numChips);
 }
@@ -6,13 +6,18 @@
  * Rev 1 - Keegan Morrow - 10/2011
  * Rev 2 - Keegan Morrow - 6/2012 moved numChips and boards to protected  -  fixed a compile error with v22
  * Rev 3 - Keegan Morrow - 1/2014 added getSize(), added hook utility
+ * Rev 4 - 10/2026 added background scanning with an input change event queue
+ * Rev 5 - 10/2026 moved the data transfer to shiftTransport, added SPI and USART transports
+ * Rev 6 - 10/2026 moved hook to the shared hook library, update() calls the before update event, scan() raises the on change event
+ * Rev 7 - 10/2026 added inputExtendT, a template version with the pins and buffer size fixed at compile time
+ * Rev 8 - 10/2026 the SPI and USART transports are started by begin() instead of the constructor
  * 
  */
 
 #ifndef __inputExtend_h_
 #define __inputExtend_h_
 
-#define INPUTEXTEND 3 //revision number
+#define INPUTEXTEND 8 //revision number
 #if defined(ARDUINO) && ARDUINO >= 100
 #include "Arduino.h"
 #else
@@ -22,22 +27,40 @@
 
 #include <inttypes.h>
 
-#include "utility/hook.h"
+#include "../shiftTransport/shiftTransport.h"
+#include "../hook/hook.h"
+
+/**
+ * Input change event, generated by inputExtend::scan().
+ */
+struct inputEvent
+{
+	byte pin; ///< Input pin number (same numbering as extendedRead())
+	boolean state; ///< New state of the pin
+	unsigned long time; ///< millis() at the time of the scan
+};
 
 /**
  * Hardware interface class for the inputExtend board or other boards based on the 74HC165 chip.
  * @author Keegan Morrow
- * @version 3 31.01.2014
+ * @version 8 17.10.2026
  */
 class inputExtend: public hook
 {
 private:
-	byte dataMask;
-	byte clkMask;
 	byte latchMask;
-	volatile byte *dataPortPtr;
-	volatile byte *clkPortPtr;
 	volatile byte *latchPortPtr;
+	shiftTransport transport;
+	byte *scanBuffer;
+	volatile inputEvent *events;
+	byte eventMask;
+	volatile byte eventHead;
+	volatile byte eventTail;
+	volatile byte eventsDropped;
+	void shiftIn(byte *);
+	void pushEvent(byte, boolean, unsigned long);
+	void startup(byte);
+	void startLatch(byte);
 
 protected:
 	/**
@@ -49,18 +72,55 @@ protected:
 	 */
 	byte *boards;
 
+	inputExtend(byte, byte, byte *); // latch, boardCount, buffer (for derived classes that do their own shifting)
+	virtual void readChain(byte *); // reads the chain into a buffer, the latch is handled by the caller
+
 public:
 	/**
 	 * Determines if inputExtend::update() is called automatically. Default is true.
 	 */
 	boolean autoUpdate;
 	inputExtend(byte, byte, byte, byte); //data, clock, latch, boardCount
+	inputExtend(byte, byte, shiftTransportMode); //latch, boardCount, transport (shiftSPI or shiftUSART)
+	void begin(); // starts the SPI or USART transport, call from setup()
 	boolean extendedRead(byte);
 	byte* byteRead();
 	byte byteRead(byte);
 	void update();
 	byte* getPtr(); // pointer to the output buffer
 	byte getSize(); // returns the size of the output buffer
+	void startScan(byte); // event queue size, switches to background scanning
+	void scan(); // call from a timer interrupt
+	byte eventsAvailable();
+	boolean readEvent(inputEvent *);
+	byte getEventsDropped();
+};
+
+/**
+ * inputExtend with the pins and the number of boards fixed at compile time.
+ * The buffer is part of the object instead of being allocated, and the shift loop is unrolled with the port
+ * addresses and masks as constants (single instruction pin accesses on the ATmega168/328).
+ * e.g. inputExtendT<2, 3, 4, 2> inputs; // data, clock, latch, boardCount
+ * @author Keegan Morrow
+ * @version 8 17.10.2026
+ */
+template <byte DATA_PIN, byte CLOCK_PIN, byte LATCH_PIN, byte NUM_CHIPS>
+class inputExtendT: public inputExtend
+{
+private:
+	byte buffer[NUM_CHIPS];
+
+protected:
+	void readChain(byte *data)
+	{
+		shiftPins<DATA_PIN, CLOCK_PIN>::read(data, NUM_CHIPS);
+	}
+
+public:
+	inputExtendT() : inputExtend(LATCH_PIN, NUM_CHIPS, buffer)
+	{
+		shiftPins<DATA_PIN, CLOCK_PIN>::begin(true);
+	}
 };
 
 #endif //__inputExtend_h_
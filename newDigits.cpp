@@ -2,137 +2,88 @@
 #include "newDigits.h"
 
 //=====================================================
-//					Digit Link
+//					Digit Group
 //
-//			Data Structure and backend of
-//			the seven segment display.
+//			A view on one group of the frame buffer,
+//			the group is described by parent->groups[groupID].
 //=====================================================
 
 
-//constructor
-DigitLink::digitLink(){
+DigitGroup::DigitGroup(Digits* parent, uint8_t groupID){
+	this->parent = parent;
+	this->groupID = groupID;
+	autoUpdate = true;
+}
+
+
+void DigitGroup::turnOnBrightness(){
+	GroupDesc* desc = parent->getGroup(groupID);
+	for (uint8_t i = 0; i < desc->length; i++){
+		uint8_t address = desc->address + i;
+		parent->sendByte(address);
+		parent->sendByte(0x44);
+		parent->sendByte(0x9F);
+		parent->sendByte(((address + 0x44 + 0x9F) % 64) + 0xC0);
+	}
 }
 
+
 /*
  *
- *	FxN :: getPointerHead
- *		+returns the head pointer of the linked list.
+ *	FxN :: update
+ *	
+ *	@brief :: updates the seven segmented displays in this group.
+ *
  *
  */
-/*
-Segment* DigitLink::getPointerHead(){
-	return head;
-
+void DigitGroup::update(){
+	parent->sendGroup(groupID);
 }
-*/
+
 /*
  *
- *	FxN :: getHead
- *		+returns the head node of the linked list.
+ *	FxN :: getPtr
+ *		@returns -> [uint8_t*] the first digit of the group in the frame buffer.
  *
  */
-
-/*
-Segment DigitLink::getHead(){
-	return *head;
-}
-*/
-
-//=====================================================
-//					Digit Group
-//=====================================================
-
-
-DigitGroup::DigitGroup(Segment* node, uint8_t serialComm, uint8_t groupSize){
-	head = node;
-	mySerial.begin(250000);
-	mySerial.setTX(serialComm);
-	numDigits = groupSize;
-	autoUpdate = true;
+uint8_t* DigitGroup::getPtr(){
+	return parent->frame + parent->getGroup(groupID)->offset;
 }
 
-
-void DigitGroup::sendByte(uint8_t data){
-	mySerial.write(data);
-}
-
-void DigitGroup::turnOnBrightness(){
-	Segment* curr = head;
-	while (curr != NULL){
-		mySerial.write(curr->address);
-		mySerial.write(0x44);
-		mySerial.write(0x9F);
-		mySerial.write((curr->address + 0x44 + 0x9F) % 64) + 0XC0;
-		curr = curr->next;
-	}
+/*
+ *
+ *	FxN :: getNumDigits
+ *		@returns -> [uint8_t] number of digits in the group.
+ *
+ */
+uint8_t DigitGroup::getNumDigits(){
+	return parent->getGroup(groupID)->length;
 }
 
-
 /*
  *
- *	FxN :: update
- *	
- *	@brief :: updates the seven segmented displays.
- *
+ *	FxN :: getGroupID
+ *		@returns -> [uint8_t] index of the group descriptor, see Digits::setLayout.
  *
  */
-void DigitGroup::update(){
-	Segment* curr = head;
-	uint8_t mod = 64;
-	uint8_t eof = 0xC0;
-	uint8_t command = 0x43;
-	while (curr != NULL){
-		mySerial.write(curr->address);
-		mySerial.write(0x43); 
-		mySerial.write(curr->number + 0x80);
-		uint8_t checksum = ((curr->address + 0x43 + curr->number + 0x80) % 64) + 0xC0;
-		mySerial.write(checksum);
-		curr = curr->next;
-	}
-
-	/*
-	while (curr != NULL){
-		mySerial.write(curr->address);
-		mySerial.write(command); 
-		mySerial.write(curr->number + 0x80);
-		uint8_t checksum = ((curr->address + command + curr->number + 0x80) % mod) + eof;
-		mySerial.write(checksum);
-		curr = curr->next;
-	}
-	delay(1000);
-	Serial.println("calling lib update");
-	*/
+uint8_t DigitGroup::getGroupID(){
+	return groupID;
 }
-		/*
-		delay(500);
-		printData(groupA);
-		mySerial.write(groupA->head->address);
-		mySerial.write(0x43); 
-		mySerial.write(groupA->head->number + 0x80);
-		uint8_t checksum = ((groupA->head->address + 0x43 + groupA->head->number + 0x80) % 64) + 0xC0;
-		mySerial.write(checksum);
-		*/
 
 void DigitGroup::setDigit(uint8_t segment, uint8_t num, boolean state = false){
 
-	//iterate through linked list for node
-	Segment* curr = head;
-	if (segment > numDigits) { return; }
-	for (uint8_t i = 0; i < segment; i++){
-		curr = curr->next;
-	}
+	//index straight into the frame buffer
+	if (segment >= getNumDigits()) { return; }
+	getPtr()[segment] = num;
 
-	//set number
-	//curr->number = _digits_mapToSegs(num);
-	
 	//set decimal
 	
 	/*
 	if (state){
-		curr->number |= 0x01;
+		getPtr()[segment] |= 0x01;
 	}
 	else{
-		curr->number &= 0xFE;
+		getPtr()[segment] &= 0xFE;
 	}
 	*/
 
@@ -151,38 +102,12 @@ void DigitGroup::setDigit(uint8_t segment, uint8_t num, boolean state = false){
  *
  * 		@param number -> [uint32_t] inputted number
  *		@param numDig -> [uint8_t] number of digits
- *		@param fill   -> [uint8_t] fill (blank digit)
  *
  *	+brief :: addresses each place in a number to a segmented display else makes them blank.
  *
  */
 uint8_t DigitGroup::digitToSeg(uint32_t number, uint8_t numDig){
-
-	uint8_t blank = 0;
-	uint8_t digitCount = 0;
-	Segment* curr = head;
-	if (number == 0){
-		if (numDig > 1){
-			curr->number = blank;
-			digitCount = 1;
-		}
-	}
-	else{
-		for (uint8_t pos = 0; pos < numDig; pos++){
-			if (number != 0){
-				curr->number = number % 10;
-				number /= 10;
-				digitCount++;
-			}
-			else{
-				curr->number = blank;
-			}
-			if (curr->next != NULL){
-				curr = curr->next;
-			}
-		}
-	}
-	return digitCount;
+	return parent->digitToSegs(number, getPtr(), numDig);
 }
 
 
@@ -196,16 +121,10 @@ uint8_t DigitGroup::digitToSeg(uint32_t number, uint8_t numDig){
  *
  */
 uint8_t DigitGroup::segCalc(uint32_t number, uint8_t dpPos){
-	uint8_t digitsUsed = digitToSeg(number, numDigits);
-	Segment* curr = head;
+	uint8_t digitsUsed = digitToSeg(number, getNumDigits());
 	/*
-	if (dpPos != 0 && dpPos < numDigits){
-		uint8_t counter = 0;
-		while (counter != dpPos){
-			curr = curr->next;
-			counter++;
-		}
-		curr-> number |= 0x01; //decimal value
+	if (dpPos != 0 && dpPos < getNumDigits()){
+		getPtr()[dpPos] |= 0x01; //decimal value
 	}
 	*/
 	//return (digitsUsed >= dpPos) ? digitsUsed : dpPos;
@@ -235,11 +154,11 @@ boolean DigitGroup::segDispSign(int32_t number, uint8_t dpPos=0){
 	uint8_t dash = 1;//TODO this will change when we get some new proto in
 
 	if (number != uNumber){
-		if (signPos >= numDigits){
+		if (signPos >= getNumDigits()){
 			signOverflow = true;
 		}
 		else{
-			head->number |= dash; //TODO this will change.
+			getPtr()[0] |= dash; //TODO this will change.
 		}
 	}
 
@@ -297,53 +216,71 @@ void DigitGroup::chaseAnimation8(uint8_t pos){
 */
 //=====================================================
 //					 Digits
+//
+//			Frame buffer and backend of
+//			the seven segment display.
 //=====================================================
 
 static const uint8_t dash = 0x80;
 static const uint8_t blank = 0x0A;
 
 
-/* NOT USED STUFF */
-/*
- *
- * digits *digitsPtr;
- * uint8_t *digPtr;
- * uint8_t numDigits;
- *
- */
-
-uint8_t _digits_mapToSegs(uint8_t);
-
 /*
  *
  *	Constructor
- *		
+ *		@param serialPin -> [uint8_t] pin connected to the displays
+ *		@param size      -> [uint8_t] size of the frame buffer (total number of digits)
  *
  */
+Digits::Digits(uint8_t serialPin, uint8_t size){
+	startup(serialPin, size);
+}
+
 Digits::Digits(uint8_t serialPin){
-		mySerial.setTX(serialPin); //createSoftware Serial
-		autoUpdate = true;
-		//update();
+	startup(serialPin, DIGITS_DEFAULT_SIZE);
 }
 
 Digits::Digits(){
+	frame = NULL;
+	frameSize = 0;
+	numDigits = 0;
+	numGroups = 0;
+	autoUpdate = true;
+}
 
+/* Private Function */
+void Digits::startup(uint8_t serialPin, uint8_t size){
+	mySerial.begin(250000);
+	mySerial.setTX(serialPin); //createSoftware Serial
+	frame = (uint8_t*) calloc(size, sizeof(uint8_t));
+	if (frame == NULL)
+		while (1); //this is a (kludgy) catch-all for out of memory errors
+	frameSize = size;
+	numDigits = 0;
+	numGroups = 0;
+	autoUpdate = true;
 }
 
 /*
  *
  *	FxN :: getPtr
- *		@returns head -> [Segment*] the head pointer of the linked list.
+ *		@returns frame -> [uint8_t*] the frame buffer, one byte per digit.
  *
- * 	@brief :: Gets the head of the linked list.
+ */
+uint8_t* Digits::getPtr(){
+	return frame;
+}
+
+/*
  *
+ *	FxN :: getSize
+ *		@returns frameSize -> [uint8_t] size of the frame buffer
  *
  */
-/*
-Segment* Digits::getPtr(){
-	return head;
+uint8_t Digits::getSize(){
+	return frameSize;
 }
-*/
+
 /*
  *
  *	FxN :: sendByte
@@ -356,112 +293,131 @@ void Digits::sendByte(uint8_t data){
 	mySerial.write(data);
 }
 
+/*
+ *
+ *	FxN :: sendDigit
+ *		@param address -> [uint8_t] address of the 7-seg
+ *		@param number  -> [uint8_t] number to display
+ *
+ *	@brief :: sends one display packet {address, command, number, checksum}.
+ *
+ */
+void Digits::sendDigit(uint8_t address, uint8_t number){
+	uint8_t packet[4];
+	packet[0] = address;
+	packet[1] = 0x43;
+	packet[2] = number + 0x80;
+	packet[3] = ((address + 0x43 + number + 0x80) % 64) + 0xC0;
+	mySerial.write(packet, sizeof(packet));
+}
+
+/*
+ *
+ *	FxN :: sendGroup
+ *		@param groupID -> [uint8_t] group descriptor index
+ *
+ *	@brief :: streams one group of the frame buffer.
+ *
+ */
+void Digits::sendGroup(uint8_t groupID){
+	GroupDesc* desc = &groups[groupID];
+	uint8_t* data = frame + desc->offset;
+	for (uint8_t i = 0; i < desc->length; i++){
+		sendDigit(desc->address + i, data[i]);
+	}
+}
+
 /*
  *
  *	FxN :: addGroup
  *		@address :: address of the 7-seg <check DIP switch> +Should be contiguous per group.
 *		@groupSize :: size of the group
- *	Adds a group of 7segs to the linked list. 
+ *	Adds a group of 7segs to the end of the frame buffer. 
  *	
- *		+returns a pointer to the head of the group. 
+ *		+returns a pointer to the group, NULL if there is no room.
  *
  *
  */
 DigitGroup* Digits::addGroup(uint8_t address, uint8_t groupSize){
-	uint8_t static group = 0;
-	Segment* groupPointer = NULL;
-	static Segment* prevNode = NULL;
-	if (groupSize != 0){
-		for (uint8_t i = 0; i < groupSize; i++){
-			if (i == 0){
-				Segment* currNode = new Segment;
-				currNode->number = 0;
-				currNode->address = address;
-				currNode->groupID = group;
-				if (head == NULL){
-					head = currNode;
-				}
-				groupHead = currNode;
-				if (prevNode != NULL){
-					prevNode->next = currNode;
-				}
-				prevNode = currNode;
-			}
-			else{
-				Segment* currNode = new Segment;	
-				currNode->number = 0;
-				currNode->address = address;
-				currNode->groupID = group;
-				prevNode->next = currNode;
-				prevNode = currNode;
-				currNode->next = NULL;
-			}
-			address++;
-		}
-		group++;
-	}
-	DigitGroup* temp = new DigitGroup(groupHead, this->mySerial.getTxPin(), groupSize);
+	if (numGroups >= DIGITS_MAX_GROUPS) { return NULL; }
+	if ((numDigits + groupSize) > frameSize) { return NULL; }
+	groups[numGroups].offset = numDigits;
+	groups[numGroups].length = groupSize;
+	groups[numGroups].address = address;
+	numDigits += groupSize;
+	DigitGroup* temp = new DigitGroup(this, numGroups);
+	numGroups++;
 	return temp;
 }
 
 /*
  *
- *	FxN :: update
- *	
- *	@brief :: updates the seven segmented displays.
+ *	FxN :: setLayout
+ *		@groupID :: group descriptor index (DigitGroup::getGroupID)
+ *		@offset  :: first digit in the frame buffer
+ *		@length  :: number of digits
+ *		@address :: address of the first 7-seg
  *
+ *	Moves or resizes a group without reallocating anything, the
+ *	DigitGroup objects stay valid.
+ *
+ *		+returns false if the group does not exist or does not fit.
  *
  */
-void Digits::update(){
-	/*
-	sendByte(startBit);
-	Segment* curr = head;
-	while (curr != NULL){
-		sendByte(curr->address);
-		sendByte(curr->number);
-		curr = curr->next;
-	}
-	sendByte(stopBit);
-	*/
+boolean Digits::setLayout(uint8_t groupID, uint8_t offset, uint8_t length, uint8_t address){
+	if (groupID >= numGroups) { return false; }
+	if ((offset + length) > frameSize) { return false; }
+	groups[groupID].offset = offset;
+	groups[groupID].length = length;
+	groups[groupID].address = address;
+	if ((offset + length) > numDigits) { numDigits = offset + length; }
+	return true;
 }
 
-
 /*
  *
- *	FxN :: size
- *		@returns size -> number of bytes of the linked list
+ *	FxN :: getGroup
+ *		@returns -> [GroupDesc*] the group descriptor
+ *
+ */
+GroupDesc* Digits::getGroup(uint8_t groupID){
+	return &groups[groupID];
+}
+
+/*
  *
- * 	@brief :: gets the size (in bytes) of the total number of digits
+ *	FxN :: getNumGroups
+ *		@returns numGroups -> [uint8_t] number of groups added
  *
  */
+uint8_t Digits::getNumGroups(){
+	return numGroups;
+}
+
 /*
-uint32_t Digits::getSize(){
-	uint32_t size = 0;
-	Segment* curr = head;
-	while (curr != NULL){
-		size += sizeof(curr);
-		curr = curr->next;
+ *
+ *	FxN :: update
+ *	
+ *	@brief :: streams the frame buffer to every group.
+ *
+ *
+ */
+void Digits::update(){
+	for (uint8_t i = 0; i < numGroups; i++){
+		sendGroup(i);
 	}
-	return size;
 }
-*/
+
 
 /*
  *
  *	FxN :: getNumDigits
- *		@param group -> [Segment*] group of 1 or more digits
- *		@returns numDigits -> [uint8_t] unsigned byte of the number of digits in group
+ *		@returns numDigits -> [uint8_t] number of digits in use
  * 	
- *	@brief :: retreives the number of digits in a group.
+ *	@brief :: retreives the number of digits in the frame buffer that are in use.
  *
  */
 uint8_t Digits::getNumDigits(){
-	uint8_t numDigits = 0;
-	Segment* curr = head;
-	while (curr != NULL){
-		curr = curr->next;
-		numDigits++;
-	}
 	return numDigits;
 }
 
@@ -470,49 +426,39 @@ uint8_t Digits::getNumDigits(){
 /*
  *
  *	FxN :: copySection
- *		@groupA -> [Segment*] group of 1 or more digits (source)
- *		@groupB -> [Segment*] group of 1 or more digits (destination)
+ *		@groupA -> [DigitGroup*] group of 1 or more digits (source)
+ *		@groupB -> [DigitGroup*] group of 1 or more digits (destination)
  *
  * 	@brief :: This copies numbers from one group to another.
  *
  */
 /*
 void Digits::copySection(DigitGroup* groupA, DigitGroup* groupB){
-	if (groupA->head->groupID != groupB->head->groupID){
-		if (groupA->numDigits == groupB->numDigits){
-			Segment* currA = groupA->head;
-			Segment* currB = groupB->head;
-			uint8_t tempAID = currA->groupID;
-			uint8_t tempBID = currB->groupID;
-			while (tempAID == currA->groupID && tempBID == currB->groupID){
-				currB->number = currA->number;
-				currA = currA->next;
-				currB = currB->next;
-			}
+	if (groupA->getGroupID() != groupB->getGroupID()){
+		if (groupA->getNumDigits() == groupB->getNumDigits()){
+			memcpy(groupB->getPtr(), groupA->getPtr(), groupA->getNumDigits());
 		}
 	}
 }
 */
 
-void Digits::setDigit(Segment* group, uint8_t segment, uint8_t num, boolean state){
+void Digits::setDigit(uint8_t segment, uint8_t num, boolean state){
 
-	//iterate through linked list for node
-	Segment* curr = group;
-	if (segment > getNumDigits()) { return; }
-	for (uint8_t i = 0; i < segment; i++){
-		curr = curr->next;
-	}
+	//index straight into the frame buffer
+	if (segment >= numDigits) { return; }
 
 	//set number
-	curr->number = _digits_mapToSegs(num);
+	frame[segment] = num;
 	
 	//set decimal
+	/*
 	if (state){
-		curr->number |= 0x01;
+		frame[segment] |= 0x01;
 	}
 	else{
-		curr->number &= 0xFE;
+		frame[segment] &= 0xFE;
 	}
+	*/
 
 	//update
 	if (autoUpdate) { update(); }
@@ -525,37 +471,36 @@ void Digits::setDigit(Segment* group, uint8_t segment, uint8_t num, boolean stat
 /*
  *
  *
- *	FxN :: digitToSeg
+ *	FxN :: digitToSegs
  *
  * 		@param number -> [uint32_t] inputted number
+ *		@param data   -> [uint8_t*] first digit to write
  *		@param numDig -> [uint8_t] number of digits
- *		@param fill   -> [uint8_t] fill (blank digit)
  *
  *	+brief :: addresses each place in a number to a segmented display else makes them blank.
  *
  */
-uint8_t Digits::digitToSeg(uint32_t number, uint8_t numDig){
+uint8_t Digits::digitToSegs(uint32_t number, uint8_t* data, uint8_t numDig){
 
 	uint8_t blank = 0;
 	uint8_t digitCount = 0;
-	Segment* curr = head;
+	if (numDig == 0) { return 0; }
 	if (number == 0){
 		if (numDig > 1){
-			curr->number = blank;
+			data[0] = blank;
 			digitCount = 1;
 		}
 	}
 	else{
 		for (uint8_t pos = 0; pos < numDig; pos++){
 			if (number != 0){
-				curr->number = number % 10;
+				data[pos] = number % 10;
 				number /= 10;
 				digitCount++;
 			}
 			else{
-				curr->number = blank;//TODO blank digit!!
+				data[pos] = blank;//TODO blank digit!!
 			}
-			curr = curr->next;
 		}
 	}
 	return digitCount;
@@ -572,14 +517,9 @@ uint8_t Digits::digitToSeg(uint32_t number, uint8_t numDig){
  *
  */
 uint8_t Digits::segCalc(uint32_t number, uint8_t dpPos){
-	uint8_t digitsUsed = digitToSeg(number, getNumDigits());
-	Segment* curr = head;
-	if (dpPos != 0 && dpPos < getNumDigits()){
-		uint8_t counter = 0;
-		while (counter != dpPos){
-			curr = curr->next;
-		}
-		curr-> number |= 0x01; //decimal value
+	uint8_t digitsUsed = digitToSegs(number, frame, numDigits);
+	if (dpPos != 0 && dpPos < numDigits){
+		frame[dpPos] |= 0x01; //decimal value
 	}
 	return (digitsUsed >= dpPos) ? digitsUsed : dpPos;
 }
@@ -616,11 +556,11 @@ boolean Digits::segDispSign(int32_t number, uint8_t dpPos=0){
 	uint8_t signPos = segCalc(uNumber,dpPos);
 	
 	if (number != uNumber){
-		if (signPos >= getNumDigits()){
+		if (signPos >= numDigits){
 			signOverflow = true;
 		}
 		else{
-			head->number |= dash; 
+			frame[0] |= dash; 
 		}
 	}
 	// Update &| return
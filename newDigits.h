@@ -1,7 +1,7 @@
-#ifndef __digits_h_
-#define __digits_h_
+#ifndef __newDigits_h_
+#define __newDigits_h_
 
-#define DIGITS 7 //revision number
+#define NEWDIGITS 8 //revision number
 #if defined(ARDUINO) && ARDUINO >= 100
 #include "Arduino.h"
 #else
@@ -13,81 +13,61 @@
 //static uint8_t _digits_mapToSegs(uint8_t);
 //static uint8_t _digits_iToSegs(uint32_t, uint8_t *, uint8_t, uint8_t);
 
+#define DIGITS_MAX_GROUPS 8 //number of group descriptors per Digits object
+#define DIGITS_DEFAULT_SIZE 32 //default frame buffer size (total number of digits)
+
 //forward declaration;
-struct segment;
-typedef segment Segment;
+class Digits;
 class DigitGroup;
 
 
 /*
- *	Struct display
- *		Collections object for each individual segmented display
- *		contains : {number,next, prev}
+ *	Struct groupDesc
+ *		Describes where a group lives in the frame buffer
+ *		contains : {offset, length, address}
+ *		digit i of the group is frame[offset + i] and has the address (address + i)
  */
-struct segment{
-	uint8_t number; //0b000;
-	uint8_t address; //0-255;
-	uint8_t groupID;
-	segment* next;
+struct groupDesc{
+	uint8_t offset; //first digit in the frame buffer
+	uint8_t length; //number of digits
+	uint8_t address; //address of the first 7-seg <check DIP switch>
 };
-
-
-/**
- *
- * Class digitLink
- *
- * 	This class is responsible for managing the data structure that
- * 	goes along with manipulating the segmented displays.
- *
- *
- */
-class DigitLink{
-	protected:
-		//Segment addLink(uint8_t, uint8_t, Segment, Segment);
-		Segment* head = NULL; //this is the first segment
-		Segment* groupHead = NULL;
-	public:
-		digitLink();
-		//Segment* addGroup(uint8_t, uint8_t);
-		//Segment* getPointerHead();
-		//Segment getHead();
-		//Segment getTail();
-};
-
+typedef groupDesc GroupDesc;
 
 
 /*
  *
  *
- *	Class DigitGroup	
- *		handles communication protocols to get the segmented
- *		displays to change number and/or brightness.
+ *	Class DigitGroup
+ *		A view on one group of the Digits frame buffer,
+ *		writes go straight to the frame buffer.
  *
  */
 class DigitGroup{
 	private:
-		void sendByte(uint8_t);
-		SegSerial mySerial;
-		//uint8_t numDigits;
-		//Segment* head;
+		Digits* parent;
+		uint8_t groupID;
 		uint8_t segCalc(uint32_t, uint8_t);
 		uint8_t digitToSeg(uint32_t, uint8_t);
-	public:		
-		uint8_t numDigits;
-		Segment* head;
-		DigitGroup(Segment*, uint8_t, uint8_t); 
-		
-		boolean autoUpdate; 
+	public:
+		DigitGroup(Digits*, uint8_t);
+
+		boolean autoUpdate;
 		void update();
 		void turnOnBrightness();
-		
+
 		//set && copy
-		void setDigit(uint8_t, uint8_t, boolean); 
-		
+		void setDigit(uint8_t, uint8_t, boolean);
+
 		//displays a number on the seven segment display (group's digits);
 		void segDisp(uint32_t, uint8_t);
 		//boolean segDispSign(int32_t, uint8_t);
 
+		//meta data about the group
+		uint8_t* getPtr();
+		uint8_t getNumDigits();
+		uint8_t getGroupID();
+
 		//chase animation on the seven segment display (group's digits);
 		//void chaseAnimation();
 		//void chaseAnimation(uint8_t);
@@ -97,40 +77,54 @@ class DigitGroup{
 
 /*
  *
- *	Class digits	
- *		handles communication protocols to get the segmented
+ *	Class digits
+ *		Owns the frame buffer (one byte per digit) and the group
+ *		descriptors, handles communication protocols to get the segmented
  *		displays to change number and/or brightness.
  *
  */
-class Digits : public DigitLink{
+class Digits{
+	friend class DigitGroup;
 	private:
 		void sendByte(uint8_t);
+		void sendDigit(uint8_t, uint8_t);
+		void sendGroup(uint8_t);
 		SegSerial mySerial;
+		uint8_t* frame; //frame buffer, one byte per digit
+		uint8_t frameSize; //size of the frame buffer
+		uint8_t numDigits; //digits in use
+		GroupDesc groups[DIGITS_MAX_GROUPS];
+		uint8_t numGroups;
+		void startup(uint8_t, uint8_t);
 		uint8_t segCalc(uint32_t, uint8_t);
-		uint8_t digitToSeg(uint32_t, uint8_t);
+		uint8_t digitToSegs(uint32_t, uint8_t*, uint8_t);
 	public:
 		//constructor
 		Digits();
-		Digits(uint8_t); 
-		
+		Digits(uint8_t);
+		Digits(uint8_t, uint8_t); //serial pin, frame buffer size
+
 		//updates
-		boolean autoUpdate; 
+		boolean autoUpdate;
 		void update();
-	
+
 		//adding a group
 		DigitGroup* addGroup(uint8_t, uint8_t);
+		boolean setLayout(uint8_t, uint8_t, uint8_t, uint8_t); //groupID, offset, length, address
+		GroupDesc* getGroup(uint8_t);
 	//	void copySection(DigitGroup*, DigitGroup*);
-		void setDigit(Segment*, uint8_t, uint8_t, boolean); 
-		
+		void setDigit(uint8_t, uint8_t, boolean);
+
 		//meta data about the segment displays
-		Segment* getPtr(); 
-	//	uint32_t getSize(); 
+		uint8_t* getPtr();
+		uint8_t getSize();
 		uint8_t getNumDigits();
-		
+		uint8_t getNumGroups();
+
 		//display a number on the seven segment display.
 		void segDisp(uint32_t, uint8_t);
 		boolean segDispSign(int32_t, uint8_t);
-		
+
 		//chase animation on the seven segment display (all digits);
 	//	void chaseAnimation();
 	//	void chaseAnimation(uint8_t);
@@ -138,4 +132,4 @@ class Digits : public DigitLink{
 	//	void chaseAnimation8(uint8_t);
 };
 
-#endif //__digits_h_
+#endif //__newDigits_h_
@@ -8,6 +8,9 @@
  * Rev 3 - KM 6/2012 - Added 'boolean getState(pin)'
  * Rev 4 - Keegan Morrow - 1/2014 added getSize(), added hook utility
  * Rev 5 - KM 2/2015 - added code to allow use of the hardware SPI module for very fast updates
+ * Rev 6 - 10/2026 - added delta update mode (skips the transfer if nothing changed), frames and transfer counters
+ * Rev 7 - 10/2026 - moved hook to the shared hook library, added the before update and on change (delta update mode) events
+ * Rev 8 - 10/2026 - added outputExtendT, a template version with the pins and buffer size fixed at compile time
  *
  */
 
@@ -52,9 +55,35 @@ void outputExtend::startup()
 	if (boards == NULL)
 		while (1); //this is a (kludgy) catch-all for out of memory errors
 	autoUpdate = true;
+	frameOpen = false;
+	lastSent = NULL;
+	clearCounters();
 	update();
 }
 
+/**
+ * Constructor for derived classes that supply the buffer and override shiftOut(), see outputExtendT.
+ * Only the latch pin is set up, update() is not called.
+ * @param latchPin Pin number attached to the latch pin
+ * @param numChips Number of boards in use
+ * @param buffer Output buffer, numChips bytes
+ */
+outputExtend::outputExtend(byte latchPin, byte numChips, byte *buffer)
+{
+	this->numChips = numChips;
+	hwSPI = false;
+	latchPortPtr = portOutputRegister(digitalPinToPort(latchPin));
+	latchMask = digitalPinToBitMask(latchPin);
+	pinMode(latchPin, OUTPUT);
+	digitalWrite(latchPin, LOW);
+	boards = buffer;
+	memset(boards, 0, numChips);
+	autoUpdate = true;
+	frameOpen = false;
+	lastSent = NULL;
+	clearCounters();
+}
+
 /**
  * Bitbanging mode constructor. Sets the direction of the io pins and allocates needed memory.
  * This should be used to declare a global object.
@@ -98,7 +127,7 @@ void outputExtend::extendedWrite(byte pinNumber, boolean state)
 	byte byteNumber = pinNumber >> 3;
 	byte bitNumber = pinNumber - (byteNumber << 3);
 	bitWrite(*(boards + byteNumber), bitNumber, state);
-	if (autoUpdate)
+	if (autoUpdate && !frameOpen)
 	{
 		update();
 	}
@@ -119,7 +148,7 @@ void outputExtend::byteWrite(byte *bytePtr, byte offset, byte count)
 	}
 	count = (count + offset) > numChips ? numChips - offset : count;
 	memcpy(&boards[offset], bytePtr, (size_t) count);
-	if (autoUpdate)
+	if (autoUpdate && !frameOpen)
 	{
 		update();
 	}
@@ -137,7 +166,7 @@ void outputExtend::byteWrite(byte board, byte data)
 		return;
 	}
 	*(boards + board) = data;
-	if (autoUpdate)
+	if (autoUpdate && !frameOpen)
 	{
 		update();
 	}
@@ -179,8 +208,124 @@ boolean outputExtend::getState(byte pinNumber)
  * This function is normally called automatically  when needed.
  * In a situation where very fast multi-board writes or synchronized outputs are needed, autoUpdate
  * can be set to false and this can be called manually.
+ * If delta update mode is on, nothing is sent if the buffer is the same as the last update.
  */
 void outputExtend::update()
+{
+	updatesRequested++;
+	if (lastSent != NULL)
+	{
+		if (memcmp(lastSent, boards, numChips) == 0)
+		{
+			return;
+		}
+		memcpy(lastSent, boards, numChips);
+		callHook(hookOnChange);
+	}
+	transfer();
+}
+
+/**
+ * Turns delta update mode on or off. Default is off.
+ * In delta update mode a copy of the last data sent is kept (one byte per board) and update() skips the
+ * transfer when the buffer has not changed. Changes made through getPtr() are detected as well.
+ * A 74HC595 chain can only be updated as a whole, so when any board has changed the full chain is sent.
+ * Turning the mode on sends the current buffer so the copy matches the outputs.
+ * @param state true to turn delta update mode on
+ */
+void outputExtend::setDeltaUpdate(boolean state)
+{
+	if (state)
+	{
+		if (lastSent == NULL)
+		{
+			lastSent = (byte *) malloc(numChips);
+			if (lastSent == NULL)
+				while (1); //this is a (kludgy) catch-all for out of memory errors
+		}
+		memcpy(lastSent, boards, numChips);
+		transfer();
+	}
+	else if (lastSent != NULL)
+	{
+		free(lastSent);
+		lastSent = NULL;
+	}
+}
+
+/**
+ * Starts a frame. Until endFrame() is called, writes only change the output buffer and automatic updates are held off.
+ * This allows a group of writes to be sent in one update while autoUpdate is left on.
+ */
+void outputExtend::beginFrame()
+{
+	frameOpen = true;
+}
+
+/**
+ * Ends a frame started by beginFrame() and, if autoUpdate is on, sends all of the writes made during the frame.
+ */
+void outputExtend::endFrame()
+{
+	frameOpen = false;
+	if (autoUpdate)
+	{
+		update();
+	}
+}
+
+/**
+ * @return Number of calls to update() since the counters were cleared
+ */
+unsigned long outputExtend::getUpdatesRequested()
+{
+	return updatesRequested;
+}
+
+/**
+ * @return Number of times the chain was shifted out and latched since the counters were cleared
+ */
+unsigned long outputExtend::getUpdatesPerformed()
+{
+	return updatesPerformed;
+}
+
+/**
+ * @return Number of bytes shifted out since the counters were cleared
+ */
+unsigned long outputExtend::getBytesShifted()
+{
+	return bytesShifted;
+}
+
+/**
+ * Resets the transfer counters to zero.
+ */
+void outputExtend::clearCounters()
+{
+	updatesRequested = 0;
+	updatesPerformed = 0;
+	bytesShifted = 0;
+}
+
+/*private function*/
+void outputExtend::transfer()
+{
+	callHook(hookBeforeUpdate);
+	shiftOut();
+	*latchPortPtr |= latchMask;
+	*latchPortPtr &= ~latchMask;
+
+	updatesPerformed++;
+	bytesShifted += numChips;
+	callHook();
+}
+
+/**
+ * Shifts the output buffer into the chain, last board first. Derived classes can override this to use a
+ * different transport, the latch is pulsed by the caller.
+ */
+void outputExtend::shiftOut()
 {
 	if (hwSPI)
 	{
@@ -196,10 +341,6 @@ void outputExtend::update()
 			updateBB(*(boards + (i - 1)));
 		}
 	}
-	*latchPortPtr |= latchMask;
-	*latchPortPtr &= ~latchMask;
-
-	callHook();
 }
 
 /*private function*/
@@ -8,13 +8,16 @@
  * Rev 3 - KM 6/2012 - Added 'boolean getState(pin)'
  * Rev 4 - Keegan Morrow - 1/2014 added getSize(), added hook utility
  * Rev 5 - KM 2/2015 - added code to allow use of the hardware SPI module for very fast updates
+ * Rev 6 - 10/2026 - added delta update mode (skips the transfer if nothing changed), frames and transfer counters
+ * Rev 7 - 10/2026 - moved hook to the shared hook library, added the before update and on change (delta update mode) events
+ * Rev 8 - 10/2026 - added outputExtendT, a template version with the pins and buffer size fixed at compile time
  *
  */
 
 #ifndef __outputExtend_h__
 #define __outputExtend_h__
 
-#define OUTPUTEXTEND 5 //revision number
+#define OUTPUTEXTEND 8 //revision number
 #if defined(ARDUINO) && ARDUINO >= 100
 #include "Arduino.h"
 #else
@@ -23,13 +26,14 @@
 #endif
 
 #include "../SPI/SPI.h"
+#include "../shiftTransport/shiftTransport.h"
 #include <inttypes.h>
 
-#include "utility/hook.h"
+#include "../hook/hook.h"
 /**
  * Hardware interface class for the outputExtend board or other 74HC595 based boards.
  * @author Keegan Morrow
- * @version 5 2015.02.06
+ * @version 8 2026.10.17
  */
 class outputExtend: public hook
 {
@@ -45,7 +49,10 @@ private:
 	void startupBB(byte, byte, byte);
 	void updateSPI(byte);
 	void updateBB(byte);
+	void transfer();
 	boolean hwSPI;
+	boolean frameOpen;
+	byte *lastSent;
 
 protected:
 	/**
@@ -57,6 +64,16 @@ protected:
 	 */
 	byte numChips;
 
+	/**
+	 * Transfer counters, see getUpdatesRequested(), getUpdatesPerformed() and getBytesShifted().
+	 */
+	unsigned long updatesRequested;
+	unsigned long updatesPerformed;
+	unsigned long bytesShifted;
+
+	outputExtend(byte, byte, byte *); // latch, numBoards, buffer (for derived classes that do their own shifting)
+	virtual void shiftOut(); // shifts the output buffer into the chain, the latch is pulsed by the caller
+
 public:
 	/**
 	 * Determines if inputExtend::update() is called automatically. Default is true.
@@ -71,6 +88,41 @@ public:
 	boolean getState(byte); // outNumber
 	byte *getPtr(); // pointer to the output buffer
 	byte getSize(); // returns the size of the output buffer
+	void setDeltaUpdate(boolean); // only shift the chain out when the buffer has changed
+	void beginFrame(); // hold off automatic updates
+	void endFrame(); // release automatic updates and send the frame
+	unsigned long getUpdatesRequested(); // number of calls to update()
+	unsigned long getUpdatesPerformed(); // number of times the chain was shifted out
+	unsigned long getBytesShifted(); // number of bytes shifted out
+	void clearCounters();
+};
+
+/**
+ * outputExtend with the pins and the number of boards fixed at compile time.
+ * The buffer is part of the object instead of being allocated, and the shift loop is unrolled with the port
+ * addresses and masks as constants (single instruction pin writes on the ATmega168/328).
+ * e.g. outputExtendT<2, 3, 4, 2> outputs; // data, clock, latch, numBoards
+ * @author Keegan Morrow
+ * @version 8 2026.10.17
+ */
+template <byte DATA_PIN, byte CLOCK_PIN, byte LATCH_PIN, byte NUM_CHIPS>
+class outputExtendT: public outputExtend
+{
+private:
+	byte buffer[NUM_CHIPS];
+
+protected:
+	void shiftOut()
+	{
+		shiftPins<DATA_PIN, CLOCK_PIN>::writeReverse(buffer, NUM_CHIPS);
+	}
+
+public:
+	outputExtendT() : outputExtend(LATCH_PIN, NUM_CHIPS, buffer)
+	{
+		shiftPins<DATA_PIN, CLOCK_PIN>::begin(false);
+		update();
+	}
 };
 
 #endif //__outputExtend_h__
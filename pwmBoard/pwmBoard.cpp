@@ -45,7 +45,11 @@ pwmBoard::pwmBoard(uint8_t baseAddress)
 uint8_t pwmBoard::alloc(uint8_t n)
 {
 	levels = (uint8_t *) calloc(n, 8);
-	return (levels != NULL) ? n : 0;
+	sentLevels = (uint8_t *) calloc(n, 8);
+	sentValid = false;
+	allCall = false;
+	clearCounters();
+	return ((levels != NULL) && (sentLevels != NULL)) ? n : 0;
 }
 
 /* private function */
@@ -75,7 +79,7 @@ void pwmBoard::start()
 		Wire.WIRE_WRITE_FUNCTION(0b10101010); // in register 0x0d (LEDOUT1) set all to mode 10 (output using PWMx registers)
 		Wire.endTransmission();
 	}
-
+	sentValid = false; // the next update() sends every channel
 }
 
 /**
@@ -88,17 +92,148 @@ void pwmBoard::send()
 
 /**
  * @brief Send the current output buffer to all boards.
+ * @details Only the channels that changed since the last update are sent, using the auto-increment of the
+ * PWM registers so each board is at most one transaction. Boards that have not changed are skipped.
+ * If ALLCALL is enabled (see setAllCall()) and every board has the same levels, one broadcast is sent instead.
  */
 void pwmBoard::update()
 {
-	uint8_t *levPtr = levels;
+	uint8_t first;
+	uint8_t last;
+	uint8_t rangeFirst = 8;
+	uint8_t rangeLast = 0;
+	boolean identical = allCall && (numBoards > 1);
+
+	for (uint8_t i = 1; identical && (i < numBoards); i++)
+	{
+		identical = (memcmp(levels, levels + (i * 8), 8) == 0);
+	}
+
 	for (uint8_t i = 0; i < numBoards; i++)
 	{
-		Wire.beginTransmission(getAddr(baseAddress + i));
-		Wire.WIRE_WRITE_FUNCTION(0b10100010);
-		Wire.WIRE_WRITE_FUNCTION(levPtr, 8);
-		Wire.endTransmission();
-		levPtr += 8;
+		if (!changedRange(i, &first, &last))
+		{
+			continue;
+		}
+		if (identical)
+		{
+			rangeFirst = min(rangeFirst, first);
+			rangeLast = max(rangeLast, last);
+		}
+		else
+		{
+			markSent(i, sendRange(getAddr(baseAddress + i), levels + (i * 8), first, last) == 0);
+		}
+	}
+	if (identical && (rangeFirst <= rangeLast))
+	{
+		boolean ok = (sendRange(PWMBOARD_ALLCALL, levels, rangeFirst, rangeLast) == 0);
+		for (uint8_t i = 0; i < numBoards; i++)
+		{
+			markSent(i, ok);
+		}
+	}
+	sentValid = true;
+}
+
+/**
+ * @brief Mark every channel as changed, so the next update() sends all of them.
+ * @details update() only sends the channels that differ from what was last acknowledged, so a board that lost
+ * its registers (reset, power cycled or written by another master) is not corrected until its levels change.
+ * Call this after such an event, then update(). start() does this itself.
+ */
+void pwmBoard::refresh()
+{
+	sentValid = false;
+}
+
+/**
+ * @brief Allow update() to use the PCA9634 ALLCALL address when every board has the same levels.
+ * @details Every PCA9634 on the bus responds to ALLCALL, so only enable this when all of them belong to this object.
+ * 
+ * @param state true to allow broadcasts, default is false
+ */
+void pwmBoard::setAllCall(boolean state)
+{
+	allCall = state;
+}
+
+/**
+ * @brief Get the number of i2c transactions sent by update() that were acknowledged, since the counters were cleared.
+ * @return Number of transactions
+ */
+unsigned long pwmBoard::getTransactions()
+{
+	return transactions;
+}
+
+/**
+ * @brief Get the number of bytes in acknowledged transactions sent by update() since the counters were cleared,
+ * not including the address byte.
+ * @return Number of bytes
+ */
+unsigned long pwmBoard::getBytesSent()
+{
+	return bytesSent;
+}
+
+/**
+ * @brief Reset the transfer counters to zero.
+ */
+void pwmBoard::clearCounters()
+{
+	transactions = 0;
+	bytesSent = 0;
+}
+
+/* private function */
+boolean pwmBoard::changedRange(uint8_t board, uint8_t *first, uint8_t *last)
+{
+	uint8_t *levPtr = levels + (board * 8);
+	uint8_t *sentPtr = sentLevels + (board * 8);
+	if (!sentValid)
+	{
+		*first = 0;
+		*last = 7;
+		return true;
+	}
+	*first = 0;
+	while ((*first < 8) && (levPtr[*first] == sentPtr[*first]))
+		(*first)++;
+	if (*first == 8)
+		return false;
+	*last = 7;
+	while (levPtr[*last] == sentPtr[*last])
+		(*last)--;
+	return true;
+}
+
+/* private function, returns the Wire.endTransmission() status */
+uint8_t pwmBoard::sendRange(uint8_t addr, uint8_t *levPtr, uint8_t first, uint8_t last)
+{
+	uint8_t status;
+	uint8_t count = (last - first) + 1;
+	Wire.beginTransmission(addr);
+	Wire.WIRE_WRITE_FUNCTION(0b10100010 + first); // auto increment over the PWMx registers, starting at PWM[first]
+	Wire.WIRE_WRITE_FUNCTION(levPtr + first, count);
+	status = Wire.endTransmission();
+	if (status == 0)
+	{
+		transactions++;
+		bytesSent += count + 1;
+	}
+	return status;
+}
+
+/* private function */
+void pwmBoard::markSent(uint8_t board, boolean ok)
+{
+	uint8_t *levPtr = levels + (board * 8);
+	uint8_t *sentPtr = sentLevels + (board * 8);
+	for (uint8_t i = 0; i < 8; i++)
+	{
+		// after a failed send every channel is made to differ, so the whole board is sent again next time
+		sentPtr[i] = ok ? levPtr[i] : ~levPtr[i];
 	}
 }
 
@@ -7,7 +7,8 @@
 #ifndef __pwmBoard_h_
 #define __pwmBoard_h_
 
-#define PWMBOARD 4 //revision number
+#define PWMBOARD 6 //revision number
+#define PWMBOARD_ALLCALL 0x70 // PCA9634 power-up ALLCALL address (0xE0 in 8 bit form)
 #if defined(ARDUINO) && ARDUINO >= 100
 #include "Arduino.h"
 #else
@@ -20,7 +21,7 @@
 /**
  * @brief Hardware interface class for the pwmBoard PCA9634 based PWM dimmer board.
  * @author Keegan Morrow
- * @version 4
+ * @version 6
  * @details Revision history:
  * 
  * r2 - 12/2011 - KM - update for compatibility with arduino 100
@@ -29,6 +30,10 @@
  * 
  * r4 - 8/2012 - KM - added update() and autoUpdate for similarity with other libraries
  * 
+ * r5 - 10/2026 - update() only sends the changed channel range of each board, added ALLCALL broadcast and transfer counters
+ * 
+ * r6 - 10/2026 - added refresh() to resend every channel
+ * 
  * 
  */
 class pwmBoard
@@ -39,6 +44,14 @@ private:
 	uint8_t alloc(uint8_t);
 	uint8_t getAddr(uint8_t);
 	uint8_t *levels;
+	uint8_t *sentLevels;
+	boolean sentValid;
+	boolean allCall;
+	unsigned long transactions;
+	unsigned long bytesSent;
+	boolean changedRange(uint8_t, uint8_t *, uint8_t *);
+	uint8_t sendRange(uint8_t, uint8_t *, uint8_t, uint8_t);
+	void markSent(uint8_t, boolean);
 
 public:
 	/**
@@ -55,6 +68,11 @@ public:
 	byte* getPtr(); //use this function to access the levels array like this: className.getPtr()[channel] = level;
 	void send(); // only here for backwards compatibility, use update()
 	void update();
+	void refresh(); // the next update() sends every channel, for boards that were reset or power cycled
+	void setAllCall(boolean); // allow update() to broadcast identical frames to the ALLCALL address
+	unsigned long getTransactions(); // number of i2c transactions sent by update()
+	unsigned long getBytesSent(); // number of bytes sent by update(), not including the address
+	void clearCounters();
 };
 
 #endif //__pwmBoard_h_
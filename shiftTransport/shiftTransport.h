@@ -0,0 +1,515 @@
+/*
+ * shiftTransport.h
+ * Byte transport for chains of shift registers (74HC595, 74HC165 and similar)
+ * Shared by the shift register libraries so each one can use bit-banging, the hardware SPI module
+ * or USART0 in master SPI mode.
+ *
+ * Rev 1 - 10/2026
+ * Rev 2 - 10/2026 - Added shiftPin, shiftPins and shiftPinsDuplex, bit-bang kernels with the pins fixed at compile time
+ * Rev 3 - 10/2026 - The SPI and USART registers are set up by begin() instead of from the constructors of the libraries
+ *
+ */
+
+#ifndef __shiftTransport_h_
+#define __shiftTransport_h_
+
+#define SHIFTTRANSPORT 3 //revision number
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#include "pins_arduino.h"
+#endif
+
+#include "../SPI/SPI.h"
+#include <inttypes.h>
+
+#if defined(UMSEL01)
+#define SHIFTTRANSPORT_HAS_USART
+#ifndef SHIFTTRANSPORT_XCK_PIN
+#define SHIFTTRANSPORT_XCK_PIN 4 // XCK0 on the ATmega328 (Uno), TX (pin 1) is data out, RX (pin 0) is data in
+#endif
+#endif
+
+/**
+ * Transport types for shiftTransport.
+ */
+enum shiftTransportMode
+{
+	shiftBitBang = 0, // any two pins
+	shiftSPI = 1, // hardware SPI module, data out on MOSI, data in on MISO, clock on SCK
+	shiftUSART = 2 // USART0 in master SPI mode, Serial can not be used at the same time
+};
+
+/**
+ * Moves bytes in and out of a shift register chain, MSB first, data is valid on the rising clock edge.
+ * Latching is left to the library using the transport.
+ * The libraries are normally global objects, and their constructors run before init(), which clears the USART
+ * registers. So a library constructor only calls select() for a hardware transport, and the registers are set
+ * up by begin() from setup(), or by the first transfer if begin() was not called.
+ * @version 3 2026.10.17
+ */
+class shiftTransport
+{
+private:
+	shiftTransportMode mode;
+	boolean started;
+	byte dataMask;
+	byte clkMask;
+	volatile byte *dataPortPtr;
+	volatile byte *clkPortPtr;
+
+	/*
+	 * Bit-bang kernels, unrolled so each bit is a constant mask test instead of a counted shift loop.
+	 */
+	inline void clockPulse()
+	{
+		*clkPortPtr |= clkMask;
+		*clkPortPtr &= ~clkMask;
+	}
+	inline void writeBit(byte data, byte bit)
+	{
+		if (data & bit)
+		{
+			*dataPortPtr |= dataMask;
+		}
+		else
+		{
+			*dataPortPtr &= ~dataMask;
+		}
+		clockPulse();
+	}
+	inline void readBit(byte &data, byte bit)
+	{
+		if (*dataPortPtr & dataMask)
+		{
+			data |= bit;
+		}
+		clockPulse();
+	}
+	void writeBB(byte data)
+	{
+		writeBit(data, 0x80);
+		writeBit(data, 0x40);
+		writeBit(data, 0x20);
+		writeBit(data, 0x10);
+		writeBit(data, 0x08);
+		writeBit(data, 0x04);
+		writeBit(data, 0x02);
+		writeBit(data, 0x01);
+	}
+	byte readBB()
+	{
+		byte data = 0;
+		readBit(data, 0x80);
+		readBit(data, 0x40);
+		readBit(data, 0x20);
+		readBit(data, 0x10);
+		readBit(data, 0x08);
+		readBit(data, 0x04);
+		readBit(data, 0x02);
+		readBit(data, 0x01);
+		return data;
+	}
+
+public:
+	shiftTransport()
+	{
+		mode = shiftBitBang;
+		started = true;
+		dataPortPtr = NULL;
+		clkPortPtr = NULL;
+		dataMask = 0;
+		clkMask = 0;
+	}
+
+	/**
+	 * Start the bit-bang transport.
+	 * @param dataPin Pin number attached to the data pin of the chain
+	 * @param clockPin Pin number attached to the clock pin of the chain
+	 * @param input true if the data pin is an input (74HC165), the internal pull-up is turned on
+	 */
+	void beginBitBang(byte dataPin, byte clockPin, boolean input)
+	{
+		mode = shiftBitBang;
+		started = true;
+		if (input)
+		{
+			dataPortPtr = portInputRegister(digitalPinToPort(dataPin));
+			pinMode(dataPin, INPUT);
+			digitalWrite(dataPin, HIGH); //for the internal pull-up
+		}
+		else
+		{
+			dataPortPtr = portOutputRegister(digitalPinToPort(dataPin));
+			pinMode(dataPin, OUTPUT);
+		}
+		clkPortPtr = portOutputRegister(digitalPinToPort(clockPin));
+		dataMask = digitalPinToBitMask(dataPin);
+		clkMask = digitalPinToBitMask(clockPin);
+		pinMode(clockPin, OUTPUT);
+		digitalWrite(clockPin, LOW);
+	}
+
+	/**
+	 * Choose a hardware transport without touching the hardware, it is started by begin().
+	 * This is safe to call from a constructor.
+	 * @param mode shiftSPI or shiftUSART
+	 */
+	void select(shiftTransportMode mode)
+	{
+		this->mode = mode;
+		started = false;
+	}
+
+	/**
+	 * Start the transport chosen by select(), call from setup(). Does nothing if it has already been started.
+	 * If shiftUSART was chosen and the chip does not have a USART with master SPI mode, the SPI module is used.
+	 * @return Transport in use
+	 */
+	shiftTransportMode begin()
+	{
+		if (!started)
+		{
+			if ((mode != shiftUSART) || !beginUSART())
+			{
+				beginSPI();
+			}
+		}
+		return mode;
+	}
+
+	/**
+	 * Start the hardware SPI transport. Note: data out must be on pin 11, data in on pin 12, clock on pin 13 (Uno).
+	 */
+	void beginSPI()
+	{
+		mode = shiftSPI;
+		started = true;
+		SPI.begin();
+		SPI.setBitOrder(MSBFIRST);
+		SPI.setDataMode(SPI_MODE0);
+		SPI.setClockDivider(SPI_CLOCK_DIV8);
+	}
+
+	/**
+	 * Start the USART transport. The USART transmit buffer lets the next byte be loaded while the current one
+	 * is shifting, so block writes run back to back.
+	 * @return false if the chip does not have a USART with master SPI mode, the bit-bang transport is left in use
+	 */
+	boolean beginUSART()
+	{
+#if defined(SHIFTTRANSPORT_HAS_USART)
+		mode = shiftUSART;
+		started = true;
+		UBRR0 = 0;
+		pinMode(SHIFTTRANSPORT_XCK_PIN, OUTPUT); // XCK must be an output to select master mode
+		UCSR0C = (1 << UMSEL01) | (1 << UMSEL00); // master SPI mode, MSB first, SPI mode 0
+		UCSR0B = (1 << RXEN0) | (1 << TXEN0);
+		UBRR0 = 3; // f_osc / 8, same rate as the SPI transport, must be set after the transmitter is enabled
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/**
+	 * @return Transport in use
+	 */
+	shiftTransportMode getMode()
+	{
+		return mode;
+	}
+
+	/**
+	 * Send and receive one byte.
+	 * @param data Byte to send
+	 * @return Byte received (always 0 for the bit-bang transport)
+	 */
+	byte transfer(byte data)
+	{
+		if (!started)
+		{
+			begin();
+		}
+		if (mode == shiftSPI)
+		{
+			return SPI.transfer(data);
+		}
+#if defined(SHIFTTRANSPORT_HAS_USART)
+		if (mode == shiftUSART)
+		{
+			while (!(UCSR0A & (1 << UDRE0)));
+			UDR0 = data;
+			while (!(UCSR0A & (1 << RXC0)));
+			return UDR0;
+		}
+#endif
+		writeBB(data);
+		return 0;
+	}
+
+	/**
+	 * Send a buffer, last byte first, so buffer[0] ends up in the first chip of the chain.
+	 * Returns once the last bit has been shifted, so the chain can be latched immediately.
+	 * @param buffer Data to send
+	 * @param len Number of bytes
+	 */
+	void writeReverse(const byte *buffer, byte len)
+	{
+		if (!started)
+		{
+			begin();
+		}
+		if (mode == shiftSPI)
+		{
+			for (byte i = len; i != 0; i--)
+			{
+				SPDR = *(buffer + (i - 1));
+				while (!(SPSR & (1 << SPIF)));
+			}
+			return;
+		}
+#if defined(SHIFTTRANSPORT_HAS_USART)
+		if (mode == shiftUSART)
+		{
+			UCSR0A = (1 << TXC0); // clear the transmit complete flag
+			for (byte i = len; i != 0; i--)
+			{
+				while (!(UCSR0A & (1 << UDRE0)));
+				UDR0 = *(buffer + (i - 1));
+			}
+			if (len != 0)
+			{
+				while (!(UCSR0A & (1 << TXC0)));
+			}
+			while (UCSR0A & (1 << RXC0)) { UDR0; } // discard what was received
+			return;
+		}
+#endif
+		for (byte i = len; i != 0; i--)
+		{
+			writeBB(*(buffer + (i - 1)));
+		}
+	}
+
+	/**
+	 * Receive a buffer, buffer[0] is the first byte out of the chain.
+	 * @param buffer Buffer to fill
+	 * @param len Number of bytes
+	 */
+	void read(byte *buffer, byte len)
+	{
+		if (mode == shiftBitBang)
+		{
+			for (byte i = 0; i < len; i++)
+			{
+				*(buffer + i) = readBB();
+			}
+			return;
+		}
+		for (byte i = 0; i < len; i++)
+		{
+			*(buffer + i) = transfer(0x00);
+		}
+	}
+};
+
+/*
+ * Compile time pin lookup. On the ATmega168/328 (Uno, Nano, Pro Mini) a constant pin number becomes a constant
+ * port address and mask, so setting or clearing a pin is a single sbi or cbi instruction.
+ * Other chips fall back to the Arduino pin tables, which works but is no faster than the run time classes.
+ */
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega328__) || defined(__AVR_ATmega168__) || \
+	defined(__AVR_ATmega168A__) || defined(__AVR_ATmega168P__) || defined(__AVR_ATmega8__)
+#define SHIFTTRANSPORT_CONST_PINS
+#define _shiftPinOut(p) ((p) < 8 ? &PORTD : ((p) < 14 ? &PORTB : &PORTC))
+#define _shiftPinIn(p) ((p) < 8 ? &PIND : ((p) < 14 ? &PINB : &PINC))
+#define _shiftPinMask(p) ((byte) (1 << ((p) < 8 ? (p) : ((p) < 14 ? (p) - 8 : (p) - 14))))
+#else
+#define _shiftPinOut(p) portOutputRegister(digitalPinToPort(p))
+#define _shiftPinIn(p) portInputRegister(digitalPinToPort(p))
+#define _shiftPinMask(p) digitalPinToBitMask(p)
+#endif
+
+/**
+ * One pin, fixed at compile time.
+ * @version 2 2026.10.17
+ */
+template <byte PIN>
+class shiftPin
+{
+public:
+	static inline void high()
+	{
+		*_shiftPinOut(PIN) |= _shiftPinMask(PIN);
+	}
+	static inline void low()
+	{
+		*_shiftPinOut(PIN) &= ~_shiftPinMask(PIN);
+	}
+	static inline void pulse()
+	{
+		high();
+		low();
+	}
+	static inline boolean read()
+	{
+		return (*_shiftPinIn(PIN) & _shiftPinMask(PIN)) != 0;
+	}
+};
+
+/**
+ * Bit-bang kernel for one data pin and a clock pin fixed at compile time, MSB first, data is valid on the
+ * rising clock edge. Used by the template versions of the shift register libraries (outputExtendT and so on).
+ * @version 2 2026.10.17
+ */
+template <byte DATA_PIN, byte CLOCK_PIN>
+class shiftPins
+{
+private:
+	static inline void writeBit(byte data, byte bit)
+	{
+		if (data & bit)
+		{
+			shiftPin<DATA_PIN>::high();
+		}
+		else
+		{
+			shiftPin<DATA_PIN>::low();
+		}
+		shiftPin<CLOCK_PIN>::pulse();
+	}
+	static inline void readBit(byte &data, byte bit)
+	{
+		if (shiftPin<DATA_PIN>::read())
+		{
+			data |= bit;
+		}
+		shiftPin<CLOCK_PIN>::pulse();
+	}
+
+public:
+	/**
+	 * Set up the pins.
+	 * @param input true if the data pin is an input (74HC165), the internal pull-up is turned on
+	 */
+	static void begin(boolean input)
+	{
+		pinMode(DATA_PIN, input ? INPUT : OUTPUT);
+		if (input)
+		{
+			digitalWrite(DATA_PIN, HIGH); //for the internal pull-up
+		}
+		pinMode(CLOCK_PIN, OUTPUT);
+		digitalWrite(CLOCK_PIN, LOW);
+	}
+	static inline void write(byte data)
+	{
+		writeBit(data, 0x80);
+		writeBit(data, 0x40);
+		writeBit(data, 0x20);
+		writeBit(data, 0x10);
+		writeBit(data, 0x08);
+		writeBit(data, 0x04);
+		writeBit(data, 0x02);
+		writeBit(data, 0x01);
+	}
+	static inline byte read()
+	{
+		byte data = 0;
+		readBit(data, 0x80);
+		readBit(data, 0x40);
+		readBit(data, 0x20);
+		readBit(data, 0x10);
+		readBit(data, 0x08);
+		readBit(data, 0x04);
+		readBit(data, 0x02);
+		readBit(data, 0x01);
+		return data;
+	}
+	/**
+	 * Send a buffer, last byte first, so buffer[0] ends up in the first chip of the chain.
+	 * @param buffer Data to send
+	 * @param len Number of bytes
+	 */
+	static void writeReverse(const byte *buffer, byte len)
+	{
+		for (byte i = len; i != 0; i--)
+		{
+			write(*(buffer + (i - 1)));
+		}
+	}
+	/**
+	 * Receive a buffer, buffer[0] is the first byte out of the chain.
+	 * @param buffer Buffer to fill
+	 * @param len Number of bytes
+	 */
+	static void read(byte *buffer, byte len)
+	{
+		for (byte i = 0; i < len; i++)
+		{
+			*(buffer + i) = read();
+		}
+	}
+};
+
+/**
+ * Full duplex bit-bang kernel with the pins fixed at compile time, a bit is shifted out on OUT_PIN as a bit is
+ * shifted in from IN_PIN on each clock, MSB first.
+ * @version 2 2026.10.17
+ */
+template <byte OUT_PIN, byte IN_PIN, byte CLOCK_PIN>
+class shiftPinsDuplex
+{
+private:
+	static inline void transferBit(byte out, byte &in, byte bit)
+	{
+		if (out & bit)
+		{
+			shiftPin<OUT_PIN>::high();
+		}
+		else
+		{
+			shiftPin<OUT_PIN>::low();
+		}
+		if (shiftPin<IN_PIN>::read())
+		{
+			in |= bit;
+		}
+		shiftPin<CLOCK_PIN>::pulse();
+	}
+
+public:
+	/**
+	 * Set up the pins, the internal pull-up is turned on for the input.
+	 */
+	static void begin()
+	{
+		pinMode(IN_PIN, INPUT);
+		digitalWrite(IN_PIN, HIGH);
+		pinMode(OUT_PIN, OUTPUT);
+		pinMode(CLOCK_PIN, OUTPUT);
+		digitalWrite(CLOCK_PIN, LOW);
+	}
+	/**
+	 * Send and receive one byte.
+	 * @param data Byte to send
+	 * @return Byte received
+	 */
+	static inline byte transfer(byte data)
+	{
+		byte in = 0;
+		transferBit(data, in, 0x80);
+		transferBit(data, in, 0x40);
+		transferBit(data, in, 0x20);
+		transferBit(data, in, 0x10);
+		transferBit(data, in, 0x08);
+		transferBit(data, in, 0x04);
+		transferBit(data, in, 0x02);
+		transferBit(data, in, 0x01);
+		return in;
+	}
+};
+
+#endif //__shiftTransport_h_
@@ -1,5 +1,6 @@
 //updated on 12/2011 for compatibility with arduino 100 - Keegan
 // changed the memory allocation mode to remove the buffer size constraint 
+// replaced the shift and re-sum with a ring buffer and a running sum, each sample is now constant time
 
 #include "smooth.h"
 
@@ -11,54 +12,40 @@ smooth::smooth(int arraySize)
 	 dataArray = (unsigned int *)calloc(arraySize, sizeof(unsigned int));
 	 while(dataArray == NULL);
 	 smoothedData = 0; 
+	 runningSum = 0;
+	 writeIndex = 0;
 	 bufferedDataCount = 0; //first set of beat coutns that fill the buffer -- index for dataArray 
      bufferFull = false;   //boolean to say if we've filled the array 
 }
 
 void smooth::smoothData(long data)
 {
-  smoothedData = 0; // set back to 0 so addition can happen to it
-  if(bufferedDataCount < amountToBuffer && bufferFull == false)
+  // the oldest sample is dropped from the running sum instead of re-summing the whole array
+  if(bufferFull == true)
   {
-    dataArray[bufferedDataCount] = data; // store data into the array
-    bufferedDataCount++;   //increment the dataArray index counter
-    for(int i = 0; i < bufferedDataCount; i++)
-    {
-      // Serial.print("Fill data = ");
-      // Serial.println(dataArray[i],DEC);
-       smoothedData += dataArray[i];
-    }
-    smoothedData = smoothedData/bufferedDataCount;
-   // Serial.print("Fill Average = ");
-   // Serial.println(smoothedData,DEC);
-   }
-   if(bufferFull == true)
-   {
-     for(int i = 0; i < amountToBuffer; i++)
-     {
-       if(i < (amountToBuffer-1))
-       {
-        dataArray[i] = dataArray[i+1];
-       }
-       else if(i == (amountToBuffer-1))
-       {
-          dataArray[i] = data;
-       }
-     }
-     for(int i = 0; i < amountToBuffer; i++)
-     {
-        smoothedData += dataArray[i];
-     }
-     smoothedData = smoothedData/amountToBuffer;
-   }
-
-  if(bufferedDataCount == amountToBuffer){bufferFull = true;}
+    runningSum -= dataArray[writeIndex];
+  }
+  else
+  {
+    bufferedDataCount++;   //increment the fill counter
+  }
+  dataArray[writeIndex] = data; // store data into the array
+  runningSum += dataArray[writeIndex];
+  writeIndex++;
+  if(writeIndex >= amountToBuffer)
+  {
+    writeIndex = 0;
+    bufferFull = true;
+  }
+  smoothedData = runningSum/(bufferFull ? amountToBuffer : bufferedDataCount);
   return;
 }
 
 void smooth::clearData()
 {
   smoothedData = 0; 
+  runningSum = 0;
+  writeIndex = 0;
   bufferedDataCount = 0; //first set of beat coutns that fill the buffer -- index for dataArray 
   bufferFull = false;   //boolean to say if we've filled the array
 }
@@ -1,4 +1,6 @@
 //updated on 12/2011 for compatibility with arduino 100 - Keegan
+//updated to use a ring buffer with a running sum, added the smoothAverage, smoothExponential,
+//smoothMedian and smoothDecimate templates
 
 #ifndef smooth_h
 #define smooth_h
@@ -22,6 +24,8 @@ class smooth
  private:
 	byte arraySize;
 	int  amountToBuffer;
+	int  writeIndex;              //next slot in dataArray to be overwritten (oldest sample once full)
+	unsigned long runningSum;     //sum of every sample currently held in dataArray
 	unsigned int  *dataArray;
  public:
 	 unsigned long  smoothedData;
@@ -34,5 +38,236 @@ class smooth
 	 void clearData();
 	 
 };
-#endif
 
+/*
+ * The templates below are statically sized alternatives to smooth, no memory is allocated at run time.
+ * They all share the same interface:
+ *   bool smoothData(TYPE)  add a sample, returns true if smoothedData was updated
+ *   void clearData()       discard all samples
+ *   TYPE smoothedData      the filter output
+ *   bool bufferFull        true once the filter has seen enough samples to be settled
+ */
+
+/**
+ * Moving average over the last SIZE samples. Each sample costs the same no matter how large SIZE is.
+ * @tparam TYPE Sample type
+ * @tparam SIZE Number of samples in the window (1-255)
+ * @tparam SUMTYPE Accumulator type, must hold SIZE * the largest sample (use float for floating point samples)
+ */
+template <typename TYPE, uint8_t SIZE, typename SUMTYPE = long>
+class smoothAverage
+{
+private:
+	TYPE dataArray[SIZE];
+	uint8_t writeIndex;
+	SUMTYPE runningSum;
+public:
+	TYPE smoothedData;
+	bool bufferFull;
+	uint8_t bufferedDataCount;
+
+	smoothAverage() { clearData(); }
+
+	/**
+	 * Add a sample to the window.
+	 * @param data New sample
+	 * @return Always true
+	 */
+	bool smoothData(TYPE data)
+	{
+		if (bufferFull) { runningSum -= dataArray[writeIndex]; }
+		else { bufferedDataCount++; }
+		dataArray[writeIndex] = data;
+		runningSum += data;
+		if (++writeIndex >= SIZE)
+		{
+			writeIndex = 0;
+			bufferFull = true;
+		}
+		smoothedData = runningSum / bufferedDataCount;
+		return true;
+	}
+
+	/**
+	 * Discard all samples.
+	 */
+	void clearData()
+	{
+		writeIndex = 0;
+		runningSum = 0;
+		smoothedData = 0;
+		bufferedDataCount = 0;
+		bufferFull = false;
+	}
+};
+
+/**
+ * Exponential moving average, smoothedData moves 1/(2^SHIFT) of the way to each new sample.
+ * Integer sample types only, the accumulator keeps SHIFT fractional bits so small steps are not lost.
+ * @tparam TYPE Sample type
+ * @tparam SHIFT Smoothing factor as a power of two (larger is smoother)
+ * @tparam SUMTYPE Accumulator type, must hold the largest sample * 2^SHIFT
+ */
+template <typename TYPE, uint8_t SHIFT, typename SUMTYPE = long>
+class smoothExponential
+{
+private:
+	SUMTYPE accumulator;
+public:
+	TYPE smoothedData;
+	bool bufferFull;
+
+	smoothExponential() { clearData(); }
+
+	/**
+	 * Add a sample to the filter. The first sample after clearData() seeds the output.
+	 * @param data New sample
+	 * @return Always true
+	 */
+	bool smoothData(TYPE data)
+	{
+		if (!bufferFull)
+		{
+			accumulator = (SUMTYPE)data << SHIFT;
+			bufferFull = true;
+		}
+		else
+		{
+			accumulator += (SUMTYPE)data - (accumulator >> SHIFT);
+		}
+		smoothedData = accumulator >> SHIFT;
+		return true;
+	}
+
+	/**
+	 * Discard the filter state.
+	 */
+	void clearData()
+	{
+		accumulator = 0;
+		smoothedData = 0;
+		bufferFull = false;
+	}
+};
+
+/**
+ * Median of the last SIZE samples, used to reject single sample spikes.
+ * A sorted copy of the window is kept so each sample is one removal and one insertion, this is
+ * intended for small windows (3-15).
+ * @tparam TYPE Sample type
+ * @tparam SIZE Number of samples in the window (1-255), odd numbers give a true median
+ */
+template <typename TYPE, uint8_t SIZE>
+class smoothMedian
+{
+private:
+	TYPE dataArray[SIZE];
+	TYPE sortedArray[SIZE];
+	uint8_t writeIndex;
+public:
+	TYPE smoothedData;
+	bool bufferFull;
+	uint8_t bufferedDataCount;
+
+	smoothMedian() { clearData(); }
+
+	/**
+	 * Add a sample to the window.
+	 * @param data New sample
+	 * @return Always true
+	 */
+	bool smoothData(TYPE data)
+	{
+		uint8_t i = bufferedDataCount;
+		if (bufferFull)
+		{
+			// remove the oldest sample from the sorted copy, compared as bits so that a NaN is found
+			// (NaN != NaN), bounded so that the last slot is dropped if it is somehow not there
+			TYPE oldest = dataArray[writeIndex];
+			i = 0;
+			while ((i < (SIZE - 1)) && (memcmp(&sortedArray[i], &oldest, sizeof(TYPE)) != 0)) { i++; }
+			for (; i < (SIZE - 1); i++) { sortedArray[i] = sortedArray[i + 1]; }
+		}
+		else
+		{
+			bufferedDataCount++;
+		}
+		// insert the new sample, i is the last free slot
+		while ((i != 0) && (sortedArray[i - 1] > data))
+		{
+			sortedArray[i] = sortedArray[i - 1];
+			i--;
+		}
+		sortedArray[i] = data;
+		dataArray[writeIndex] = data;
+		if (++writeIndex >= SIZE)
+		{
+			writeIndex = 0;
+			bufferFull = true;
+		}
+		smoothedData = sortedArray[(bufferedDataCount - 1) >> 1];
+		return true;
+	}
+
+	/**
+	 * Discard all samples.
+	 */
+	void clearData()
+	{
+		writeIndex = 0;
+		smoothedData = 0;
+		bufferedDataCount = 0;
+		bufferFull = false;
+	}
+};
+
+/**
+ * Decimating average, smoothedData is the average of each block of FACTOR samples.
+ * The output only changes once per block, so it can be used to reduce the sample rate.
+ * @tparam TYPE Sample type
+ * @tparam FACTOR Number of samples per output (1-255)
+ * @tparam SUMTYPE Accumulator type, must hold FACTOR * the largest sample (use float for floating point samples)
+ */
+template <typename TYPE, uint8_t FACTOR, typename SUMTYPE = long>
+class smoothDecimate
+{
+private:
+	SUMTYPE runningSum;
+	uint8_t sampleCount;
+public:
+	TYPE smoothedData;
+	bool bufferFull;
+
+	smoothDecimate() { clearData(); }
+
+	/**
+	 * Add a sample to the current block.
+	 * @param data New sample
+	 * @return true if the block was completed and smoothedData was updated
+	 */
+	bool smoothData(TYPE data)
+	{
+		runningSum += data;
+		if (++sampleCount < FACTOR)
+		{
+			return false;
+		}
+		smoothedData = runningSum / FACTOR;
+		runningSum = 0;
+		sampleCount = 0;
+		bufferFull = true;
+		return true;
+	}
+
+	/**
+	 * Discard the current block and the last output.
+	 */
+	void clearData()
+	{
+		runningSum = 0;
+		sampleCount = 0;
+		smoothedData = 0;
+		bufferFull = false;
+	}
+};
+#endif
@@ -0,0 +1,457 @@
+#include "wireQueue.h"
+
+wireQueue WireQueue;
+
+wireQueue::wireQueue()
+{
+	head = NULL;
+	tail = NULL;
+	active = NULL;
+	completed = 0;
+	errors = 0;
+#if defined(WIREQUEUE_ASYNC)
+	transfer.callback = transferDone;
+	transfer.context = this;
+	transfer.next = NULL;
+	modifyWrite = false;
+	finished = 0;
+#endif
+}
+
+/**
+ * @brief Add a transaction to the end of the queue
+ *
+ * @param t Transaction to add
+ * @param release Called when the transaction leaves the queue, before the callback or from
+ * cancel(), so that the owner can track its transactions. May be NULL
+ * @param owner Stored in the transaction for release
+ * @return false if the transaction is already queued or does not fit in the Wire buffer
+ */
+bool wireQueue::add(wireTransaction *t, void (*release)(wireTransaction *), void *owner)
+{
+	if (isQueued(t)) { return false; }
+	if (t->count == 0 || ((uint16_t)t->count * t->width) >= BUFFER_LENGTH)
+	{
+		t->status = WIREQUEUE_INVALID;
+		return false;
+	}
+	t->status = WIREQUEUE_PENDING;
+	t->release = release;
+	t->owner = owner;
+	t->next = NULL;
+	WIREQUEUE_LOCK();
+	if (tail == NULL) { head = t; }
+	else { tail->next = t; }
+	tail = t;
+#if defined(WIREQUEUE_ASYNC)
+	if (active == NULL) { start(); }
+#endif
+	WIREQUEUE_UNLOCK();
+	return true;
+}
+
+/**
+ * @brief Check if a transaction is in the queue
+ *
+ * @param t Transaction to find
+ * @return true if the transaction is waiting to be run or is on the bus
+ */
+bool wireQueue::isQueued(wireTransaction *t)
+{
+	bool found = false;
+	WIREQUEUE_LOCK();
+	if (t == active) { found = true; }
+	for (wireTransaction *p = head; p != NULL && !found; p = p->next)
+	{
+		if (p == t) { found = true; }
+	}
+	WIREQUEUE_UNLOCK();
+	return found;
+}
+
+/**
+ * @brief Remove a transaction that has not been run yet
+ * @details The callback is not called, release is. A transaction that is already on the bus can't be removed.
+ *
+ * @param t Transaction to remove
+ * @return false if the transaction was not waiting in the queue
+ */
+bool wireQueue::cancel(wireTransaction *t)
+{
+	wireTransaction *prev = NULL;
+	WIREQUEUE_LOCK();
+	for (wireTransaction *p = head; p != NULL; p = p->next)
+	{
+		if (p == t)
+		{
+			if (prev == NULL) { head = t->next; }
+			else { prev->next = t->next; }
+			if (tail == t) { tail = prev; }
+			t->next = NULL;
+			if (t->release != NULL) { (*t->release)(t); }
+			WIREQUEUE_UNLOCK();
+			return true;
+		}
+		prev = p;
+	}
+	WIREQUEUE_UNLOCK();
+	return false;
+}
+
+/**
+ * @brief Get the number of transactions that completed successfully
+ *
+ * @return Number of transactions
+ */
+uint32_t wireQueue::getCompleted()
+{
+	uint32_t n;
+	WIREQUEUE_LOCK();
+	n = completed;
+	WIREQUEUE_UNLOCK();
+	return n;
+}
+
+/**
+ * @brief Get the number of transactions that failed
+ *
+ * @return Number of transactions
+ */
+uint32_t wireQueue::getErrors()
+{
+	uint32_t n;
+	WIREQUEUE_LOCK();
+	n = errors;
+	WIREQUEUE_UNLOCK();
+	return n;
+}
+
+/**
+ * @brief Reset the transaction counters
+ */
+void wireQueue::clearCounters()
+{
+	WIREQUEUE_LOCK();
+	completed = 0;
+	errors = 0;
+	WIREQUEUE_UNLOCK();
+}
+
+/**
+ * @brief Get a register value from the buffer of a transaction
+ *
+ * @param t Transaction
+ * @param i Index in the buffer
+ * @return Register value
+ */
+uint32_t wireQueue::getValue(wireTransaction *t, uint8_t i)
+{
+	switch (t->width)
+	{
+	case 4:
+		return ((uint32_t *)t->buffer)[i];
+	case 2:
+		return ((uint16_t *)t->buffer)[i];
+	default:
+		return ((uint8_t *)t->buffer)[i];
+	}
+}
+
+/**
+ * @brief Store a register value in the buffer of a transaction
+ *
+ * @param t Transaction
+ * @param i Index in the buffer
+ * @param d Register value
+ */
+void wireQueue::setValue(wireTransaction *t, uint8_t i, uint32_t d)
+{
+	switch (t->width)
+	{
+	case 4:
+		((uint32_t *)t->buffer)[i] = d;
+		break;
+	case 2:
+		((uint16_t *)t->buffer)[i] = (uint16_t)d;
+		break;
+	default:
+		((uint8_t *)t->buffer)[i] = (uint8_t)d;
+	}
+}
+
+#if defined(WIREQUEUE_ASYNC)
+
+/**
+ * @brief Check the bus
+ * @details The transactions are run by the twi interrupt, this only resets the bus if it has
+ * stalled for longer than the Wire.setBusTimeout() time (see Wire.poll()).
+ *
+ * @param maxTransactions Not used
+ * @return Number of transactions completed since the last call
+ */
+uint8_t wireQueue::run(uint8_t maxTransactions)
+{
+	uint8_t n;
+	(void)maxTransactions;
+	Wire.poll();
+	WIREQUEUE_LOCK();
+	n = finished;
+	finished = 0;
+	WIREQUEUE_UNLOCK();
+	return n;
+}
+
+/**
+ * @brief Move the first waiting transaction to the bus
+ * @details Interrupts must be off.
+ */
+void wireQueue::start()
+{
+	wireTransaction *t = head;
+	uint8_t bytes;
+
+	if (t == NULL) { return; }
+	head = t->next;
+	if (head == NULL) { tail = NULL; }
+	t->next = NULL;
+	active = t;
+
+	bytes = t->count * t->width;
+	frame[0] = t->reg;
+	transfer.address = t->address;
+	transfer.txData = frame;
+	transfer.rxData = frame + 1;
+	if (t->type == WIRE_WRITE)
+	{
+		for (uint8_t i = 0; i < t->count; i++) { packValue(frame + 1 + (i * t->width), getValue(t, i), t->width); }
+		transfer.txLength = bytes + 1;
+		transfer.rxLength = 0;
+	}
+	else
+	{
+		transfer.txLength = 1;
+		transfer.rxLength = (t->type == WIRE_MODIFY) ? t->width : bytes;
+	}
+	modifyWrite = false;
+	Wire.queueTransfer(&transfer);
+}
+
+/**
+ * @brief Complete the active transaction and start the next one
+ * @details Called from the twi interrupt.
+ *
+ * @param status 0 on success, twi status or WIREQUEUE_TIMEOUT on failure
+ */
+void wireQueue::finish(uint8_t status)
+{
+	wireTransaction *t = active;
+
+	active = NULL;
+	if (status == 0) { completed++; }
+	else { errors++; }
+	finished++;
+	t->status = status;
+	start();
+	if (t->release != NULL) { (*t->release)(t); }
+	if (t->callback != NULL) { (*t->callback)(t); }
+}
+
+/**
+ * @brief twi callback for the transfer of the active transaction
+ * @details The read of a WIRE_MODIFY is followed by the write of the new value, the transaction
+ * is complete when that is done.
+ *
+ * @param tr The transfer
+ */
+void wireQueue::transferDone(twi_transfer *tr)
+{
+	wireQueue *q = (wireQueue *)tr->context;
+	wireTransaction *t = q->active;
+	uint32_t value;
+
+	if (tr->status == TWI_ERROR_TIMEOUT && tr->rxCount < tr->rxLength)
+	{
+		// the bus was reset before the data was all read, reported as the blocking run() does
+		q->finish(WIREQUEUE_TIMEOUT);
+		return;
+	}
+	if (tr->status != TWI_OK)
+	{
+		q->finish(tr->status);
+		return;
+	}
+	if (t->type == WIRE_WRITE)
+	{
+		q->finish(0);
+		return;
+	}
+	if (q->modifyWrite)
+	{
+		if (t->buffer != NULL) { q->setValue(t, 0, unpackValue(q->frame + 1, t->width)); }
+		q->finish(0);
+		return;
+	}
+	if (tr->rxCount < tr->rxLength)
+	{
+		q->finish(WIREQUEUE_TIMEOUT);
+		return;
+	}
+	if (t->type == WIRE_READ)
+	{
+		for (uint8_t i = 0; i < t->count; i++) { q->setValue(t, i, unpackValue(q->frame + 1 + (i * t->width), t->width)); }
+		q->finish(0);
+		return;
+	}
+
+	value = unpackValue(q->frame + 1, t->width);
+	value = (value & ~t->mask) | (t->value & t->mask);
+	packValue(q->frame + 1, value, t->width);
+	tr->txLength = t->width + 1;
+	tr->rxLength = 0;
+	q->modifyWrite = true;
+	Wire.queueTransfer(tr);
+}
+
+/**
+ * @brief Re-assembles a big endian value
+ *
+ * @param p First byte
+ * @param width Size of the value in bytes
+ * @return The value
+ */
+uint32_t wireQueue::unpackValue(const uint8_t *p, uint8_t width)
+{
+	uint32_t d = 0;
+	for (uint8_t i = 0; i < width; i++)
+	{
+		d <<= 8;
+		d |= p[i];
+	}
+	return d;
+}
+
+/**
+ * @brief Splits a value into big endian bytes
+ *
+ * @param p Where to store the first byte
+ * @param d Value
+ * @param width Size of the value in bytes
+ */
+void wireQueue::packValue(uint8_t *p, uint32_t d, uint8_t width)
+{
+	for (uint8_t i = width; i != 0; i--)
+	{
+		*p++ = (uint8_t)(d >> (8 * (i - 1)));
+	}
+}
+
+#else
+
+
+/**
+ * @brief Run the transactions in the queue
+ * @details Each transaction is removed from the queue before its callback is called, so the
+ * callback can add it again.
+ *
+ * @param maxTransactions Maximum number of transactions to run in this call
+ * @return Number of transactions run
+ */
+uint8_t wireQueue::run(uint8_t maxTransactions)
+{
+	uint8_t n = 0;
+	wireTransaction *t;
+	while (head != NULL && n < maxTransactions)
+	{
+		t = head;
+		head = t->next;
+		if (head == NULL) { tail = NULL; }
+		t->next = NULL;
+		t->status = execute(t);
+		if (t->status == 0) { completed++; }
+		else { errors++; }
+		n++;
+		if (t->release != NULL) { (*t->release)(t); }
+		if (t->callback != NULL) { (*t->callback)(t); }
+	}
+	return n;
+}
+
+/**
+ * @brief Run one transaction on the bus
+ *
+ * @param t Transaction to run
+ * @return 0 on success, Wire status or WIREQUEUE_TIMEOUT on failure
+ */
+uint8_t wireQueue::execute(wireTransaction *t)
+{
+	uint8_t status;
+	uint8_t bytes = t->count * t->width;
+	uint32_t value;
+
+	if (t->type == WIRE_WRITE)
+	{
+		Wire.beginTransmission(t->address);
+		Wire.write(t->reg);
+		for (uint8_t i = 0; i < t->count; i++) { writeValue(getValue(t, i), t->width); }
+		return Wire.endTransmission();
+	}
+
+	if (t->type == WIRE_MODIFY) { bytes = t->width; }
+	Wire.beginTransmission(t->address);
+	Wire.write(t->reg);
+	status = Wire.endTransmission(false);
+	if (status != 0) { return status; }
+	if (Wire.requestFrom(t->address, bytes) < bytes || Wire.available() < bytes)
+	{
+		while (Wire.available()) { Wire.read(); }
+		return WIREQUEUE_TIMEOUT;
+	}
+
+	if (t->type == WIRE_READ)
+	{
+		for (uint8_t i = 0; i < t->count; i++) { setValue(t, i, readValue(t->width)); }
+		return 0;
+	}
+
+	value = readValue(t->width);
+	value = (value & ~t->mask) | (t->value & t->mask);
+	Wire.beginTransmission(t->address);
+	Wire.write(t->reg);
+	writeValue(value, t->width);
+	status = Wire.endTransmission();
+	if (status == 0 && t->buffer != NULL) { setValue(t, 0, value); }
+	return status;
+}
+
+/**
+ * @brief Receives a big endian value
+ *
+ * @param width Size of the value in bytes
+ * @return The re-assembled value
+ */
+uint32_t wireQueue::readValue(uint8_t width)
+{
+	uint32_t d = 0;
+	for (uint8_t i = 0; i < width; i++)
+	{
+		d <<= 8;
+		d |= (uint8_t)Wire.read();
+	}
+	return d;
+}
+
+/**
+ * @brief Writes a big endian value
+ *
+ * @param d Value to write
+ * @param width Size of the value in bytes
+ */
+void wireQueue::writeValue(uint32_t d, uint8_t width)
+{
+	for (uint8_t i = width; i != 0; i--)
+	{
+		Wire.write((uint8_t)(d >> (8 * (i - 1))));
+	}
+}
+
+#endif
@@ -0,0 +1,116 @@
+/**
+ * @file	wireQueue.h
+ * @author	Keegan Morrow
+ * @version	1.2.0
+ * @brief Queue of register transactions shared by all of the devices on the i2c bus
+ *
+ */
+
+#ifndef __wireQueue_h_
+#define __wireQueue_h_
+
+#include <Arduino.h>
+#include <Wire.h>
+
+static const uint8_t WIREQUEUE_PENDING = 0xFF; ///< Transaction is waiting in the queue
+static const uint8_t WIREQUEUE_TIMEOUT = 0xFE; ///< The device did not return all of the data
+static const uint8_t WIREQUEUE_INVALID = 0xFD; ///< Transaction does not fit in the Wire buffer
+
+#if defined(TWI_PENDING)
+#define WIREQUEUE_ASYNC ///< Wire has twi_transfer, the transactions are run by the twi interrupt
+// Guard data that is shared with the twi interrupt
+#define WIREQUEUE_LOCK() uint8_t oldSREG = SREG; cli()
+#define WIREQUEUE_UNLOCK() SREG = oldSREG
+#else
+#define WIREQUEUE_LOCK()
+#define WIREQUEUE_UNLOCK()
+#endif
+
+/**
+ * @brief Type of register transaction
+ */
+enum wireTransaction_t
+{
+	WIRE_READ, ///< Read a sequence of registers
+	WIRE_WRITE, ///< Write a sequence of registers
+	WIRE_MODIFY ///< Read modify write one register
+};
+
+/**
+ * @brief One queued register transaction
+ * @details The transaction and its buffer are owned by the caller and must stay in scope until
+ * the transaction is complete (status is no longer WIREQUEUE_PENDING). With WIREQUEUE_ASYNC the
+ * buffer is filled in and the callback is called from the twi interrupt, so keep the callback
+ * short and don't use the blocking Wire functions in it.
+ */
+struct wireTransaction
+{
+	uint8_t address; ///< Hardware address of the device
+	uint8_t reg; ///< First register address
+	wireTransaction_t type;
+	uint8_t width; ///< Size of each register in bytes (1, 2 or 4)
+	uint8_t count; ///< Number of registers
+	void *buffer; ///< Data to write, or where to store the data read (register size units)
+	uint32_t mask; ///< Bits to change for WIRE_MODIFY
+	uint32_t value; ///< New state of the bits in mask for WIRE_MODIFY
+	volatile uint8_t status; ///< WIREQUEUE_PENDING, 0 on success, or the Wire / twi status or WIREQUEUE_TIMEOUT on failure
+	void (*callback)(wireTransaction *); ///< Called when the transaction is complete, may be NULL
+	void *context; ///< Not used by the queue, for the callback
+	void (*release)(wireTransaction *); ///< Set by add(), called before the callback or by cancel()
+	void *owner; ///< Set by add(), for release
+	wireTransaction *next;
+};
+
+/**
+ * @brief Queue of register transactions
+ * @details Transactions from any number of devices are run back to back, in the order they were
+ * added. With WIREQUEUE_ASYNC each one is handed to Wire.queueTransfer() and the next is started
+ * when the interrupt completes it, run() only checks for a stalled bus. Without it (other cores)
+ * run() does the transactions with the blocking Wire functions. Either way call run() from loop().
+ */
+class wireQueue
+{
+public:
+	wireQueue();
+	bool add(wireTransaction *, void (*)(wireTransaction *) = NULL, void * = NULL);
+	bool cancel(wireTransaction *);
+	bool isQueued(wireTransaction *);
+	uint8_t run(uint8_t = 0xFF);
+	/**
+	 * @brief Check if there are transactions waiting
+	 *
+	 * @return true if the queue is empty
+	 */
+	inline bool isIdle() {return head == NULL && active == NULL;}
+	uint32_t getCompleted();
+	uint32_t getErrors();
+	void clearCounters();
+
+private:
+	wireTransaction *head; ///< First transaction waiting, not including active
+	wireTransaction *tail;
+	wireTransaction * volatile active; ///< Transaction on the bus, NULL if none
+	volatile uint32_t completed;
+	volatile uint32_t errors;
+	uint32_t getValue(wireTransaction *, uint8_t);
+	void setValue(wireTransaction *, uint8_t, uint32_t);
+#if defined(WIREQUEUE_ASYNC)
+	twi_transfer transfer; ///< Used for each transaction in turn
+	uint8_t frame[BUFFER_LENGTH]; ///< Register address followed by the data
+	bool modifyWrite; ///< The read of a WIRE_MODIFY is done, transfer is the write
+	volatile uint8_t finished; ///< Transactions completed since the last run()
+	void start();
+	void finish(uint8_t);
+	static void transferDone(twi_transfer *);
+	static uint32_t unpackValue(const uint8_t *, uint8_t);
+	static void packValue(uint8_t *, uint32_t, uint8_t);
+#else
+	uint8_t execute(wireTransaction *);
+	uint32_t readValue(uint8_t);
+	void writeValue(uint32_t, uint8_t);
+#endif
+};
+
+extern wireQueue WireQueue;
+
+#endif // __wireQueue_h_
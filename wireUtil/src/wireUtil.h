@@ -1,7 +1,7 @@
 /**
  * @file	wireUtil.h
  * @author	Keegan Morrow
- * @version	1.1.3
+ * @version	1.3.0
  * @brief Utility base class for reading and writing registers on i2c devices
  *
  */
@@ -11,6 +11,7 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include "wireQueue.h"
 
 /**
  * @brief Utility base class for reading and writing registers on i2c devices
@@ -22,6 +23,18 @@ template <typename REGTYPE, typename DATATYPE = uint8_t>
 class wireUtil
 {
 public:
+	wireUtil()
+	{
+		timeOutHandler = NULL;
+		errorHandler = NULL;
+		shadow = NULL;
+		shadowFlags = NULL;
+		shadowSize = 0;
+		queuedWrites = 0;
+		shadowQueued = false;
+		busTransactions = 0;
+		transactionsSaved = 0;
+	}
 	/**
 	 * @brief Attach a function to be called on a read timeout
 	 *
@@ -59,6 +72,31 @@ public:
 	bool readRegisters(REGTYPE, DATATYPE *, uint8_t);
 	bool setRegisterBit(REGTYPE, uint8_t, bool);
 
+	bool queueRead(wireTransaction *, REGTYPE, DATATYPE *, uint8_t, void (*)(wireTransaction *) = NULL, void * = NULL);
+	bool queueWrite(wireTransaction *, REGTYPE, DATATYPE *, uint8_t, void (*)(wireTransaction *) = NULL, void * = NULL);
+	bool queueSetBits(wireTransaction *, REGTYPE, DATATYPE, DATATYPE, DATATYPE * = NULL, void (*)(wireTransaction *) = NULL, void * = NULL);
+
+	bool enableShadow(uint8_t);
+	void setVolatile(REGTYPE, bool = true);
+	void invalidateShadow();
+	bool flushRegisters();
+	/**
+	 * @brief Get the number of transactions on the bus
+	 *
+	 * @return Number of transactions
+	 */
+	inline uint32_t getBusTransactions() {return busTransactions;}
+	/**
+	 * @brief Get the number of transactions avoided by the register shadow
+	 *
+	 * @return Number of transactions
+	 */
+	inline uint32_t getTransactionsSaved() {return transactionsSaved;}
+	/**
+	 * @brief Reset the transaction counters
+	 */
+	inline void clearCounters() {busTransactions = 0; transactionsSaved = 0;}
+
 protected:
 	uint8_t address; ///< Hardware address of the device
 
@@ -67,6 +105,26 @@ private:
 	void (*errorHandler)(uint8_t);
 	void writeAsBytes(DATATYPE);
 	DATATYPE readAsBytes();
+	bool queueTransaction(wireTransaction *, wireTransaction_t, REGTYPE, DATATYPE *, uint8_t, void (*)(wireTransaction *), void *);
+
+	enum
+	{
+		SHADOW_VALID = 0x01, ///< The shadow matches the device (or holds a pending write)
+		SHADOW_DIRTY = 0x02, ///< The shadow holds a change that has not been written
+		SHADOW_VOLATILE = 0x04, ///< The register can change on its own, never served from the shadow
+		SHADOW_QUEUED = 0x08 ///< A queued write has not completed, not valid until it has
+	};
+	DATATYPE *shadow; ///< Copy of the device registers, NULL if the shadow is not enabled
+	uint8_t *shadowFlags;
+	uint8_t shadowSize; ///< Number of registers in the shadow
+	volatile uint8_t queuedWrites; ///< Queued writes that have not completed, changed by the twi interrupt
+	bool shadowQueued; ///< Some registers are marked SHADOW_QUEUED
+	uint32_t busTransactions;
+	uint32_t transactionsSaved;
+	bool shadowHit(REGTYPE, uint8_t);
+	void shadowStore(REGTYPE, DATATYPE *, uint8_t, bool);
+	void shadowSettle();
+	static void queueRelease(wireTransaction *);
 };
 
 /*
@@ -110,6 +168,7 @@ void wireUtil<REGTYPE, DATATYPE>::begin(uint8_t address, uint8_t SDApin, uint8_t
 
 /**
  * @brief Write a single register on an i2c device
+ * @details See writeRegisters() for the shadow.
  *
  * @param reg Register address (from a device specific enum)
  * @param data Data to be written to the device
@@ -123,6 +182,10 @@ bool wireUtil<REGTYPE, DATATYPE>::writeRegister(REGTYPE reg, DATATYPE data)
 
 /**
  * @brief Write to a sequence of registers on an i2c device
+ * @details With the shadow enabled the write is skipped if the device already holds this data.
+ * Registers where a write does something even if the value is the same (e.g. a start conversion
+ * bit like the ADS1x15 OS bit, or a clear on write flag) must be marked with setVolatile(),
+ * every write to those goes to the device.
  *
  * @param reg First register address (from a device specific enum)
  * @param buffer Array containing the data to be written
@@ -132,6 +195,17 @@ bool wireUtil<REGTYPE, DATATYPE>::writeRegister(REGTYPE reg, DATATYPE data)
 template <typename REGTYPE, typename DATATYPE>
 bool wireUtil<REGTYPE, DATATYPE>::writeRegisters(REGTYPE reg, DATATYPE *buffer, uint8_t len)
 {
+	if (shadowHit(reg, len) && memcmp(shadow + (uint8_t)reg, buffer, len * sizeof(DATATYPE)) == 0)
+	{
+		bool clean = true;
+		for (uint8_t i = 0; i < len; i++) { clean &= !(shadowFlags[(uint8_t)reg + i] & SHADOW_DIRTY); }
+		if (clean)
+		{
+			transactionsSaved++; // the device already holds this data
+			return true;
+		}
+	}
+	busTransactions++;
 	Wire.beginTransmission(address);
 	Wire.write(reg);
 	for (uint8_t i = 0; i < len; i++)
@@ -142,7 +216,11 @@ bool wireUtil<REGTYPE, DATATYPE>::writeRegisters(REGTYPE reg, DATATYPE *buffer,
 
 	uint8_t status;
 	status = Wire.endTransmission();
-	if (status == 0) { return true; }
+	if (status == 0)
+	{
+		shadowStore(reg, buffer, len, true);
+		return true;
+	}
 	else if (errorHandler != NULL)
 	{
 		(*errorHandler)(status);
@@ -161,6 +239,13 @@ template <typename REGTYPE, typename DATATYPE>
 DATATYPE wireUtil<REGTYPE, DATATYPE>::readRegister(REGTYPE reg)
 {
 	unsigned long abortTime;
+	DATATYPE d;
+	if (shadowHit(reg, 1))
+	{
+		transactionsSaved++;
+		return shadow[(uint8_t)reg];
+	}
+	busTransactions++;
 	Wire.beginTransmission(address);
 	Wire.write((uint8_t)reg);
 	Wire.endTransmission(false);
@@ -177,8 +262,10 @@ DATATYPE wireUtil<REGTYPE, DATATYPE>::readRegister(REGTYPE reg)
 			return 0;
 		}
 	}
-	if (sizeof(DATATYPE) == 1) { return Wire.read(); }
-	else { return readAsBytes(); }
+	if (sizeof(DATATYPE) == 1) { d = Wire.read(); }
+	else { d = readAsBytes(); }
+	shadowStore(reg, &d, 1, false);
+	return d;
 }
 
 /**
@@ -192,6 +279,13 @@ DATATYPE wireUtil<REGTYPE, DATATYPE>::readRegister(REGTYPE reg)
 template <typename REGTYPE, typename DATATYPE>
 bool wireUtil<REGTYPE, DATATYPE>::readRegisters(REGTYPE reg, DATATYPE *buffer, uint8_t len)
 {
+	if (shadowHit(reg, len))
+	{
+		memcpy(buffer, shadow + (uint8_t)reg, len * sizeof(DATATYPE));
+		transactionsSaved++;
+		return true;
+	}
+	busTransactions++;
 	Wire.beginTransmission(address);
 	Wire.write((uint8_t)reg);
 	Wire.endTransmission(false);
@@ -218,12 +312,15 @@ bool wireUtil<REGTYPE, DATATYPE>::readRegisters(REGTYPE reg, DATATYPE *buffer, u
 		if (sizeof(DATATYPE) == 1) { buffer[i] = Wire.read(); }
 		else { buffer[i] = readAsBytes(); }
 	}
+	shadowStore(reg, buffer, len, false);
 
 	return true;
 }
 
 /**
  * @brief Read modify write a bit on a register
+ * @details If the register is in the shadow only the shadow is changed, the change is
+ * written by flushRegisters().
  *
  * @param reg register to modify
  * @param bit index of the bit to set
@@ -235,11 +332,271 @@ bool wireUtil<REGTYPE, DATATYPE>::setRegisterBit(REGTYPE reg, uint8_t bit, bool
 {
 	DATATYPE tempReg;
 	tempReg = readRegister(reg);
+	if (shadowHit(reg, 1))
+	{
+		if (state) { shadow[(uint8_t)reg] |= (DATATYPE)(1 << bit); }
+		else { shadow[(uint8_t)reg] &= ~(DATATYPE)(1 << bit); }
+		if (shadow[(uint8_t)reg] != tempReg) { shadowFlags[(uint8_t)reg] |= SHADOW_DIRTY; }
+		transactionsSaved++; // the write is deferred to flushRegisters()
+		return true;
+	}
 	if (state) { tempReg |= (DATATYPE)(1 << bit); }
 	else { tempReg &= ~(DATATYPE)(1 << bit); }
 	return writeRegister(reg, tempReg);
 }
 
+/**
+ * @brief Queue a read of a sequence of registers
+ * @details The transaction is run by WireQueue, the result is in the buffer when the
+ * status of the transaction is 0.
+ *
+ * @param t Transaction to use, must stay in scope until it is complete
+ * @param reg First register address (from a device specific enum)
+ * @param buffer Array to contain the data read
+ * @param len Number of registers to read
+ * @param callback Function to call when the transaction is complete, may be NULL
+ * @param context Pointer stored in the transaction for the callback
+ * @return false if the transaction is already queued or too large for the Wire buffer
+ */
+template <typename REGTYPE, typename DATATYPE>
+bool wireUtil<REGTYPE, DATATYPE>::queueRead(wireTransaction *t, REGTYPE reg, DATATYPE *buffer, uint8_t len, void (*callback)(wireTransaction *), void *context)
+{
+	return queueTransaction(t, WIRE_READ, reg, buffer, len, callback, context);
+}
+
+/**
+ * @brief Queue a write to a sequence of registers
+ * @details The buffer is read when the transaction is run, not when it is queued.
+ *
+ * @param t Transaction to use, must stay in scope until it is complete
+ * @param reg First register address (from a device specific enum)
+ * @param buffer Array containing the data to be written
+ * @param len Number of registers to write
+ * @param callback Function to call when the transaction is complete, may be NULL
+ * @param context Pointer stored in the transaction for the callback
+ * @return false if the transaction is already queued or too large for the Wire buffer
+ */
+template <typename REGTYPE, typename DATATYPE>
+bool wireUtil<REGTYPE, DATATYPE>::queueWrite(wireTransaction *t, REGTYPE reg, DATATYPE *buffer, uint8_t len, void (*callback)(wireTransaction *), void *context)
+{
+	return queueTransaction(t, WIRE_WRITE, reg, buffer, len, callback, context);
+}
+
+/**
+ * @brief Queue a read modify write of the bits in a register
+ *
+ * @param t Transaction to use, must stay in scope until it is complete
+ * @param reg Register address (from a device specific enum)
+ * @param mask Bits to change
+ * @param value New state of the bits in mask
+ * @param result Where to store the value written, may be NULL
+ * @param callback Function to call when the transaction is complete, may be NULL
+ * @param context Pointer stored in the transaction for the callback
+ * @return false if the transaction is already queued
+ */
+template <typename REGTYPE, typename DATATYPE>
+bool wireUtil<REGTYPE, DATATYPE>::queueSetBits(wireTransaction *t, REGTYPE reg, DATATYPE mask, DATATYPE value, DATATYPE *result, void (*callback)(wireTransaction *), void *context)
+{
+	if (WireQueue.isQueued(t)) { return false; } // the interrupt may be using mask and value
+	t->mask = mask;
+	t->value = value;
+	return queueTransaction(t, WIRE_MODIFY, reg, result, 1, callback, context);
+}
+
+/**
+ * @brief Fill in a transaction and add it to WireQueue
+ */
+template <typename REGTYPE, typename DATATYPE>
+bool wireUtil<REGTYPE, DATATYPE>::queueTransaction(wireTransaction *t, wireTransaction_t type, REGTYPE reg, DATATYPE *buffer, uint8_t len, void (*callback)(wireTransaction *), void *context)
+{
+	bool queued;
+	if (WireQueue.isQueued(t)) { return false; }
+	t->address = address;
+	t->reg = (uint8_t)reg;
+	t->type = type;
+	t->width = sizeof(DATATYPE);
+	t->count = len;
+	t->buffer = buffer;
+	t->callback = callback;
+	t->context = context;
+	if (type == WIRE_READ || shadow == NULL) { return WireQueue.add(t); }
+
+	// the registers are not valid until the write is complete, see shadowSettle()
+	WIREQUEUE_LOCK();
+	queued = WireQueue.add(t, queueRelease, this);
+	if (queued) { queuedWrites++; }
+	WIREQUEUE_UNLOCK();
+	if (!queued) { return false; }
+	for (uint8_t i = (uint8_t)reg; i < shadowSize && i < (uint8_t)reg + len; i++)
+	{
+		shadowFlags[i] &= ~(SHADOW_VALID | SHADOW_DIRTY); // the queued write wins over changes in the shadow
+		shadowFlags[i] |= SHADOW_QUEUED;
+	}
+	shadowQueued = true;
+	return true;
+}
+
+/**
+ * @brief Called by WireQueue when a queued write leaves the queue
+ * @details May be called from the twi interrupt, so only the count is changed here and the
+ * shadow is updated by shadowSettle().
+ *
+ * @param t The transaction
+ */
+template <typename REGTYPE, typename DATATYPE>
+void wireUtil<REGTYPE, DATATYPE>::queueRelease(wireTransaction *t)
+{
+	((wireUtil<REGTYPE, DATATYPE> *)t->owner)->queuedWrites--;
+}
+
+/**
+ * @brief Keep a copy of the device registers in RAM
+ * @details Reads of registers in the shadow are served from RAM once they have been read or
+ * written, writes of unchanged data are skipped, and setRegisterBit() only changes the shadow
+ * until flushRegisters() is called. Registers that can change on their own (status, data) must
+ * be marked with setVolatile(), as must registers where writing the same value does something
+ * (see writeRegisters()). Queued writes bypass the shadow, those registers are read from the
+ * device again once the writes are complete.
+ *
+ * @param numRegs Number of registers to shadow, starting from register 0
+ * @return false if there is not enough memory
+ */
+template <typename REGTYPE, typename DATATYPE>
+bool wireUtil<REGTYPE, DATATYPE>::enableShadow(uint8_t numRegs)
+{
+	free(shadow);
+	free(shadowFlags);
+	shadow = (DATATYPE *)calloc(numRegs, sizeof(DATATYPE));
+	shadowFlags = (uint8_t *)calloc(numRegs, sizeof(uint8_t));
+	if (shadow == NULL || shadowFlags == NULL)
+	{
+		free(shadow);
+		free(shadowFlags);
+		shadow = NULL;
+		shadowFlags = NULL;
+		shadowSize = 0;
+		return false;
+	}
+	shadowSize = numRegs;
+	return true;
+}
+
+/**
+ * @brief Mark a register that can change on its own, it is always read from and written to the device
+ * @details A change made by setRegisterBit() that has not been written is kept for flushRegisters().
+ *
+ * @param reg Register address (from a device specific enum)
+ * @param state true if the register is volatile
+ */
+template <typename REGTYPE, typename DATATYPE>
+void wireUtil<REGTYPE, DATATYPE>::setVolatile(REGTYPE reg, bool state)
+{
+	if ((uint8_t)reg >= shadowSize) { return; }
+	if (state)
+	{
+		shadowFlags[(uint8_t)reg] |= SHADOW_VOLATILE;
+		shadowFlags[(uint8_t)reg] &= ~SHADOW_VALID; // the copy is not kept up to date from now on
+	}
+	else { shadowFlags[(uint8_t)reg] &= ~SHADOW_VOLATILE; }
+}
+
+/**
+ * @brief Discard the shadow, e.g. after the device has been reset
+ * @details Changes that have not been written by flushRegisters() are lost.
+ */
+template <typename REGTYPE, typename DATATYPE>
+void wireUtil<REGTYPE, DATATYPE>::invalidateShadow()
+{
+	for (uint8_t i = 0; i < shadowSize; i++) { shadowFlags[i] &= (SHADOW_VOLATILE | SHADOW_QUEUED); }
+}
+
+/**
+ * @brief Write all of the changed registers in the shadow
+ * @details Each run of consecutive changed registers is written in a single transaction,
+ * this relies on the device incrementing the register address.
+ *
+ * @return true on success, false if NACK
+ */
+template <typename REGTYPE, typename DATATYPE>
+bool wireUtil<REGTYPE, DATATYPE>::flushRegisters()
+{
+	bool status = true;
+	uint8_t i = 0;
+	uint8_t len;
+	while (i < shadowSize)
+	{
+		if (!(shadowFlags[i] & SHADOW_DIRTY))
+		{
+			i++;
+			continue;
+		}
+		len = 1;
+		while ((i + len) < shadowSize && (shadowFlags[i + len] & SHADOW_DIRTY)
+		        && ((len + 1) * sizeof(DATATYPE)) < BUFFER_LENGTH)
+		{
+			len++;
+		}
+		if (writeRegisters((REGTYPE)i, shadow + i, len)) { transactionsSaved--; } // counted as saved by setRegisterBit()
+		else { status = false; }
+		i += len;
+	}
+	return status;
+}
+
+/**
+ * @brief Check if a range of registers can be served from the shadow
+ *
+ * @param reg First register address
+ * @param len Number of registers
+ * @return true if all of the registers are valid and not volatile
+ */
+template <typename REGTYPE, typename DATATYPE>
+bool wireUtil<REGTYPE, DATATYPE>::shadowHit(REGTYPE reg, uint8_t len)
+{
+	if (shadow == NULL || ((uint16_t)reg + len) > shadowSize) { return false; }
+	shadowSettle();
+	for (uint8_t i = (uint8_t)reg; i < (uint8_t)reg + len; i++)
+	{
+		if ((shadowFlags[i] & (SHADOW_VALID | SHADOW_VOLATILE | SHADOW_QUEUED)) != SHADOW_VALID) { return false; }
+	}
+	return true;
+}
+
+/**
+ * @brief Release the registers of queued writes once all of them are complete
+ * @details The registers stay invalid, so they are read from the device the next time.
+ */
+template <typename REGTYPE, typename DATATYPE>
+void wireUtil<REGTYPE, DATATYPE>::shadowSettle()
+{
+	if (!shadowQueued || queuedWrites != 0) { return; }
+	for (uint8_t i = 0; i < shadowSize; i++) { shadowFlags[i] &= ~SHADOW_QUEUED; }
+	shadowQueued = false;
+}
+
+/**
+ * @brief Update the shadow with data that was read from or written to the device
+ *
+ * @param reg First register address
+ * @param buffer Register data
+ * @param len Number of registers
+ * @param written true if the data was written, false if it was read (changes that have not been written are kept)
+ */
+template <typename REGTYPE, typename DATATYPE>
+void wireUtil<REGTYPE, DATATYPE>::shadowStore(REGTYPE reg, DATATYPE *buffer, uint8_t len, bool written)
+{
+	if (shadow == NULL) { return; }
+	shadowSettle();
+	for (uint8_t i = 0; i < len && ((uint8_t)reg + i) < shadowSize; i++)
+	{
+		uint8_t r = (uint8_t)reg + i;
+		if (shadowFlags[r] & (SHADOW_VOLATILE | SHADOW_QUEUED)) { continue; } // a queued write will change it
+		if (!written && (shadowFlags[r] & SHADOW_DIRTY)) { continue; }
+		shadow[r] = buffer[i];
+		shadowFlags[r] = SHADOW_VALID;
+	}
+}
+
 /**
  * @brief Assembles and writes a big endian packet
  *